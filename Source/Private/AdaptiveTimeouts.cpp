@@ -0,0 +1,152 @@
+﻿#include "AdaptiveTimeouts.h"
+#include <algorithm>
+#include <cmath>
+
+// 类内初始化的静态常量在取地址时需要定义
+const size_t LatencyHistogram::BUCKET_COUNT;
+const size_t LatencyHistogram::GENERATION_SIZE;
+const size_t AdaptiveTimeouts::MIN_SAMPLES;
+constexpr double AdaptiveTimeouts::FACTOR;
+const int AdaptiveTimeouts::MIN_CONNECT_MS;
+const int AdaptiveTimeouts::MIN_RESPONSE_MS;
+const int AdaptiveTimeouts::MIN_IDLE_MS;
+const size_t AdaptiveTimeouts::TOKEN_OVERHEAD;
+
+namespace
+{
+    // 相邻桶上界之比
+    const double BUCKET_RATIO = 1.2;
+}
+
+/**
+ * @brief 获取桶的上界
+ * @param bucket 桶编号
+ * @return 上界
+ */
+double LatencyHistogram::BucketLimit(size_t bucket)
+{
+    return std::pow(BUCKET_RATIO, static_cast<double>(bucket));
+}
+
+/**
+ * @brief 记录一个样本
+ * @param value 耗时
+ */
+void LatencyHistogram::Add(double value)
+{
+    size_t bucket = 0;
+    if (value > 1.0)
+        bucket = std::min(static_cast<size_t>(std::ceil(std::log(value) / std::log(BUCKET_RATIO))), BUCKET_COUNT - 1);
+
+    // 当前代已满时成为上一代，更早的样本丢弃
+    if (m_currentCount == GENERATION_SIZE)
+    {
+        std::copy(std::begin(m_current), std::end(m_current), std::begin(m_previous));
+        std::fill(std::begin(m_current), std::end(m_current), 0u);
+        m_previousCount = m_currentCount;
+        m_currentCount = 0;
+    }
+    m_current[bucket]++;
+    m_currentCount++;
+}
+
+/**
+ * @brief 获取百分位数
+ * @param quantile 分位
+ * @return 百分位数，没有样本时返回0
+ */
+double LatencyHistogram::Percentile(double quantile) const
+{
+    size_t total = GetCount();
+    if (total == 0)
+        return 0;
+
+    // 至少覆盖rank个样本的最小桶
+    size_t rank = static_cast<size_t>(std::ceil(quantile * total));
+    rank = std::max<size_t>(rank, 1);
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+    {
+        seen += m_current[bucket] + m_previous[bucket];
+        if (seen >= rank)
+            return BucketLimit(bucket);
+    }
+    return BucketLimit(BUCKET_COUNT - 1);
+}
+
+/**
+ * @brief 按输入长度估计输出token数
+ *
+ * 中英互译时译文token数通常不超过原文字节数的一半，估计偏大只会放宽超时
+ * @param inputBytes 发送的UTF-8文本字节数
+ * @param maxTokens 配置档的max_tokens
+ * @return 预计token数
+ */
+size_t AdaptiveTimeouts::EstimateOutputTokens(size_t inputBytes, int maxTokens)
+{
+    size_t estimate = inputBytes / 2 + 16;
+    return maxTokens > 0 ? std::min(estimate, static_cast<size_t>(maxTokens)) : estimate;
+}
+
+/**
+ * @brief 记录一次成功请求的各阶段耗时
+ * @param sendMs 连接并发送请求的耗时
+ * @param responseMs 等待响应头的耗时
+ * @param maxGapMs 响应体数据块之间的最长间隔
+ * @param expectedTokens 发送时的预计输出token数
+ */
+void AdaptiveTimeouts::Record(double sendMs, double responseMs, double maxGapMs, size_t expectedTokens)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_send.Add(sendMs);
+    m_responsePerToken.Add(responseMs / static_cast<double>(expectedTokens + TOKEN_OVERHEAD));
+    m_gap.Add(maxGapMs);
+}
+
+/**
+ * @brief 计算一次请求的各阶段超时
+ * @param ceilings 配置的超时
+ * @param expectedTokens 预计输出token数
+ * @return 各阶段超时
+ */
+PhaseTimeouts AdaptiveTimeouts::Compute(const PhaseTimeouts& ceilings, size_t expectedTokens) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_send.GetCount() < MIN_SAMPLES)
+        return ceilings;
+
+    PhaseTimeouts timeouts;
+    timeouts.connectMs = PhaseTimeout(m_send, 1.0, MIN_CONNECT_MS, ceilings.connectMs);
+    timeouts.sendMs = PhaseTimeout(m_send, 1.0, MIN_CONNECT_MS, ceilings.sendMs);
+    timeouts.responseMs = PhaseTimeout(m_responsePerToken, static_cast<double>(expectedTokens + TOKEN_OVERHEAD),
+        MIN_RESPONSE_MS, ceilings.responseMs);
+    timeouts.idleMs = PhaseTimeout(m_gap, 1.0, MIN_IDLE_MS, ceilings.idleMs);
+    return timeouts;
+}
+
+/**
+ * @brief 清除全部样本
+ */
+void AdaptiveTimeouts::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_send = LatencyHistogram();
+    m_responsePerToken = LatencyHistogram();
+    m_gap = LatencyHistogram();
+}
+
+/**
+ * @brief 由直方图计算一个阶段的超时
+ * @param histogram 直方图
+ * @param scale 样本值到毫秒的倍数
+ * @param floorMs 下限
+ * @param ceilingMs 上限
+ * @return 超时（毫秒）
+ */
+int AdaptiveTimeouts::PhaseTimeout(const LatencyHistogram& histogram, double scale, int floorMs, int ceilingMs)
+{
+    double timeout = std::max(histogram.Percentile(0.99) * scale * FACTOR, static_cast<double>(floorMs));
+    if (ceilingMs > 0)
+        timeout = std::min(timeout, static_cast<double>(ceilingMs));
+    return static_cast<int>(timeout);
+}
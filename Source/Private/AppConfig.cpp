@@ -0,0 +1,661 @@
+﻿#include "AppConfig.h"
+#include "RequestTemplate.h"
+#include <cstdlib>
+#include <cerrno>
+#include <optional>
+
+// 内置默认系统提示词
+static const char* DEFAULT_SYSTEM_PROMPT = "Translation mode: only return the translation, never answer questions or add explanations. If I send Chinese, translate it into concise English words separated by spaces, without any case formatting or punctuation. If I send English, translate it into Chinese. If a word is misspelled or unknown, infer its probable meaning and translate it.";
+
+// 内置精简系统提示词（Prompt=Compact），约为默认提示词的三分之一，适合短文本以减少每次请求的输入token
+static const char* COMPACT_SYSTEM_PROMPT = "Translate only, no explanations. Chinese to concise English words separated by spaces, no punctuation. English to Chinese. Guess misspelled words.";
+
+// 静态成员变量定义
+std::shared_ptr<const AppConfig> ConfigStore::s_pConfig;
+std::atomic<uint64_t> ConfigStore::s_nVersion(0);
+
+namespace
+{
+    // 解析过程中暂存的配置档字段，未设置的字段在解析结束后从[Api]继承
+    struct PendingProfile
+    {
+        std::string name;
+        int lineNumber = 0;
+        std::optional<HotkeyBinding> hotkey;
+        std::optional<std::string> model;
+        std::optional<double> temperature;
+        std::optional<int> maxTokens;
+        std::optional<std::string> systemPrompt;
+        std::optional<std::string> promptPreset;    // Prompt=Full/Compact 选择的内置提示词
+        std::optional<std::string> cacheNamespace;
+        CaseStyle caseStyle = CaseStyle::Pascal;
+        OutputMode output = OutputMode::Paste;
+        std::optional<uint32_t> postProcess;        // 未设置时按Case选择默认阶段
+        int maxLength = 0;
+        std::vector<ResultPipeline::Replacement> replacements;
+        bool codeAware = true;
+        bool deltaAware = true;
+    };
+
+    // 去除首尾空白
+    std::string Trim(const std::string& text)
+    {
+        size_t begin = 0;
+        size_t end = text.length();
+        while (begin < end && (text[begin] == ' ' || text[begin] == '\t' || text[begin] == '\r'))
+            begin++;
+        while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t' || text[end - 1] == '\r'))
+            end--;
+        return text.substr(begin, end - begin);
+    }
+
+    // 转为小写（仅ASCII，键名和节名不区分大小写）
+    std::string ToLower(std::string text)
+    {
+        for (char& c : text)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+        }
+        return text;
+    }
+
+    // 还原值中的 \n 和 \\ 转义
+    std::string UnescapeValue(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.length());
+        for (size_t i = 0; i < value.length(); i++)
+        {
+            if (value[i] == '\\' && i + 1 < value.length())
+            {
+                switch (value[i + 1])
+                {
+                    case 'n': result += '\n'; i++; continue;
+                    case 't': result += '\t'; i++; continue;
+                    case '\\': result += '\\'; i++; continue;
+                    default: break;
+                }
+            }
+            result += value[i];
+        }
+        return result;
+    }
+
+    // 将换行等字符转义为单行值
+    std::string EscapeValue(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.length());
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '\n': result += "\\n"; break;
+                case '\t': result += "\\t"; break;
+                case '\\': result += "\\\\"; break;
+                default: result += c; break;
+            }
+        }
+        return result;
+    }
+
+    bool ParseInt(const std::string& text, int minValue, int maxValue, int& value)
+    {
+        if (text.empty())
+            return false;
+        char* end = nullptr;
+        errno = 0;
+        long parsed = std::strtol(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0' || parsed < minValue || parsed > maxValue)
+            return false;
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    bool ParseDouble(const std::string& text, double minValue, double maxValue, double& value)
+    {
+        if (text.empty())
+            return false;
+        char* end = nullptr;
+        errno = 0;
+        double parsed = std::strtod(text.c_str(), &end);
+        if (errno != 0 || *end != '\0' || parsed < minValue || parsed > maxValue)
+            return false;
+        value = parsed;
+        return true;
+    }
+
+    // 解析单个键名为虚拟键码
+    bool ParseKeyName(const std::string& name, uint32_t& vk)
+    {
+        std::string key = ToLower(name);
+        if (key.length() == 1)
+        {
+            char c = key[0];
+            if (c >= 'a' && c <= 'z') { vk = static_cast<uint32_t>('A' + (c - 'a')); return true; }
+            if (c >= '0' && c <= '9') { vk = static_cast<uint32_t>(c); return true; }
+            if (c == '`') { vk = 0xC0; return true; }   // VK_OEM_3
+        }
+        if (key.length() >= 2 && key[0] == 'f')
+        {
+            int n = 0;
+            if (ParseInt(key.substr(1), 1, 24, n))
+            {
+                vk = static_cast<uint32_t>(0x70 + n - 1);  // VK_F1..VK_F24
+                return true;
+            }
+        }
+
+        struct NamedKey { const char* name; uint32_t vk; };
+        static const NamedKey namedKeys[] = {
+            { "space", 0x20 }, { "enter", 0x0D }, { "return", 0x0D }, { "tab", 0x09 },
+            { "esc", 0x1B }, { "escape", 0x1B }, { "insert", 0x2D }, { "delete", 0x2E },
+            { "home", 0x24 }, { "end", 0x23 }, { "pageup", 0x21 }, { "pagedown", 0x22 },
+            { "left", 0x25 }, { "up", 0x26 }, { "right", 0x27 }, { "down", 0x28 },
+            { "pause", 0x13 }, { "backquote", 0xC0 },
+        };
+        for (const NamedKey& named : namedKeys)
+        {
+            if (key == named.name)
+            {
+                vk = named.vk;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 解析内置提示词名称
+    bool ParsePromptPreset(const std::string& value, std::string& prompt)
+    {
+        std::string name = ToLower(value);
+        if (name == "full") prompt = DEFAULT_SYSTEM_PROMPT;
+        else if (name == "compact") prompt = COMPACT_SYSTEM_PROMPT;
+        else return false;
+        return true;
+    }
+
+    // 未设置PostProcess时由配置档自身的设置决定后处理阶段：清理包装的阶段总是启用，
+    // 译文转换为标识符（Case不是None）时才去除解释、句点和非标识符字符。
+    // 后处理只作用于输出，缓存和历史保存原始译文，Delta沿用的上次译文保留句末标点，
+    // 句子切分和拼接不受这些阶段影响
+    uint32_t DefaultStages(const PendingProfile& pending)
+    {
+        uint32_t stages = ResultPipeline::DEFAULT_TEXT_STAGES;
+        if (pending.caseStyle != CaseStyle::None)
+            stages |= ResultPipeline::IDENTIFIER_STAGES;
+        return stages;
+    }
+
+    // 由暂存字段和[Api]默认值生成配置档
+    std::shared_ptr<const TranslationProfile> MakeProfile(const PendingProfile& pending, const AppConfig& config)
+    {
+        auto profile = std::make_shared<TranslationProfile>();
+        profile->name = pending.name;
+        profile->hotkey = pending.hotkey.value_or(HotkeyBinding());
+        profile->model = pending.model.value_or(config.model);
+        profile->temperature = pending.temperature.value_or(config.temperature);
+        profile->maxTokens = pending.maxTokens.value_or(config.maxTokens);
+        // 显式的SystemPrompt优先于Prompt选择的内置提示词
+        profile->systemPrompt = pending.systemPrompt.value_or(pending.promptPreset.value_or(config.systemPrompt));
+        profile->cacheNamespace = pending.cacheNamespace.value_or(ToLower(pending.name));
+        profile->caseStyle = pending.caseStyle;
+        profile->output = pending.output;
+        uint32_t stages = pending.postProcess.value_or(DefaultStages(pending));
+        profile->codeAware = pending.codeAware;
+        profile->deltaAware = pending.deltaAware;
+        profile->resultPipeline = ResultPipeline(stages, static_cast<size_t>(pending.maxLength), pending.replacements);
+        profile->BuildRequestTemplate();
+        return profile;
+    }
+}
+
+/**
+ * @brief 获取内置默认配置
+ * @return 默认配置
+ */
+AppConfig AppConfig::Defaults()
+{
+    AppConfig config;
+    config.systemPrompt = DEFAULT_SYSTEM_PROMPT;
+
+    PendingProfile pending;
+    pending.name = "Default";
+    config.profiles.push_back(MakeProfile(pending, config));
+    return config;
+}
+
+/**
+ * @brief 按名称查找配置档
+ * @param name 配置档名称
+ * @return 找到返回配置档，否则返回nullptr
+ */
+std::shared_ptr<const TranslationProfile> AppConfig::FindProfile(const std::string& name) const
+{
+    std::string lowerName = ToLower(name);
+    for (const auto& profile : profiles)
+    {
+        if (ToLower(profile->name) == lowerName)
+            return profile;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 解析热键描述字符串
+ * @param text 热键描述，例如 "Ctrl+Space"
+ * @param binding 输出热键绑定
+ * @return 解析成功返回true，失败返回false
+ */
+bool ConfigParser::ParseHotkey(const std::string& text, HotkeyBinding& binding)
+{
+    HotkeyBinding parsed;
+    parsed.modifiers = 0;
+    parsed.virtualKey = 0;
+
+    size_t start = 0;
+    while (start <= text.length())
+    {
+        size_t plus = text.find('+', start);
+        std::string part = Trim(text.substr(start, plus == std::string::npos ? std::string::npos : plus - start));
+        std::string lower = ToLower(part);
+
+        if (lower == "ctrl" || lower == "control")
+            parsed.modifiers |= HotkeyBinding::MOD_CONTROL_FLAG;
+        else if (lower == "alt")
+            parsed.modifiers |= HotkeyBinding::MOD_ALT_FLAG;
+        else if (lower == "shift")
+            parsed.modifiers |= HotkeyBinding::MOD_SHIFT_FLAG;
+        else if (lower == "win")
+            parsed.modifiers |= HotkeyBinding::MOD_WIN_FLAG;
+        else if (parsed.virtualKey != 0 || !ParseKeyName(part, parsed.virtualKey))
+            return false;   // 多个主键或无法识别的键名
+
+        if (plus == std::string::npos)
+            break;
+        start = plus + 1;
+    }
+
+    if (parsed.virtualKey == 0)
+        return false;
+
+    binding = parsed;
+    return true;
+}
+
+/**
+ * @brief 解析配置文本
+ * @param text UTF-8编码的配置文件内容
+ * @param config 输入为基础配置，输出为覆盖后的配置
+ * @param error 失败时输出错误描述
+ * @return 解析成功返回true，失败返回false
+ */
+bool ConfigParser::Parse(const std::string& text, AppConfig& config, std::string& error)
+{
+    std::string section;
+    size_t lineStart = 0;
+    int lineNumber = 0;
+    HotkeyBinding legacyHotkey;                 // [Hotkey] Translate，仅在未定义配置档时使用
+    std::vector<PendingProfile> pendingProfiles;
+    std::optional<std::string> apiSystemPrompt;     // [Api] SystemPrompt
+    std::optional<std::string> apiPromptPreset;     // [Api] Prompt选择的内置提示词
+
+    // 跳过UTF-8 BOM
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        lineStart = 3;
+
+    while (lineStart < text.length())
+    {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = text.length();
+        std::string line = Trim(text.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        lineNumber++;
+
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+            continue;
+
+        if (line[0] == '[')
+        {
+            if (line.back() != ']')
+            {
+                error = "第" + std::to_string(lineNumber) + "行：节名缺少 ]";
+                return false;
+            }
+            std::string sectionName = Trim(line.substr(1, line.length() - 2));
+            section = ToLower(sectionName);
+            if (section.compare(0, 8, "profile.") == 0)
+            {
+                PendingProfile pending;
+                pending.name = Trim(sectionName.substr(8));
+                pending.lineNumber = lineNumber;
+                if (pending.name.empty())
+                {
+                    error = "第" + std::to_string(lineNumber) + "行：配置档名称为空";
+                    return false;
+                }
+                for (const PendingProfile& existing : pendingProfiles)
+                {
+                    if (ToLower(existing.name) == ToLower(pending.name))
+                    {
+                        error = "第" + std::to_string(lineNumber) + "行：配置档 " + pending.name + " 重复定义";
+                        return false;
+                    }
+                }
+                pendingProfiles.push_back(pending);
+                section = "profile";
+            }
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            error = "第" + std::to_string(lineNumber) + "行：缺少 =";
+            return false;
+        }
+
+        std::string key = ToLower(Trim(line.substr(0, equals)));
+        std::string value = UnescapeValue(Trim(line.substr(equals + 1)));
+        bool valid = true;
+
+        if (section == "api")
+        {
+            int port = 0;
+            if (key == "apikey") config.apiKey = value;
+            else if (key == "host") valid = !(config.host = value).empty();
+            else if (key == "port") { valid = ParseInt(value, 1, 65535, port); config.port = static_cast<uint16_t>(port); }
+            else if (key == "path") valid = !(config.path = value).empty() && value[0] == '/';
+            else if (key == "model") valid = !(config.model = value).empty();
+            else if (key == "temperature") valid = ParseDouble(value, 0.0, 2.0, config.temperature);
+            else if (key == "maxtokens") valid = ParseInt(value, 1, 65536, config.maxTokens);
+            else if (key == "requestsperminute") valid = ParseInt(value, 0, 100000, config.requestsPerMinute);
+            else if (key == "tokensperminute") valid = ParseInt(value, 0, 100000000, config.tokensPerMinute);
+            else if (key == "systemprompt") apiSystemPrompt = value;
+            else if (key == "prompt")
+            {
+                std::string prompt;
+                valid = ParsePromptPreset(value, prompt);
+                apiPromptPreset = prompt;
+            }
+        }
+        else if (section == "timeouts")
+        {
+            int adaptive = 0;
+            if (key == "resolve") valid = ParseInt(value, 0, 600000, config.resolveTimeoutMs);
+            else if (key == "connect") valid = ParseInt(value, 0, 600000, config.connectTimeoutMs);
+            else if (key == "send") valid = ParseInt(value, 0, 600000, config.sendTimeoutMs);
+            else if (key == "receive") valid = ParseInt(value, 0, 600000, config.receiveTimeoutMs);
+            else if (key == "adaptive") { valid = ParseInt(value, 0, 1, adaptive); config.adaptiveTimeouts = adaptive != 0; }
+        }
+        else if (section == "cache")
+        {
+            if (key == "capacity") valid = ParseInt(value, 0, 10000000, config.cacheCapacity);
+        }
+        else if (section == "memory")
+        {
+            if (key == "capacity") valid = ParseInt(value, 0, 10000000, config.memoryCapacity);
+            else if (key == "answer") valid = ParseDouble(value, 0.0, 1.0, config.memoryAnswer);
+            else if (key == "hint") valid = ParseDouble(value, 0.0, 1.0, config.memoryHint);
+        }
+        else if (section == "history")
+        {
+            if (key == "maxsizekb") valid = ParseInt(value, 0, 1024 * 1024, config.historyMaxKB);
+        }
+        else if (section == "glossary")
+        {
+            if (key == "mode") valid = Glossary::ParseMode(value, config.glossaryMode);
+            else if (key == "file") { valid = !value.empty(); config.glossaryFile = value; }
+        }
+        else if (section == "paste")
+        {
+            if (key == "maxtypedchars") valid = ParseInt(value, 0, 4096, config.pasteMaxTypedChars);
+            else if (key == "clipboardclasses") config.pasteClipboardClasses = value;
+        }
+        else if (section == "scheduler")
+        {
+            if (key == "interactiveconcurrency") valid = ParseInt(value, 1, 16, config.interactiveConcurrency);
+            else if (key == "clientconcurrency") valid = ParseInt(value, 1, 16, config.clientConcurrency);
+            else if (key == "backgroundconcurrency") valid = ParseInt(value, 1, 16, config.backgroundConcurrency);
+        }
+        else if (section == "server")
+        {
+            int enabled = 0;
+            if (key == "enabled") { valid = ParseInt(value, 0, 1, enabled); config.serverEnabled = enabled != 0; }
+            else if (key == "maxclients") valid = ParseInt(value, 1, 64, config.serverMaxClients);
+        }
+        else if (section == "hotkey")
+        {
+            if (key == "translate") valid = ParseHotkey(value, legacyHotkey);
+        }
+        else if (section == "profile")
+        {
+            PendingProfile& pending = pendingProfiles.back();
+            if (key == "hotkey")
+            {
+                HotkeyBinding binding;
+                valid = ParseHotkey(value, binding);
+                pending.hotkey = binding;
+            }
+            else if (key == "model") { valid = !value.empty(); pending.model = value; }
+            else if (key == "temperature")
+            {
+                double temperature = 0.0;
+                valid = ParseDouble(value, 0.0, 2.0, temperature);
+                pending.temperature = temperature;
+            }
+            else if (key == "maxtokens")
+            {
+                int maxTokens = 0;
+                valid = ParseInt(value, 1, 65536, maxTokens);
+                pending.maxTokens = maxTokens;
+            }
+            else if (key == "systemprompt") pending.systemPrompt = value;
+            else if (key == "prompt")
+            {
+                std::string prompt;
+                valid = ParsePromptPreset(value, prompt);
+                pending.promptPreset = prompt;
+            }
+            else if (key == "cachenamespace") { valid = !value.empty(); pending.cacheNamespace = value; }
+            else if (key == "case") valid = IdentifierCase::ParseStyle(value, pending.caseStyle);
+            else if (key == "output")
+            {
+                std::string mode = ToLower(value);
+                if (mode == "paste") pending.output = OutputMode::Paste;
+                else if (mode == "show") pending.output = OutputMode::Show;
+                else valid = false;
+            }
+            else if (key == "postprocess")
+            {
+                uint32_t stages = 0;
+                valid = ResultPipeline::ParseStages(value, stages);
+                pending.postProcess = stages;
+            }
+            else if (key == "maxlength") valid = ParseInt(value, 0, 65536, pending.maxLength);
+            else if (key == "replace") valid = ResultPipeline::ParseReplacements(value, pending.replacements);
+            else if (key == "code")
+            {
+                std::string mode = ToLower(value);
+                if (mode == "auto") pending.codeAware = true;
+                else if (mode == "off") pending.codeAware = false;
+                else valid = false;
+            }
+            else if (key == "delta")
+            {
+                std::string mode = ToLower(value);
+                if (mode == "auto") pending.deltaAware = true;
+                else if (mode == "off") pending.deltaAware = false;
+                else valid = false;
+            }
+        }
+        // 未知的节和键直接忽略，便于新旧版本共用同一配置文件
+
+        if (!valid)
+        {
+            error = "第" + std::to_string(lineNumber) + "行：" + key + " 的值无效";
+            return false;
+        }
+    }
+
+    // [Api]中显式的SystemPrompt优先于Prompt选择的内置提示词
+    if (apiSystemPrompt)
+        config.systemPrompt = *apiSystemPrompt;
+    else if (apiPromptPreset)
+        config.systemPrompt = *apiPromptPreset;
+
+    // 生成配置档（在全部解析完成后进行，配置档可继承写在其后的[Api]设置）
+    config.profiles.clear();
+    if (pendingProfiles.empty())
+    {
+        PendingProfile pending;
+        pending.name = "Default";
+        pending.hotkey = legacyHotkey;
+        pendingProfiles.push_back(pending);
+    }
+
+    for (const PendingProfile& pending : pendingProfiles)
+    {
+        if (!pending.hotkey)
+        {
+            error = "第" + std::to_string(pending.lineNumber) + "行：配置档 " + pending.name + " 缺少 Hotkey";
+            return false;
+        }
+        for (const auto& existing : config.profiles)
+        {
+            if (existing->hotkey == *pending.hotkey)
+            {
+                error = "第" + std::to_string(pending.lineNumber) + "行：配置档 " + pending.name + " 与 " + existing->name + " 热键相同";
+                return false;
+            }
+        }
+        config.profiles.push_back(MakeProfile(pending, config));
+    }
+
+    return true;
+}
+
+/**
+ * @brief 生成默认配置文件内容
+ * @return UTF-8编码的INI文本
+ */
+std::string ConfigParser::GenerateDefaultText()
+{
+    AppConfig config = AppConfig::Defaults();
+
+    std::string text;
+    text += "; 元析翻译配置文件，保存后自动生效，无需重启\n";
+    text += "\n[Api]\n";
+    text += "; APIKey获取地址，阿里百炼：https://bailian.console.aliyun.com\n";
+    text += "ApiKey=\n";
+    text += "Host=" + config.host + "\n";
+    text += "Port=" + std::to_string(config.port) + "\n";
+    text += "Path=" + config.path + "\n";
+    text += "Model=" + config.model + "\n";
+    text += "Temperature=0.3\n";
+    text += "MaxTokens=" + std::to_string(config.maxTokens) + "\n";
+    text += "SystemPrompt=" + EscapeValue(config.systemPrompt) + "\n";
+    text += "; 服务商每分钟请求数和token数配额，超出时请求排队等待，0表示不限\n";
+    text += "RequestsPerMinute=" + std::to_string(config.requestsPerMinute) + "\n";
+    text += "TokensPerMinute=" + std::to_string(config.tokensPerMinute) + "\n";
+    text += "\n[Timeouts]\n";
+    text += "; 单位：毫秒\n";
+    text += "Resolve=" + std::to_string(config.resolveTimeoutMs) + "\n";
+    text += "Connect=" + std::to_string(config.connectTimeoutMs) + "\n";
+    text += "Send=" + std::to_string(config.sendTimeoutMs) + "\n";
+    text += "Receive=" + std::to_string(config.receiveTimeoutMs) + "\n";
+    text += "; 1：按最近请求的耗时分布（P99的3倍）收紧各阶段超时，以上述值为上限；超时后在新连接上按上述值重试一次\n";
+    text += "Adaptive=" + std::string(config.adaptiveTimeouts ? "1" : "0") + "\n";
+    text += "\n[Cache]\n";
+    text += "; 翻译缓存最大条目数，0表示禁用\n";
+    text += "Capacity=" + std::to_string(config.cacheCapacity) + "\n";
+    text += "\n[Memory]\n";
+    text += "; 翻译记忆：精确缓存未命中时查找相似原文的已有译文（忽略大小写、空白和标点）\n";
+    text += "; Capacity 最大条目数（0禁用）；Answer 相似度达到该值时直接沿用译文；Hint 达到该值时作为参考译文附在请求中（0关闭）\n";
+    text += "Capacity=" + std::to_string(config.memoryCapacity) + "\n";
+    text += "; Answer低于1时，只差一个数字或否定词的原文也可能被直接沿用\n";
+    text += "Answer=1\n";
+    text += "Hint=0.75\n";
+    text += "\n[History]\n";
+    text += "; 翻译历史文件上限（KB），超出后保留最新的一半记录，0表示禁用，重启后生效\n";
+    text += "MaxSizeKB=" + std::to_string(config.historyMaxKB) + "\n";
+    text += "\n[Glossary]\n";
+    text += "; 术语表文件每行一条“术语=译法”，保存配置文件时重新加载\n";
+    text += "; Mode：Substitute 请求前把术语替换为约定译法 / Prompt 在请求中附上命中的术语 / Off 不使用\n";
+    text += "Mode=Substitute\n";
+    text += "File=" + config.glossaryFile + "\n";
+    text += "\n[Paste]\n";
+    text += "; 不超过MaxTypedChars个字符的单行译文直接以按键输入，不经过剪切板（0表示总是通过剪切板粘贴）\n";
+    text += "; ClipboardClasses：总是通过剪切板粘贴的窗口类名，分号分隔\n";
+    text += "MaxTypedChars=" + std::to_string(config.pasteMaxTypedChars) + "\n";
+    text += "ClipboardClasses=" + config.pasteClipboardClasses + "\n";
+    text += "\n[Scheduler]\n";
+    text += "; 同时执行的请求数上限：热键翻译（InteractiveConcurrency）、本地IPC单条翻译（ClientConcurrency）和后台请求（BackgroundConcurrency），保存后立即生效\n";
+    text += "InteractiveConcurrency=" + std::to_string(config.interactiveConcurrency) + "\n";
+    text += "ClientConcurrency=" + std::to_string(config.clientConcurrency) + "\n";
+    text += "BackgroundConcurrency=" + std::to_string(config.backgroundConcurrency) + "\n";
+    text += "\n[Server]\n";
+    text += "; 本地IPC翻译服务：编辑器插件和脚本通过命名管道复用本程序的连接、缓存和配额（1开启，0关闭）\n";
+    text += "Enabled=0\n";
+    text += "MaxClients=" + std::to_string(config.serverMaxClients) + "\n";
+    text += "\n; 翻译配置档：每个配置档绑定一个热键，可单独设置 Model、Temperature、MaxTokens、\n";
+    text += "; SystemPrompt（未设置时沿用[Api]中的值）、Prompt（内置提示词：Full 完整 / Compact 精简，SystemPrompt优先）、\n";
+    text += "; CacheNamespace、Output（Paste 替换选中文本 / Show 仅显示）\n";
+    text += "; 和 Case（英文译文的命名风格：Pascal、Camel、Snake、ScreamingSnake、Kebab、None）\n";
+    text += "; 译文后处理：PostProcess（Trim、Fences、Quotes、Explanation、Period、Charset 逗号分隔，None 全部关闭；\n";
+    text += "; 默认 Trim,Fences,Quotes，Case 不是 None 时另加 Explanation,Period,Charset；只作用于输出，缓存保存原始译文）、\n";
+    text += "; MaxLength（最大字符数，0不限）\n";
+    text += "; 和 Replace（译文整词替换，如 Replace=Obj>Object;Info>Information）\n";
+    text += "; Code：Auto 选中代码时只翻译注释和字符串并写回原处（默认）/ Off 整段翻译\n";
+    text += "; Delta：Auto 重新翻译编辑过的段落时只发送改动的句子，其余沿用翻译历史中的译文（默认）/ Off 整段翻译\n";
+    text += "[Profile.Default]\n";
+    text += "Hotkey=Ctrl+Space\n";
+    text += "Case=Pascal\n";
+    text += "\n; [Profile.Camel]\n";
+    text += "; Hotkey=Ctrl+Alt+Space\n";
+    text += "; CacheNamespace=default\n";
+    text += "; Case=Camel\n";
+    text += "\n; [Profile.Show]\n";
+    text += "; Hotkey=Ctrl+Shift+Space\n";
+    text += "; CacheNamespace=default\n";
+    text += "; Output=Show\n";
+    return text;
+}
+
+/**
+ * @brief 获取当前配置快照
+ * @return 当前配置
+ */
+std::shared_ptr<const AppConfig> ConfigStore::Current()
+{
+    std::shared_ptr<const AppConfig> config = std::atomic_load(&s_pConfig);
+    if (!config)
+    {
+        // 尚未发布过配置，使用默认配置
+        static const std::shared_ptr<const AppConfig> defaults = std::make_shared<const AppConfig>(AppConfig::Defaults());
+        return defaults;
+    }
+    return config;
+}
+
+/**
+ * @brief 发布新配置，原子替换当前快照
+ * @param config 新配置
+ * @return 新配置的版本号
+ */
+uint64_t ConfigStore::Publish(std::shared_ptr<const AppConfig> config)
+{
+    std::atomic_store(&s_pConfig, std::move(config));
+    return ++s_nVersion;
+}
+
+/**
+ * @brief 获取当前配置版本号
+ * @return 版本号
+ */
+uint64_t ConfigStore::Version()
+{
+    return s_nVersion.load();
+}
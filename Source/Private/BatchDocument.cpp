@@ -0,0 +1,229 @@
+﻿#include "BatchDocument.h"
+
+/**
+ * @brief 判断字节是否为行内空白（空格、制表符、回车）
+ * @param ch 字节
+ * @return 是空白返回true
+ */
+static bool IsBlank(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' || ch == '\v';
+}
+
+/**
+ * @brief 拆分输入
+ * @param input UTF-8文本
+ * @param split 拆分方式
+ */
+BatchDocument::BatchDocument(std::string input, BatchSplit split)
+    : m_input(std::move(input)), m_split(split)
+{
+    // BOM作为第一条记录之前的空白原样输出
+    if (m_input.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        m_contentBegin = 3;
+
+    if (m_split == BatchSplit::Lines)
+        SplitLines();
+    else
+        SplitParagraphs();
+}
+
+/**
+ * @brief 按行拆分
+ */
+void BatchDocument::SplitLines()
+{
+    size_t lineBegin = m_contentBegin;
+    while (lineBegin < m_input.length())
+    {
+        size_t lineEnd = m_input.find('\n', lineBegin);
+        if (lineEnd == std::string::npos)
+            lineEnd = m_input.length();
+        AddRecord(lineBegin, lineEnd);
+        lineBegin = lineEnd + 1;
+    }
+}
+
+/**
+ * @brief 按段落拆分
+ */
+void BatchDocument::SplitParagraphs()
+{
+    size_t paragraphBegin = std::string::npos;
+    size_t paragraphEnd = 0;
+    size_t lineBegin = m_contentBegin;
+    while (lineBegin < m_input.length())
+    {
+        size_t lineEnd = m_input.find('\n', lineBegin);
+        if (lineEnd == std::string::npos)
+            lineEnd = m_input.length();
+
+        bool blank = true;
+        for (size_t i = lineBegin; i < lineEnd && blank; ++i)
+            blank = IsBlank(m_input[i]);
+
+        if (blank)
+        {
+            // 空行结束当前段落
+            if (paragraphBegin != std::string::npos)
+                AddRecord(paragraphBegin, paragraphEnd);
+            paragraphBegin = std::string::npos;
+        }
+        else
+        {
+            if (paragraphBegin == std::string::npos)
+                paragraphBegin = lineBegin;
+            paragraphEnd = lineEnd;
+        }
+        lineBegin = lineEnd + 1;
+    }
+    if (paragraphBegin != std::string::npos)
+        AddRecord(paragraphBegin, paragraphEnd);
+}
+
+/**
+ * @brief 去除区间首尾空白后加入记录，全为空白时忽略
+ * @param begin 起始位置
+ * @param end 结束位置
+ */
+void BatchDocument::AddRecord(size_t begin, size_t end)
+{
+    while (begin < end && IsBlank(m_input[begin]))
+        ++begin;
+    while (end > begin && IsBlank(m_input[end - 1]))
+        --end;
+    if (begin < end)
+        m_records.push_back(Record{ begin, end, false, false, std::string() });
+}
+
+/**
+ * @brief 获取记录原文
+ * @param index 记录索引
+ * @return 原文（UTF-8）
+ */
+std::string BatchDocument::GetRecord(size_t index) const
+{
+    const Record& record = m_records[index];
+    return m_input.substr(record.begin, record.end - record.begin);
+}
+
+/**
+ * @brief 记录翻译完成
+ * @param index 记录索引
+ * @param success 是否成功
+ * @param result 译文（UTF-8），失败时忽略
+ */
+void BatchDocument::Complete(size_t index, bool success, std::string result)
+{
+    if (success && m_split == BatchSplit::Lines)
+    {
+        // 一行原文只能对应一行译文
+        size_t write = 0;
+        for (size_t read = 0; read < result.length(); ++read)
+        {
+            char ch = result[read];
+            if (ch == '\r' || ch == '\n')
+            {
+                if (write > 0 && result[write - 1] != ' ')
+                    result[write++] = ' ';
+                continue;
+            }
+            result[write++] = ch;
+        }
+        while (write > 0 && result[write - 1] == ' ')
+            --write;
+        result.resize(write);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Record& record = m_records[index];
+        if (record.done)
+            return;
+        record.done = true;
+        record.success = success && !result.empty();
+        if (record.success)
+            record.result = std::move(result);
+        else
+            ++m_failed;
+        ++m_completed;
+    }
+    m_progress.notify_all();
+}
+
+/**
+ * @brief 取出按顺序已连续完成的输出
+ * @param out 追加到的输出
+ * @return 本次取出的记录数
+ */
+size_t BatchDocument::TakeReady(std::string& out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t taken = 0;
+    while (m_nextFlush < m_records.size() && m_records[m_nextFlush].done)
+    {
+        Record& record = m_records[m_nextFlush];
+        out.append(m_input, m_flushPos, record.begin - m_flushPos);
+        if (record.success)
+            out += record.result;
+        else
+            out.append(m_input, record.begin, record.end - record.begin);
+        m_flushPos = record.end;
+        std::string().swap(record.result);
+        ++m_nextFlush;
+        ++taken;
+    }
+
+    if (m_nextFlush == m_records.size() && !m_tailFlushed)
+    {
+        out.append(m_input, m_flushPos, std::string::npos);
+        m_flushPos = m_input.length();
+        m_tailFlushed = true;
+    }
+    return taken;
+}
+
+/**
+ * @brief 等待新的记录完成
+ * @param timeout 最长等待时间
+ * @return 等待期间有记录完成或已全部完成返回true
+ */
+bool BatchDocument::WaitForProgress(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    size_t completed = m_completed;
+    return m_progress.wait_for(lock, timeout, [&]
+    {
+        return m_completed != completed || m_completed == m_records.size();
+    });
+}
+
+/**
+ * @brief 获取已完成的记录数
+ * @return 记录数
+ */
+size_t BatchDocument::GetCompletedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_completed;
+}
+
+/**
+ * @brief 获取失败的记录数
+ * @return 记录数
+ */
+size_t BatchDocument::GetFailedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+/**
+ * @brief 是否全部记录都已完成并取出
+ * @return 全部取出返回true
+ */
+bool BatchDocument::IsFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tailFlushed;
+}
@@ -0,0 +1,529 @@
+﻿#include "BatchRunner.h"
+#include "TranslationManager.h"
+#include "TranslationService.h"
+#include "TranslationHistory.h"
+#include "ConfigManager.h"
+#include "AppConfig.h"
+#include "RateLimiter.h"
+#include "RequestScheduler.h"
+#include "Glossary.h"
+#include "TextEncoding.h"
+#include "TranslationMemory.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <fstream>
+#include <filesystem>
+
+// 静态成员变量定义
+HANDLE BatchRunner::s_hInput = nullptr;
+HANDLE BatchRunner::s_hOutput = nullptr;
+HANDLE BatchRunner::s_hError = nullptr;
+std::atomic<bool> BatchRunner::s_bInterrupted{ false };
+std::atomic<size_t> BatchRunner::s_cacheHits{ 0 };
+std::atomic<size_t> BatchRunner::s_requests{ 0 };
+std::wstring BatchRunner::s_firstError;
+std::mutex BatchRunner::s_errorMutex;
+
+// 当日用量文件名（与常驻实例共用）
+static const wchar_t* QUOTA_FILE_NAME = L"YunsioTranslation.quota";
+
+// 并发请求数上限
+static const int MAX_JOBS = 32;
+
+// 进度刷新间隔（毫秒）
+static const int PROGRESS_INTERVAL_MS = 500;
+
+// Ctrl+C后等待进行中的请求返回的最长时间
+static const std::chrono::milliseconds INTERRUPT_CANCEL_TIMEOUT(2000);
+
+// 退出码
+static const int EXIT_OK = 0;
+static const int EXIT_USAGE = 1;
+static const int EXIT_PARTIAL = 2;
+static const int EXIT_INTERRUPTED = 3;
+
+static const wchar_t* USAGE_TEXT =
+    L"用法：YunsioTranslation.exe --batch [选项] [输入文件|-]...\n"
+    L"  --profile 名称    使用的翻译配置档（默认第一个）\n"
+    L"  --jobs N          并发请求数，1-32（默认4）\n"
+    L"  --paragraphs      以空行分隔的段落为一条记录（默认每个非空行一条）\n"
+    L"  --output 文件     写入文件（只能有一个输入，默认写到标准输出）\n"
+    L"  --record 文件     把API请求和响应（含分块和耗时，密钥已脱敏）录制到文件\n"
+    L"  --replay 文件     不访问网络，由录制文件应答请求（不需要API密钥）\n"
+    L"  --replay-scale X  回放耗时系数，1按录制时的耗时（默认），0不等待\n"
+    L"没有输入文件或输入为 - 时读取标准输入；翻译失败的记录输出原文\n";
+
+/**
+ * @brief 判断命令行是否请求批量模式
+ * @param argc 参数个数
+ * @param argv 参数
+ * @return 第一个参数为--batch时返回true
+ */
+bool BatchRunner::IsBatchCommand(int argc, wchar_t** argv)
+{
+    return argc >= 2 && wcscmp(argv[1], L"--batch") == 0;
+}
+
+/**
+ * @brief 解析命令行
+ * @param argc 参数个数
+ * @param argv 参数
+ * @param options 输出选项
+ * @param error 失败时输出错误描述
+ * @return 成功返回true
+ */
+bool BatchRunner::ParseOptions(int argc, wchar_t** argv, Options& options, std::wstring& error)
+{
+    for (int i = 2; i < argc; ++i)
+    {
+        std::wstring arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == L"--profile" && hasValue)
+        {
+            options.profile = TextEncoding::WideToUtf8(argv[++i]);
+        }
+        else if (arg == L"--jobs" && hasValue)
+        {
+            wchar_t* end = nullptr;
+            long jobs = wcstol(argv[++i], &end, 10);
+            if (end == nullptr || *end != L'\0' || jobs < 1 || jobs > MAX_JOBS)
+            {
+                error = L"--jobs 应为 1 到 32 之间的整数";
+                return false;
+            }
+            options.jobs = static_cast<int>(jobs);
+        }
+        else if (arg == L"--paragraphs")
+        {
+            options.split = BatchSplit::Paragraphs;
+        }
+        else if (arg == L"--output" && hasValue)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == L"--record" && hasValue)
+        {
+            options.record = argv[++i];
+        }
+        else if (arg == L"--replay" && hasValue)
+        {
+            options.replay = argv[++i];
+        }
+        else if (arg == L"--replay-scale" && hasValue)
+        {
+            wchar_t* end = nullptr;
+            double scale = wcstod(argv[++i], &end);
+            if (end == nullptr || *end != L'\0' || !(scale >= 0 && scale <= 100))
+            {
+                error = L"--replay-scale 应为 0 到 100 之间的数";
+                return false;
+            }
+            options.replayScale = scale;
+        }
+        else if (arg == L"-" || arg.compare(0, 1, L"-") != 0)
+        {
+            options.inputs.push_back(arg);
+        }
+        else
+        {
+            error = L"无法识别的参数：" + arg;
+            return false;
+        }
+    }
+
+    if (options.inputs.empty())
+        options.inputs.push_back(L"-");
+    if (!options.output.empty() && options.inputs.size() > 1)
+    {
+        error = L"--output 只能用于一个输入";
+        return false;
+    }
+    if (!options.record.empty() && !options.replay.empty())
+    {
+        error = L"--record 和 --replay 不能同时使用";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 连接到父进程的控制台并取得标准输入输出句柄
+ *
+ * 窗口程序的标准句柄只在被重定向时有效；未重定向的句柄在连接父进程控制台后改用控制台设备
+ */
+void BatchRunner::AttachStdHandles()
+{
+    s_hInput = GetStdHandle(STD_INPUT_HANDLE);
+    s_hOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+    s_hError = GetStdHandle(STD_ERROR_HANDLE);
+
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+        return;
+
+    auto openConsole = [](const wchar_t* device, DWORD access)
+    {
+        HANDLE handle = CreateFileW(device, access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        return handle == INVALID_HANDLE_VALUE ? nullptr : handle;
+    };
+    if (s_hInput == nullptr || s_hInput == INVALID_HANDLE_VALUE)
+        s_hInput = openConsole(L"CONIN$", GENERIC_READ | GENERIC_WRITE);
+    if (s_hOutput == nullptr || s_hOutput == INVALID_HANDLE_VALUE)
+        s_hOutput = openConsole(L"CONOUT$", GENERIC_READ | GENERIC_WRITE);
+    if (s_hError == nullptr || s_hError == INVALID_HANDLE_VALUE)
+        s_hError = openConsole(L"CONOUT$", GENERIC_READ | GENERIC_WRITE);
+}
+
+/**
+ * @brief 读取输入文件或标准输入
+ * @param input 文件路径，"-"表示标准输入
+ * @param text 输出内容（UTF-8）
+ * @return 成功返回true
+ */
+bool BatchRunner::ReadInput(const std::wstring& input, std::string& text)
+{
+    text.clear();
+    if (input != L"-")
+    {
+        std::ifstream file(std::filesystem::path(input), std::ios::binary);
+        if (!file)
+            return false;
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !file.bad();
+    }
+
+    if (s_hInput == nullptr || s_hInput == INVALID_HANDLE_VALUE)
+        return false;
+
+    // 控制台输入按UTF-16读取（以Ctrl+Z结束），管道和重定向的文件按原始字节读取
+    DWORD mode = 0;
+    if (GetConsoleMode(s_hInput, &mode))
+    {
+        std::wstring wideText;
+        wchar_t buffer[4096];
+        DWORD read = 0;
+        while (ReadConsoleW(s_hInput, buffer, ARRAYSIZE(buffer), &read, nullptr) && read > 0)
+        {
+            wideText.append(buffer, read);
+            size_t eof = wideText.find(L'\x1A');
+            if (eof != std::wstring::npos)
+            {
+                wideText.resize(eof);
+                break;
+            }
+        }
+        return TextEncoding::WideToUtf8(wideText, text);
+    }
+
+    char buffer[65536];
+    DWORD read = 0;
+    while (ReadFile(s_hInput, buffer, sizeof(buffer), &read, nullptr) && read > 0)
+        text.append(buffer, read);
+    return true;
+}
+
+/**
+ * @brief 写出UTF-8文本
+ * @param handle 目标句柄
+ * @param text UTF-8文本
+ * @return 成功返回true
+ */
+bool BatchRunner::WriteText(HANDLE handle, const std::string& text)
+{
+    if (handle == nullptr || handle == INVALID_HANDLE_VALUE)
+        return false;
+    if (text.empty())
+        return true;
+
+    DWORD mode = 0;
+    if (GetConsoleMode(handle, &mode))
+    {
+        std::wstring wideText;
+        TextEncoding::Utf8ToWide(text.data(), text.length(), wideText);
+        DWORD written = 0;
+        return WriteConsoleW(handle, wideText.data(), static_cast<DWORD>(wideText.length()), &written, nullptr) != FALSE;
+    }
+
+    size_t offset = 0;
+    while (offset < text.length())
+    {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(text.length() - offset, 1 << 20));
+        DWORD written = 0;
+        if (!WriteFile(handle, text.data() + offset, chunk, &written, nullptr) || written == 0)
+            return false;
+        offset += written;
+    }
+    return true;
+}
+
+/**
+ * @brief 向标准错误写出一行提示
+ * @param text 提示文本
+ */
+void BatchRunner::WriteError(const std::wstring& text)
+{
+    WriteText(s_hError, TextEncoding::WideToUtf8(text + L"\n"));
+}
+
+/**
+ * @brief 控制台Ctrl+C处理：请求停止
+ * @param ctrlType 事件类型
+ * @return 已处理返回TRUE
+ */
+BOOL WINAPI BatchRunner::ConsoleCtrlHandler(DWORD ctrlType)
+{
+    if (ctrlType != CTRL_C_EVENT && ctrlType != CTRL_BREAK_EVENT)
+        return FALSE;
+    s_bInterrupted = true;
+    return TRUE;
+}
+
+/**
+ * @brief 翻译一条记录
+ * @param document 所属文档
+ * @param index 记录索引
+ * @param profile 翻译配置档
+ * @param cancelled 取消信号
+ */
+void BatchRunner::TranslateRecord(BatchDocument& document, size_t index, const TranslationProfile& profile,
+    const std::atomic<bool>& cancelled)
+{
+    std::wstring source = TextEncoding::Utf8ToWide(document.GetRecord(index));
+    std::wstring result;
+    bool cached = false;
+    bool success = TranslationManager::TranslateText(profile, source, result, cached, &cancelled);
+    if (cancelled)
+        return;
+
+    if (success)
+    {
+        if (cached)
+            ++s_cacheHits;
+        else
+            ++s_requests;
+        document.Complete(index, true, TextEncoding::WideToUtf8(result));
+        return;
+    }
+
+    ++s_requests;
+    {
+        std::lock_guard<std::mutex> lock(s_errorMutex);
+        if (s_firstError.empty())
+            s_firstError = result.empty() ? L"未知错误" : result;
+    }
+    document.Complete(index, false, std::string());
+}
+
+/**
+ * @brief 运行批量翻译
+ * @param argc 参数个数
+ * @param argv 参数
+ * @return 进程退出码
+ */
+int BatchRunner::Run(int argc, wchar_t** argv)
+{
+    AttachStdHandles();
+
+    Options options;
+    std::wstring error;
+    if (!ParseOptions(argc, argv, options, error))
+    {
+        WriteError(error);
+        WriteText(s_hError, TextEncoding::WideToUtf8(USAGE_TEXT));
+        return EXIT_USAGE;
+    }
+
+    // 与常驻实例共用配置文件、当日用量文件和翻译历史；配置只读取一次，错误写到标准错误，不弹出对话框也不监视文件
+    std::wstring configError;
+    if (!ConfigManager::LoadOnce(configError))
+    {
+        WriteError(L"配置加载失败（" + ConfigManager::GetConfigPath() + L"）：" + configError);
+        return EXIT_USAGE;
+    }
+
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    std::shared_ptr<const TranslationProfile> profile = options.profile.empty() ?
+        (config->profiles.empty() ? nullptr : config->profiles.front()) : config->FindProfile(options.profile);
+    if (!profile)
+    {
+        WriteError(L"找不到翻译配置档：" + TextEncoding::Utf8ToWide(options.profile));
+        return EXIT_USAGE;
+    }
+
+    // 回放不计入当日用量，也不受每分钟配额限制
+    bool capturing = !options.record.empty() || !options.replay.empty();
+    RateLimiter::Initialize(options.replay.empty() ? TextEncoding::WideToUtf8(ConfigManager::GetAppDirectory() + QUOTA_FILE_NAME) : std::string());
+    TranslationManager::ApplyConfig();
+    if (!options.replay.empty())
+        RateLimiter::SetLimits(0, 0);
+    
+    TranslationService::SetCapture(TextEncoding::WideToUtf8(options.record), TextEncoding::WideToUtf8(options.replay), options.replayScale);
+    if (!TranslationService::Initialize())
+    {
+        WriteError(capturing ? L"翻译服务初始化失败（无法打开录制或回放文件）" : L"翻译服务初始化失败");
+        RateLimiter::Cleanup();
+        return EXIT_USAGE;
+    }
+    
+    // 录制和回放时请求内容只取决于输入：不用翻译历史预热缓存，不附带翻译记忆的参考译文
+    if (capturing)
+        TranslationMemory::SetCapacity(0);
+    else
+        TranslationHistory::Initialize();
+    TranslationManager::LoadGlossary();
+
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+
+    // 需要请求的记录作为交互请求，并发数由--jobs决定；每分钟配额只在本进程内计数，当日用量与常驻实例合并保存
+    RequestScheduler scheduler;
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = options.jobs;
+    scheduler.Start(limits);
+
+    DWORD consoleMode = 0;
+    bool showProgress = s_hError != nullptr && GetConsoleMode(s_hError, &consoleMode);
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    size_t totalRecords = 0;
+    size_t totalFailed = 0;
+    uint64_t totalBytes = 0;
+    bool writeFailed = false;
+
+    for (const std::wstring& input : options.inputs)
+    {
+        if (s_bInterrupted)
+            break;
+
+        std::string text;
+        if (!ReadInput(input, text))
+        {
+            WriteError(L"无法读取：" + input);
+            writeFailed = true;
+            continue;
+        }
+        totalBytes += text.length();
+
+        HANDLE hOutput = s_hOutput;
+        bool ownOutput = false;
+        if (!options.output.empty())
+        {
+            hOutput = CreateFileW(options.output.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (hOutput == INVALID_HANDLE_VALUE)
+            {
+                WriteError(L"无法写入：" + options.output);
+                writeFailed = true;
+                break;
+            }
+            ownOutput = true;
+        }
+
+        // 术语表、缓存和翻译记忆命中的记录直接完成，不占用调度器的并发名额和每分钟配额
+        BatchDocument document(std::move(text), options.split);
+        for (size_t index = 0; index < document.GetRecordCount(); ++index)
+        {
+            std::wstring result;
+            if (TranslationManager::TranslateLocally(*profile, TextEncoding::Utf8ToWide(document.GetRecord(index)), result))
+            {
+                ++s_cacheHits;
+                document.Complete(index, true, TextEncoding::WideToUtf8(result));
+                continue;
+            }
+            scheduler.Submit(RequestPriority::Interactive, [&document, index, profile](const std::atomic<bool>& cancelled)
+            {
+                TranslateRecord(document, index, *profile, cancelled);
+                return true;
+            });
+        }
+
+        // 主线程按顺序写出已完成的前缀，并定期刷新进度
+        std::string ready;
+        std::chrono::steady_clock::time_point lastProgress = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point lastFlush = lastProgress;
+        while (!document.IsFinished() && !s_bInterrupted)
+        {
+            document.WaitForProgress(std::chrono::milliseconds(PROGRESS_INTERVAL_MS));
+            ready.clear();
+            document.TakeReady(ready);
+            if (!WriteText(hOutput, ready))
+                writeFailed = true;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (showProgress && now - lastProgress >= std::chrono::milliseconds(PROGRESS_INTERVAL_MS))
+            {
+                double seconds = std::chrono::duration<double>(now - startTime).count();
+                size_t done = totalRecords + document.GetCompletedCount();
+                wchar_t progress[128];
+                swprintf(progress, ARRAYSIZE(progress), L"\r%zu/%zu 条  失败 %zu  %.1f 条/秒   ",
+                    document.GetCompletedCount(), document.GetRecordCount(), document.GetFailedCount(),
+                    seconds > 0 ? done / seconds : 0.0);
+                WriteText(s_hError, TextEncoding::WideToUtf8(progress));
+                lastProgress = now;
+            }
+
+            // 当日用量由主线程定期保存，工作线程记录用量时不等待文件读写
+            if (now - lastFlush >= std::chrono::milliseconds(RateLimiter::FLUSH_INTERVAL_MS))
+            {
+                RateLimiter::Flush();
+                lastFlush = now;
+            }
+        }
+        if (showProgress)
+            WriteText(s_hError, "\r\n");
+
+        totalRecords += document.GetCompletedCount();
+        totalFailed += document.GetFailedCount();
+
+        // 中断时取消进行中的请求，只写出按顺序连续完成的部分；请求仍阻塞时文档不能释放，直接结束进程
+        if (s_bInterrupted)
+        {
+            bool stopped = scheduler.Stop(std::chrono::milliseconds::zero(), INTERRUPT_CANCEL_TIMEOUT);
+            ready.clear();
+            document.TakeReady(ready);
+            WriteText(hOutput, ready);
+            if (!stopped)
+            {
+                WriteError(L"已中断");
+                RateLimiter::Cleanup();
+                TerminateProcess(GetCurrentProcess(), EXIT_INTERRUPTED);
+            }
+        }
+        if (ownOutput)
+            CloseHandle(hOutput);
+    }
+
+    scheduler.Stop(std::chrono::milliseconds::zero(), INTERRUPT_CANCEL_TIMEOUT);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    // 进程CPU时间（用户态加内核态），回放时用于比较两个版本的开销
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    double cpuSeconds = 0;
+    if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        ULARGE_INTEGER kernel = { { kernelTime.dwLowDateTime, kernelTime.dwHighDateTime } };
+        ULARGE_INTEGER user = { { userTime.dwLowDateTime, userTime.dwHighDateTime } };
+        cpuSeconds = (kernel.QuadPart + user.QuadPart) / 1e7;
+    }
+    
+    wchar_t summary[256];
+    swprintf(summary, ARRAYSIZE(summary),
+        L"完成 %zu 条：请求 %zu，缓存命中 %zu，失败 %zu；用时 %.2f 秒（CPU %.2f 秒），%.1f 条/秒，%.1f KB/秒",
+        totalRecords, s_requests.load(), s_cacheHits.load(), totalFailed, seconds, cpuSeconds,
+        seconds > 0 ? totalRecords / seconds : 0.0, seconds > 0 ? totalBytes / 1024.0 / seconds : 0.0);
+    WriteError(summary);
+    if (!options.replay.empty() && Instrumentation::GetCounter("replay.missed") > 0)
+        WriteError(L"录制文件中没有的请求：" + std::to_wstring(Instrumentation::GetCounter("replay.missed")) + L" 个（输入、配置档或提示词与录制时不同）");
+    if (totalFailed > 0)
+        WriteError(L"首个失败原因：" + s_firstError);
+
+    TranslationService::Cleanup();
+    TranslationHistory::Cleanup();
+    RateLimiter::Cleanup();
+    Glossary::Publish(nullptr);
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, FALSE);
+
+    if (s_bInterrupted)
+        return EXIT_INTERRUPTED;
+    return totalFailed > 0 || writeFailed ? EXIT_PARTIAL : EXIT_OK;
+}
@@ -0,0 +1,580 @@
+﻿#include "CodeLexer.h"
+#include <cstring>
+
+const char* const CodeLexer::BATCH_SYSTEM_PROMPT = "You translate comments and string literals extracted from source code. Each input line is N|text. Translate every text (Chinese into English, English into Chinese) and output exactly one line N|translation per input line, with the same numbers in the same order and nothing else. Keep identifiers, placeholders such as %d, {0} or ${name}, escape sequences such as \\n, and URLs unchanged.";
+
+namespace
+{
+    inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    inline bool IsAsciiLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+    inline bool IsIdentifierChar(char c)
+    {
+        return IsAsciiLetter(c) || (c >= '0' && c <= '9') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    inline bool IsCodePunctuation(char c)
+    {
+        return c == ';' || c == '{' || c == '}' || c == '=' || c == '(' || c == ')';
+    }
+
+    inline size_t LineEnd(const std::string& text, size_t pos)
+    {
+        size_t end = text.find('\n', pos);
+        return end == std::string::npos ? text.length() : end;
+    }
+
+    // 去除首尾空白后非空则加入片段
+    void AddSegment(const std::string& text, size_t begin, size_t end, CodeSegmentKind kind, char quote,
+        std::vector<CodeSegment>& segments)
+    {
+        while (begin < end && IsSpace(text[begin]))
+            begin++;
+        while (end > begin && IsSpace(text[end - 1]))
+            end--;
+        if (begin < end)
+            segments.push_back({ begin, end, kind, quote });
+    }
+
+    // 跨行区域按行拆分，块注释还去除行首的星号
+    void AddLines(const std::string& text, size_t begin, size_t end, CodeSegmentKind kind, char quote,
+        std::vector<CodeSegment>& segments)
+    {
+        while (begin < end)
+        {
+            size_t lineEnd = text.find('\n', begin);
+            if (lineEnd == std::string::npos || lineEnd > end)
+                lineEnd = end;
+
+            size_t lineBegin = begin;
+            if (kind == CodeSegmentKind::BlockComment)
+            {
+                while (lineBegin < lineEnd && IsSpace(text[lineBegin]))
+                    lineBegin++;
+                while (lineBegin < lineEnd && text[lineBegin] == '*')
+                    lineBegin++;
+            }
+            AddSegment(text, lineBegin, lineEnd, kind, quote, segments);
+            begin = lineEnd + 1;
+        }
+    }
+
+    // 查找引号结束位置（反斜杠转义下一个字符）；allowNewline为false时遇到换行视为未结束
+    size_t FindClosingQuote(const std::string& text, size_t pos, char quote, bool allowNewline)
+    {
+        for (; pos < text.length(); ++pos)
+        {
+            char c = text[pos];
+            if (c == '\\')
+                pos++;
+            else if (c == quote)
+                return pos;
+            else if (c == '\n' && !allowNewline)
+                return std::string::npos;
+        }
+        return std::string::npos;
+    }
+
+    // 含字母的字节数（非ASCII字节计入，一个汉字计为多个）
+    size_t CountLetters(const std::string& text, const CodeSegment& segment)
+    {
+        size_t count = 0;
+        for (size_t i = segment.begin; i < segment.end; ++i)
+        {
+            if (IsAsciiLetter(text[i]) || static_cast<unsigned char>(text[i]) >= 0x80)
+                count++;
+        }
+        return count;
+    }
+
+    // 字符串是否像自然语言：含非ASCII字符，或含空格分隔的单词
+    bool LooksLikeProse(const std::string& text, const CodeSegment& segment)
+    {
+        bool hasSpace = false;
+        for (size_t i = segment.begin; i < segment.end; ++i)
+        {
+            if (static_cast<unsigned char>(text[i]) >= 0x80)
+                return true;
+            if (text[i] == ' ')
+                hasSpace = true;
+        }
+        // 插值字符串的表达式部分不能交给模型
+        if (segment.kind == CodeSegmentKind::String && segment.quote == '`' &&
+            text.find("${", segment.begin) < segment.end)
+        {
+            return false;
+        }
+        return hasSpace && CountLetters(text, segment) >= 2;
+    }
+
+    // 行首的关键字（其后须为空格或左括号）
+    bool StartsWithKeyword(const std::string& text, size_t first, size_t last)
+    {
+        static const char* const keywords[] =
+        {
+            "if", "else", "for", "while", "do", "switch", "case", "return", "def", "class", "struct", "enum",
+            "elif", "try", "except", "catch", "with", "import", "from", "using", "namespace", "function",
+            "const", "let", "var", "public", "private", "protected", "static", "void"
+        };
+        for (const char* keyword : keywords)
+        {
+            size_t length = std::strlen(keyword);
+            if (first + length < last && text.compare(first, length, keyword) == 0 &&
+                (text[first + length] == ' ' || text[first + length] == '('))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 行首是调用或赋值：标识符（可带.和->）后紧跟左括号，或后跟=、+=等（不含==）
+    bool StartsWithStatement(const std::string& text, size_t first, size_t last)
+    {
+        size_t pos = first;
+        if (pos >= last || !(IsAsciiLetter(text[pos]) || text[pos] == '_'))
+            return false;
+        while (pos < last && (IsAsciiLetter(text[pos]) || (text[pos] >= '0' && text[pos] <= '9') || text[pos] == '_' ||
+            text[pos] == '.' || (text[pos] == '-' && pos + 1 < last && text[pos + 1] == '>') || (text[pos] == '>' && text[pos - 1] == '-')))
+        {
+            pos++;
+        }
+        if (pos < last && text[pos] == '(')
+            return true;
+        while (pos < last && text[pos] == ' ')
+            pos++;
+        if (pos < last && std::strchr("+-*/|&", text[pos]) != nullptr)
+            pos++;
+        return pos + 1 < last && text[pos] == '=' && text[pos + 1] != '=';
+    }
+
+    /**
+     * @brief 判断一行是否有代码特征：注释行、以 ; { } 结尾、关键字开头的语句头、行首的调用或赋值
+     * @param inComment 整行位于块注释或三引号字符串中
+     */
+    bool IsCodeLine(const std::string& text, size_t first, size_t last, CodeLanguage language, bool inComment)
+    {
+        if (inComment || text.compare(first, 2, "//") == 0 || text.compare(first, 2, "/*") == 0 ||
+            text.compare(first, 2, "*/") == 0 || (text[first] == '*' && first + 1 == last) ||
+            (language == CodeLanguage::Python && text[first] == '#'))
+        {
+            return true;
+        }
+        char tail = text[last - 1];
+        if (tail == ';' || tail == '{' || tail == '}')
+            return true;
+        if (StartsWithKeyword(text, first, last) && (tail == ':' || tail == ')' || language == CodeLanguage::Python))
+            return true;
+        return StartsWithStatement(text, first, last);
+    }
+
+    /**
+     * @brief 统计有代码特征的行数
+     * @param segments Lex的结果（过滤前，用于识别块注释内部的行）
+     * @param lines 输出非空行数
+     * @return 有代码特征的行数
+     */
+    size_t CountCodeLines(const std::string& text, CodeLanguage language, const std::vector<CodeSegment>& segments, size_t& lines)
+    {
+        size_t codeLines = 0;
+        size_t next = 0;
+        lines = 0;
+        size_t lineStart = 0;
+        while (lineStart < text.length())
+        {
+            size_t lineEnd = LineEnd(text, lineStart);
+            size_t first = lineStart;
+            while (first < lineEnd && IsSpace(text[first]))
+                first++;
+            size_t last = lineEnd;
+            while (last > first && IsSpace(text[last - 1]))
+                last--;
+
+            if (first < last)
+            {
+                // 块注释和三引号字符串按行拆分，片段之前只有星号、注释或引号标记说明整行在其中
+                while (next < segments.size() && segments[next].begin < first)
+                    next++;
+                bool inComment = false;
+                if (next < segments.size() && segments[next].begin < last &&
+                    (segments[next].kind == CodeSegmentKind::BlockComment || segments[next].kind == CodeSegmentKind::TextBlock))
+                {
+                    inComment = true;
+                    for (size_t pos = first; pos < segments[next].begin; ++pos)
+                        inComment = inComment && std::strchr(" \t*/!\"'", text[pos]) != nullptr;
+                }
+                // 行尾注释之前的部分才是这一行的代码（int x = 0; // 说明）
+                size_t codeLast = last;
+                for (size_t k = next; !inComment && k < segments.size() && segments[k].begin < last; ++k)
+                {
+                    if (segments[k].kind != CodeSegmentKind::LineComment)
+                        continue;
+                    size_t marker = language == CodeLanguage::Python ? text.rfind('#', segments[k].begin) : text.rfind("//", segments[k].begin);
+                    if (marker != std::string::npos && marker > first)
+                    {
+                        codeLast = marker;
+                        while (codeLast > first && IsSpace(text[codeLast - 1]))
+                            codeLast--;
+                    }
+                    break;
+                }
+                lines++;
+                if (IsCodeLine(text, first, codeLast, language, inComment))
+                    codeLines++;
+            }
+            lineStart = lineEnd + 1;
+        }
+        return codeLines;
+    }
+
+    /**
+     * @brief C系词法分析
+     */
+    bool LexCFamily(const std::string& text, std::vector<CodeSegment>& segments)
+    {
+        bool punctuation = false;
+        size_t i = 0;
+        while (i < text.length())
+        {
+            char c = text[i];
+            char next = i + 1 < text.length() ? text[i + 1] : '\0';
+
+            if (c == '/' && next == '/' && (i == 0 || IsSpace(text[i - 1]) || text[i - 1] == '\n' ||
+                text[i - 1] == ';' || text[i - 1] == '{' || text[i - 1] == '}'))
+            {
+                // 文档注释 /// 和 //! 的标记不属于正文
+                size_t begin = i + 2;
+                while (begin < text.length() && (text[begin] == '/' || text[begin] == '!'))
+                    begin++;
+                size_t end = LineEnd(text, begin);
+                AddSegment(text, begin, end, CodeSegmentKind::LineComment, 0, segments);
+                i = end;
+            }
+            else if (c == '/' && next == '*')
+            {
+                size_t begin = i + 2;
+                while (begin < text.length() && (text[begin] == '*' || text[begin] == '!'))
+                    begin++;
+                size_t close = text.find("*/", begin);
+                size_t end = close == std::string::npos ? text.length() : close;
+                AddLines(text, begin, end, CodeSegmentKind::BlockComment, 0, segments);
+                i = close == std::string::npos ? text.length() : close + 2;
+            }
+            else if (c == '"' && i > 0 && text[i - 1] == 'R' && (i == 1 || !IsIdentifierChar(text[i - 2]) ||
+                text[i - 2] == '8' || text[i - 2] == 'L' || text[i - 2] == 'u' || text[i - 2] == 'U'))
+            {
+                // C++原始字符串 R"delim(...)delim"：整体跳过
+                size_t open = text.find('(', i + 1);
+                if (open == std::string::npos)
+                {
+                    i++;
+                    continue;
+                }
+                std::string terminator = ")" + text.substr(i + 1, open - i - 1) + "\"";
+                size_t close = text.find(terminator, open + 1);
+                i = close == std::string::npos ? text.length() : close + terminator.length();
+            }
+            else if (c == '"' && i > 0 && text[i - 1] == '@')
+            {
+                // C#逐字字符串 @"..."：没有转义，"" 表示一个引号
+                size_t pos = i + 1;
+                while (pos < text.length() && !(text[pos] == '"' && (pos + 1 >= text.length() || text[pos + 1] != '"')))
+                    pos += text[pos] == '"' ? 2 : 1;
+                AddLines(text, i + 1, pos, CodeSegmentKind::VerbatimString, '"', segments);
+                i = pos + 1;
+            }
+            else if (c == '"' || c == '`' || (c == '\'' && (i == 0 || !IsIdentifierChar(text[i - 1]))))
+            {
+                // 数字分隔符 1'000 和英文缩写中的撇号不是字符字面量
+                size_t close = FindClosingQuote(text, i + 1, c, c == '`');
+                if (close == std::string::npos)
+                {
+                    i++;
+                    continue;
+                }
+                if (c == '`')
+                    AddLines(text, i + 1, close, CodeSegmentKind::String, c, segments);
+                else
+                    AddSegment(text, i + 1, close, CodeSegmentKind::String, c, segments);
+                i = close + 1;
+            }
+            else
+            {
+                punctuation = punctuation || IsCodePunctuation(c);
+                i++;
+            }
+        }
+        return punctuation;
+    }
+
+    /**
+     * @brief Python词法分析
+     */
+    bool LexPython(const std::string& text, std::vector<CodeSegment>& segments)
+    {
+        bool punctuation = false;
+        size_t i = 0;
+        while (i < text.length())
+        {
+            char c = text[i];
+            if (c == '#')
+            {
+                size_t begin = i + 1;
+                while (begin < text.length() && (text[begin] == '#' || text[begin] == '!'))
+                    begin++;
+                size_t end = LineEnd(text, begin);
+                AddSegment(text, begin, end, CodeSegmentKind::LineComment, 0, segments);
+                i = end;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                // 字符串前缀（r、b、f、u及组合）紧邻引号；f字符串含表达式，不翻译
+                size_t prefixBegin = i;
+                while (prefixBegin > 0 && IsAsciiLetter(text[prefixBegin - 1]) && i - prefixBegin < 2)
+                    prefixBegin--;
+                bool formatted = false;
+                for (size_t p = prefixBegin; p < i; ++p)
+                    formatted = formatted || text[p] == 'f' || text[p] == 'F';
+
+                if (text.compare(i, 3, std::string(3, c)) == 0)
+                {
+                    std::string triple(3, c);
+                    size_t close = std::string::npos;
+                    for (size_t pos = i + 3; pos < text.length(); ++pos)
+                    {
+                        if (text[pos] == '\\')
+                            pos++;
+                        else if (text.compare(pos, 3, triple) == 0)
+                        {
+                            close = pos;
+                            break;
+                        }
+                    }
+                    size_t end = close == std::string::npos ? text.length() : close;
+                    if (!formatted)
+                        AddLines(text, i + 3, end, CodeSegmentKind::TextBlock, c, segments);
+                    i = close == std::string::npos ? text.length() : close + 3;
+                }
+                else
+                {
+                    size_t close = FindClosingQuote(text, i + 1, c, false);
+                    if (close == std::string::npos)
+                    {
+                        i++;
+                        continue;
+                    }
+                    if (!formatted)
+                        AddSegment(text, i + 1, close, CodeSegmentKind::String, c, segments);
+                    i = close + 1;
+                }
+            }
+            else
+            {
+                punctuation = punctuation || IsCodePunctuation(c);
+                i++;
+            }
+        }
+        return punctuation;
+    }
+}
+
+/**
+ * @brief 根据特征猜测语言
+ * @param text UTF-8文本
+ * @return 语言
+ */
+CodeLanguage CodeLexer::DetectLanguage(const std::string& text)
+{
+    int python = 0;
+    int cFamily = 0;
+    size_t lineStart = 0;
+    while (lineStart < text.length())
+    {
+        size_t lineEnd = LineEnd(text, lineStart);
+        size_t first = lineStart;
+        while (first < lineEnd && IsSpace(text[first]))
+            first++;
+        size_t last = lineEnd;
+        while (last > first && IsSpace(text[last - 1]))
+            last--;
+
+        if (first < last)
+        {
+            // 预处理指令不是Python注释
+            static const char* const directives[] = { "#include", "#define", "#if", "#pragma", "#region", "#endregion", "#else", "#endif", "#undef" };
+            bool directive = false;
+            for (const char* name : directives)
+                directive = directive || text.compare(first, std::strlen(name), name) == 0;
+
+            if (text[first] == '#' && !directive) python++;
+            if (directive) cFamily++;
+            if (text.compare(first, 4, "def ") == 0 || (text.compare(first, 6, "class ") == 0 && text[last - 1] == ':')) python++;
+            if (text.compare(first, 7, "import ") == 0 || text.compare(first, 5, "from ") == 0 || text.compare(first, 5, "elif ") == 0) python++;
+            if (text[last - 1] == ':' && text.compare(first, 4, "case") != 0 && text.compare(first, 7, "default") != 0) python++;
+            if (text[last - 1] == ';' || text[last - 1] == '{' || text[last - 1] == '}') cFamily++;
+            if (text.compare(first, 2, "//") == 0 || text.compare(first, 2, "/*") == 0) cFamily++;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return python > cFamily ? CodeLanguage::Python : CodeLanguage::CFamily;
+}
+
+/**
+ * @brief 词法分析，输出全部注释和字符串片段
+ * @param text UTF-8文本
+ * @param language 语言
+ * @param segments 输出片段
+ * @return 注释和字符串之外出现了代码标点返回true
+ */
+bool CodeLexer::Lex(const std::string& text, CodeLanguage language, std::vector<CodeSegment>& segments)
+{
+    segments.clear();
+    return language == CodeLanguage::Python ? LexPython(text, segments) : LexCFamily(text, segments);
+}
+
+/**
+ * @brief 判断选中文本是否为代码，并输出其中值得翻译的片段
+ * @param text UTF-8文本
+ * @param segments 输出可翻译片段
+ * @return 是代码且至少有一个可翻译片段返回true
+ */
+bool CodeLexer::Analyze(const std::string& text, std::vector<CodeSegment>& segments)
+{
+    CodeLanguage language = DetectLanguage(text);
+    Lex(text, language, segments);
+
+    // 普通文本中的引号、括号和网址也会被识别为字符串、代码标点和注释，
+    // 只有至少一半的行有代码特征时才按代码处理（单行文本须本身像一行代码）
+    size_t lines = 0;
+    size_t codeLines = CountCodeLines(text, language, segments, lines);
+    if (codeLines == 0 || codeLines * 2 < lines)
+    {
+        segments.clear();
+        return false;
+    }
+
+    size_t kept = 0;
+    for (const CodeSegment& segment : segments)
+    {
+        bool comment = segment.kind == CodeSegmentKind::LineComment || segment.kind == CodeSegmentKind::BlockComment;
+        if (comment ? CountLetters(text, segment) >= 2 : LooksLikeProse(text, segment))
+            segments[kept++] = segment;
+    }
+    segments.resize(kept);
+    return kept > 0;
+}
+
+/**
+ * @brief 生成批量请求文本
+ * @param text UTF-8原文
+ * @param segments Analyze的结果
+ * @param batch 输出请求文本
+ */
+void CodeLexer::BuildBatch(const std::string& text, const std::vector<CodeSegment>& segments, std::string& batch)
+{
+    batch.clear();
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        batch += std::to_string(i + 1);
+        batch += '|';
+        batch.append(text, segments[i].begin, segments[i].end - segments[i].begin);
+        batch += '\n';
+    }
+}
+
+/**
+ * @brief 解析批量译文：每行 编号|译文
+ * @param batchResult 模型返回的批量译文
+ * @param count 请求的条数
+ * @param translations 输出每个编号的译文区间
+ * @return 每个编号都有译文返回true
+ */
+bool CodeLexer::ParseBatch(const std::string& batchResult, size_t count, std::vector<std::pair<size_t, size_t>>& translations)
+{
+    translations.assign(count, { std::string::npos, std::string::npos });
+    size_t lineStart = 0;
+    while (lineStart < batchResult.length())
+    {
+        size_t lineEnd = LineEnd(batchResult, lineStart);
+        size_t pos = lineStart;
+        lineStart = lineEnd + 1;
+
+        while (pos < lineEnd && IsSpace(batchResult[pos]))
+            pos++;
+        size_t number = 0;
+        size_t digits = 0;
+        while (pos < lineEnd && batchResult[pos] >= '0' && batchResult[pos] <= '9' && digits < 6)
+        {
+            number = number * 10 + static_cast<size_t>(batchResult[pos] - '0');
+            pos++;
+            digits++;
+        }
+        while (pos < lineEnd && IsSpace(batchResult[pos]))
+            pos++;
+        if (digits == 0 || number == 0 || number > count || pos >= lineEnd || batchResult[pos] != '|')
+            continue;
+
+        size_t begin = pos + 1;
+        size_t end = lineEnd;
+        while (begin < end && IsSpace(batchResult[begin]))
+            begin++;
+        while (end > begin && IsSpace(batchResult[end - 1]))
+            end--;
+        if (begin < end)
+            translations[number - 1] = { begin, end };
+    }
+
+    for (const auto& translation : translations)
+    {
+        if (translation.first == std::string::npos)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 将批量译文按编号写回原文
+ * @param text UTF-8原文
+ * @param segments Analyze的结果
+ * @param batchResult 模型返回的批量译文
+ * @param out 输出写回后的代码
+ * @return 每个片段都有译文返回true
+ */
+bool CodeLexer::Splice(const std::string& text, const std::vector<CodeSegment>& segments,
+    const std::string& batchResult, std::string& out)
+{
+    std::vector<std::pair<size_t, size_t>> translations;
+    if (!ParseBatch(batchResult, segments.size(), translations))
+        return false;
+
+    // 依次复制片段之间的代码和转义后的译文
+    out.clear();
+    out.reserve(text.length() + batchResult.length());
+    size_t position = 0;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const CodeSegment& segment = segments[i];
+        out.append(text, position, segment.begin - position);
+        for (size_t pos = translations[i].first; pos < translations[i].second; ++pos)
+        {
+            char c = batchResult[pos];
+            if (segment.kind == CodeSegmentKind::BlockComment && c == '/' && !out.empty() && out.back() == '*')
+                out += ' ';
+            else if ((segment.kind == CodeSegmentKind::String || segment.kind == CodeSegmentKind::TextBlock) &&
+                c == segment.quote && (pos == translations[i].first || batchResult[pos - 1] != '\\'))
+                out += '\\';
+            else if (segment.kind == CodeSegmentKind::VerbatimString && c == '"')
+            {
+                // 译文中已成对的引号原样保留
+                out += '"';
+                if (pos + 1 < translations[i].second && batchResult[pos + 1] == '"')
+                    pos++;
+            }
+            out += c;
+        }
+        position = segment.end;
+    }
+    out.append(text, position, std::string::npos);
+    return true;
+}
@@ -0,0 +1,232 @@
+﻿#include "ConfigManager.h"
+#include "AppConfig.h"
+#include "TextEncoding.h"
+
+// 静态成员变量定义
+std::wstring ConfigManager::s_configPath;
+HANDLE ConfigManager::s_hWatchThread = nullptr;
+HANDLE ConfigManager::s_hStopEvent = nullptr;
+DWORD ConfigManager::s_notifyThreadId = 0;
+FILETIME ConfigManager::s_lastWriteTime = {};
+bool ConfigManager::s_bInitialized = false;
+
+// 配置文件名
+static const wchar_t* CONFIG_FILE_NAME = L"YunsioTranslation.ini";
+
+// 文件变化后等待写入完成的去抖时间（毫秒），编辑器保存时常分多次写入
+static const DWORD RELOAD_DEBOUNCE_MS = 150;
+
+/**
+ * @brief 加载配置并启动文件监视
+ * @param notifyThreadId 配置变化时接收WM_CONFIG_CHANGED的线程ID
+ * @return 成功返回true，失败返回false
+ */
+bool ConfigManager::Initialize(DWORD notifyThreadId)
+{
+    if (s_bInitialized)
+        return true;
+
+    s_notifyThreadId = notifyThreadId;
+    s_configPath = GetAppDirectory() + CONFIG_FILE_NAME;
+
+    WriteDefaultConfigFile();
+
+    // 首次加载失败时沿用默认配置，提示用户修正后保存即可热重载生效
+    std::wstring error;
+    if (!LoadConfigFile(error))
+    {
+        std::wstring message = L"配置文件加载失败，将使用默认配置：\n" + error;
+        MessageBoxW(nullptr, message.c_str(), L"警告", MB_OK | MB_ICONWARNING);
+    }
+
+    s_hStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (s_hStopEvent == nullptr)
+        return false;
+
+    s_hWatchThread = CreateThread(nullptr, 0, WatchThreadProc, nullptr, 0, nullptr);
+    if (s_hWatchThread == nullptr)
+    {
+        CloseHandle(s_hStopEvent);
+        s_hStopEvent = nullptr;
+        return false;
+    }
+
+    s_bInitialized = true;
+    return true;
+}
+
+/**
+ * @brief 只加载一次配置，不写出默认配置、不弹出对话框、不启动文件监视
+ * @param error 失败时输出错误描述
+ * @return 成功返回true，失败返回false
+ */
+bool ConfigManager::LoadOnce(std::wstring& error)
+{
+    s_configPath = GetAppDirectory() + CONFIG_FILE_NAME;
+    return LoadConfigFile(error);
+}
+
+/**
+ * @brief 停止文件监视并释放资源
+ */
+void ConfigManager::Cleanup()
+{
+    if (!s_bInitialized)
+        return;
+
+    SetEvent(s_hStopEvent);
+    WaitForSingleObject(s_hWatchThread, INFINITE);
+    CloseHandle(s_hWatchThread);
+    CloseHandle(s_hStopEvent);
+    s_hWatchThread = nullptr;
+    s_hStopEvent = nullptr;
+
+    s_bInitialized = false;
+}
+
+/**
+ * @brief 获取配置文件完整路径
+ * @return 配置文件路径
+ */
+const std::wstring& ConfigManager::GetConfigPath()
+{
+    return s_configPath;
+}
+
+/**
+ * @brief 获取程序所在目录（以反斜杠结尾）
+ * @return 目录路径
+ */
+std::wstring ConfigManager::GetAppDirectory()
+{
+    wchar_t modulePath[MAX_PATH] = {};
+    DWORD length = GetModuleFileNameW(nullptr, modulePath, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH)
+        return L".\\";
+
+    std::wstring directory(modulePath, length);
+    size_t slash = directory.find_last_of(L"\\/");
+    if (slash == std::wstring::npos)
+        return L".\\";
+    return directory.substr(0, slash + 1);
+}
+
+/**
+ * @brief 读取并解析配置文件，成功后发布到ConfigStore
+ * @param error 失败时输出错误描述
+ * @return 成功返回true，失败返回false
+ */
+bool ConfigManager::LoadConfigFile(std::wstring& error)
+{
+    HANDLE hFile = CreateFileW(s_configPath.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        error = L"无法打开 " + s_configPath;
+        return false;
+    }
+
+    // 先记录修改时间再读取，若读取期间文件又被修改，下一次通知会再次加载
+    FILETIME lastWrite = {};
+    GetFileTime(hFile, nullptr, nullptr, &lastWrite);
+
+    std::string text;
+    LARGE_INTEGER fileSize = {};
+    if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart < 16 * 1024 * 1024)
+    {
+        text.resize(static_cast<size_t>(fileSize.QuadPart));
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile, &text[0], static_cast<DWORD>(text.size()), &bytesRead, nullptr))
+            bytesRead = 0;
+        text.resize(bytesRead);
+    }
+    CloseHandle(hFile);
+
+    AppConfig config = AppConfig::Defaults();
+    std::string parseError;
+    if (!ConfigParser::Parse(text, config, parseError))
+    {
+        error = TextEncoding::Utf8ToWide(parseError);
+        return false;
+    }
+
+    s_lastWriteTime = lastWrite;
+    ConfigStore::Publish(std::make_shared<const AppConfig>(std::move(config)));
+    return true;
+}
+
+/**
+ * @brief 配置文件不存在时写出默认配置
+ */
+void ConfigManager::WriteDefaultConfigFile()
+{
+    HANDLE hFile = CreateFileW(s_configPath.c_str(), GENERIC_WRITE, 0,
+        nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;     // 已存在或目录不可写
+
+    std::string text = "\xEF\xBB\xBF" + ConfigParser::GenerateDefaultText();
+    DWORD bytesWritten = 0;
+    WriteFile(hFile, text.data(), static_cast<DWORD>(text.size()), &bytesWritten, nullptr);
+    CloseHandle(hFile);
+}
+
+/**
+ * @brief 获取配置文件最后修改时间
+ * @param lastWrite 输出修改时间
+ * @return 成功返回true，失败返回false
+ */
+bool ConfigManager::GetLastWriteTime(FILETIME& lastWrite)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    if (!GetFileAttributesExW(s_configPath.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    lastWrite = data.ftLastWriteTime;
+    return true;
+}
+
+/**
+ * @brief 文件监视线程过程
+ * @param param 未使用
+ * @return 线程退出码
+ */
+DWORD WINAPI ConfigManager::WatchThreadProc(LPVOID param)
+{
+    UNREFERENCED_PARAMETER(param);
+
+    std::wstring directory = s_configPath.substr(0, s_configPath.find_last_of(L"\\/") + 1);
+    HANDLE hChange = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (hChange == INVALID_HANDLE_VALUE)
+        return 1;
+
+    HANDLE waitHandles[2] = { s_hStopEvent, hChange };
+    while (WaitForMultipleObjects(2, waitHandles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+    {
+        // 去抖：等待写入完成，期间收到停止信号则直接退出
+        if (WaitForSingleObject(s_hStopEvent, RELOAD_DEBOUNCE_MS) == WAIT_OBJECT_0)
+            break;
+
+        FindNextChangeNotification(hChange);
+
+        FILETIME lastWrite = {};
+        if (!GetLastWriteTime(lastWrite) || CompareFileTime(&lastWrite, &s_lastWriteTime) == 0)
+            continue;   // 目录中其他文件变化，或内容未变
+
+        // 解析失败时保留当前配置，不打断用户
+        std::wstring error;
+        if (LoadConfigFile(error))
+        {
+            PostThreadMessageW(s_notifyThreadId, WM_CONFIG_CHANGED, static_cast<WPARAM>(ConfigStore::Version()), 0);
+        }
+        else
+        {
+            s_lastWriteTime = lastWrite;    // 避免对同一份错误内容反复解析
+            OutputDebugStringW((L"YunsioTranslation: 配置重新加载失败：" + error + L"\n").c_str());
+        }
+    }
+
+    FindCloseChangeNotification(hChange);
+    return 0;
+}
@@ -1,11 +1,31 @@
 ﻿#include "GlobalHotkey.h"
 #include "TranslationManager.h"
+#include "AppConfig.h"
+#include "TextEncoding.h"
+#include "Instrumentation.h"
 
 // 静态成员变量定义
-void(*GlobalHotkey::s_HotkeyCallback)() = nullptr;
+std::atomic<void(*)()> GlobalHotkey::s_HotkeyCallback{ nullptr };
+HotkeyDispatchTable GlobalHotkey::s_table;
+std::vector<bool> GlobalHotkey::s_registered;
 bool GlobalHotkey::s_bInitialized = false;
+ModifierTracker GlobalHotkey::s_tracker;
+std::shared_ptr<const TranslationProfile> GlobalHotkey::s_pPendingProfile;
+HHOOK GlobalHotkey::s_hKeyboardHook = nullptr;
+UINT_PTR GlobalHotkey::s_releaseTimer = 0;
+ULONGLONG GlobalHotkey::s_releaseStart = 0;
 
-// 初始化全局热键监听
+// 等待修饰键释放的最长时间（毫秒），超过后按原方式直接取词
+static const UINT RELEASE_TIMEOUT_MS = 1000;
+
+// 需要等待释放的修饰键：按住Shift、Alt或Win时模拟的Ctrl+C会变成其他快捷键；
+// 按住Ctrl不影响复制（模拟的按键序列本身包含Ctrl），不必等待
+static const uint32_t RELEASE_MODIFIERS = HotkeyBinding::MOD_SHIFT_FLAG | HotkeyBinding::MOD_ALT_FLAG | HotkeyBinding::MOD_WIN_FLAG;
+
+// 需要检查初始状态的修饰键（左右分开）
+static const int RELEASE_KEYS[] = { VK_LSHIFT, VK_RSHIFT, VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU, VK_LWIN, VK_RWIN };
+
+// 初始化全局热键监听（为每个翻译配置档注册一个热键）
 bool GlobalHotkey::Initialize()
 {
     if (s_bInitialized)
@@ -13,26 +33,22 @@ bool GlobalHotkey::Initialize()
         return true;
     }
     
-    // 注册Ctrl+空格热键到当前线程
+    // 注册配置中每个配置档的热键（默认Ctrl+空格）到当前线程
     // 使用NULL作为窗口句柄，热键消息会发送到调用线程的消息队列
-    if (!RegisterHotKey(NULL, HOTKEY_ID, MOD_CONTROL, VK_SPACE))
+    HotkeyDispatchTable table(ConfigStore::Current());
+    std::wstring failedNames;
+    size_t registeredCount = RegisterTable(table, failedNames);
+    if (registeredCount == 0)
     {
-        DWORD error = GetLastError();
-        // 如果热键已被占用，尝试使用不同的ID
-        if (error == ERROR_HOTKEY_ALREADY_REGISTERED)
-        {
-            // 尝试注册到ID 2
-            if (!RegisterHotKey(NULL, HOTKEY_ID + 1, MOD_CONTROL, VK_SPACE))
-            {
-                MessageBoxW(NULL, L"热键注册失败：Ctrl+空格已被其他程序占用", L"错误", MB_OK | MB_ICONWARNING);
-                return false;
-            }
-        }
-        else
-        {
-            MessageBoxW(NULL, L"热键注册失败：未知错误", L"错误", MB_OK | MB_ICONERROR);
-            return false;
-        }
+        MessageBoxW(NULL, L"热键注册失败：热键已被其他程序占用", L"错误", MB_OK | MB_ICONWARNING);
+        return false;
+    }
+    
+    // 部分热键被占用时仍可使用其余配置档
+    if (!failedNames.empty())
+    {
+        std::wstring message = L"以下配置档的热键已被其他程序占用：" + failedNames;
+        MessageBoxW(NULL, message.c_str(), L"警告", MB_OK | MB_ICONWARNING);
     }
     
     s_bInitialized = true;
@@ -47,32 +63,225 @@ void GlobalHotkey::Cleanup()
         return;
     }
     
-    // 取消注册热键（尝试两个可能的ID）
-    UnregisterHotKey(NULL, HOTKEY_ID);
-    UnregisterHotKey(NULL, HOTKEY_ID + 1);
+    UnregisterTable();
+    s_table = HotkeyDispatchTable();
+    
+    // 放弃等待中的热键
+    if (s_hKeyboardHook)
+    {
+        UnhookWindowsHookEx(s_hKeyboardHook);
+        s_hKeyboardHook = nullptr;
+    }
+    if (s_releaseTimer)
+    {
+        KillTimer(nullptr, s_releaseTimer);
+        s_releaseTimer = 0;
+    }
+    s_tracker.Reset();
+    s_pPendingProfile.reset();
     
     s_HotkeyCallback = nullptr;
     s_bInitialized = false;
 }
 
+// 按当前配置重新注册热键（配置热重载后在主线程调用）
+void GlobalHotkey::ApplyConfig()
+{
+    if (!s_bInitialized)
+    {
+        return;
+    }
+    
+    HotkeyDispatchTable table(ConfigStore::Current());
+    
+    // 热键未变化时只替换分发表，使新的配置档（提示词、模型等）立即生效
+    if (table.HasSameBindings(s_table))
+    {
+        s_table = table;
+        return;
+    }
+    
+    // 先释放旧热键再注册新热键；新热键全部不可用时恢复旧热键，保证始终有热键可用
+    HotkeyDispatchTable oldTable = s_table;
+    UnregisterTable();
+    
+    std::wstring failedNames;
+    if (RegisterTable(table, failedNames) == 0)
+    {
+        UnregisterTable();
+        RegisterTable(oldTable, failedNames);
+        OutputDebugStringW(L"YunsioTranslation: 新热键注册失败，继续使用原热键\n");
+    }
+    else if (!failedNames.empty())
+    {
+        OutputDebugStringW((L"YunsioTranslation: 以下配置档的热键注册失败：" + failedNames + L"\n").c_str());
+    }
+}
+
+// 注册分发表中的全部热键
+size_t GlobalHotkey::RegisterTable(const HotkeyDispatchTable& table, std::wstring& failedNames)
+{
+    s_table = table;
+    s_registered.assign(table.GetCount(), false);
+    failedNames.clear();
+    
+    size_t registeredCount = 0;
+    for (size_t i = 0; i < table.GetCount(); i++)
+    {
+        const HotkeyBinding& binding = table.GetBinding(i);
+        if (RegisterHotKey(NULL, table.GetHotkeyId(i), binding.modifiers, binding.virtualKey))
+        {
+            s_registered[i] = true;
+            registeredCount++;
+        }
+        else
+        {
+            if (!failedNames.empty())
+            {
+                failedNames += L"、";
+            }
+            failedNames += TextEncoding::Utf8ToWide(table.Lookup(table.GetHotkeyId(i))->name);
+        }
+    }
+    return registeredCount;
+}
+
+// 取消注册当前分发表中的全部热键
+void GlobalHotkey::UnregisterTable()
+{
+    for (size_t i = 0; i < s_registered.size(); i++)
+    {
+        if (s_registered[i])
+        {
+            UnregisterHotKey(NULL, s_table.GetHotkeyId(i));
+        }
+    }
+    s_registered.clear();
+}
+
 // 设置热键回调函数
 void GlobalHotkey::SetHotkeyCallback(void(*callback)())
 {
     s_HotkeyCallback = callback;
 }
 
-// 处理热键消息（需要在主消息循环中调用）
+// 处理热键消息和修饰键释放消息（需要在主消息循环中调用）
 void GlobalHotkey::ProcessHotkeyMessage(MSG* msg)
 {
-    if (msg->message == WM_HOTKEY && (msg->wParam == HOTKEY_ID || msg->wParam == HOTKEY_ID + 1))
+    if (msg->message == WM_HOTKEY_RELEASED)
+    {
+        if (s_pPendingProfile)
+        {
+            FinishRelease();
+        }
+        return;
+    }
+    
+    if (msg->message != WM_HOTKEY)
+    {
+        return;
+    }
+    
+    // 等待修饰键释放期间按住热键产生的重复消息忽略
+    std::shared_ptr<const TranslationProfile> profile = s_table.Lookup(static_cast<int>(msg->wParam));
+    if (profile && !s_pPendingProfile)
+    {
+        BeginRelease(profile);
+    }
+}
+
+// 热键触发后等待修饰键释放再执行翻译
+void GlobalHotkey::BeginRelease(std::shared_ptr<const TranslationProfile> profile)
+{
+    // 先安装钩子再读取初始状态：两者之间的按键事件在回到消息循环后才送达钩子，不会遗漏
+    s_hKeyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardHookProc, GetModuleHandleW(nullptr), 0);
+    if (!s_hKeyboardHook)
+    {
+        Dispatch(profile);
+        return;
+    }
+    
+    s_releaseStart = GetTickCount64();
+    s_tracker.Arm(s_releaseStart, RELEASE_TIMEOUT_MS, RELEASE_MODIFIERS);
+    for (int key : RELEASE_KEYS)
+    {
+        if (GetAsyncKeyState(key) & 0x8000)
+        {
+            s_tracker.OnKey(static_cast<uint32_t>(key), true);
+        }
+    }
+    
+    s_pPendingProfile = profile;
+    if (s_tracker.OnTick(s_releaseStart) != ModifierTracker::State::Waiting)
+    {
+        FinishRelease();
+        return;
+    }
+    s_releaseTimer = SetTimer(nullptr, 0, RELEASE_TIMEOUT_MS, ReleaseTimerProc);
+}
+
+// 结束等待并执行翻译
+void GlobalHotkey::FinishRelease()
+{
+    UnhookWindowsHookEx(s_hKeyboardHook);
+    s_hKeyboardHook = nullptr;
+    if (s_releaseTimer)
+    {
+        KillTimer(nullptr, s_releaseTimer);
+        s_releaseTimer = 0;
+    }
+    
+    if (s_tracker.GetState() == ModifierTracker::State::TimedOut)
+    {
+        Instrumentation::AddCounter("hotkey.release_timeout");
+    }
+    else
     {
-        // 执行翻译功能
-        TranslationManager::ExecuteTranslation();
-        
-        // 如果有回调函数，也调用它
-        if (s_HotkeyCallback)
+        Instrumentation::AddCounter("hotkey.released");
+    }
+    Instrumentation::SetGauge("hotkey.release_wait_ms", static_cast<double>(GetTickCount64() - s_releaseStart));
+    
+    std::shared_ptr<const TranslationProfile> profile = std::move(s_pPendingProfile);
+    s_pPendingProfile.reset();
+    s_tracker.Reset();
+    Dispatch(profile);
+}
+
+// 执行热键对应的翻译并调用回调函数
+void GlobalHotkey::Dispatch(std::shared_ptr<const TranslationProfile> profile)
+{
+    // 按热键对应的配置档执行翻译功能
+    TranslationManager::ExecuteTranslation(profile);
+    
+    // 如果有回调函数，也调用它
+    void(*callback)() = s_HotkeyCallback.load();
+    if (callback)
+    {
+        callback();
+    }
+}
+
+// 低级键盘钩子：只记录修饰键状态，不拦截按键；钩子回调必须尽快返回，翻译交给消息循环执行
+LRESULT CALLBACK GlobalHotkey::KeyboardHookProc(int code, WPARAM wParam, LPARAM lParam)
+{
+    if (code == HC_ACTION && s_tracker.GetState() == ModifierTracker::State::Waiting)
+    {
+        const KBDLLHOOKSTRUCT* info = reinterpret_cast<const KBDLLHOOKSTRUCT*>(lParam);
+        bool keyDown = wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN;
+        if (s_tracker.OnKey(info->vkCode, keyDown) == ModifierTracker::State::Released)
         {
-            s_HotkeyCallback();
+            PostThreadMessageW(GetCurrentThreadId(), WM_HOTKEY_RELEASED, 0, 0);
         }
     }
+    return CallNextHookEx(nullptr, code, wParam, lParam);
+}
+
+// 等待期限定时器：修饰键仍未释放时按原方式直接取词
+void CALLBACK GlobalHotkey::ReleaseTimerProc(HWND hwnd, UINT message, UINT_PTR timerId, DWORD time)
+{
+    // 定时器到期即视为到达期限（GetTickCount64的精度可能使其略早于期限）
+    if (s_pPendingProfile && s_tracker.OnTick(s_releaseStart + RELEASE_TIMEOUT_MS) != ModifierTracker::State::Waiting)
+    {
+        FinishRelease();
+    }
 }
\ No newline at end of file
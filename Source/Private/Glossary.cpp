@@ -0,0 +1,418 @@
+﻿#include "Glossary.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+
+// 静态成员变量定义
+std::shared_ptr<const GlossaryMatcher> Glossary::s_pMatcher;
+const uint32_t GlossaryMatcher::NONE;
+
+// 出边数量不超过该值时线性查找，否则二分查找
+static const uint32_t LINEAR_SEARCH_EDGES = 8;
+
+namespace
+{
+    inline bool IsAsciiSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    inline bool IsAsciiAlnum(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+
+    // 去除首尾ASCII空白，返回 [begin, end)
+    void TrimRange(const std::string& text, size_t& begin, size_t& end)
+    {
+        while (begin < end && IsAsciiSpace(text[begin]))
+            begin++;
+        while (end > begin && IsAsciiSpace(text[end - 1]))
+            end--;
+    }
+
+    // 构建时的待处理状态：前缀相同的一段已排序术语
+    struct PendingState
+    {
+        uint32_t state;
+        size_t first;   // 在排序后术语序列中的范围 [first, last)
+        size_t last;
+        size_t depth;   // 前缀长度
+    };
+}
+
+/**
+ * @brief 编译术语表
+ * @param entries 术语条目
+ */
+GlossaryMatcher::GlossaryMatcher(std::vector<GlossaryEntry> entries)
+    : m_entries(std::move(entries))
+{
+    // 术语按字节序稳定排序：相同前缀的术语相邻，重复术语中原先靠前的排在前面
+    std::vector<uint32_t> order;
+    order.reserve(m_entries.size());
+    for (uint32_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (!m_entries[i].term.empty())
+            order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+    {
+        return m_entries[a].term < m_entries[b].term;
+    });
+
+    // 按层构建：状态编号即广度优先顺序，处理到某状态时为其连续分配出边（CSR），
+    // 其失败链上的状态深度更小，出边已经就绪，因此失败链可在同一遍中算出
+    m_fail.push_back(0);
+    m_output.push_back(NONE);
+    m_outputLink.push_back(NONE);
+
+    std::vector<PendingState> queue;
+    queue.push_back({ 0, 0, order.size(), 0 });
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        PendingState pending = queue[head];
+        m_edgeBegin.push_back(static_cast<uint32_t>(m_edgeByte.size()));
+
+        size_t index = pending.first;
+        if (index < pending.last && m_entries[order[index]].term.length() == pending.depth)
+        {
+            // 恰好在此结束的术语（重复项只保留第一条）
+            m_output[pending.state] = order[index];
+            while (index < pending.last && m_entries[order[index]].term.length() == pending.depth)
+                index++;
+        }
+
+        while (index < pending.last)
+        {
+            unsigned char byte = static_cast<unsigned char>(m_entries[order[index]].term[pending.depth]);
+            size_t groupEnd = index;
+            while (groupEnd < pending.last && static_cast<unsigned char>(m_entries[order[groupEnd]].term[pending.depth]) == byte)
+                groupEnd++;
+
+            uint32_t child = static_cast<uint32_t>(m_fail.size());
+            uint32_t fail = 0;
+            if (pending.state != 0)
+            {
+                uint32_t state = m_fail[pending.state];
+                uint32_t next = FindEdge(state, byte);
+                while (next == NONE && state != 0)
+                {
+                    state = m_fail[state];
+                    next = FindEdge(state, byte);
+                }
+                fail = next == NONE ? 0 : next;
+            }
+            m_fail.push_back(fail);
+            m_output.push_back(NONE);
+            m_outputLink.push_back(NONE);
+            m_edgeByte.push_back(byte);
+            m_edgeTarget.push_back(child);
+            queue.push_back({ child, index, groupEnd, pending.depth + 1 });
+            index = groupEnd;
+        }
+    }
+    m_edgeBegin.push_back(static_cast<uint32_t>(m_edgeByte.size()));
+
+    // 输出链需要失败状态的输出已确定，按广度优先顺序补齐
+    for (uint32_t state = 1; state < m_fail.size(); ++state)
+    {
+        uint32_t fail = m_fail[state];
+        m_outputLink[state] = m_output[fail] != NONE ? fail : m_outputLink[fail];
+    }
+
+    for (uint32_t byte = 0; byte < 256; ++byte)
+    {
+        uint32_t next = FindEdge(0, static_cast<unsigned char>(byte));
+        m_rootNext[byte] = next == NONE ? 0 : next;
+    }
+}
+
+/**
+ * @brief 查找状态在某字节上的出边
+ * @param state 状态
+ * @param byte 输入字节
+ * @return 目标状态，没有出边返回NONE
+ */
+uint32_t GlossaryMatcher::FindEdge(uint32_t state, unsigned char byte) const
+{
+    // 构建过程中当前状态的出边尚未分配完，m_edgeBegin[state + 1]可能还不存在
+    if (state + 1 >= m_edgeBegin.size())
+        return NONE;
+
+    uint32_t begin = m_edgeBegin[state];
+    uint32_t end = m_edgeBegin[state + 1];
+    if (end - begin <= LINEAR_SEARCH_EDGES)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (m_edgeByte[i] == byte)
+                return m_edgeTarget[i];
+        }
+        return NONE;
+    }
+
+    auto first = m_edgeByte.begin() + begin;
+    auto last = m_edgeByte.begin() + end;
+    auto found = std::lower_bound(first, last, byte);
+    if (found == last || *found != byte)
+        return NONE;
+    return m_edgeTarget[begin + static_cast<uint32_t>(found - m_edgeByte.begin() - begin)];
+}
+
+/**
+ * @brief 查找文本中的术语
+ * @param text UTF-8文本
+ * @param matches 输出命中
+ * @return 命中数量
+ */
+size_t GlossaryMatcher::FindMatches(const std::string& text, std::vector<GlossaryMatch>& matches) const
+{
+    matches.clear();
+
+    // 收集所有候选命中
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        // 沿失败链回退直到有出边，回到根状态时查直接索引表
+        unsigned char byte = static_cast<unsigned char>(text[i]);
+        for (;;)
+        {
+            if (state == 0)
+            {
+                state = m_rootNext[byte];
+                break;
+            }
+            uint32_t next = FindEdge(state, byte);
+            if (next != NONE)
+            {
+                state = next;
+                break;
+            }
+            state = m_fail[state];
+        }
+
+        uint32_t output = m_output[state] != NONE ? state : m_outputLink[state];
+        for (; output != NONE; output = m_outputLink[output])
+        {
+            const std::string& term = m_entries[m_output[output]].term;
+            size_t end = i + 1;
+            size_t begin = end - term.length();
+            if (IsAsciiAlnum(term.front()) && begin > 0 && IsAsciiAlnum(text[begin - 1]))
+                continue;
+            if (IsAsciiAlnum(term.back()) && end < text.length() && IsAsciiAlnum(text[end]))
+                continue;
+            matches.push_back({ begin, end, m_output[output] });
+        }
+    }
+
+    // 最左最长：按起点升序、长度降序排列后贪心选取互不重叠的命中
+    std::sort(matches.begin(), matches.end(), [](const GlossaryMatch& a, const GlossaryMatch& b)
+    {
+        return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+    });
+    size_t kept = 0;
+    size_t coveredEnd = 0;
+    for (const GlossaryMatch& match : matches)
+    {
+        if (match.begin < coveredEnd)
+            continue;
+        matches[kept++] = match;
+        coveredEnd = match.end;
+    }
+    matches.resize(kept);
+    return kept;
+}
+
+/**
+ * @brief 整段文本恰好是一条术语时输出其译法
+ * @param text UTF-8文本
+ * @param translation 输出约定译法
+ * @return 是一条术语返回true
+ */
+bool GlossaryMatcher::LookupExact(const std::string& text, std::string& translation) const
+{
+    size_t begin = 0;
+    size_t end = text.length();
+    TrimRange(text, begin, end);
+    if (begin == end)
+        return false;
+
+    // 只沿字典树出边前进，不走失败链
+    uint32_t state = 0;
+    for (size_t i = begin; i < end && state != NONE; ++i)
+        state = FindEdge(state, static_cast<unsigned char>(text[i]));
+    if (state == NONE || m_output[state] == NONE)
+        return false;
+
+    translation = m_entries[m_output[state]].translation;
+    return true;
+}
+
+/**
+ * @brief 把命中的术语替换为约定译法
+ * @param text UTF-8原文
+ * @param matches FindMatches的结果
+ * @param out 输出文本
+ */
+void GlossaryMatcher::Substitute(const std::string& text, const std::vector<GlossaryMatch>& matches, std::string& out) const
+{
+    out.clear();
+    size_t position = 0;
+    for (const GlossaryMatch& match : matches)
+    {
+        out.append(text, position, match.begin - position);
+        out += m_entries[match.entry].translation;
+        position = match.end;
+    }
+    out.append(text, position, std::string::npos);
+}
+
+/**
+ * @brief 在文本末尾附上命中的术语条目
+ * @param matches FindMatches的结果
+ * @param out 追加到的文本
+ */
+void GlossaryMatcher::AppendHints(const std::vector<GlossaryMatch>& matches, std::string& out) const
+{
+    if (matches.empty())
+        return;
+
+    out += "\n\n术语表（按此译法翻译，不要输出本段）：";
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        // 命中数量很少，线性去重即可
+        bool duplicate = false;
+        for (size_t j = 0; j < i && !duplicate; ++j)
+            duplicate = matches[j].entry == matches[i].entry;
+        if (duplicate)
+            continue;
+
+        const GlossaryEntry& entry = m_entries[matches[i].entry];
+        if (i > 0)
+            out += "；";
+        out += entry.term;
+        out += '=';
+        out += entry.translation;
+    }
+}
+
+/**
+ * @brief 加载并编译术语表文件
+ * @param path 术语表文件路径（UTF-8）
+ * @return 加载的条目数量
+ */
+size_t Glossary::Load(const std::string& path)
+{
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    std::vector<GlossaryEntry> entries;
+    if (file)
+    {
+        std::ostringstream content;
+        content << file.rdbuf();
+        Parse(content.str(), entries);
+    }
+
+    if (entries.empty())
+    {
+        Publish(nullptr);
+        Instrumentation::SetGauge("glossary.entries", 0);
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto matcher = std::make_shared<const GlossaryMatcher>(std::move(entries));
+    double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t count = matcher->GetEntryCount();
+    Instrumentation::SetGauge("glossary.entries", static_cast<double>(count));
+    Instrumentation::SetGauge("glossary.states", static_cast<double>(matcher->GetStateCount()));
+    Instrumentation::SetGauge("glossary.compile_ms", compileMs);
+    Publish(std::move(matcher));
+    return count;
+}
+
+/**
+ * @brief 解析术语表文本
+ * @param text 术语表文件内容（UTF-8）
+ * @param entries 输出条目
+ */
+void Glossary::Parse(const std::string& text, std::vector<GlossaryEntry>& entries)
+{
+    size_t lineStart = 0;
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        lineStart = 3;
+
+    while (lineStart < text.length())
+    {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = text.length();
+        size_t begin = lineStart;
+        size_t end = lineEnd;
+        lineStart = lineEnd + 1;
+
+        TrimRange(text, begin, end);
+        if (begin == end || text[begin] == ';' || text[begin] == '#')
+            continue;
+
+        // 优先以制表符分隔（术语本身可能含等号）
+        size_t separator = text.find('\t', begin);
+        if (separator >= end)
+            separator = text.find('=', begin);
+        if (separator >= end)
+            continue;
+
+        size_t termBegin = begin;
+        size_t termEnd = separator;
+        size_t translationBegin = separator + 1;
+        size_t translationEnd = end;
+        TrimRange(text, termBegin, termEnd);
+        TrimRange(text, translationBegin, translationEnd);
+        if (termBegin == termEnd || translationBegin == translationEnd)
+            continue;
+
+        GlossaryEntry entry;
+        entry.term.assign(text, termBegin, termEnd - termBegin);
+        entry.translation.assign(text, translationBegin, translationEnd - translationBegin);
+        entries.push_back(std::move(entry));
+    }
+}
+
+/**
+ * @brief 获取当前术语表
+ * @return 当前术语表，未加载时返回nullptr
+ */
+std::shared_ptr<const GlossaryMatcher> Glossary::Current()
+{
+    return std::atomic_load(&s_pMatcher);
+}
+
+/**
+ * @brief 替换当前术语表
+ * @param matcher 新术语表
+ */
+void Glossary::Publish(std::shared_ptr<const GlossaryMatcher> matcher)
+{
+    std::atomic_store(&s_pMatcher, std::move(matcher));
+}
+
+/**
+ * @brief 解析使用方式名称
+ * @param name 名称
+ * @param mode 输出使用方式
+ * @return 解析成功返回true
+ */
+bool Glossary::ParseMode(const std::string& name, GlossaryMode& mode)
+{
+    std::string lower;
+    for (char c : name)
+        lower += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+
+    if (lower == "off") mode = GlossaryMode::Off;
+    else if (lower == "substitute") mode = GlossaryMode::Substitute;
+    else if (lower == "prompt") mode = GlossaryMode::Prompt;
+    else return false;
+    return true;
+}
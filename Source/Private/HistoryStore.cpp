@@ -0,0 +1,306 @@
+﻿#include "HistoryStore.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const uint32_t HISTORY_MAGIC = 0x4C485459;     // "YTHL"
+    const uint32_t HISTORY_VERSION = 1;
+
+    template <typename T>
+    inline T ReadValue(const char* data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    inline void WriteValue(char* data, T value)
+    {
+        std::memcpy(data, &value, sizeof(T));
+    }
+
+    // FNV-1a校验和
+    uint32_t Checksum(const char* data, size_t length)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline char ToLowerAscii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+}
+
+/**
+ * @brief 初始化文件头
+ * @param header 文件头内存
+ */
+void HistoryCodec::InitializeHeader(char* header)
+{
+    std::memset(header, 0, HEADER_SIZE);
+    WriteValue<uint32_t>(header, HISTORY_MAGIC);
+    WriteValue<uint32_t>(header + 4, HISTORY_VERSION);
+    WriteValue<uint64_t>(header + 8, 0);
+}
+
+/**
+ * @brief 校验文件头
+ * @param header 文件头内存
+ * @param dataCapacity 数据区容量
+ * @return 合法返回true
+ */
+bool HistoryCodec::ValidateHeader(const char* header, size_t dataCapacity)
+{
+    return ReadValue<uint32_t>(header) == HISTORY_MAGIC
+        && ReadValue<uint32_t>(header + 4) == HISTORY_VERSION
+        && ReadValue<uint64_t>(header + 8) <= dataCapacity;
+}
+
+/**
+ * @brief 读取已使用的数据字节数
+ * @param header 文件头内存
+ * @return 已使用字节数
+ */
+uint64_t HistoryCodec::GetUsedBytes(const char* header)
+{
+    return ReadValue<uint64_t>(header + 8);
+}
+
+/**
+ * @brief 写入已使用的数据字节数
+ * @param header 文件头内存
+ * @param usedBytes 已使用字节数
+ */
+void HistoryCodec::SetUsedBytes(char* header, uint64_t usedBytes)
+{
+    WriteValue<uint64_t>(header + 8, usedBytes);
+}
+
+/**
+ * @brief 计算记录编码后的字节数
+ * @param record 记录
+ * @return 字节数
+ */
+size_t HistoryCodec::EncodedSize(const HistoryRecord& record)
+{
+    size_t profileLength = std::min(record.profile.length(), static_cast<size_t>(MAX_PROFILE_LENGTH));
+    return RECORD_HEADER_SIZE + profileLength + record.source.length() + record.result.length();
+}
+
+/**
+ * @brief 编码记录
+ * @param record 记录
+ * @param dest 目标内存
+ */
+void HistoryCodec::Encode(const HistoryRecord& record, char* dest)
+{
+    size_t profileLength = std::min(record.profile.length(), static_cast<size_t>(MAX_PROFILE_LENGTH));
+    size_t recordSize = EncodedSize(record);
+
+    WriteValue<uint32_t>(dest, static_cast<uint32_t>(recordSize));
+    WriteValue<int64_t>(dest + 8, record.timestamp);
+    WriteValue<uint32_t>(dest + 16, record.latencyMs);
+    WriteValue<uint16_t>(dest + 20, static_cast<uint16_t>(profileLength));
+    WriteValue<uint16_t>(dest + 22, 0);
+    WriteValue<uint32_t>(dest + 24, static_cast<uint32_t>(record.source.length()));
+    WriteValue<uint32_t>(dest + 28, static_cast<uint32_t>(record.result.length()));
+
+    char* text = dest + RECORD_HEADER_SIZE;
+    std::memcpy(text, record.profile.data(), profileLength);
+    text += profileLength;
+    std::memcpy(text, record.source.data(), record.source.length());
+    text += record.source.length();
+    std::memcpy(text, record.result.data(), record.result.length());
+
+    // 校验和覆盖记录头其余部分和全部文本
+    WriteValue<uint32_t>(dest + 4, Checksum(dest + 8, recordSize - 8));
+}
+
+/**
+ * @brief 解码记录（零拷贝）
+ * @param data 记录起始地址
+ * @param available 可读字节数
+ * @param view 输出记录视图
+ * @param consumed 输出记录占用的字节数
+ * @return 记录完整且校验通过返回true
+ */
+bool HistoryCodec::Decode(const char* data, size_t available, HistoryRecordView& view, size_t& consumed)
+{
+    if (available < RECORD_HEADER_SIZE)
+        return false;
+
+    size_t recordSize = ReadValue<uint32_t>(data);
+    if (recordSize < RECORD_HEADER_SIZE || recordSize > available)
+        return false;
+
+    size_t profileLength = ReadValue<uint16_t>(data + 20);
+    size_t sourceLength = ReadValue<uint32_t>(data + 24);
+    size_t resultLength = ReadValue<uint32_t>(data + 28);
+    if (RECORD_HEADER_SIZE + profileLength + sourceLength + resultLength != recordSize)
+        return false;
+
+    if (ReadValue<uint32_t>(data + 4) != Checksum(data + 8, recordSize - 8))
+        return false;
+
+    const char* text = data + RECORD_HEADER_SIZE;
+    view.timestamp = ReadValue<int64_t>(data + 8);
+    view.latencyMs = ReadValue<uint32_t>(data + 16);
+    view.profile = std::string_view(text, profileLength);
+    view.source = std::string_view(text + profileLength, sourceLength);
+    view.result = std::string_view(text + profileLength + sourceLength, resultLength);
+    consumed = recordSize;
+    return true;
+}
+
+/**
+ * @brief 添加记录到索引
+ * @param id 记录ID
+ * @param view 记录视图
+ */
+void HistoryIndex::Add(uint32_t id, const HistoryRecordView& view)
+{
+    std::vector<uint32_t> codePoints;
+    for (std::string_view text : { view.source, view.result })
+    {
+        Normalize(text, codePoints);
+        for (size_t i = 0; i < codePoints.size(); i++)
+        {
+            AddPosting(m_unigrams[codePoints[i]], id);
+            if (i + 1 < codePoints.size())
+            {
+                uint64_t key = (static_cast<uint64_t>(codePoints[i]) << 32) | codePoints[i + 1];
+                AddPosting(m_bigrams[key], id);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 清空索引
+ */
+void HistoryIndex::Clear()
+{
+    m_bigrams.clear();
+    m_unigrams.clear();
+}
+
+/**
+ * @brief 查找候选记录
+ * @param query UTF-8查询字符串
+ * @param candidates 输出候选记录ID（最新在前）
+ */
+void HistoryIndex::FindCandidates(std::string_view query, std::vector<uint32_t>& candidates) const
+{
+    candidates.clear();
+
+    std::vector<uint32_t> codePoints;
+    Normalize(query, codePoints);
+    if (codePoints.empty())
+        return;
+
+    if (codePoints.size() == 1)
+    {
+        auto it = m_unigrams.find(codePoints[0]);
+        if (it != m_unigrams.end())
+            candidates.assign(it->second.rbegin(), it->second.rend());
+        return;
+    }
+
+    // 收集各bigram的倒排表，任一缺失则无结果
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (size_t i = 0; i + 1 < codePoints.size(); i++)
+    {
+        uint64_t key = (static_cast<uint64_t>(codePoints[i]) << 32) | codePoints[i + 1];
+        auto it = m_bigrams.find(key);
+        if (it == m_bigrams.end())
+            return;
+        lists.push_back(&it->second);
+    }
+
+    // 从最短的倒排表开始求交集
+    std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+        return a->size() < b->size();
+    });
+
+    std::vector<uint32_t> current(*lists[0]);
+    std::vector<uint32_t> next;
+    for (size_t i = 1; i < lists.size() && !current.empty(); i++)
+    {
+        if (lists[i] == lists[i - 1])
+            continue;   // 重复的bigram
+        next.clear();
+        std::set_intersection(current.begin(), current.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        current.swap(next);
+    }
+
+    candidates.assign(current.rbegin(), current.rend());
+}
+
+/**
+ * @brief ASCII不区分大小写的子串匹配
+ * @param text 被搜索文本
+ * @param pattern 模式串
+ * @return 包含返回true
+ */
+bool HistoryIndex::ContainsIgnoreCase(std::string_view text, std::string_view pattern)
+{
+    if (pattern.empty())
+        return true;
+    if (pattern.length() > text.length())
+        return false;
+
+    auto it = std::search(text.begin(), text.end(), pattern.begin(), pattern.end(), [](char a, char b) {
+        return ToLowerAscii(a) == ToLowerAscii(b);
+    });
+    return it != text.end();
+}
+
+/**
+ * @brief 解码UTF-8为规范化的码点序列
+ * @param text UTF-8文本
+ * @param codePoints 输出码点
+ */
+void HistoryIndex::Normalize(std::string_view text, std::vector<uint32_t>& codePoints)
+{
+    codePoints.clear();
+    size_t i = 0;
+    while (i < text.length())
+    {
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        uint32_t codePoint = lead;
+        size_t extra = 0;
+        if (lead >= 0xF0) { codePoint = lead & 0x07; extra = 3; }
+        else if (lead >= 0xE0) { codePoint = lead & 0x0F; extra = 2; }
+        else if (lead >= 0xC0) { codePoint = lead & 0x1F; extra = 1; }
+
+        if (i + extra >= text.length() && extra > 0)
+            break;      // 截断的多字节序列
+
+        for (size_t k = 1; k <= extra; k++)
+            codePoint = (codePoint << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        i += extra + 1;
+
+        if (codePoint >= 'A' && codePoint <= 'Z')
+            codePoint += 'a' - 'A';
+        codePoints.push_back(codePoint);
+    }
+}
+
+/**
+ * @brief 向倒排表追加ID
+ * @param postings 倒排表
+ * @param id 记录ID
+ */
+void HistoryIndex::AddPosting(std::vector<uint32_t>& postings, uint32_t id)
+{
+    if (postings.empty() || postings.back() != id)
+        postings.push_back(id);
+}
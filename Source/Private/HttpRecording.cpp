@@ -0,0 +1,390 @@
+﻿#include "HttpRecording.h"
+#include "Instrumentation.h"
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <iterator>
+#include <cwctype>
+
+const char HttpRecording::FILE_MAGIC[4] = { 'Y', 'T', 'R', 'R' };
+
+// 类内初始化的静态常量在取地址时需要定义
+const uint8_t HttpRecording::FILE_VERSION;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 值需要脱敏的请求头（小写）
+    const char* const SECRET_HEADERS[] = { "authorization", "proxy-authorization", "cookie", "x-api-key", "api-key" };
+
+    inline void Fnv(uint64_t& hash, const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    void PutVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    void PutString(std::string& out, const std::string& value)
+    {
+        PutVarint(out, value.length());
+        out += value;
+    }
+
+    bool GetVarint(const std::string& data, size_t& pos, size_t end, uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && pos < end; shift += 7)
+        {
+            unsigned char byte = static_cast<unsigned char>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool GetString(const std::string& data, size_t& pos, size_t end, std::string& value)
+    {
+        uint64_t length = 0;
+        if (!GetVarint(data, pos, end, length) || length > end - pos)
+            return false;
+        value.assign(data, pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+        return true;
+    }
+
+    // 请求头等只含ASCII的宽字符串转为UTF-8（非ASCII字符替换为?）
+    std::string NarrowAscii(std::wstring_view text)
+    {
+        std::string out;
+        out.reserve(text.length());
+        for (wchar_t ch : text)
+            out += ch < 0x80 ? static_cast<char>(ch) : '?';
+        return out;
+    }
+
+    uint32_t ElapsedUs(Clock::time_point from, Clock::time_point to)
+    {
+        long long us = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+        return us <= 0 ? 0 : us >= 0xFFFFFFFFLL ? 0xFFFFFFFFu : static_cast<uint32_t>(us);
+    }
+}
+
+/**
+ * @brief 计算请求指纹
+ * @param request 请求描述
+ * @return 指纹
+ */
+uint64_t HttpRecording::RequestKey(const HttpRequest& request)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    std::string method = NarrowAscii(request.method);
+    std::string host = NarrowAscii(request.host);
+    std::string path = NarrowAscii(request.path);
+    Fnv(hash, method.c_str(), method.length() + 1);
+    Fnv(hash, host.c_str(), host.length() + 1);
+    Fnv(hash, &request.port, sizeof(request.port));
+    Fnv(hash, path.c_str(), path.length() + 1);
+    Fnv(hash, request.body.data(), request.body.length());
+    return hash;
+}
+
+/**
+ * @brief 请求头脱敏
+ * @param headers 请求头
+ * @return 脱敏后的请求头
+ */
+std::string HttpRecording::RedactHeaders(std::wstring_view headers)
+{
+    std::string out;
+    size_t start = 0;
+    while (start < headers.length())
+    {
+        size_t end = headers.find(L"\r\n", start);
+        if (end == std::wstring_view::npos)
+            end = headers.length();
+        std::wstring_view line = headers.substr(start, end - start);
+        size_t colon = line.find(L':');
+
+        bool secret = false;
+        if (colon != std::wstring_view::npos)
+        {
+            std::string name;
+            for (wchar_t ch : line.substr(0, colon))
+                name += static_cast<char>(std::towlower(ch));
+            for (const char* header : SECRET_HEADERS)
+                secret = secret || name == header;
+        }
+        out += secret ? NarrowAscii(line.substr(0, colon)) + ": <redacted>" : NarrowAscii(line);
+        out += "\r\n";
+        start = end + 2;
+    }
+    return out;
+}
+
+/**
+ * @brief 编码一条记录并追加到out
+ * @param exchange 录制的请求
+ * @param out 输出缓冲区
+ */
+void HttpRecording::Encode(const HttpExchange& exchange, std::string& out)
+{
+    std::string record;
+    PutVarint(record, exchange.key);
+    PutString(record, exchange.method);
+    PutString(record, exchange.host);
+    PutVarint(record, exchange.port);
+    PutString(record, exchange.path);
+    PutString(record, exchange.headers);
+    PutVarint(record, exchange.bodyLength);
+    PutVarint(record, static_cast<uint64_t>(exchange.failure));
+    PutVarint(record, exchange.statusCode);
+    PutVarint(record, exchange.compressed ? 1 : 0);
+    PutVarint(record, exchange.wireBytesReceived);
+    PutVarint(record, exchange.chunks.size());
+    for (const HttpChunk& chunk : exchange.chunks)
+    {
+        PutVarint(record, chunk.delayUs);
+        PutString(record, chunk.data);
+    }
+    PutVarint(record, exchange.tailUs);
+
+    PutVarint(out, record.length());
+    out += record;
+}
+
+/**
+ * @brief 解码一条记录
+ * @param data 文件内容
+ * @param pos 读取位置
+ * @param exchange 输出记录
+ * @return 成功返回true
+ */
+bool HttpRecording::Decode(const std::string& data, size_t& pos, HttpExchange& exchange)
+{
+    size_t cursor = pos;
+    uint64_t length = 0;
+    if (!GetVarint(data, cursor, data.length(), length) || length > data.length() - cursor)
+        return false;
+    size_t end = cursor + static_cast<size_t>(length);
+
+    uint64_t port = 0;
+    uint64_t failure = 0;
+    uint64_t statusCode = 0;
+    uint64_t compressed = 0;
+    uint64_t chunkCount = 0;
+    if (!GetVarint(data, cursor, end, exchange.key) || !GetString(data, cursor, end, exchange.method) ||
+        !GetString(data, cursor, end, exchange.host) || !GetVarint(data, cursor, end, port) ||
+        !GetString(data, cursor, end, exchange.path) || !GetString(data, cursor, end, exchange.headers) ||
+        !GetVarint(data, cursor, end, exchange.bodyLength) || !GetVarint(data, cursor, end, failure) ||
+        !GetVarint(data, cursor, end, statusCode) || !GetVarint(data, cursor, end, compressed) ||
+        !GetVarint(data, cursor, end, exchange.wireBytesReceived) || !GetVarint(data, cursor, end, chunkCount) ||
+        port > 0xFFFF || failure > static_cast<uint64_t>(HttpFailure::Cancelled) || chunkCount > end - cursor)
+        return false;
+    exchange.port = static_cast<uint16_t>(port);
+    exchange.failure = static_cast<HttpFailure>(failure);
+    exchange.statusCode = static_cast<unsigned long>(statusCode);
+    exchange.compressed = compressed != 0;
+
+    exchange.chunks.resize(static_cast<size_t>(chunkCount));
+    uint64_t value = 0;
+    for (HttpChunk& chunk : exchange.chunks)
+    {
+        if (!GetVarint(data, cursor, end, value) || value > 0xFFFFFFFFu || !GetString(data, cursor, end, chunk.data))
+            return false;
+        chunk.delayUs = static_cast<uint32_t>(value);
+    }
+    if (!GetVarint(data, cursor, end, value) || value > 0xFFFFFFFFu || cursor != end)
+        return false;
+    exchange.tailUs = static_cast<uint32_t>(value);
+    pos = end;
+    return true;
+}
+
+/**
+ * @brief 构造录制装饰器
+ * @param inner 实际发送请求的传输层
+ */
+RecordingTransport::RecordingTransport(std::unique_ptr<HttpTransport> inner)
+    : m_pInner(std::move(inner))
+{
+}
+
+/**
+ * @brief 创建录制文件并写入文件头
+ * @param path 文件路径（UTF-8）
+ * @return 成功返回true
+ */
+bool RecordingTransport::Open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.open(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+    m_file.write(HttpRecording::FILE_MAGIC, sizeof(HttpRecording::FILE_MAGIC));
+    m_file.put(static_cast<char>(HttpRecording::FILE_VERSION));
+    m_file.flush();
+    return static_cast<bool>(m_file);
+}
+
+/**
+ * @brief 发送请求并录制
+ * @param request 请求描述
+ * @param onData 响应数据回调
+ * @param result 输出结果与传输统计
+ * @return 内层传输层的返回值
+ */
+bool RecordingTransport::Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result)
+{
+    HttpExchange exchange;
+    exchange.key = HttpRecording::RequestKey(request);
+    exchange.method = NarrowAscii(request.method);
+    exchange.host = NarrowAscii(request.host);
+    exchange.port = request.port;
+    exchange.path = NarrowAscii(request.path);
+    exchange.headers = HttpRecording::RedactHeaders(request.headers);
+    exchange.bodyLength = request.body.length();
+
+    // 每块数据记下距上一块的耗时后原样交给调用方
+    Clock::time_point last = Clock::now();
+    bool received = m_pInner->Send(request, [&](const char* data, size_t length)
+    {
+        Clock::time_point now = Clock::now();
+        exchange.chunks.push_back({ ElapsedUs(last, now), std::string(data, length) });
+        last = now;
+        onData(data, length);
+    }, result);
+    exchange.tailUs = ElapsedUs(last, Clock::now());
+    if (result.failure == HttpFailure::Cancelled)
+        return received;
+
+    exchange.failure = result.failure;
+    exchange.statusCode = result.statusCode;
+    exchange.compressed = result.compressed;
+    exchange.wireBytesReceived = result.wireBytesReceived;
+
+    std::string record;
+    HttpRecording::Encode(exchange, record);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.write(record.data(), static_cast<std::streamsize>(record.length()));
+        m_file.flush();
+    }
+    Instrumentation::AddCounter("record.exchanges");
+    return received;
+}
+
+/**
+ * @brief 加载录制文件
+ * @param path 文件路径（UTF-8）
+ * @param timeScale 耗时系数
+ * @return 成功返回true
+ */
+bool ReplayTransport::Load(const std::string& path, double timeScale)
+{
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file)
+        return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.length() < sizeof(HttpRecording::FILE_MAGIC) + 1 ||
+        data.compare(0, sizeof(HttpRecording::FILE_MAGIC), HttpRecording::FILE_MAGIC, sizeof(HttpRecording::FILE_MAGIC)) != 0 ||
+        static_cast<uint8_t>(data[sizeof(HttpRecording::FILE_MAGIC)]) != HttpRecording::FILE_VERSION)
+        return false;
+
+    m_exchanges.clear();
+    m_byKey.clear();
+    m_nextUse.clear();
+    m_timeScale = timeScale < 0 ? 0 : timeScale;
+
+    size_t pos = sizeof(HttpRecording::FILE_MAGIC) + 1;
+    HttpExchange exchange;
+    while (pos < data.length() && HttpRecording::Decode(data, pos, exchange))
+    {
+        m_byKey[exchange.key].push_back(m_exchanges.size());
+        m_exchanges.push_back(std::move(exchange));
+        exchange = HttpExchange();
+    }
+    return true;
+}
+
+/**
+ * @brief 回放请求
+ * @param request 请求描述
+ * @param onData 响应数据回调
+ * @param result 输出结果与传输统计
+ * @return 录制的请求完整收到响应时返回true
+ */
+bool ReplayTransport::Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result)
+{
+    result = HttpResult();
+    result.bytesSent = request.body.length();
+
+    const HttpExchange* exchange = nullptr;
+    uint64_t key = HttpRecording::RequestKey(request);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_byKey.find(key);
+        if (found != m_byKey.end())
+            exchange = &m_exchanges[found->second[m_nextUse[key]++ % found->second.size()]];
+    }
+    if (exchange == nullptr)
+    {
+        Instrumentation::AddCounter("replay.missed");
+        result.failure = HttpFailure::Connect;
+        return false;
+    }
+    Instrumentation::AddCounter("replay.served");
+
+    // 各块按录制的间隔乘以系数到达，等待的截止时间累加计算，回调的处理时间不会推迟后续数据
+    Clock::time_point start = Clock::now();
+    Clock::time_point due = start;
+    auto wait = [&](uint32_t delayUs)
+    {
+        if (m_timeScale <= 0)
+            return;
+        due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(delayUs * m_timeScale));
+        std::this_thread::sleep_until(due);
+    };
+    // 第一块之前的等待视为等待响应头，之后的间隔视为数据块之间的间隔（与WinHttpTransport的阶段耗时对应）
+    Clock::time_point last = start;
+    bool first = true;
+    for (const HttpChunk& chunk : exchange->chunks)
+    {
+        wait(chunk.delayUs);
+        if (request.cancel != nullptr && *request.cancel)
+        {
+            result.failure = HttpFailure::Cancelled;
+            return false;
+        }
+        Clock::time_point now = Clock::now();
+        double gapMs = std::chrono::duration<double, std::milli>(now - last).count();
+        if (first)
+            result.responseMs = gapMs;
+        else if (gapMs > result.maxGapMs)
+            result.maxGapMs = gapMs;
+        first = false;
+        last = now;
+        onData(chunk.data.data(), chunk.data.length());
+        result.decodedBytesReceived += chunk.data.length();
+    }
+    wait(exchange->tailUs);
+
+    result.failure = exchange->failure;
+    result.statusCode = exchange->statusCode;
+    result.compressed = exchange->compressed;
+    result.wireBytesReceived = exchange->wireBytesReceived;
+    result.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return result.failure == HttpFailure::None;
+}
@@ -0,0 +1,220 @@
+﻿#include "IdentifierCase.h"
+
+namespace
+{
+    // 字符分类
+    enum CharClass
+    {
+        CHAR_SEPARATOR,
+        CHAR_LOWER,
+        CHAR_UPPER,
+        CHAR_DIGIT,
+        CHAR_OTHER,         // 非ASCII字节（UTF-8多字节序列）
+        CHAR_APOSTROPHE
+    };
+
+    inline CharClass Classify(char c)
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 'a' && u <= 'z') return CHAR_LOWER;
+        if (u >= 'A' && u <= 'Z') return CHAR_UPPER;
+        if (u >= '0' && u <= '9') return CHAR_DIGIT;
+        if (u >= 0x80) return CHAR_OTHER;
+        if (u == '\'') return CHAR_APOSTROPHE;
+        return CHAR_SEPARATOR;
+    }
+
+    inline char ToUpperAscii(char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c; }
+    inline char ToLowerAscii(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+}
+
+/**
+ * @brief 解析风格名称
+ * @param name 风格名称
+ * @param style 输出风格
+ * @return 解析成功返回true，失败返回false
+ */
+bool IdentifierCase::ParseStyle(const std::string& name, CaseStyle& style)
+{
+    std::string lower;
+    for (char c : name)
+    {
+        if (c != '_' && c != '-' && c != ' ')
+            lower += ToLowerAscii(c);
+    }
+
+    if (lower == "none") style = CaseStyle::None;
+    else if (lower == "pascal" || lower == "pascalcase") style = CaseStyle::Pascal;
+    else if (lower == "camel" || lower == "camelcase") style = CaseStyle::Camel;
+    else if (lower == "snake" || lower == "snakecase") style = CaseStyle::Snake;
+    else if (lower == "screamingsnake" || lower == "screaming" || lower == "screamingcase") style = CaseStyle::ScreamingSnake;
+    else if (lower == "kebab" || lower == "kebabcase") style = CaseStyle::Kebab;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief 判断文本是否仅含ASCII字符
+ * @param text UTF-8文本
+ * @return 全部为ASCII字符返回true
+ */
+bool IdentifierCase::IsAsciiText(const std::string& text)
+{
+    for (char c : text)
+    {
+        if (static_cast<unsigned char>(c) >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 将文本切分为单词
+ * @param text 输入文本
+ * @param words 输出单词区间
+ */
+void IdentifierCase::SplitWords(const std::string& text, std::vector<WordSpan>& words)
+{
+    words.clear();
+
+    const size_t length = text.length();
+    size_t wordBegin = 0;
+    bool inWord = false;
+    bool wordAllDigits = false;     // 当前单词到目前为止是否全为数字
+    CharClass prev = CHAR_SEPARATOR;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        CharClass cls = Classify(text[i]);
+
+        if (cls == CHAR_SEPARATOR)
+        {
+            if (inWord)
+                words.push_back({ wordBegin, i });
+            inWord = false;
+            continue;
+        }
+
+        // 撇号不构成边界（user's -> users），也不改变前一个字符的类别
+        if (cls == CHAR_APOSTROPHE)
+            continue;
+
+        if (inWord)
+        {
+            bool split = false;
+            if (cls == CHAR_UPPER && (prev == CHAR_LOWER || prev == CHAR_DIGIT))
+            {
+                split = true;   // getName、utf8Decoder
+            }
+            else if (cls == CHAR_UPPER && prev == CHAR_UPPER)
+            {
+                // HTTPServer：在 S 前断开（下一个有效字符为小写时）
+                size_t next = i + 1;
+                while (next < length && Classify(text[next]) == CHAR_APOSTROPHE)
+                    next++;
+                split = next < length && Classify(text[next]) == CHAR_LOWER;
+            }
+            else if ((cls == CHAR_LOWER || cls == CHAR_UPPER) && wordAllDigits)
+            {
+                split = true;   // 单词开头的数字单独成词：3D -> 3 D
+            }
+
+            if (split)
+            {
+                words.push_back({ wordBegin, i });
+                wordBegin = i;
+                wordAllDigits = false;
+            }
+        }
+        else
+        {
+            inWord = true;
+            wordBegin = i;
+            wordAllDigits = true;
+        }
+
+        if (cls != CHAR_DIGIT)
+            wordAllDigits = false;
+        prev = cls;
+    }
+
+    if (inWord)
+        words.push_back({ wordBegin, length });
+}
+
+/**
+ * @brief 转换为指定命名风格
+ * @param text UTF-8编码的英文译文
+ * @param style 目标风格
+ * @param out 输出结果
+ */
+void IdentifierCase::Convert(const std::string& text, CaseStyle style, std::string& out)
+{
+    out.clear();
+    if (style == CaseStyle::None)
+    {
+        out = text;
+        return;
+    }
+
+    std::vector<WordSpan> words;
+    words.reserve(16);
+    SplitWords(text, words);
+
+    char separator = '\0';
+    if (style == CaseStyle::Snake || style == CaseStyle::ScreamingSnake)
+        separator = '_';
+    else if (style == CaseStyle::Kebab)
+        separator = '-';
+
+    out.reserve(text.length());
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        const WordSpan& word = words[w];
+
+        if (separator != '\0' && w > 0)
+            out += separator;
+
+        // 缩写判定：单词中的字母全为大写且至少2个
+        size_t upperCount = 0;
+        bool hasLower = false;
+        for (size_t i = word.begin; i < word.end; i++)
+        {
+            CharClass cls = Classify(text[i]);
+            if (cls == CHAR_UPPER) upperCount++;
+            else if (cls == CHAR_LOWER) hasLower = true;
+        }
+        bool isAcronym = upperCount >= 2 && !hasLower;
+
+        bool firstLetter = true;
+        for (size_t i = word.begin; i < word.end; i++)
+        {
+            char c = text[i];
+            if (c == '\'')
+                continue;
+
+            switch (style)
+            {
+                case CaseStyle::Pascal:
+                case CaseStyle::Camel:
+                {
+                    bool lowerWholeWord = style == CaseStyle::Camel && w == 0;
+                    if (lowerWholeWord)
+                        c = ToLowerAscii(c);
+                    else if (!isAcronym)
+                        c = firstLetter ? ToUpperAscii(c) : ToLowerAscii(c);
+                    break;
+                }
+                case CaseStyle::ScreamingSnake:
+                    c = ToUpperAscii(c);
+                    break;
+                default:
+                    c = ToLowerAscii(c);
+                    break;
+            }
+
+            out += c;
+            firstLetter = false;
+        }
+    }
+}
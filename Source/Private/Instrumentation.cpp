@@ -0,0 +1,124 @@
+﻿#include "Instrumentation.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <filesystem>
+
+// 静态成员变量定义（时间线起点在静态初始化时确定，接近进程启动时刻）
+Instrumentation::Clock::time_point Instrumentation::s_startupOrigin = Instrumentation::Clock::now();
+std::vector<std::pair<std::string, double>> Instrumentation::s_startupPhases;
+std::map<std::string, int64_t> Instrumentation::s_counters;
+std::map<std::string, double> Instrumentation::s_gauges;
+std::mutex Instrumentation::s_mutex;
+
+/**
+ * @brief 记录一个启动阶段完成
+ * @param phase 阶段名称
+ */
+void Instrumentation::MarkStartup(const char* phase)
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    double elapsedMs = std::chrono::duration<double, std::milli>(now - s_startupOrigin).count();
+    s_startupPhases.emplace_back(phase, elapsedMs);
+}
+
+/**
+ * @brief 格式化启动时间线
+ * @return 时间线文本
+ */
+std::string Instrumentation::FormatStartupTimeline()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    std::string text;
+    char buffer[64];
+    for (const auto& phase : s_startupPhases)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%.1fms", phase.second);
+        if (!text.empty())
+            text += ' ';
+        text += phase.first + "=" + buffer;
+    }
+    return text;
+}
+
+/**
+ * @brief 累加计数器
+ * @param name 计数器名称
+ * @param delta 增量
+ */
+void Instrumentation::AddCounter(const std::string& name, int64_t delta)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_counters[name] += delta;
+}
+
+/**
+ * @brief 读取计数器
+ * @param name 计数器名称
+ * @return 当前值
+ */
+int64_t Instrumentation::GetCounter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_counters.find(name);
+    return it != s_counters.end() ? it->second : 0;
+}
+
+/**
+ * @brief 设置数值指标
+ * @param name 指标名称
+ * @param value 数值
+ */
+void Instrumentation::SetGauge(const std::string& name, double value)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_gauges[name] = value;
+}
+
+/**
+ * @brief 格式化全部计数器和数值指标
+ * @return 指标文本
+ */
+std::string Instrumentation::FormatReport()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    std::string text;
+    char buffer[64];
+    for (const auto& counter : s_counters)
+        text += counter.first + "=" + std::to_string(counter.second) + "\n";
+    for (const auto& gauge : s_gauges)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%.3f", gauge.second);
+        text += gauge.first + "=" + buffer + "\n";
+    }
+    return text;
+}
+
+/**
+ * @brief 追加一行带时间戳的文本到日志文件
+ * @param path 日志文件路径（UTF-8）
+ * @param line 文本行
+ * @return 成功返回true
+ */
+bool Instrumentation::AppendLine(const std::string& path, const std::string& line)
+{
+    std::time_t now = std::time(nullptr);
+    std::tm localTime = {};
+#ifdef _WIN32
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &localTime);
+
+    std::ofstream file(std::filesystem::u8path(path), std::ios::app | std::ios::binary);
+    if (!file)
+        return false;
+    file << timestamp << ' ' << line << '\n';
+    return static_cast<bool>(file);
+}
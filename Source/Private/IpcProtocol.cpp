@@ -0,0 +1,205 @@
+﻿#include "IpcProtocol.h"
+
+// 类内初始化的静态常量在取地址时需要定义
+const uint8_t IpcProtocol::VERSION;
+const size_t IpcProtocol::HEADER_SIZE;
+const uint32_t IpcProtocol::MAX_PAYLOAD;
+
+/**
+ * @brief 按小端序读取u32
+ * @param data 数据（至少4字节）
+ * @return 值
+ */
+static uint32_t LoadU32(const char* data)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+        (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+/**
+ * @brief 编码一帧并追加到输出
+ * @param type 帧类型
+ * @param requestId 请求编号
+ * @param payload 负载
+ * @param out 追加到的输出
+ */
+void IpcProtocol::EncodeFrame(IpcFrameType type, uint32_t requestId, const std::string& payload, std::string& out)
+{
+    out.reserve(out.length() + HEADER_SIZE + payload.length());
+    PutU32(static_cast<uint32_t>(payload.length()), out);
+    out += static_cast<char>(type);
+    out += static_cast<char>(VERSION);
+    out.append(2, '\0');
+    PutU32(requestId, out);
+    out += payload;
+}
+
+/**
+ * @brief 向负载追加u32（小端序）
+ * @param value 值
+ * @param payload 负载
+ */
+void IpcProtocol::PutU32(uint32_t value, std::string& payload)
+{
+    char bytes[4] =
+    {
+        static_cast<char>(value & 0xFF),
+        static_cast<char>((value >> 8) & 0xFF),
+        static_cast<char>((value >> 16) & 0xFF),
+        static_cast<char>((value >> 24) & 0xFF)
+    };
+    payload.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief 向负载追加字符串
+ * @param text UTF-8文本
+ * @param payload 负载
+ */
+void IpcProtocol::PutString(const std::string& text, std::string& payload)
+{
+    PutU32(static_cast<uint32_t>(text.length()), payload);
+    payload += text;
+}
+
+/**
+ * @brief 从负载读取u32
+ * @param payload 负载
+ * @param offset 读取位置，成功后前移
+ * @param value 输出值
+ * @return 剩余字节足够返回true
+ */
+bool IpcProtocol::ReadU32(const std::string& payload, size_t& offset, uint32_t& value)
+{
+    if (payload.length() < offset || payload.length() - offset < 4)
+        return false;
+    value = LoadU32(payload.data() + offset);
+    offset += 4;
+    return true;
+}
+
+/**
+ * @brief 从负载读取字符串
+ * @param payload 负载
+ * @param offset 读取位置，成功后前移
+ * @param text 输出文本
+ * @return 剩余字节足够返回true
+ */
+bool IpcProtocol::ReadString(const std::string& payload, size_t& offset, std::string& text)
+{
+    uint32_t length = 0;
+    size_t position = offset;
+    if (!ReadU32(payload, position, length) || payload.length() - position < length)
+        return false;
+    text.assign(payload, position, length);
+    offset = position + length;
+    return true;
+}
+
+/**
+ * @brief 编码Result帧
+ * @param requestId 请求编号
+ * @param index 条目索引
+ * @param status 状态
+ * @param text 译文或错误信息（UTF-8）
+ * @param out 追加到的输出
+ */
+void IpcProtocol::EncodeResult(uint32_t requestId, uint32_t index, IpcStatus status, const std::string& text, std::string& out)
+{
+    std::string payload;
+    payload.reserve(9 + text.length());
+    PutU32(index, payload);
+    payload += static_cast<char>(status);
+    PutString(text, payload);
+    EncodeFrame(IpcFrameType::Result, requestId, payload, out);
+}
+
+/**
+ * @brief 编码Partial帧
+ * @param requestId 请求编号
+ * @param offset 片段在原始译文中的字节偏移
+ * @param data 片段
+ * @param length 片段字节数
+ * @param out 追加到的输出
+ */
+void IpcProtocol::EncodePartial(uint32_t requestId, uint32_t offset, const char* data, size_t length, std::string& out)
+{
+    std::string payload;
+    payload.reserve(8 + length);
+    PutU32(offset, payload);
+    PutU32(static_cast<uint32_t>(length), payload);
+    payload.append(data, length);
+    EncodeFrame(IpcFrameType::Partial, requestId, payload, out);
+}
+
+/**
+ * @brief 获取不以不完整字符结尾的最长前缀长度
+ * @param text UTF-8文本
+ * @return 字节数
+ */
+size_t IpcProtocol::CompleteUtf8Length(const std::string& text)
+{
+    // 从末尾向前找到最后一个字符的首字节，其后的字节数不足该字符的长度时不计入
+    size_t length = text.length();
+    for (size_t back = 1; back <= 4 && back <= length; ++back)
+    {
+        unsigned char byte = static_cast<unsigned char>(text[length - back]);
+        if ((byte & 0xC0) == 0x80)
+            continue;
+        size_t expected = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+        return expected > back ? length - back : length;
+    }
+    return length;
+}
+
+/**
+ * @brief 追加收到的字节
+ * @param data 数据
+ * @param length 字节数
+ */
+void IpcFrameDecoder::Feed(const char* data, size_t length)
+{
+    if (m_bError)
+        return;
+
+    // 已取出的部分超过一半时前移，避免缓冲区随连接时长无限增长
+    if (m_offset > 0 && m_offset >= m_buffer.length() / 2)
+    {
+        m_buffer.erase(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(data, length);
+}
+
+/**
+ * @brief 取出下一帧
+ * @param frame 输出帧
+ * @return 有完整的帧返回true
+ */
+bool IpcFrameDecoder::Next(IpcFrame& frame)
+{
+    if (m_bError || GetBufferedSize() < IpcProtocol::HEADER_SIZE)
+        return false;
+
+    const char* header = m_buffer.data() + m_offset;
+    uint32_t length = LoadU32(header);
+    if (length > IpcProtocol::MAX_PAYLOAD || static_cast<uint8_t>(header[5]) != IpcProtocol::VERSION)
+    {
+        m_bError = true;
+        return false;
+    }
+    if (GetBufferedSize() - IpcProtocol::HEADER_SIZE < length)
+        return false;
+
+    frame.type = static_cast<IpcFrameType>(static_cast<uint8_t>(header[4]));
+    frame.requestId = LoadU32(header + 8);
+    frame.payload.assign(m_buffer, m_offset + IpcProtocol::HEADER_SIZE, length);
+    m_offset += IpcProtocol::HEADER_SIZE + length;
+    if (m_offset == m_buffer.length())
+    {
+        m_buffer.clear();
+        m_offset = 0;
+    }
+    return true;
+}
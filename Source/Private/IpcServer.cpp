@@ -0,0 +1,483 @@
+﻿#include "IpcServer.h"
+#include "TranslationManager.h"
+#include "AppConfig.h"
+#include "Instrumentation.h"
+#include "TextEncoding.h"
+#include <vector>
+
+// 静态成员变量定义
+HANDLE IpcServer::s_hListenThread = nullptr;
+std::shared_ptr<IpcServer::Generation> IpcServer::s_generation;
+std::atomic<int> IpcServer::s_maxClients{ 16 };
+
+// 管道缓冲区大小
+static const DWORD PIPE_BUFFER_SIZE = 64 * 1024;
+
+// 一条Batch请求的条数上限
+static const uint32_t MAX_BATCH_ITEMS = 10000;
+
+/**
+ * @brief 关闭本代的事件句柄（最后一个持有者释放时）
+ */
+IpcServer::Generation::~Generation()
+{
+    if (hStopEvent)
+        CloseHandle(hStopEvent);
+    if (hClientsIdle)
+        CloseHandle(hClientsIdle);
+}
+
+/**
+ * @brief 关闭管道句柄
+ */
+IpcServer::Connection::~Connection()
+{
+    if (hPipe != INVALID_HANDLE_VALUE)
+        CloseHandle(hPipe);
+}
+
+/**
+ * @brief 获取当前会话的管道名
+ * @return 管道名
+ */
+std::wstring IpcServer::GetPipeName()
+{
+    DWORD sessionId = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &sessionId);
+    return L"\\\\.\\pipe\\YunsioTranslation." + std::to_wstring(sessionId);
+}
+
+/**
+ * @brief 按当前配置启动或停止服务
+ */
+void IpcServer::ApplyConfig()
+{
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    s_maxClients = config->serverMaxClients;
+    if (config->serverEnabled && s_hListenThread == nullptr)
+        Start();
+    else if (!config->serverEnabled && s_hListenThread != nullptr)
+        Stop(1000);
+}
+
+/**
+ * @brief 停止服务
+ * @param timeoutMs 等待读取线程退出的最长时间（毫秒）
+ */
+void IpcServer::Cleanup(DWORD timeoutMs)
+{
+    if (s_hListenThread != nullptr)
+        Stop(timeoutMs);
+}
+
+/**
+ * @brief 启动监听线程
+ * @return 成功返回true
+ */
+bool IpcServer::Start()
+{
+    std::shared_ptr<Generation> generation = std::make_shared<Generation>();
+    generation->hStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    generation->hClientsIdle = CreateEventW(nullptr, TRUE, TRUE, nullptr);
+    if (generation->hStopEvent == nullptr || generation->hClientsIdle == nullptr)
+        return false;
+
+    // 监听线程持有本代的一份引用，线程退出时释放
+    std::shared_ptr<Generation>* threadRef = new std::shared_ptr<Generation>(generation);
+    s_hListenThread = CreateThread(nullptr, 0, ListenThreadProc, threadRef, 0, nullptr);
+    if (s_hListenThread == nullptr)
+    {
+        delete threadRef;
+        return false;
+    }
+    s_generation = std::move(generation);
+    return true;
+}
+
+/**
+ * @brief 停止监听线程和所有读取线程
+ * @param timeoutMs 等待读取线程退出的最长时间（毫秒）
+ */
+void IpcServer::Stop(DWORD timeoutMs)
+{
+    std::shared_ptr<Generation> generation = std::move(s_generation);
+    SetEvent(generation->hStopEvent);
+    WaitForSingleObject(s_hListenThread, INFINITE);
+    CloseHandle(s_hListenThread);
+    s_hListenThread = nullptr;
+
+    // 读取线程在等待I/O时同时等待停止事件，通常立即退出；超时未退出的线程仍持有本代，事件句柄随最后一个持有者释放
+    if (WaitForSingleObject(generation->hClientsIdle, timeoutMs) != WAIT_OBJECT_0)
+        Instrumentation::AddCounter("ipc.stop_timeouts");
+}
+
+/**
+ * @brief 等待重叠I/O完成，停止事件触发时取消I/O
+ * @param generation 所属的一代服务
+ * @param hPipe 管道句柄
+ * @param overlapped 重叠结构（hEvent已创建）
+ * @param transferred 输出传输的字节数
+ * @return I/O成功完成返回true
+ */
+bool IpcServer::WaitForIo(const Generation& generation, HANDLE hPipe, OVERLAPPED& overlapped, DWORD& transferred)
+{
+    HANDLE handles[2] = { overlapped.hEvent, generation.hStopEvent };
+    if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+        CancelIoEx(hPipe, &overlapped);
+    return GetOverlappedResult(hPipe, &overlapped, &transferred, TRUE) != FALSE;
+}
+
+/**
+ * @brief 监听线程：逐个创建管道实例并等待客户端连接
+ * @param param Generation的shared_ptr（由线程释放）
+ * @return 线程退出码
+ */
+DWORD WINAPI IpcServer::ListenThreadProc(LPVOID param)
+{
+    std::unique_ptr<std::shared_ptr<Generation>> threadRef(static_cast<std::shared_ptr<Generation>*>(param));
+    std::shared_ptr<Generation> generation = *threadRef;
+
+    std::wstring pipeName = GetPipeName();
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (overlapped.hEvent == nullptr)
+        return 1;
+
+    // 第一个实例要求管道名尚未被占用，防止其他进程抢先创建同名管道冒充本服务
+    DWORD firstInstance = FILE_FLAG_FIRST_PIPE_INSTANCE;
+    while (WaitForSingleObject(generation->hStopEvent, 0) != WAIT_OBJECT_0)
+    {
+        HANDLE hPipe = CreateNamedPipeW(pipeName.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | firstInstance,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, nullptr);
+        if (hPipe == INVALID_HANDLE_VALUE)
+        {
+            OutputDebugStringW((L"[IpcServer] 创建管道失败: " + std::to_wstring(GetLastError()) + L"\n").c_str());
+            break;
+        }
+        firstInstance = 0;
+
+        ResetEvent(overlapped.hEvent);
+        bool connected = ConnectNamedPipe(hPipe, &overlapped) != FALSE;
+        if (!connected)
+        {
+            DWORD error = GetLastError();
+            DWORD transferred = 0;
+            connected = error == ERROR_PIPE_CONNECTED || (error == ERROR_IO_PENDING && WaitForIo(*generation, hPipe, overlapped, transferred));
+        }
+        if (!connected)
+        {
+            CloseHandle(hPipe);
+            continue;
+        }
+
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->hPipe = hPipe;
+        connection->generation = generation;
+        Instrumentation::AddCounter("ipc.connections");
+        if (generation->clientCount >= s_maxClients)
+        {
+            SendError(*connection, 0, "连接数已达上限");
+            continue;
+        }
+
+        // 读取线程持有连接的一份引用，线程退出时释放
+        if (generation->clientCount++ == 0)
+            ResetEvent(generation->hClientsIdle);
+        std::shared_ptr<Connection>* threadRef = new std::shared_ptr<Connection>(connection);
+        HANDLE hThread = CreateThread(nullptr, 0, ClientThreadProc, threadRef, 0, nullptr);
+        if (hThread == nullptr)
+        {
+            delete threadRef;
+            if (--generation->clientCount == 0)
+                SetEvent(generation->hClientsIdle);
+            continue;
+        }
+        CloseHandle(hThread);
+        Instrumentation::SetGauge("ipc.clients", generation->clientCount);
+    }
+
+    CloseHandle(overlapped.hEvent);
+    return 0;
+}
+
+/**
+ * @brief 读取线程：解码请求帧并分发
+ * @param param Connection的shared_ptr（由线程释放）
+ * @return 线程退出码
+ */
+DWORD WINAPI IpcServer::ClientThreadProc(LPVOID param)
+{
+    std::unique_ptr<std::shared_ptr<Connection>> threadRef(static_cast<std::shared_ptr<Connection>*>(param));
+    std::shared_ptr<Connection> connection = *threadRef;
+    std::shared_ptr<Generation> generation = connection->generation;
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (overlapped.hEvent != nullptr)
+    {
+        IpcFrameDecoder decoder;
+        IpcFrame frame;
+        std::vector<char> buffer(PIPE_BUFFER_SIZE);
+        bool healthy = true;
+        while (healthy)
+        {
+            ResetEvent(overlapped.hEvent);
+            DWORD transferred = 0;
+            if (!ReadFile(connection->hPipe, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, &overlapped) &&
+                GetLastError() != ERROR_IO_PENDING)
+            {
+                break;
+            }
+            if (!WaitForIo(*generation, connection->hPipe, overlapped, transferred) || transferred == 0)
+                break;
+
+            decoder.Feed(buffer.data(), transferred);
+            while (healthy && decoder.Next(frame))
+                healthy = HandleFrame(connection, frame);
+            if (decoder.HasError())
+            {
+                SendError(*connection, 0, "帧格式或协议版本不符");
+                healthy = false;
+            }
+        }
+        CloseHandle(overlapped.hEvent);
+    }
+
+    // 断开后尚未开始的条目不再翻译，已开始的请求写回时直接丢弃
+    connection->closed = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->requestMutex);
+        for (auto& request : connection->requests)
+            *request.second = true;
+    }
+    CancelIoEx(connection->hPipe, nullptr);
+
+    int remaining = --generation->clientCount;
+    Instrumentation::SetGauge("ipc.clients", remaining);
+    connection.reset();
+    threadRef.reset();
+    if (remaining == 0)
+        SetEvent(generation->hClientsIdle);
+    return 0;
+}
+
+/**
+ * @brief 向客户端写出完整的帧
+ * @param connection 连接
+ * @param frames 已编码的帧
+ * @return 成功返回true
+ */
+bool IpcServer::Send(Connection& connection, const std::string& frames)
+{
+    if (connection.closed)
+        return false;
+
+    std::lock_guard<std::mutex> lock(connection.writeMutex);
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (overlapped.hEvent == nullptr)
+        return false;
+
+    size_t offset = 0;
+    bool success = true;
+    while (success && offset < frames.length())
+    {
+        ResetEvent(overlapped.hEvent);
+        DWORD transferred = 0;
+        DWORD chunk = static_cast<DWORD>(frames.length() - offset);
+        if (!WriteFile(connection.hPipe, frames.data() + offset, chunk, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+            success = false;
+        else if (!WaitForIo(*connection.generation, connection.hPipe, overlapped, transferred) || transferred == 0)
+            success = false;
+        offset += transferred;
+    }
+    CloseHandle(overlapped.hEvent);
+    if (!success)
+        connection.closed = true;
+    return success;
+}
+
+/**
+ * @brief 向客户端写出错误帧
+ * @param connection 连接
+ * @param requestId 请求编号
+ * @param message 错误信息（UTF-8）
+ */
+void IpcServer::SendError(Connection& connection, uint32_t requestId, const std::string& message)
+{
+    std::string payload;
+    IpcProtocol::PutString(message, payload);
+    std::string frame;
+    IpcProtocol::EncodeFrame(IpcFrameType::Error, requestId, payload, frame);
+    Send(connection, frame);
+}
+
+/**
+ * @brief 处理一个请求帧
+ * @param connection 连接
+ * @param frame 请求帧
+ * @return 帧格式正确返回true
+ */
+bool IpcServer::HandleFrame(const std::shared_ptr<Connection>& connection, const IpcFrame& frame)
+{
+    if (frame.type == IpcFrameType::Cancel)
+    {
+        std::lock_guard<std::mutex> lock(connection->requestMutex);
+        auto it = connection->requests.find(frame.requestId);
+        if (it != connection->requests.end())
+            *it->second = true;
+        return true;
+    }
+    if (frame.type != IpcFrameType::Translate && frame.type != IpcFrameType::Batch && frame.type != IpcFrameType::Stream)
+        return false;
+
+    size_t offset = 0;
+    std::string profileName;
+    if (!IpcProtocol::ReadString(frame.payload, offset, profileName))
+        return false;
+
+    std::vector<std::string> texts;
+    uint32_t count = 1;
+    if (frame.type == IpcFrameType::Batch && (!IpcProtocol::ReadU32(frame.payload, offset, count) || count > MAX_BATCH_ITEMS))
+        return false;
+    texts.resize(count);
+    for (std::string& text : texts)
+    {
+        if (!IpcProtocol::ReadString(frame.payload, offset, text))
+            return false;
+    }
+
+    // 配置档名称为空时使用第一个配置档
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    std::shared_ptr<const TranslationProfile> profile = profileName.empty() ?
+        (config->profiles.empty() ? nullptr : config->profiles.front()) : config->FindProfile(profileName);
+    if (!profile)
+    {
+        SendError(*connection, frame.requestId, "找不到翻译配置档：" + profileName);
+        return true;
+    }
+
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    {
+        std::lock_guard<std::mutex> lock(connection->requestMutex);
+        if (!connection->requests.emplace(frame.requestId, cancelled).second)
+        {
+            SendError(*connection, frame.requestId, "请求编号正在使用");
+            return true;
+        }
+    }
+    Instrumentation::AddCounter("ipc.requests");
+    Instrumentation::AddCounter("ipc.items", count);
+
+    if (frame.type == IpcFrameType::Batch && count == 0)
+    {
+        FinishRequest(*connection, frame.requestId);
+        std::string payload;
+        IpcProtocol::PutU32(0, payload);
+        std::string done;
+        IpcProtocol::EncodeFrame(IpcFrameType::Done, frame.requestId, payload, done);
+        Send(*connection, done);
+        return true;
+    }
+
+    std::shared_ptr<std::atomic<uint32_t>> remaining;
+    if (frame.type == IpcFrameType::Batch)
+        remaining = std::make_shared<std::atomic<uint32_t>>(count);
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        if (!SubmitItem(connection, frame.requestId, index, count, profile, std::move(texts[index]), cancelled, remaining,
+            frame.type == IpcFrameType::Stream))
+        {
+            // 调度器已停止（程序正在退出）
+            FinishRequest(*connection, frame.requestId);
+            SendError(*connection, frame.requestId, "翻译服务正在退出");
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 提交一条翻译
+ * @param connection 连接
+ * @param requestId 请求编号
+ * @param index 条目索引
+ * @param count 请求的总条数
+ * @param profile 翻译配置档
+ * @param text 原文（UTF-8）
+ * @param cancelled 请求的取消标志
+ * @param remaining 请求尚未完成的条数（Translate和Stream请求为nullptr）
+ * @param stream 是否在译文到达时写出Partial帧
+ * @return 已排队返回true
+ */
+bool IpcServer::SubmitItem(const std::shared_ptr<Connection>& connection, uint32_t requestId, uint32_t index, uint32_t count,
+    std::shared_ptr<const TranslationProfile> profile, std::string text,
+    std::shared_ptr<std::atomic<bool>> cancelled, std::shared_ptr<std::atomic<uint32_t>> remaining, bool stream)
+{
+    RequestScheduler::Job job = [connection, requestId, index, count, profile, text = std::move(text), cancelled, remaining, stream](const std::atomic<bool>& preempted)
+    {
+        std::string frames;
+        if (*cancelled || connection->closed)
+        {
+            IpcProtocol::EncodeResult(requestId, index, IpcStatus::Cancelled, std::string(), frames);
+        }
+        else
+        {
+            // 每块响应写出新增的完整字符；超时重试时译文从头开始，写出偏移为0的片段让客户端截断
+            size_t sent = 0;
+            TranslationService::ProgressCallback progress = [&connection, requestId, &sent](const std::string& content)
+            {
+                bool restarted = content.length() < sent;
+                if (restarted)
+                    sent = 0;
+                size_t end = IpcProtocol::CompleteUtf8Length(content);
+                if (end <= sent && !restarted)
+                    return;
+                std::string partial;
+                IpcProtocol::EncodePartial(requestId, static_cast<uint32_t>(sent), content.data() + sent, end - sent, partial);
+                Send(*connection, partial);
+                sent = end;
+            };
+
+            std::wstring result;
+            bool cached = false;
+            bool success = TranslationManager::WaitForService() &&
+                TranslationManager::TranslateText(*profile, TextEncoding::Utf8ToWide(text), result, cached, &preempted,
+                    stream ? progress : nullptr);
+            if (!success && preempted)
+                return false;   // 被热键翻译抢占的批量条目重新排队
+            if (!success && result.empty())
+                result = L"翻译服务不可用";
+            IpcProtocol::EncodeResult(requestId, index, success ? (cached ? IpcStatus::Cached : IpcStatus::Ok) : IpcStatus::Failed,
+                TextEncoding::WideToUtf8(result), frames);
+        }
+
+        // 最后一条完成时连同Done一起写出
+        if (!remaining || --*remaining == 0)
+        {
+            FinishRequest(*connection, requestId);
+            if (remaining)
+            {
+                std::string payload;
+                IpcProtocol::PutU32(count, payload);
+                IpcProtocol::EncodeFrame(IpcFrameType::Done, requestId, payload, frames);
+            }
+        }
+        Send(*connection, frames);
+        return true;
+    };
+
+    return remaining ? TranslationManager::SubmitBackground(std::move(job)) : TranslationManager::SubmitClient(std::move(job));
+}
+
+/**
+ * @brief 请求的全部条目完成后注销请求编号
+ * @param connection 连接
+ * @param requestId 请求编号
+ */
+void IpcServer::FinishRequest(Connection& connection, uint32_t requestId)
+{
+    std::lock_guard<std::mutex> lock(connection.requestMutex);
+    connection.requests.erase(requestId);
+}
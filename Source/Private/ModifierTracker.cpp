@@ -0,0 +1,128 @@
+﻿#include "ModifierTracker.h"
+#include "TranslationProfile.h"
+
+namespace
+{
+    // 物理修饰键：左右键各占一位，低两位为Shift，依次为Ctrl、Alt、Win
+    const uint32_t KEY_COUNT = 8;
+    const uint32_t KEY_MODIFIERS[KEY_COUNT] =
+    {
+        HotkeyBinding::MOD_SHIFT_FLAG, HotkeyBinding::MOD_SHIFT_FLAG,
+        HotkeyBinding::MOD_CONTROL_FLAG, HotkeyBinding::MOD_CONTROL_FLAG,
+        HotkeyBinding::MOD_ALT_FLAG, HotkeyBinding::MOD_ALT_FLAG,
+        HotkeyBinding::MOD_WIN_FLAG, HotkeyBinding::MOD_WIN_FLAG
+    };
+
+    // 虚拟键码对应的物理键位，不是修饰键返回-1（通用键码按左键处理）
+    int KeyBit(uint32_t virtualKey)
+    {
+        switch (virtualKey)
+        {
+        case 0xA0: case 0x10: return 0;     // VK_LSHIFT、VK_SHIFT
+        case 0xA1: return 1;                // VK_RSHIFT
+        case 0xA2: case 0x11: return 2;     // VK_LCONTROL、VK_CONTROL
+        case 0xA3: return 3;                // VK_RCONTROL
+        case 0xA4: case 0x12: return 4;     // VK_LMENU、VK_MENU
+        case 0xA5: return 5;                // VK_RMENU
+        case 0x5B: return 6;                // VK_LWIN
+        case 0x5C: return 7;                // VK_RWIN
+        default: return -1;
+        }
+    }
+}
+
+/**
+ * @brief 获取虚拟键码对应的修饰键
+ * @param virtualKey 虚拟键码
+ * @return 修饰键标志，不是修饰键返回0
+ */
+uint32_t ModifierTracker::ModifierOf(uint32_t virtualKey)
+{
+    int bit = KeyBit(virtualKey);
+    return bit < 0 ? 0 : KEY_MODIFIERS[bit];
+}
+
+/**
+ * @brief 开始等待
+ * @param now 当前时间（毫秒）
+ * @param timeoutMs 最长等待时间（毫秒）
+ * @param modifiers 需要等待释放的修饰键
+ */
+void ModifierTracker::Arm(uint64_t now, uint32_t timeoutMs, uint32_t modifiers)
+{
+    m_state = State::Waiting;
+    m_heldKeys = 0;
+    m_modifiers = modifiers;
+    m_deadline = now + timeoutMs;
+}
+
+/**
+ * @brief 处理一个键盘事件
+ * @param virtualKey 虚拟键码
+ * @param keyDown 按下为true，抬起为false
+ * @return 处理后的状态
+ */
+ModifierTracker::State ModifierTracker::OnKey(uint32_t virtualKey, bool keyDown)
+{
+    int bit = KeyBit(virtualKey);
+    if (m_state != State::Waiting || bit < 0 || (KEY_MODIFIERS[bit] & m_modifiers) == 0)
+        return m_state;
+
+    // 等待期间重新按下的修饰键同样要等它释放
+    if (keyDown)
+    {
+        m_heldKeys |= 1u << bit;
+        return m_state;
+    }
+
+    // 抬起通用键码时无法区分左右，按该修饰键的两个物理键都已释放处理
+    if (virtualKey == 0x10 || virtualKey == 0x11 || virtualKey == 0x12)
+        m_heldKeys &= ~(3u << bit);
+    else
+        m_heldKeys &= ~(1u << bit);
+    if (m_heldKeys == 0)
+        m_state = State::Released;
+    return m_state;
+}
+
+/**
+ * @brief 检查是否已全部释放或到达期限
+ * @param now 当前时间（毫秒）
+ * @return 检查后的状态
+ */
+ModifierTracker::State ModifierTracker::OnTick(uint64_t now)
+{
+    if (m_state != State::Waiting)
+        return m_state;
+    if (m_heldKeys == 0)
+        m_state = State::Released;
+    else if (now >= m_deadline)
+        m_state = State::TimedOut;
+    return m_state;
+}
+
+/**
+ * @brief 结束等待
+ */
+void ModifierTracker::Reset()
+{
+    m_state = State::Idle;
+    m_heldKeys = 0;
+    m_modifiers = 0;
+    m_deadline = 0;
+}
+
+/**
+ * @brief 获取仍按下的修饰键
+ * @return 修饰键标志
+ */
+uint32_t ModifierTracker::GetHeldModifiers() const
+{
+    uint32_t modifiers = 0;
+    for (uint32_t bit = 0; bit < KEY_COUNT; ++bit)
+    {
+        if (m_heldKeys & (1u << bit))
+            modifiers |= KEY_MODIFIERS[bit];
+    }
+    return modifiers;
+}
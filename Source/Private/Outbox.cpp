@@ -0,0 +1,292 @@
+﻿#include "Outbox.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+
+// 静态成员变量定义
+std::vector<Outbox::Slot> Outbox::s_slots;
+std::string Outbox::s_path;
+uint64_t Outbox::s_nextId = 1;
+std::mutex Outbox::s_mutex;
+
+// 首次重放失败后的退避时间和退避上限
+static const std::chrono::seconds INITIAL_BACKOFF(5);
+static const std::chrono::minutes MAX_BACKOFF(10);
+
+/**
+ * @brief 转义字段中的反斜杠、制表符和换行符，使每条请求占一行
+ * @param text 原文
+ * @return 转义后的文本
+ */
+static std::string EscapeField(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.length());
+    for (char ch : text)
+    {
+        switch (ch)
+        {
+            case '\\': escaped += "\\\\"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            default: escaped += ch; break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief 还原EscapeField转义的字段
+ * @param text 转义后的文本
+ * @return 原文
+ */
+static std::string UnescapeField(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.length());
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        if (text[i] != '\\' || i + 1 == text.length())
+        {
+            result += text[i];
+            continue;
+        }
+        char next = text[++i];
+        result += next == 't' ? '\t' : next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+    }
+    return result;
+}
+
+/**
+ * @brief 从文件加载队列
+ * @param path 队列文件路径（UTF-8）
+ */
+void Outbox::Initialize(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_path = path;
+    s_slots.clear();
+
+    // 每行一条请求："失败次数\t配置档\t原文"
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    std::string line;
+    Clock::time_point now = Clock::now();
+    while (std::getline(file, line) && s_slots.size() < MAX_ENTRIES)
+    {
+        size_t first = line.find('\t');
+        size_t second = first == std::string::npos ? std::string::npos : line.find('\t', first + 1);
+        if (second == std::string::npos)
+            continue;
+
+        Slot slot;
+        slot.entry.id = s_nextId++;
+        slot.entry.attempts = std::atoi(line.substr(0, first).c_str());
+        slot.entry.profile = UnescapeField(line.substr(first + 1, second - first - 1));
+        slot.entry.source = UnescapeField(line.substr(second + 1));
+        slot.dueTime = now;
+        if (!slot.entry.source.empty())
+            s_slots.push_back(std::move(slot));
+    }
+    Instrumentation::SetGauge("outbox.pending", static_cast<double>(s_slots.size()));
+}
+
+/**
+ * @brief 清空内存中的队列
+ */
+void Outbox::Cleanup()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_slots.clear();
+    s_path.clear();
+}
+
+/**
+ * @brief 加入队列
+ * @param profile 配置档名称
+ * @param source 原文（UTF-8）
+ * @return 新加入返回true，已在队列中返回false
+ */
+bool Outbox::Enqueue(const std::string& profile, const std::string& source)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (const Slot& slot : s_slots)
+    {
+        if (slot.entry.profile == profile && slot.entry.source == source)
+            return false;
+    }
+
+    // 队列已满时丢弃最早且未在重放中的请求
+    if (s_slots.size() >= MAX_ENTRIES)
+    {
+        auto oldest = std::find_if(s_slots.begin(), s_slots.end(), [](const Slot& slot) { return !slot.taken; });
+        if (oldest == s_slots.end())
+            return false;
+        s_slots.erase(oldest);
+        Instrumentation::AddCounter("outbox.dropped");
+    }
+
+    Slot slot;
+    slot.entry.id = s_nextId++;
+    slot.entry.profile = profile;
+    slot.entry.source = source;
+    slot.dueTime = Clock::now() + INITIAL_BACKOFF;
+    s_slots.push_back(std::move(slot));
+    Instrumentation::AddCounter("outbox.enqueued");
+    SaveLocked();
+    return true;
+}
+
+/**
+ * @brief 取出一条已到重放时间的请求
+ * @param now 当前时间
+ * @param entry 输出请求
+ * @return 有到期请求返回true
+ */
+bool Outbox::TakeDue(Clock::time_point now, OutboxEntry& entry)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (Slot& slot : s_slots)
+    {
+        if (!slot.taken && slot.dueTime <= now)
+        {
+            slot.taken = true;
+            entry = slot.entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 重放成功，从队列移除
+ * @param id 请求编号
+ */
+void Outbox::Complete(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    size_t index = FindLocked(id);
+    if (index == SIZE_MAX)
+        return;
+    s_slots.erase(s_slots.begin() + index);
+    Instrumentation::AddCounter("outbox.replayed");
+    SaveLocked();
+}
+
+/**
+ * @brief 重放失败，按退避时间推迟
+ * @param id 请求编号
+ * @param now 当前时间
+ */
+void Outbox::Retry(uint64_t id, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    size_t index = FindLocked(id);
+    if (index == SIZE_MAX)
+        return;
+
+    Slot& slot = s_slots[index];
+    if (++slot.entry.attempts >= MAX_ATTEMPTS)
+    {
+        s_slots.erase(s_slots.begin() + index);
+        Instrumentation::AddCounter("outbox.dropped");
+    }
+    else
+    {
+        slot.taken = false;
+        slot.dueTime = now + GetBackoff(slot.entry.attempts);
+    }
+    SaveLocked();
+}
+
+/**
+ * @brief 重放被中断，放回队列
+ * @param id 请求编号
+ */
+void Outbox::Release(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    size_t index = FindLocked(id);
+    if (index != SIZE_MAX)
+        s_slots[index].taken = false;
+}
+
+/**
+ * @brief 是否有已到重放时间且未被取出的请求
+ * @param now 当前时间
+ * @return 有返回true
+ */
+bool Outbox::HasDue(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return std::any_of(s_slots.begin(), s_slots.end(),
+        [now](const Slot& slot) { return !slot.taken && slot.dueTime <= now; });
+}
+
+/**
+ * @brief 获取队列中的请求数
+ * @return 请求数
+ */
+size_t Outbox::GetCount()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_slots.size();
+}
+
+/**
+ * @brief 计算退避时间：5秒起每次翻倍，最长10分钟
+ * @param attempts 已失败次数（从1开始）
+ * @return 退避时间
+ */
+Outbox::Clock::duration Outbox::GetBackoff(int attempts)
+{
+    Clock::duration backoff = INITIAL_BACKOFF;
+    for (int i = 1; i < attempts && backoff < MAX_BACKOFF; ++i)
+        backoff *= 2;
+    return std::min<Clock::duration>(backoff, MAX_BACKOFF);
+}
+
+/**
+ * @brief 按编号查找请求（调用方持有锁）
+ * @param id 请求编号
+ * @return 找到返回下标，否则返回SIZE_MAX
+ */
+size_t Outbox::FindLocked(uint64_t id)
+{
+    for (size_t i = 0; i < s_slots.size(); ++i)
+    {
+        if (s_slots[i].entry.id == id)
+            return i;
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @brief 将队列写入文件并上报队列长度（调用方持有锁）
+ */
+void Outbox::SaveLocked()
+{
+    Instrumentation::SetGauge("outbox.pending", static_cast<double>(s_slots.size()));
+    if (s_path.empty())
+        return;
+
+    // 先写临时文件再替换，写入中途退出不会损坏已有队列
+    std::filesystem::path path = std::filesystem::u8path(s_path);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        for (const Slot& slot : s_slots)
+            file << slot.entry.attempts << '\t' << EscapeField(slot.entry.profile) << '\t' << EscapeField(slot.entry.source) << '\n';
+        if (!file)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+}
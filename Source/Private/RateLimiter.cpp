@@ -0,0 +1,417 @@
+﻿#include "RateLimiter.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+
+// 静态成员变量定义
+RateLimiter::Bucket RateLimiter::s_requests;
+RateLimiter::Bucket RateLimiter::s_tokens;
+RateLimiter::Clock::time_point RateLimiter::s_pausedUntil;
+bool RateLimiter::s_bDelaying = false;
+DailyUsage RateLimiter::s_daily;
+DailyUsage RateLimiter::s_unsaved;
+std::string RateLimiter::s_statePath;
+std::mutex RateLimiter::s_mutex;
+std::mutex RateLimiter::s_flushMutex;
+const int RateLimiter::FLUSH_INTERVAL_MS;
+
+// 服务端返回429后暂停启动新请求的时长
+static const std::chrono::seconds THROTTLE_PAUSE(5);
+
+// 等待配额期间检查取消信号的间隔
+static const std::chrono::milliseconds ACQUIRE_POLL(50);
+
+// 用量文件锁：获取锁的最长等待时间、重试间隔，以及视为残留（持有进程已崩溃）的锁龄
+static const std::chrono::milliseconds FILE_LOCK_TIMEOUT(1000);
+static const std::chrono::milliseconds FILE_LOCK_RETRY(10);
+static const std::chrono::seconds FILE_LOCK_STALE(10);
+
+/**
+ * @class QuotaFileLock
+ * @brief 用量文件的跨进程锁（常驻实例和批处理实例共用同一个用量文件）
+ *
+ * 以“创建锁目录”作为原子操作，目录已存在说明其他进程持有锁；超时仍拿不到锁时只读不写，
+ * 避免覆盖其他进程正在写入的用量
+ */
+class QuotaFileLock
+{
+public:
+    /**
+     * @brief 获取锁，最多等待FILE_LOCK_TIMEOUT
+     * @param statePath 用量文件路径，锁目录为同名加“.lock”
+     */
+    explicit QuotaFileLock(const std::filesystem::path& statePath)
+        : m_path(statePath)
+    {
+        m_path += ".lock";
+        std::error_code error;
+        auto deadline = std::chrono::steady_clock::now() + FILE_LOCK_TIMEOUT;
+        for (;;)
+        {
+            if (std::filesystem::create_directory(m_path, error))
+            {
+                m_bLocked = true;
+                return;
+            }
+
+            // 持有锁的进程崩溃时锁目录会残留，超过锁龄后清除
+            auto modified = std::filesystem::last_write_time(m_path, error);
+            if (!error && std::filesystem::file_time_type::clock::now() - modified > FILE_LOCK_STALE)
+            {
+                std::filesystem::remove(m_path, error);
+                continue;
+            }
+            if (std::chrono::steady_clock::now() > deadline)
+                return;
+            std::this_thread::sleep_for(FILE_LOCK_RETRY);
+        }
+    }
+
+    /**
+     * @brief 释放锁
+     */
+    ~QuotaFileLock()
+    {
+        std::error_code error;
+        if (m_bLocked)
+            std::filesystem::remove(m_path, error);
+    }
+
+    QuotaFileLock(const QuotaFileLock&) = delete;
+    QuotaFileLock& operator=(const QuotaFileLock&) = delete;
+
+    /**
+     * @brief 是否已获取锁
+     * @return 获取成功返回true，等待超时返回false
+     */
+    bool IsLocked() const { return m_bLocked; }
+
+private:
+    std::filesystem::path m_path;
+    bool m_bLocked = false;
+};
+
+/**
+ * @brief 获取本地日期
+ * @return YYYY-MM-DD
+ */
+static std::string GetLocalDate()
+{
+    std::time_t now = std::time(nullptr);
+    std::tm localTime = {};
+#ifdef _WIN32
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y-%m-%d", &localTime);
+    return date;
+}
+
+/**
+ * @brief 设置桶容量，从不限变为限制时按满桶开始
+ * @param perMinute 每分钟配额，0表示不限
+ * @param now 当前时间
+ */
+void RateLimiter::Bucket::Configure(int perMinute, Clock::time_point now)
+{
+    double newCapacity = std::max(perMinute, 0);
+    if (capacity == 0)
+        level = newCapacity;
+    else
+        level = std::min(level, newCapacity);
+    capacity = newCapacity;
+    lastRefill = now;
+}
+
+/**
+ * @brief 按流逝时间补充令牌
+ * @param now 当前时间
+ */
+void RateLimiter::Bucket::Refill(Clock::time_point now)
+{
+    if (capacity == 0 || now <= lastRefill)
+        return;
+    double elapsedSeconds = std::chrono::duration<double>(now - lastRefill).count();
+    level = std::min(capacity, level + elapsedSeconds * capacity / 60.0);
+    lastRefill = now;
+}
+
+/**
+ * @brief 计算令牌数补充到目标值所需的时间
+ * @param target 目标令牌数
+ * @return 秒数，已达到时为0
+ */
+double RateLimiter::Bucket::SecondsUntil(double target) const
+{
+    if (capacity == 0 || level >= target)
+        return 0;
+    return (target - level) * 60.0 / capacity;
+}
+
+/**
+ * @brief 加载当日累计用量
+ * @param statePath 用量文件路径（UTF-8）
+ */
+void RateLimiter::Initialize(const std::string& statePath)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_statePath = statePath;
+    s_daily = DailyUsage();
+    s_daily.date = GetLocalDate();
+    s_unsaved = DailyUsage();
+    s_unsaved.date = s_daily.date;
+
+    if (!statePath.empty())
+    {
+        QuotaFileLock fileLock(std::filesystem::u8path(statePath));
+        LoadDaily(statePath, s_daily);
+    }
+    ReportGauges();
+}
+
+/**
+ * @brief 保存当日累计用量
+ */
+void RateLimiter::Cleanup()
+{
+    Flush();
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_statePath.clear();
+}
+
+/**
+ * @brief 把上次保存以来的用量合并进用量文件
+ * @return 已保存或没有需要保存的用量返回true，否则返回false
+ *
+ * 其他进程（如批处理实例）可能在此期间写过文件，因此在文件锁内重新读取文件，
+ * 加上本进程未保存的增量后写回，并以合并结果作为本进程看到的当日用量
+ */
+bool RateLimiter::Flush()
+{
+    std::lock_guard<std::mutex> flushLock(s_flushMutex);
+
+    // 取走未保存的增量后释放限流锁，文件锁的等待和读写期间其他线程照常获取配额、记录用量
+    std::string path;
+    DailyUsage pending;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        RollDate();
+        if (s_statePath.empty() || (s_unsaved.requests == 0 && s_unsaved.promptTokens == 0 && s_unsaved.completionTokens == 0))
+            return true;
+        path = s_statePath;
+        pending = s_unsaved;
+        s_unsaved = DailyUsage();
+        s_unsaved.date = pending.date;
+    }
+
+    DailyUsage merged;
+    merged.date = pending.date;
+    bool saved = false;
+    {
+        QuotaFileLock fileLock(std::filesystem::u8path(path));
+        if (fileLock.IsLocked())
+        {
+            LoadDaily(path, merged);
+            merged.requests += pending.requests;
+            merged.promptTokens += pending.promptTokens;
+            merged.completionTokens += pending.completionTokens;
+            std::ofstream file(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+            saved = static_cast<bool>(file << merged.date << ' ' << merged.requests << ' ' << merged.promptTokens << ' '
+                << merged.completionTokens << '\n' << std::flush);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_daily.date != pending.date)
+        return saved;
+    if (!saved)
+    {
+        // 拿不到文件锁或写入失败：增量放回，下次保存时再合并
+        s_unsaved.requests += pending.requests;
+        s_unsaved.promptTokens += pending.promptTokens;
+        s_unsaved.completionTokens += pending.completionTokens;
+        Instrumentation::AddCounter("ratelimit.save_deferred");
+        return false;
+    }
+
+    // 合并结果加上保存期间本进程新增的用量
+    s_daily = merged;
+    s_daily.requests += s_unsaved.requests;
+    s_daily.promptTokens += s_unsaved.promptTokens;
+    s_daily.completionTokens += s_unsaved.completionTokens;
+    ReportGauges();
+    return true;
+}
+
+/**
+ * @brief 设置配额
+ * @param requestsPerMinute 每分钟请求数，0表示不限
+ * @param tokensPerMinute 每分钟token数，0表示不限
+ */
+void RateLimiter::SetLimits(int requestsPerMinute, int tokensPerMinute)
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_requests.Refill(now);
+    s_tokens.Refill(now);
+    s_requests.Configure(requestsPerMinute, now);
+    s_tokens.Configure(tokensPerMinute, now);
+    ReportGauges();
+}
+
+/**
+ * @brief 尝试为一个请求获取配额
+ * @param now 当前时间
+ * @param retryTime 配额不足时输出可重试的时间
+ * @return 获取成功返回true
+ */
+bool RateLimiter::TryAcquire(Clock::time_point now, Clock::time_point& retryTime)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    s_requests.Refill(now);
+    s_tokens.Refill(now);
+
+    // 需要一个完整的请求令牌，token桶只要不为负即可（本次请求的用量事后扣除）
+    double waitSeconds = std::max(s_requests.SecondsUntil(1.0), s_tokens.SecondsUntil(0.0));
+    Clock::time_point readyTime = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(waitSeconds));
+    readyTime = std::max(readyTime, s_pausedUntil);
+    if (readyTime > now)
+    {
+        if (!s_bDelaying)
+            Instrumentation::AddCounter("ratelimit.delayed");
+        s_bDelaying = true;
+        Instrumentation::SetGauge("ratelimit.wait_ms", std::chrono::duration<double, std::milli>(readyTime - now).count());
+        retryTime = readyTime;
+        return false;
+    }
+
+    s_bDelaying = false;
+    if (s_requests.capacity > 0)
+        s_requests.level -= 1.0;
+
+    RollDate();
+    s_daily.requests++;
+    s_unsaved.requests++;
+    ReportGauges();
+    return true;
+}
+
+/**
+ * @brief 为一个请求获取配额，配额不足时等待
+ * @param cancel 取消信号，可为nullptr
+ * @return 获取成功返回true，等待期间被取消返回false
+ */
+bool RateLimiter::Acquire(const std::atomic<bool>* cancel)
+{
+    for (;;)
+    {
+        if (cancel != nullptr && cancel->load())
+            return false;
+
+        Clock::time_point now = Clock::now();
+        Clock::time_point retryTime;
+        if (TryAcquire(now, retryTime))
+            return true;
+        std::this_thread::sleep_until(std::min(retryTime, now + ACQUIRE_POLL));
+    }
+}
+
+/**
+ * @brief 按响应中的usage扣除token配额并累加当日用量
+ * @param promptTokens 输入token数
+ * @param completionTokens 输出token数
+ */
+void RateLimiter::RecordUsage(int64_t promptTokens, int64_t completionTokens)
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_tokens.Refill(now);
+    if (s_tokens.capacity > 0)
+        s_tokens.level -= static_cast<double>(promptTokens + completionTokens);
+
+    RollDate();
+    s_daily.promptTokens += promptTokens;
+    s_daily.completionTokens += completionTokens;
+    s_unsaved.promptTokens += promptTokens;
+    s_unsaved.completionTokens += completionTokens;
+    ReportGauges();
+}
+
+/**
+ * @brief 服务端返回429时清空请求令牌并暂停一段时间
+ */
+void RateLimiter::OnThrottled()
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_requests.Refill(now);
+    s_requests.level = std::min(s_requests.level, 0.0);
+    s_pausedUntil = now + THROTTLE_PAUSE;
+    Instrumentation::AddCounter("ratelimit.throttled");
+    ReportGauges();
+}
+
+/**
+ * @brief 获取当日累计用量
+ * @return 当日用量
+ */
+DailyUsage RateLimiter::GetDailyUsage()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    RollDate();
+    return s_daily;
+}
+
+/**
+ * @brief 日期变化时清零当日用量（调用方持有锁）
+ */
+void RateLimiter::RollDate()
+{
+    std::string today = GetLocalDate();
+    if (s_daily.date != today)
+    {
+        s_daily = DailyUsage();
+        s_daily.date = today;
+        s_unsaved = DailyUsage();
+        s_unsaved.date = today;
+    }
+}
+
+/**
+ * @brief 读取用量文件（调用方持有文件锁）
+ * @param path 用量文件路径（UTF-8）
+ * @param usage 文件中的日期与usage.date相同时输出文件中的用量，否则不变
+ */
+void RateLimiter::LoadDaily(const std::string& path, DailyUsage& usage)
+{
+    // 文件内容为一行："日期 请求数 输入token数 输出token数"
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    DailyUsage saved;
+    if (file >> saved.date >> saved.requests >> saved.promptTokens >> saved.completionTokens &&
+        saved.date == usage.date)
+    {
+        usage = saved;
+    }
+}
+
+/**
+ * @brief 上报令牌桶和当日用量（调用方持有锁）
+ */
+void RateLimiter::ReportGauges()
+{
+    if (s_requests.capacity > 0)
+        Instrumentation::SetGauge("ratelimit.requests_available", s_requests.level);
+    if (s_tokens.capacity > 0)
+        Instrumentation::SetGauge("ratelimit.tokens_available", s_tokens.level);
+    Instrumentation::SetGauge("ratelimit.daily_requests", static_cast<double>(s_daily.requests));
+    Instrumentation::SetGauge("ratelimit.daily_tokens", static_cast<double>(s_daily.promptTokens + s_daily.completionTokens));
+}
@@ -0,0 +1,78 @@
+﻿#include "RequestArena.h"
+#include "Instrumentation.h"
+
+// 每次请求结束都会更新的指标名（超出短字符串容量），预先构造，避免Reset本身产生堆分配
+static const std::string RETAINED_BYTES_GAUGE = "arena.retained_bytes";
+
+/**
+ * @brief 获取当前线程的缓冲区集合
+ * @return 线程局部实例
+ */
+RequestArena& RequestArena::ForCurrentThread()
+{
+    thread_local RequestArena arena;
+    return arena;
+}
+
+/**
+ * @brief 清空全部缓冲区并保留容量
+ */
+void RequestArena::Reset()
+{
+    utf8Text.clear();
+    glossaryMatches.clear();
+    requestText.clear();
+    memoryMatch.source.clear();
+    memoryMatch.result.clear();
+    codeSegments.clear();
+    codeBatch.clear();
+    codeOutput.clear();
+    deltaBatch.clear();
+    deltaOutput.clear();
+    body.clear();
+    responseRing.Reset();
+    parser.Reset();
+    result.clear();
+
+    size_t capacity = GetCapacityBytes();
+    if (capacity > MAX_RETAINED_BYTES)
+    {
+        // 单次超大请求，释放内存避免长期占用
+        std::string().swap(utf8Text);
+        std::vector<GlossaryMatch>().swap(glossaryMatches);
+        std::string().swap(requestText);
+        std::string().swap(memoryMatch.source);
+        std::string().swap(memoryMatch.result);
+        std::vector<CodeSegment>().swap(codeSegments);
+        std::string().swap(codeBatch);
+        std::string().swap(codeOutput);
+        std::string().swap(deltaBatch);
+        std::string().swap(deltaOutput);
+        std::string().swap(body);
+        parser.ReleaseMemory();
+        std::wstring().swap(result);
+        capacity = GetCapacityBytes();
+        Instrumentation::AddCounter("arena.release");
+    }
+    else if (capacity > m_retainedBytes)
+    {
+        // 只有容量增长时才说明本次请求发生了分配
+        Instrumentation::AddCounter("arena.grow");
+    }
+
+    m_retainedBytes = capacity;
+    Instrumentation::SetGauge(RETAINED_BYTES_GAUGE, static_cast<double>(capacity));
+}
+
+/**
+ * @brief 获取全部缓冲区的总容量
+ * @return 字节数
+ */
+size_t RequestArena::GetCapacityBytes() const
+{
+    return utf8Text.capacity() + glossaryMatches.capacity() * sizeof(GlossaryMatch) + requestText.capacity()
+        + memoryMatch.source.capacity() + memoryMatch.result.capacity()
+        + codeSegments.capacity() * sizeof(CodeSegment) + codeBatch.capacity() + codeOutput.capacity()
+        + deltaBatch.capacity() + deltaOutput.capacity() + body.capacity() + responseRing.GetCapacity() + parser.GetCapacityBytes()
+        + result.capacity() * sizeof(wchar_t);
+}
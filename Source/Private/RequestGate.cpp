@@ -0,0 +1,102 @@
+﻿#include "RequestGate.h"
+
+/**
+ * @brief 移动赋值，先离开当前持有的闸门
+ * @param other 另一个通行证
+ * @return 自身
+ */
+RequestGate::Pass& RequestGate::Pass::operator=(Pass&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_pGate = other.m_pGate;
+        other.m_pGate = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * @brief 提前离开
+ */
+void RequestGate::Pass::Release()
+{
+    if (m_pGate != nullptr)
+    {
+        m_pGate->Leave();
+        m_pGate = nullptr;
+    }
+}
+
+/**
+ * @brief 打开闸门
+ */
+void RequestGate::Open()
+{
+    m_state.fetch_or(OPEN_FLAG, std::memory_order_acq_rel);
+}
+
+/**
+ * @brief 尝试进入
+ * @return 闸门打开时返回有效通行证，否则返回空通行证
+ */
+RequestGate::Pass RequestGate::TryEnter()
+{
+    uint32_t state = m_state.load(std::memory_order_acquire);
+    while ((state & OPEN_FLAG) != 0)
+    {
+        if (m_state.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            return Pass(this);
+    }
+    return Pass();
+}
+
+/**
+ * @brief 关闭闸门并等待进行中的调用全部离开
+ * @param timeout 最长等待时间
+ * @return 全部离开返回true，超时返回false
+ */
+bool RequestGate::CloseAndDrain(std::chrono::milliseconds timeout)
+{
+    m_state.fetch_and(~OPEN_FLAG, std::memory_order_acq_rel);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto drained = [this]() { return m_state.load(std::memory_order_acquire) == 0; };
+    if (timeout == std::chrono::milliseconds::max())
+    {
+        m_drained.wait(lock, drained);
+        return true;
+    }
+    return m_drained.wait_for(lock, timeout, drained);
+}
+
+/**
+ * @brief 闸门是否打开
+ * @return 打开返回true
+ */
+bool RequestGate::IsOpen() const
+{
+    return (m_state.load(std::memory_order_acquire) & OPEN_FLAG) != 0;
+}
+
+/**
+ * @brief 获取进行中的调用数
+ * @return 调用数
+ */
+uint32_t RequestGate::GetInFlight() const
+{
+    return m_state.load(std::memory_order_acquire) & ~OPEN_FLAG;
+}
+
+/**
+ * @brief 离开闸门，关闭后的最后一次离开唤醒等待方
+ */
+void RequestGate::Leave()
+{
+    uint32_t previous = m_state.fetch_sub(1, std::memory_order_acq_rel);
+    if (previous == 1)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_drained.notify_all();
+    }
+}
@@ -0,0 +1,316 @@
+﻿#include "RequestScheduler.h"
+#include "Instrumentation.h"
+#include <algorithm>
+
+/**
+ * @brief 停止调度器
+ */
+RequestScheduler::~RequestScheduler()
+{
+    // 上次停止时有任务阻塞：进程正在结束，放弃这些线程而不是在析构时终止进程
+    if (!Stop())
+    {
+        for (std::thread& worker : m_workers)
+            worker.detach();
+    }
+}
+
+/**
+ * @brief 按并发上限创建工作线程
+ * @param limits 并发设置
+ * @return 成功返回true，已启动时返回false
+ */
+bool RequestScheduler::Start(const Limits& limits)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bRunning)
+        return false;
+
+    m_limits = limits;
+    m_limits.interactiveConcurrency = std::max(m_limits.interactiveConcurrency, 1);
+    m_limits.clientConcurrency = std::max(m_limits.clientConcurrency, 1);
+    m_limits.backgroundConcurrency = std::max(m_limits.backgroundConcurrency, 1);
+    AddWorkers();
+
+    m_bRunning = true;
+    m_bStopping = false;
+    return true;
+}
+
+/**
+ * @brief 调整运行中的调度器的并发上限
+ * @param limits 并发设置
+ */
+void RequestScheduler::SetLimits(const Limits& limits)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_bRunning || m_bStopping)
+            return;
+
+        // 上限降低时执行中的任务照常完成，此后按新上限启动任务，多出的工作线程保持空闲
+        m_limits = limits;
+        m_limits.interactiveConcurrency = std::max(m_limits.interactiveConcurrency, 1);
+        m_limits.clientConcurrency = std::max(m_limits.clientConcurrency, 1);
+        m_limits.backgroundConcurrency = std::max(m_limits.backgroundConcurrency, 1);
+        AddWorkers();
+    }
+    m_wakeup.notify_all();
+}
+
+/**
+ * @brief 停止调度器
+ * @param drainTimeout 等待执行中的任务自然完成的最长时间，0表示立即取消
+ * @param cancelTimeout 发出取消信号后等待的最长时间
+ * @return 工作线程全部退出返回true，仍有任务阻塞时返回false
+ */
+bool RequestScheduler::Stop(std::chrono::milliseconds drainTimeout, std::chrono::milliseconds cancelTimeout)
+{
+    std::vector<std::thread> workers;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_bRunning)
+            return true;
+        if (m_bStopping)
+            return false;   // 上次停止时有任务阻塞
+
+        // 不再启动新任务，空闲的工作线程随即退出
+        m_bStopping = true;
+        m_interactiveQueue.clear();
+        m_clientQueue.clear();
+        m_backgroundQueue.clear();
+        m_wakeup.notify_all();
+
+        auto idle = [this]() { return m_running.empty(); };
+        auto waitIdle = [&](std::chrono::milliseconds timeout)
+        {
+            if (timeout == std::chrono::milliseconds::max())
+            {
+                m_wakeup.wait(lock, idle);
+                return true;
+            }
+            return m_wakeup.wait_for(lock, timeout, idle);
+        };
+
+        // 先排空：执行中的任务自然完成；超时后取消，再等待它们在下一个检查点返回
+        if (!waitIdle(drainTimeout))
+        {
+            for (const auto& task : m_running)
+                task->cancelled = true;
+            if (!waitIdle(cancelTimeout))
+            {
+                Instrumentation::AddCounter("scheduler.stop_timeouts");
+                return false;
+            }
+        }
+        workers.swap(m_workers);
+    }
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bRunning = false;
+    m_bStopping = false;
+    return true;
+}
+
+/**
+ * @brief 提交任务
+ * @param priority 优先级
+ * @param job 任务
+ * @return 已排队返回true，调度器未启动时返回false
+ */
+bool RequestScheduler::Submit(RequestPriority priority, Job job)
+{
+    if (!job)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_bRunning || m_bStopping)
+            return false;
+
+        std::shared_ptr<Task> task = std::make_shared<Task>();
+        task->priority = priority;
+        task->job = std::move(job);
+        task->submitTime = Clock::now();
+
+        QueueOf(priority).push_back(std::move(task));
+        if (priority != RequestPriority::Background)
+            PreemptBackground();
+        ReportGauges();
+    }
+    m_wakeup.notify_all();
+    return true;
+}
+
+/**
+ * @brief 获取排队中的任务数
+ * @param priority 优先级
+ * @return 任务数
+ */
+size_t RequestScheduler::GetQueuedCount(RequestPriority priority) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    switch (priority)
+    {
+    case RequestPriority::Interactive: return m_interactiveQueue.size();
+    case RequestPriority::Client: return m_clientQueue.size();
+    default: return m_backgroundQueue.size();
+    }
+}
+
+/**
+ * @brief 工作线程主循环
+ */
+void RequestScheduler::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_bStopping)
+    {
+        std::shared_ptr<Task> task = TakeNextTask();
+        if (!task)
+        {
+            m_wakeup.wait(lock);
+            continue;
+        }
+
+        bool interactive = task->priority == RequestPriority::Interactive;
+        RunningOf(task->priority)++;
+        m_running.push_back(task);
+        ReportGauges();
+        if (interactive)
+        {
+            double waitMs = std::chrono::duration<double, std::milli>(Clock::now() - task->submitTime).count();
+            Instrumentation::SetGauge("scheduler.interactive_wait_ms", waitMs);
+        }
+
+        lock.unlock();
+        bool finished = true;
+        try
+        {
+            finished = task->job(task->cancelled);
+        }
+        catch (...)
+        {
+            // 任务自行负责错误回调，异常不能终止工作线程
+        }
+        lock.lock();
+
+        RunningOf(task->priority)--;
+        m_running.erase(std::find(m_running.begin(), m_running.end(), task));
+
+        // 被抢占而中断的后台任务回到后台队首，等交互请求全部完成后继续
+        if (!finished && task->priority == RequestPriority::Background && task->cancelled && !m_bStopping)
+        {
+            task->cancelled = false;
+            m_backgroundQueue.push_front(task);
+            Instrumentation::AddCounter("scheduler.requeued");
+        }
+        ReportGauges();
+        m_wakeup.notify_all();
+    }
+}
+
+/**
+ * @brief 按并发上限补足工作线程（调用方持有锁）
+ */
+void RequestScheduler::AddWorkers()
+{
+    // 每个并发名额一个工作线程，任何时刻都有空闲线程可以接手允许启动的任务
+    size_t workerCount = static_cast<size_t>(m_limits.interactiveConcurrency + m_limits.clientConcurrency + m_limits.backgroundConcurrency);
+    while (m_workers.size() < workerCount)
+        m_workers.emplace_back(&RequestScheduler::WorkerLoop, this);
+}
+
+/**
+ * @brief 获取某一优先级的排队队列
+ * @param priority 优先级
+ * @return 队列
+ */
+std::deque<std::shared_ptr<RequestScheduler::Task>>& RequestScheduler::QueueOf(RequestPriority priority)
+{
+    switch (priority)
+    {
+    case RequestPriority::Interactive: return m_interactiveQueue;
+    case RequestPriority::Client: return m_clientQueue;
+    default: return m_backgroundQueue;
+    }
+}
+
+/**
+ * @brief 获取某一优先级执行中的任务数
+ * @param priority 优先级
+ * @return 任务数
+ */
+int& RequestScheduler::RunningOf(RequestPriority priority)
+{
+    switch (priority)
+    {
+    case RequestPriority::Interactive: return m_runningInteractive;
+    case RequestPriority::Client: return m_runningClient;
+    default: return m_runningBackground;
+    }
+}
+
+/**
+ * @brief 取出下一个可以启动的任务（调用方持有锁）
+ * @return 任务，暂无可启动任务时返回nullptr
+ */
+std::shared_ptr<RequestScheduler::Task> RequestScheduler::TakeNextTask()
+{
+    std::deque<std::shared_ptr<Task>>* queue = nullptr;
+    if (!m_interactiveQueue.empty())
+    {
+        // 有交互请求排队时其他请求一律等待，名额空出后先给交互请求
+        if (m_runningInteractive < m_limits.interactiveConcurrency)
+            queue = &m_interactiveQueue;
+    }
+    else if (!m_clientQueue.empty())
+    {
+        // 客户端请求有独立的名额，不占用交互请求的名额
+        if (m_runningClient < m_limits.clientConcurrency)
+            queue = &m_clientQueue;
+    }
+    else if (!m_backgroundQueue.empty() && m_runningInteractive == 0 && m_runningClient == 0 &&
+        m_runningBackground < m_limits.backgroundConcurrency)
+    {
+        queue = &m_backgroundQueue;
+    }
+
+    if (queue == nullptr)
+        return nullptr;
+
+    std::shared_ptr<Task> task = std::move(queue->front());
+    queue->pop_front();
+    return task;
+}
+
+/**
+ * @brief 向正在执行的后台任务发出取消信号（调用方持有锁）
+ */
+void RequestScheduler::PreemptBackground()
+{
+    for (const auto& task : m_running)
+    {
+        if (task->priority == RequestPriority::Background && !task->cancelled)
+        {
+            task->cancelled = true;
+            Instrumentation::AddCounter("scheduler.preempted");
+        }
+    }
+}
+
+/**
+ * @brief 上报排队长度和执行数（调用方持有锁）
+ */
+void RequestScheduler::ReportGauges() const
+{
+    Instrumentation::SetGauge("scheduler.queued_interactive", static_cast<double>(m_interactiveQueue.size()));
+    Instrumentation::SetGauge("scheduler.queued_client", static_cast<double>(m_clientQueue.size()));
+    Instrumentation::SetGauge("scheduler.queued_background", static_cast<double>(m_backgroundQueue.size()));
+    Instrumentation::SetGauge("scheduler.running_interactive", m_runningInteractive);
+    Instrumentation::SetGauge("scheduler.running_client", m_runningClient);
+    Instrumentation::SetGauge("scheduler.running_background", m_runningBackground);
+}
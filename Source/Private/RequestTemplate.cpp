@@ -0,0 +1,90 @@
+﻿#include "RequestTemplate.h"
+#include "TranslationProfile.h"
+#include <cstdio>
+
+/**
+ * @brief 根据配置档构建请求体模板
+ * @param profile 配置档
+ */
+RequestTemplate::RequestTemplate(const TranslationProfile& profile)
+    : RequestTemplate(profile, profile.systemPrompt)
+{
+}
+
+/**
+ * @brief 使用配置档的模型参数和指定的系统提示词构建请求体模板
+ * @param profile 配置档
+ * @param systemPrompt 系统提示词
+ */
+RequestTemplate::RequestTemplate(const TranslationProfile& profile, const std::string& systemPrompt)
+{
+    char temperature[32];
+    std::snprintf(temperature, sizeof(temperature), "%.2f", profile.temperature);
+
+    m_prefix.reserve(256 + systemPrompt.length());
+    m_prefix = "{\"model\":\"";
+    AppendJsonEscaped(m_prefix, profile.model.data(), profile.model.length());
+    m_prefix += "\",\"temperature\":";
+    m_prefix += temperature;
+    m_prefix += ",\"max_tokens\":";
+    m_prefix += std::to_string(profile.maxTokens);
+    m_prefix += ",\"messages\":[{\"role\":\"system\",\"content\":\"";
+    AppendJsonEscaped(m_prefix, systemPrompt.data(), systemPrompt.length());
+    m_prefix += "\"},{\"role\":\"user\",\"content\":\"";
+
+    m_suffix = "\"}]}";
+    m_streamSuffix = "\"}],\"stream\":true,\"stream_options\":{\"include_usage\":true}}";
+}
+
+/**
+ * @brief 生成完整请求体
+ * @param utf8Text UTF-8编码的待翻译文本
+ * @param body 输出请求体
+ * @param stream 是否要求流式返回
+ */
+void RequestTemplate::BuildBody(const std::string& utf8Text, std::string& body, bool stream) const
+{
+    const std::string& suffix = stream ? m_streamSuffix : m_suffix;
+    body.clear();
+    body.reserve(m_prefix.length() + utf8Text.length() * 2 + suffix.length());
+    body += m_prefix;
+    AppendJsonEscaped(body, utf8Text.data(), utf8Text.length());
+    body += suffix;
+}
+
+/**
+ * @brief 追加JSON转义后的字符串内容
+ * @param out 输出缓冲区
+ * @param data UTF-8数据
+ * @param length 数据长度
+ */
+void RequestTemplate::AppendJsonEscaped(std::string& out, const char* data, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = data[i];
+        switch (c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    // 其余控制字符必须以\u形式转义，否则请求体不是合法JSON
+                    out += "\\u00";
+                    out += hexDigits[(c >> 4) & 0x0F];
+                    out += hexDigits[c & 0x0F];
+                }
+                else
+                {
+                    out += c;
+                }
+                break;
+        }
+    }
+}
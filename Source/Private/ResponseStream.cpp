@@ -0,0 +1,283 @@
+﻿#include "ResponseStream.h"
+#include <cstring>
+
+namespace
+{
+    const char SSE_DATA_FIELD[] = "data:";
+    const size_t SSE_DATA_FIELD_LENGTH = sizeof(SSE_DATA_FIELD) - 1;
+
+    // 解析非负整数（token数），含小数点或指数等非整数形式时返回false
+    bool ParseCount(std::string_view text, int64_t& value)
+    {
+        if (text.empty() || text.length() > 18)
+            return false;
+        int64_t result = 0;
+        for (char c : text)
+        {
+            if (c < '0' || c > '9')
+                return false;
+            result = result * 10 + (c - '0');
+        }
+        value = result;
+        return true;
+    }
+}
+
+/**
+ * @brief 构造缓冲区
+ * @param capacity 容量（字节）
+ */
+ByteRing::ByteRing(size_t capacity)
+    : m_data(capacity)
+{
+}
+
+/**
+ * @brief 获取连续的可写区间
+ * @param length 输出可写字节数
+ * @return 可写区间起始地址
+ */
+char* ByteRing::GetWriteSpan(size_t& length)
+{
+    size_t capacity = m_data.size();
+    size_t tail = (m_head + m_size) % capacity;
+    if (m_size == capacity)
+        length = 0;
+    else if (tail >= m_head)
+        length = capacity - tail;
+    else
+        length = m_head - tail;
+    return m_data.data() + tail;
+}
+
+/**
+ * @brief 提交已写入的字节
+ * @param length 字节数
+ */
+void ByteRing::CommitWrite(size_t length)
+{
+    m_size += length;
+}
+
+/**
+ * @brief 获取连续的可读区间
+ * @param length 输出可读字节数
+ * @return 可读区间起始地址
+ */
+const char* ByteRing::GetReadSpan(size_t& length) const
+{
+    length = m_size < m_data.size() - m_head ? m_size : m_data.size() - m_head;
+    return m_data.data() + m_head;
+}
+
+/**
+ * @brief 消费已读取的字节
+ * @param length 字节数
+ */
+void ByteRing::ConsumeRead(size_t length)
+{
+    m_size -= length;
+    // 读空时回到起点，使下一次可写区间尽可能大
+    m_head = m_size == 0 ? 0 : (m_head + length) % m_data.size();
+}
+
+/**
+ * @brief 清空缓冲区
+ */
+void ByteRing::Reset()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+/**
+ * @brief 构造解析器
+ */
+ChatResponseParser::ChatResponseParser()
+    : m_json(*this)
+{
+}
+
+/**
+ * @brief 重置以解析新响应
+ */
+void ChatResponseParser::Reset()
+{
+    m_json.Reset();
+    m_mode = Mode::Unknown;
+    m_lineState = LineState::Start;
+    m_fieldLength = 0;
+    m_hasContent = false;
+    m_pTarget = nullptr;
+    m_content.clear();
+    m_errorMessage.clear();
+    m_usage = TokenUsage();
+}
+
+/**
+ * @brief 释放缓冲区内存
+ */
+void ChatResponseParser::ReleaseMemory()
+{
+    Reset();
+    std::string().swap(m_content);
+    std::string().swap(m_errorMessage);
+}
+
+/**
+ * @brief 送入一块响应数据
+ * @param data 数据
+ * @param length 长度
+ */
+void ChatResponseParser::Feed(const char* data, size_t length)
+{
+    size_t i = 0;
+    if (m_mode == Mode::Unknown)
+    {
+        // 跳过开头的空白，按首个字符识别响应格式
+        while (i < length && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n'))
+            i++;
+        if (i == length)
+            return;
+        m_mode = data[i] == '{' ? Mode::Json : Mode::Sse;
+    }
+
+    if (m_mode == Mode::Json)
+        m_json.Feed(data + i, length - i);
+    else
+        FeedSse(data + i, length - i);
+}
+
+/**
+ * @brief 响应结束后判断是否得到完整译文
+ * @return 得到译文返回true
+ */
+bool ChatResponseParser::Finish() const
+{
+    if (!m_hasContent || m_content.empty())
+        return false;
+    // 普通JSON必须完整；SSE以已收到的片段为准
+    return m_mode == Mode::Sse || m_json.IsComplete();
+}
+
+/**
+ * @brief 字符串值开始：只接收译文和错误信息
+ * @param path 字符串值的路径
+ * @return 需要接收返回true
+ */
+bool ChatResponseParser::OnStringBegin(const JsonPath& path)
+{
+    if (path.GetDepth() == 4 && path.IsKey(0, "choices") && path.IsIndex(1, 0)
+        && (path.IsKey(2, "message") || path.IsKey(2, "delta")) && path.IsKey(3, "content"))
+    {
+        m_hasContent = true;
+        m_pTarget = &m_content;
+        return true;
+    }
+
+    if (path.GetDepth() == 2 && path.IsKey(0, "error") && path.IsKey(1, "message"))
+    {
+        m_errorMessage.clear();
+        m_pTarget = &m_errorMessage;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 接收字符串片段
+ * @param fragment UTF-8片段
+ */
+void ChatResponseParser::OnStringFragment(std::string_view fragment)
+{
+    if (m_pTarget != nullptr)
+        m_pTarget->append(fragment.data(), fragment.length());
+}
+
+/**
+ * @brief 数值：提取usage中的token用量（SSE中只有最后一个事件携带usage）
+ * @param path 数值的路径
+ * @param number 数值原文
+ */
+void ChatResponseParser::OnNumber(const JsonPath& path, std::string_view number)
+{
+    if (!path.IsKey(0, "usage"))
+        return;
+
+    int64_t* target = nullptr;
+    if (path.GetDepth() == 2 && path.IsKey(1, "prompt_tokens"))
+        target = &m_usage.promptTokens;
+    else if (path.GetDepth() == 2 && path.IsKey(1, "completion_tokens"))
+        target = &m_usage.completionTokens;
+    else if (path.GetDepth() == 3 && path.IsKey(1, "prompt_tokens_details") && path.IsKey(2, "cached_tokens"))
+        target = &m_usage.cachedTokens;
+
+    if (target != nullptr && ParseCount(number, *target))
+        m_usage.reported = true;
+}
+
+/**
+ * @brief 按SSE格式处理数据
+ * @param data 数据
+ * @param length 长度
+ */
+void ChatResponseParser::FeedSse(const char* data, size_t length)
+{
+    size_t i = 0;
+    while (i < length)
+    {
+        char c = data[i];
+        switch (m_lineState)
+        {
+            case LineState::Start:
+                // 逐字符匹配 "data:"，字段名可能被分块边界截断
+                if (c == '\n')
+                {
+                    m_fieldLength = 0;
+                    i++;
+                }
+                else if (c == SSE_DATA_FIELD[m_fieldLength])
+                {
+                    i++;
+                    if (++m_fieldLength == SSE_DATA_FIELD_LENGTH)
+                    {
+                        m_fieldLength = 0;
+                        m_json.Reset();
+                        m_lineState = LineState::Space;
+                    }
+                }
+                else
+                {
+                    m_fieldLength = 0;
+                    m_lineState = LineState::Skip;
+                }
+                break;
+
+            case LineState::Space:
+                if (c == ' ')
+                    i++;
+                m_lineState = LineState::Data;
+                break;
+
+            case LineState::Data:
+            case LineState::Skip:
+            {
+                const char* lineEnd = static_cast<const char*>(std::memchr(data + i, '\n', length - i));
+                size_t runEnd = lineEnd != nullptr ? static_cast<size_t>(lineEnd - data) : length;
+
+                // 事件数据就地送入JSON解析器；[DONE]等非JSON数据解析失败后自然忽略
+                if (m_lineState == LineState::Data)
+                    m_json.Feed(data + i, runEnd - i);
+
+                i = runEnd;
+                if (lineEnd != nullptr)
+                {
+                    m_lineState = LineState::Start;
+                    i++;
+                }
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,440 @@
+﻿#include "ResultPipeline.h"
+#include <cstring>
+
+// 类内初始化的静态常量在绑定到引用（如std::optional::value_or的参数）时需要定义
+const uint32_t ResultPipeline::DEFAULT_TEXT_STAGES;
+const uint32_t ResultPipeline::IDENTIFIER_STAGES;
+
+namespace
+{
+    // 成对引号（UTF-8）
+    struct QuotePair
+    {
+        const char* open;
+        const char* close;
+    };
+
+    const QuotePair QUOTE_PAIRS[] =
+    {
+        { "\"", "\"" },
+        { "'", "'" },
+        { "`", "`" },
+        { "\xE2\x80\x9C", "\xE2\x80\x9D" },     // “”
+        { "\xE2\x80\x98", "\xE2\x80\x99" },     // ‘’
+        { "\xE3\x80\x8C", "\xE3\x80\x8D" },     // 「」
+        { "\xE3\x80\x8E", "\xE3\x80\x8F" },     // 『』
+    };
+
+    const char FENCE[] = "```";
+    const char FULLWIDTH_SPACE[] = "\xE3\x80\x80";
+    const char NO_BREAK_SPACE[] = "\xC2\xA0";
+    const char FULLWIDTH_LEFT_PAREN[] = "\xEF\xBC\x88";     // （
+    const char FULLWIDTH_RIGHT_PAREN[] = "\xEF\xBC\x89";    // ）
+
+    inline bool IsAsciiSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    inline bool IsAsciiAlnum(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+
+    inline bool IsAscii(const char* begin, const char* end)
+    {
+        for (const char* p = begin; p < end; ++p)
+        {
+            if (static_cast<unsigned char>(*p) >= 0x80)
+                return false;
+        }
+        return true;
+    }
+
+    inline bool StartsWith(const std::string& text, size_t pos, const char* prefix, size_t length)
+    {
+        return text.length() - pos >= length && text.compare(pos, length, prefix) == 0;
+    }
+
+    inline bool EndsWith(const std::string& text, size_t end, const char* suffix, size_t length)
+    {
+        return end >= length && text.compare(end - length, length, suffix) == 0;
+    }
+
+    // 转为小写（仅ASCII）
+    std::string ToLower(std::string text)
+    {
+        for (char& c : text)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+        }
+        return text;
+    }
+
+    // 去除首尾ASCII空白（解析配置用）
+    std::string TrimAscii(const std::string& text)
+    {
+        size_t begin = 0;
+        size_t end = text.length();
+        while (begin < end && IsAsciiSpace(text[begin]))
+            begin++;
+        while (end > begin && IsAsciiSpace(text[end - 1]))
+            end--;
+        return text.substr(begin, end - begin);
+    }
+}
+
+/**
+ * @brief 构造流水线
+ * @param stages 启用的阶段
+ * @param maxLength 译文最大字符数，0表示不限
+ * @param replacements 整词替换表
+ */
+ResultPipeline::ResultPipeline(uint32_t stages, size_t maxLength, std::vector<Replacement> replacements)
+    : m_stages(stages)
+    , m_maxLength(maxLength)
+    , m_replacements(std::move(replacements))
+{
+}
+
+/**
+ * @brief 解析阶段列表
+ * @param list 阶段列表
+ * @param stages 输出阶段组合
+ * @return 解析成功返回true
+ */
+bool ResultPipeline::ParseStages(const std::string& list, uint32_t& stages)
+{
+    uint32_t parsed = 0;
+    size_t start = 0;
+    while (start <= list.length())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.length();
+        std::string name = ToLower(TrimAscii(list.substr(start, comma - start)));
+        start = comma + 1;
+
+        if (name == "trim") parsed |= STAGE_TRIM;
+        else if (name == "fences") parsed |= STAGE_FENCES;
+        else if (name == "quotes") parsed |= STAGE_QUOTES;
+        else if (name == "explanation") parsed |= STAGE_EXPLANATION;
+        else if (name == "period") parsed |= STAGE_PERIOD;
+        else if (name == "charset") parsed |= STAGE_CHARSET;
+        else if (name != "none") return false;
+    }
+    stages = parsed;
+    return true;
+}
+
+/**
+ * @brief 解析替换表
+ * @param list 替换表文本
+ * @param replacements 输出替换表
+ * @return 解析成功返回true
+ */
+bool ResultPipeline::ParseReplacements(const std::string& list, std::vector<Replacement>& replacements)
+{
+    std::vector<Replacement> parsed;
+    size_t start = 0;
+    while (start < list.length())
+    {
+        size_t semicolon = list.find(';', start);
+        if (semicolon == std::string::npos)
+            semicolon = list.length();
+        std::string item = TrimAscii(list.substr(start, semicolon - start));
+        start = semicolon + 1;
+        if (item.empty())
+            continue;
+
+        size_t arrow = item.find('>');
+        if (arrow == std::string::npos)
+            return false;
+        Replacement replacement;
+        replacement.from = TrimAscii(item.substr(0, arrow));
+        replacement.to = TrimAscii(item.substr(arrow + 1));
+        if (replacement.from.empty())
+            return false;
+        parsed.push_back(std::move(replacement));
+    }
+    replacements = std::move(parsed);
+    return true;
+}
+
+/**
+ * @brief 依次执行启用的阶段
+ * @param text UTF-8译文，原地修改
+ */
+void ResultPipeline::Apply(std::string& text) const
+{
+    bool trim = (m_stages & STAGE_TRIM) != 0;
+    if (trim)
+        Trim(text);
+
+    if (m_stages & STAGE_FENCES)
+    {
+        StripFences(text);
+        if (trim)
+            Trim(text);
+    }
+
+    // 解释在引号之前去除：`GetObject` 后另起一行的说明会让首尾引号不成对
+    if (m_stages & STAGE_EXPLANATION)
+    {
+        StripExplanation(text);
+        if (trim)
+            Trim(text);
+    }
+
+    // 引号可能嵌套（如 "`GetObject`"），逐层去除
+    if (m_stages & STAGE_QUOTES)
+    {
+        while (StripQuotes(text))
+        {
+            if (trim)
+                Trim(text);
+        }
+    }
+
+    if (m_stages & STAGE_PERIOD)
+        StripTrailingPeriod(text);
+
+    if (m_stages & STAGE_CHARSET)
+        EnforceIdentifierCharset(text);
+
+    if (!m_replacements.empty())
+        ApplyReplacements(text, m_replacements);
+
+    if (m_maxLength > 0)
+    {
+        LimitLength(text, m_maxLength);
+        if (trim)
+            Trim(text);
+    }
+}
+
+/**
+ * @brief 去除首尾空白
+ * @param text UTF-8文本
+ */
+void ResultPipeline::Trim(std::string& text)
+{
+    size_t end = text.length();
+    for (;;)
+    {
+        if (end > 0 && IsAsciiSpace(text[end - 1]))
+            end--;
+        else if (EndsWith(text, end, FULLWIDTH_SPACE, 3))
+            end -= 3;
+        else if (EndsWith(text, end, NO_BREAK_SPACE, 2))
+            end -= 2;
+        else
+            break;
+    }
+    text.resize(end);
+
+    size_t begin = 0;
+    for (;;)
+    {
+        if (begin < text.length() && IsAsciiSpace(text[begin]))
+            begin++;
+        else if (StartsWith(text, begin, FULLWIDTH_SPACE, 3))
+            begin += 3;
+        else if (StartsWith(text, begin, NO_BREAK_SPACE, 2))
+            begin += 2;
+        else
+            break;
+    }
+    text.erase(0, begin);
+}
+
+/**
+ * @brief 去除包裹全文的代码块标记
+ * @param text UTF-8文本
+ */
+void ResultPipeline::StripFences(std::string& text)
+{
+    if (!StartsWith(text, 0, FENCE, 3))
+        return;
+
+    // 去除结尾标记（及其前面的空白）
+    size_t end = text.length();
+    while (end > 0 && IsAsciiSpace(text[end - 1]))
+        end--;
+    if (end >= 6 && EndsWith(text, end, FENCE, 3))
+        end -= 3;
+    text.resize(end);
+
+    // 去除开头标记和同一行的语言名；没有换行时标记后直接是内容
+    size_t newline = text.find('\n');
+    text.erase(0, newline == std::string::npos ? 3 : newline + 1);
+}
+
+/**
+ * @brief 去除包裹全文的一层成对引号
+ * @param text UTF-8文本
+ * @return 去除了引号返回true
+ */
+bool ResultPipeline::StripQuotes(std::string& text)
+{
+    for (const QuotePair& pair : QUOTE_PAIRS)
+    {
+        size_t openLength = std::strlen(pair.open);
+        size_t closeLength = std::strlen(pair.close);
+        if (text.length() < openLength + closeLength ||
+            !StartsWith(text, 0, pair.open, openLength) || !EndsWith(text, text.length(), pair.close, closeLength))
+        {
+            continue;
+        }
+
+        // 内部出现同种引号时（如 "a" 和 "b"），首尾引号不是一对
+        size_t innerEnd = text.length() - closeLength;
+        size_t found = text.find(pair.close, openLength);
+        if (found != innerEnd)
+            return false;
+        if (openLength != closeLength || std::strcmp(pair.open, pair.close) != 0)
+        {
+            found = text.find(pair.open, openLength);
+            if (found < innerEnd)
+                return false;
+        }
+
+        text.resize(innerEnd);
+        text.erase(0, openLength);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 去除模型附加的解释
+ * @param text UTF-8文本
+ */
+void ResultPipeline::StripExplanation(std::string& text)
+{
+    // 标识符译文后另起一行的说明：只保留首行
+    size_t newline = text.find('\n');
+    if (newline != std::string::npos)
+    {
+        size_t lineEnd = newline;
+        while (lineEnd > 0 && text[lineEnd - 1] == '\r')
+            lineEnd--;
+        if (lineEnd > 0 && IsAscii(text.data(), text.data() + lineEnd))
+            text.resize(lineEnd);
+        else
+            return;
+    }
+
+    // 末尾的括号说明（括号后可有一个句点）：GetObject (gets the object)、GetObject（获取对象）
+    size_t end = text.length();
+    if (end > 0 && text[end - 1] == '.')
+        end--;
+    size_t open = std::string::npos;
+    if (end > 0 && text[end - 1] == ')')
+        open = text.rfind('(', end - 1);
+    else if (EndsWith(text, end, FULLWIDTH_RIGHT_PAREN, 3))
+        open = text.rfind(FULLWIDTH_LEFT_PAREN, end - 3);
+    if (open == std::string::npos || open == 0 || !IsAscii(text.data(), text.data() + open))
+        return;
+
+    size_t keep = open;
+    while (keep > 0 && IsAsciiSpace(text[keep - 1]))
+        keep--;
+    if (keep > 0)
+        text.resize(keep);
+}
+
+/**
+ * @brief 去除单行ASCII文本末尾的句点
+ * @param text UTF-8文本
+ */
+void ResultPipeline::StripTrailingPeriod(std::string& text)
+{
+    size_t length = text.length();
+    if (length < 2 || text[length - 1] != '.' || text[length - 2] == '.')
+        return;
+    if (text.find('\n') != std::string::npos || !IsAscii(text.data(), text.data() + length))
+        return;
+    text.resize(length - 1);
+}
+
+/**
+ * @brief 只保留标识符字符
+ * @param text UTF-8文本
+ */
+void ResultPipeline::EnforceIdentifierCharset(std::string& text)
+{
+    if (!IsAscii(text.data(), text.data() + text.length()))
+        return;
+
+    // 原地压缩：write不超过read
+    size_t write = 0;
+    bool pendingSpace = false;
+    for (size_t read = 0; read < text.length(); ++read)
+    {
+        char c = text[read];
+        if (c == '\'')
+            continue;
+        if (IsAsciiAlnum(c) || c == '_')
+        {
+            if (pendingSpace && write > 0)
+                text[write++] = ' ';
+            pendingSpace = false;
+            text[write++] = c;
+        }
+        else
+        {
+            pendingSpace = true;
+        }
+    }
+    text.resize(write);
+}
+
+/**
+ * @brief 按整词替换
+ * @param text UTF-8文本
+ * @param replacements 替换表
+ */
+void ResultPipeline::ApplyReplacements(std::string& text, const std::vector<Replacement>& replacements)
+{
+    for (const Replacement& replacement : replacements)
+    {
+        const std::string& from = replacement.from;
+        bool checkStart = IsAsciiAlnum(from.front());
+        bool checkEnd = IsAsciiAlnum(from.back());
+
+        size_t pos = text.find(from);
+        while (pos != std::string::npos)
+        {
+            size_t after = pos + from.length();
+            bool wordStart = !checkStart || pos == 0 || !IsAsciiAlnum(text[pos - 1]);
+            bool wordEnd = !checkEnd || after == text.length() || !IsAsciiAlnum(text[after]);
+            if (wordStart && wordEnd)
+            {
+                text.replace(pos, from.length(), replacement.to);
+                pos = text.find(from, pos + replacement.to.length());
+            }
+            else
+            {
+                pos = text.find(from, pos + 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 截断到最多maxLength个字符
+ * @param text UTF-8文本
+ * @param maxLength 最大字符数
+ */
+void ResultPipeline::LimitLength(std::string& text, size_t maxLength)
+{
+    // 按字符起始字节（非10xxxxxx）计数，第maxLength+1个字符的起始处即截断位置
+    size_t count = 0;
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80 && count++ == maxLength)
+        {
+            text.resize(i);
+            return;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+﻿#include "SendInputSink.h"
+
+/**
+ * @brief 注入一批按键事件
+ * @param events 事件
+ * @param count 事件数
+ * @return 实际注入的事件数
+ */
+size_t SendInputSink::Send(const KeyEvent* events, size_t count)
+{
+    m_inputs.assign(count, INPUT{});
+    for (size_t i = 0; i < count; ++i)
+    {
+        INPUT& input = m_inputs[i];
+        input.type = INPUT_KEYBOARD;
+        input.ki.wVk = 0;
+        input.ki.wScan = events[i].unit;
+        input.ki.dwFlags = KEYEVENTF_UNICODE | (events[i].keyUp ? KEYEVENTF_KEYUP : 0);
+    }
+    return SendInput(static_cast<UINT>(count), m_inputs.data(), sizeof(INPUT));
+}
+
+/**
+ * @brief 两批之间等待目标程序处理
+ * @param milliseconds 毫秒
+ */
+void SendInputSink::Pause(uint32_t milliseconds)
+{
+    Sleep(milliseconds);
+}
@@ -0,0 +1,244 @@
+﻿#include "SentenceDelta.h"
+#include "CodeLexer.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+const char* const SentenceDelta::BATCH_SYSTEM_PROMPT = "You translate sentences taken from one paragraph that the user has edited. Each input line is N|sentence, in paragraph order; the unchanged sentences between them were translated before and are omitted. Translate every sentence (Chinese into English, English into Chinese) and output exactly one line N|translation per input line, with the same numbers in the same order and nothing else.";
+
+// 类内初始化的静态常量在取地址时需要定义
+const size_t SentenceDelta::MAX_SENTENCES;
+const size_t SentenceDelta::NONE;
+
+namespace
+{
+    inline bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    // 句末标点的字节数（. ! ? 。 ！ ？），不是句末标点返回0
+    size_t TerminatorLength(const std::string& text, size_t pos)
+    {
+        char c = text[pos];
+        if (c == '.' || c == '!' || c == '?')
+            return 1;
+        if (text.compare(pos, 3, "\xE3\x80\x82") == 0 || text.compare(pos, 3, "\xEF\xBC\x81") == 0 ||
+            text.compare(pos, 3, "\xEF\xBC\x9F") == 0)
+            return 3;
+        return 0;
+    }
+
+    // 句末标点之后的右引号和右括号的字节数（" ' ) ] ” ’ 」 』 ）），不是返回0
+    size_t CloserLength(const std::string& text, size_t pos)
+    {
+        char c = text[pos];
+        if (c == '"' || c == '\'' || c == ')' || c == ']')
+            return 1;
+        if (text.compare(pos, 3, "\xE2\x80\x9D") == 0 || text.compare(pos, 3, "\xE2\x80\x99") == 0 ||
+            text.compare(pos, 3, "\xE3\x80\x8D") == 0 || text.compare(pos, 3, "\xE3\x80\x8F") == 0 ||
+            text.compare(pos, 3, "\xEF\xBC\x89") == 0)
+            return 3;
+        return 0;
+    }
+
+    // 句子之后的空白是否含换行
+    inline bool EndsLine(const std::string& text, const SentenceSpan& sentence)
+    {
+        return std::memchr(text.data() + sentence.end, '\n', sentence.next - sentence.end) != nullptr;
+    }
+
+    // 两个句子的文本是否相同
+    inline bool SameText(const std::string& a, const SentenceSpan& x, const std::string& b, const SentenceSpan& y)
+    {
+        size_t length = x.end - x.begin;
+        return length == y.end - y.begin && std::memcmp(a.data() + x.begin, b.data() + y.begin, length) == 0;
+    }
+}
+
+/**
+ * @brief 按句拆分
+ * @param text UTF-8文本
+ * @param sentences 输出句子
+ */
+void SentenceDelta::Split(const std::string& text, std::vector<SentenceSpan>& sentences)
+{
+    sentences.clear();
+    size_t length = text.length();
+    size_t pos = 0;
+    while (pos < length && IsBlank(text[pos]))
+        pos++;
+
+    while (pos < length)
+    {
+        size_t begin = pos;
+        size_t end = length;
+        while (pos < length)
+        {
+            if (text[pos] == '\n')
+            {
+                end = pos;
+                break;
+            }
+            size_t terminator = TerminatorLength(text, pos);
+            if (terminator == 0)
+            {
+                pos++;
+                continue;
+            }
+
+            // 连续的句末标点和其后的右引号、右括号属于同一句
+            bool ascii = terminator == 1;
+            pos += terminator;
+            while (pos < length)
+            {
+                size_t extra = TerminatorLength(text, pos);
+                if (extra == 0)
+                    extra = CloserLength(text, pos);
+                if (extra == 0)
+                    break;
+                pos += extra;
+            }
+
+            // 英文句号后紧跟非空白时（小数、文件名、缩写）不断句
+            if (!ascii || pos >= length || IsBlank(text[pos]))
+            {
+                end = pos;
+                break;
+            }
+        }
+
+        while (end > begin && IsBlank(text[end - 1]))
+            end--;
+        pos = end;
+        while (pos < length && IsBlank(text[pos]))
+            pos++;
+        sentences.push_back({ begin, end, pos });
+    }
+}
+
+/**
+ * @brief 生成增量计划
+ * @param source 新原文
+ * @param previousSource 上次的原文
+ * @param previousResult 上次的译文
+ * @return 可以增量翻译返回true
+ */
+bool SentenceDelta::Build(const std::string& source, const std::string& previousSource, const std::string& previousResult)
+{
+    m_source = source;
+    m_previousResult = previousResult;
+    Split(m_source, m_sentences);
+    Split(m_previousResult, m_resultSentences);
+    m_reuse.assign(m_sentences.size(), NONE);
+    m_changedCount = m_sentences.size();
+    m_reusedBytes = 0;
+
+    std::vector<SentenceSpan> previous;
+    Split(previousSource, previous);
+    size_t n = m_sentences.size();
+    size_t m = previous.size();
+    if (n == 0 || m == 0 || n > MAX_SENTENCES || m > MAX_SENTENCES || m != m_resultSentences.size())
+        return false;
+
+    // 上次的译文与原文句数相同且换行位置一致，才认为逐句对应
+    for (size_t j = 0; j + 1 < m; ++j)
+    {
+        if (EndsLine(previousSource, previous[j]) != EndsLine(m_previousResult, m_resultSentences[j]))
+            return false;
+    }
+
+    // lengths[i * (m + 1) + j] 为新原文第i句起与上次原文第j句起的最长公共子序列长度
+    std::vector<uint16_t> lengths((n + 1) * (m + 1), 0);
+    for (size_t i = n; i-- > 0;)
+    {
+        for (size_t j = m; j-- > 0;)
+        {
+            uint16_t& cell = lengths[i * (m + 1) + j];
+            if (SameText(m_source, m_sentences[i], previousSource, previous[j]))
+                cell = static_cast<uint16_t>(lengths[(i + 1) * (m + 1) + j + 1] + 1);
+            else
+                cell = std::max(lengths[(i + 1) * (m + 1) + j], lengths[i * (m + 1) + j + 1]);
+        }
+    }
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < n && j < m)
+    {
+        if (SameText(m_source, m_sentences[i], previousSource, previous[j]))
+        {
+            m_reuse[i] = j;
+            m_reusedBytes += m_sentences[i].end - m_sentences[i].begin;
+            m_changedCount--;
+            i++;
+            j++;
+        }
+        else if (lengths[(i + 1) * (m + 1) + j] >= lengths[i * (m + 1) + j + 1])
+            i++;
+        else
+            j++;
+    }
+    return m_changedCount < n;
+}
+
+/**
+ * @brief 生成批量请求文本
+ * @param batch 输出请求文本
+ */
+void SentenceDelta::BuildBatch(std::string& batch) const
+{
+    batch.clear();
+    size_t number = 0;
+    for (size_t i = 0; i < m_sentences.size(); ++i)
+    {
+        if (m_reuse[i] != NONE)
+            continue;
+        batch += std::to_string(++number);
+        batch += '|';
+        batch.append(m_source, m_sentences[i].begin, m_sentences[i].end - m_sentences[i].begin);
+        batch += '\n';
+    }
+}
+
+/**
+ * @brief 拼出整段译文
+ * @param batchResult 模型返回的批量译文
+ * @param out 输出整段译文
+ * @return 每个需要翻译的句子都有译文返回true
+ */
+bool SentenceDelta::Assemble(const std::string& batchResult, std::string& out) const
+{
+    std::vector<std::pair<size_t, size_t>> translations;
+    if (m_changedCount > 0 && !CodeLexer::ParseBatch(batchResult, m_changedCount, translations))
+        return false;
+
+    out.clear();
+    if (m_sentences.empty())
+        return true;
+    out.reserve(m_source.length() + m_previousResult.length() + batchResult.length());
+    out.append(m_source, 0, m_sentences[0].begin);
+
+    size_t number = 0;
+    for (size_t i = 0; i < m_sentences.size(); ++i)
+    {
+        const SentenceSpan& sentence = m_sentences[i];
+        size_t reused = m_reuse[i];
+        if (reused != NONE)
+        {
+            const SentenceSpan& translated = m_resultSentences[reused];
+            out.append(m_previousResult, translated.begin, translated.end - translated.begin);
+        }
+        else
+        {
+            const std::pair<size_t, size_t>& translated = translations[number++];
+            out.append(batchResult, translated.first, translated.second - translated.first);
+        }
+
+        // 句间空白：换行和末尾空白按新原文，行内按上次译文或译文的语言
+        if (i + 1 == m_sentences.size() || EndsLine(m_source, sentence))
+            out.append(m_source, sentence.end, sentence.next - sentence.end);
+        else if (reused != NONE && m_reuse[i + 1] == reused + 1)
+            out.append(m_previousResult, m_resultSentences[reused].end, m_resultSentences[reused].next - m_resultSentences[reused].end);
+        else if (static_cast<unsigned char>(out.back()) < 0x80)
+            out += ' ';
+    }
+    return true;
+}
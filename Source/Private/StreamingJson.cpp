@@ -0,0 +1,411 @@
+﻿#include "StreamingJson.h"
+
+namespace
+{
+    inline bool IsJsonSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    inline int HexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    const uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+}
+
+/**
+ * @brief 构造解析器
+ * @param handler 事件接收者
+ */
+StreamingJsonParser::StreamingJsonParser(JsonHandler& handler)
+    : m_handler(handler)
+{
+}
+
+/**
+ * @brief 重置为初始状态
+ */
+void StreamingJsonParser::Reset()
+{
+    m_path.m_depth = 0;
+    m_state = State::Value;
+    m_inKey = false;
+    m_capture = false;
+    m_codeUnit = 0;
+    m_unicodeDigits = 0;
+    m_highSurrogate = 0;
+    m_token.clear();
+}
+
+/**
+ * @brief 送入一块数据
+ * @param data 数据
+ * @param length 长度
+ * @return 语法正确返回true
+ */
+bool StreamingJsonParser::Feed(const char* data, size_t length)
+{
+    size_t i = 0;
+    while (i < length && m_state != State::Error)
+    {
+        char c = data[i];
+        switch (m_state)
+        {
+            case State::Value:
+                if (IsJsonSpace(c) || BeginValue(c))
+                    i++;
+                break;
+
+            case State::ValueOrEnd:
+                if (IsJsonSpace(c))
+                    i++;
+                else if (c == ']')
+                {
+                    PopContainer(true);
+                    i++;
+                }
+                else
+                    m_state = State::Value;
+                break;
+
+            case State::KeyOrEnd:
+            case State::Key:
+                if (IsJsonSpace(c))
+                    i++;
+                else if (c == '}' && m_state == State::KeyOrEnd)
+                {
+                    PopContainer(false);
+                    i++;
+                }
+                else if (c == '"')
+                {
+                    m_path.m_segments[m_path.m_depth - 1].key.clear();
+                    m_inKey = true;
+                    m_state = State::String;
+                    i++;
+                }
+                else
+                    m_state = State::Error;
+                break;
+
+            case State::Colon:
+                if (IsJsonSpace(c))
+                    i++;
+                else if (c == ':')
+                {
+                    m_state = State::Value;
+                    i++;
+                }
+                else
+                    m_state = State::Error;
+                break;
+
+            case State::String:
+            {
+                if (m_highSurrogate != 0 && c != '\\')
+                    FlushPendingSurrogate();
+
+                // 不含转义的连续片段整体输出，不逐字节复制
+                size_t runEnd = i;
+                while (runEnd < length && data[runEnd] != '"' && data[runEnd] != '\\')
+                    runEnd++;
+                if (runEnd > i)
+                    AppendString(data + i, runEnd - i);
+                i = runEnd;
+                if (i == length)
+                    break;
+
+                if (data[i] == '\\')
+                    m_state = State::Escape;
+                else if (m_inKey)
+                {
+                    m_inKey = false;
+                    m_state = State::Colon;
+                }
+                else
+                    EndValue();
+                i++;
+                break;
+            }
+
+            case State::Escape:
+            {
+                if (c != 'u' && m_highSurrogate != 0)
+                    FlushPendingSurrogate();
+
+                char unescaped = 0;
+                switch (c)
+                {
+                    case '"': case '\\': case '/': unescaped = c; break;
+                    case 'b': unescaped = '\b'; break;
+                    case 'f': unescaped = '\f'; break;
+                    case 'n': unescaped = '\n'; break;
+                    case 'r': unescaped = '\r'; break;
+                    case 't': unescaped = '\t'; break;
+                    case 'u':
+                        m_codeUnit = 0;
+                        m_unicodeDigits = 0;
+                        m_state = State::Unicode;
+                        break;
+                    default:
+                        m_state = State::Error;
+                        break;
+                }
+                if (unescaped != 0)
+                {
+                    AppendString(&unescaped, 1);
+                    m_state = State::String;
+                }
+                i++;
+                break;
+            }
+
+            case State::Unicode:
+            {
+                int digit = HexValue(c);
+                if (digit < 0)
+                {
+                    m_state = State::Error;
+                    break;
+                }
+                m_codeUnit = (m_codeUnit << 4) | static_cast<uint32_t>(digit);
+                if (++m_unicodeDigits == 4)
+                {
+                    HandleCodeUnit(m_codeUnit);
+                    m_state = State::String;
+                }
+                i++;
+                break;
+            }
+
+            case State::Number:
+                if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+                {
+                    m_token += c;
+                    i++;
+                }
+                else
+                {
+                    // 数值以分隔符结束，分隔符留给下一状态处理
+                    m_handler.OnNumber(m_path, m_token);
+                    EndValue();
+                }
+                break;
+
+            case State::Literal:
+                if (c >= 'a' && c <= 'z')
+                {
+                    m_token += c;
+                    i++;
+                }
+                else if (m_token == "true" || m_token == "false" || m_token == "null")
+                    EndValue();
+                else
+                    m_state = State::Error;
+                break;
+
+            case State::CommaOrEnd:
+            {
+                bool inArray = m_path.m_segments[m_path.m_depth - 1].isArray;
+                if (c == ',')
+                {
+                    if (inArray)
+                    {
+                        m_path.m_segments[m_path.m_depth - 1].index++;
+                        m_state = State::Value;
+                    }
+                    else
+                        m_state = State::Key;
+                }
+                else if (c == (inArray ? ']' : '}'))
+                    PopContainer(inArray);
+                else if (!IsJsonSpace(c))
+                    m_state = State::Error;
+                i++;
+                break;
+            }
+
+            case State::Done:
+                // 根值之后的内容忽略
+                i = length;
+                break;
+
+            case State::Error:
+                break;
+        }
+    }
+
+    return m_state != State::Error;
+}
+
+/**
+ * @brief 开始一个值
+ * @param c 首字符
+ * @return 首字符已被消费返回true
+ */
+bool StreamingJsonParser::BeginValue(char c)
+{
+    switch (c)
+    {
+        case '{':
+            PushContainer(false);
+            return true;
+
+        case '[':
+            PushContainer(true);
+            return true;
+
+        case '"':
+            m_inKey = false;
+            m_capture = m_handler.OnStringBegin(m_path);
+            m_state = State::String;
+            return true;
+
+        case 't': case 'f': case 'n':
+            m_token.clear();
+            m_state = State::Literal;
+            return false;
+
+        default:
+            if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                m_token.clear();
+                m_state = State::Number;
+            }
+            else
+                m_state = State::Error;
+            return false;
+    }
+}
+
+/**
+ * @brief 进入对象或数组
+ * @param isArray 是否为数组
+ */
+void StreamingJsonParser::PushContainer(bool isArray)
+{
+    if (m_path.m_depth >= MAX_DEPTH)
+    {
+        m_state = State::Error;
+        return;
+    }
+
+    if (m_path.m_segments.size() <= m_path.m_depth)
+        m_path.m_segments.emplace_back();
+
+    JsonPathSegment& segment = m_path.m_segments[m_path.m_depth++];
+    segment.isArray = isArray;
+    segment.index = 0;
+    segment.key.clear();
+    m_state = isArray ? State::ValueOrEnd : State::KeyOrEnd;
+}
+
+/**
+ * @brief 结束当前对象或数组
+ * @param isArray 结束符是否为 ]
+ */
+void StreamingJsonParser::PopContainer(bool isArray)
+{
+    if (m_path.m_depth == 0 || m_path.m_segments[m_path.m_depth - 1].isArray != isArray)
+    {
+        m_state = State::Error;
+        return;
+    }
+
+    m_path.m_depth--;
+    EndValue();
+}
+
+/**
+ * @brief 一个值结束后更新状态
+ */
+void StreamingJsonParser::EndValue()
+{
+    m_capture = false;
+    m_state = m_path.m_depth == 0 ? State::Done : State::CommaOrEnd;
+}
+
+/**
+ * @brief 追加字符串内容
+ * @param data 数据
+ * @param length 长度
+ */
+void StreamingJsonParser::AppendString(const char* data, size_t length)
+{
+    if (m_inKey)
+        m_path.m_segments[m_path.m_depth - 1].key.append(data, length);
+    else if (m_capture)
+        m_handler.OnStringFragment(std::string_view(data, length));
+}
+
+/**
+ * @brief 以UTF-8追加一个码点
+ * @param codePoint Unicode码点
+ */
+void StreamingJsonParser::AppendCodePoint(uint32_t codePoint)
+{
+    char buffer[4];
+    size_t length = 0;
+    if (codePoint < 0x80)
+    {
+        buffer[length++] = static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        buffer[length++] = static_cast<char>(0xC0 | (codePoint >> 6));
+        buffer[length++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        buffer[length++] = static_cast<char>(0xE0 | (codePoint >> 12));
+        buffer[length++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        buffer[length++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        buffer[length++] = static_cast<char>(0xF0 | (codePoint >> 18));
+        buffer[length++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        buffer[length++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        buffer[length++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    AppendString(buffer, length);
+}
+
+/**
+ * @brief 处理 \uXXXX 解出的UTF-16码元
+ * @param codeUnit 码元
+ */
+void StreamingJsonParser::HandleCodeUnit(uint32_t codeUnit)
+{
+    if (m_highSurrogate != 0)
+    {
+        if (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF)
+        {
+            AppendCodePoint(0x10000 + ((m_highSurrogate - 0xD800) << 10) + (codeUnit - 0xDC00));
+            m_highSurrogate = 0;
+            return;
+        }
+        FlushPendingSurrogate();
+    }
+
+    if (codeUnit >= 0xD800 && codeUnit <= 0xDBFF)
+        m_highSurrogate = codeUnit;
+    else if (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF)
+        AppendCodePoint(REPLACEMENT_CHARACTER);
+    else
+        AppendCodePoint(codeUnit);
+}
+
+/**
+ * @brief 输出未配对的高代理项
+ */
+void StreamingJsonParser::FlushPendingSurrogate()
+{
+    m_highSurrogate = 0;
+    AppendCodePoint(REPLACEMENT_CHARACTER);
+}
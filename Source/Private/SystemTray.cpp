@@ -1,11 +1,21 @@
 ﻿#include "SystemTray.h"
 #include "../../Resource/resource.h"  // 包含资源定义（如图标ID）
 #include <shellapi.h>        // 包含Shell_NotifyIconW等托盘API
+#include <vector>
+#include "TranslationHistory.h"
+#include "TranslationManager.h"
+#include "TextEncoding.h"
+#include "TranslationService.h"
 
 // 静态成员变量定义
 HWND SystemTray::s_hWnd = nullptr;
 HMENU SystemTray::s_hMenu = nullptr;
 static bool s_bTrayCreated = false;  // 跟踪托盘是否已创建
+static HMENU s_hHistoryMenu = nullptr;                  // "最近翻译"子菜单
+static std::vector<HistoryRecord> s_recentRecords;      // 子菜单中显示的历史记录
+static HWND s_hPreviousForeground = nullptr;            // 弹出菜单前的前台窗口（重新粘贴的目标）
+static bool s_bOffline = false;                         // 当前显示的离线状态
+static size_t s_pendingCount = 0;                       // 当前显示的离线队列长度
 
 /**
  * @brief 创建系统托盘图标
@@ -142,12 +152,61 @@ HMENU SystemTray::CreateTrayMenu()
     if (hMenu == nullptr)
         return nullptr;
     
-    // 添加退出菜单项
+    // 添加"最近翻译"子菜单（内容在每次弹出菜单前重建）
+    s_hHistoryMenu = CreatePopupMenu();
+    if (s_hHistoryMenu != nullptr)
+    {
+        AppendMenuW(hMenu, MF_POPUP, reinterpret_cast<UINT_PTR>(s_hHistoryMenu), L"最近翻译");
+        AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
+    }
+    
+    // 添加用量统计和退出菜单项
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_USAGE, L"用量统计");
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_EXIT, L"退出");
     
     return hMenu;
 }
 
+/**
+ * @brief 重建"最近翻译"子菜单
+ * 
+ * 每次弹出菜单前从翻译历史读取最近的记录
+ */
+void SystemTray::RebuildHistoryMenu()
+{
+    if (s_hHistoryMenu == nullptr)
+        return;
+    
+    while (GetMenuItemCount(s_hHistoryMenu) > 0)
+        DeleteMenu(s_hHistoryMenu, 0, MF_BYPOSITION);
+    
+    TranslationHistory::GetRecent(TRAY_HISTORY_COUNT, s_recentRecords);
+    if (s_recentRecords.empty())
+    {
+        AppendMenuW(s_hHistoryMenu, MF_STRING | MF_GRAYED, 0, L"（无）");
+        return;
+    }
+    
+    for (size_t i = 0; i < s_recentRecords.size(); i++)
+    {
+        // 菜单文本：原文 → 译文，过长时截断
+        std::wstring label = TextEncoding::Utf8ToWide(s_recentRecords[i].source) + L" → " + TextEncoding::Utf8ToWide(s_recentRecords[i].result);
+        for (wchar_t& c : label)
+        {
+            if (c == L'\r' || c == L'\n' || c == L'\t')
+                c = L' ';
+        }
+        if (label.length() > 48)
+            label = label.substr(0, 47) + L"…";
+        
+        // & 在菜单中表示助记符，需要转义
+        for (size_t pos = label.find(L'&'); pos != std::wstring::npos; pos = label.find(L'&', pos + 2))
+            label.insert(pos, 1, L'&');
+        
+        AppendMenuW(s_hHistoryMenu, MF_STRING, ID_TRAY_HISTORY_BASE + i, label.c_str());
+    }
+}
+
 /**
  * @brief 显示托盘右键菜单
  * @param hWnd 窗口句柄
@@ -159,6 +218,10 @@ void SystemTray::ShowTrayMenu(HWND hWnd)
     if (s_hMenu == nullptr)
         return;
     
+    // 记录当前前台窗口，重新粘贴历史译文时将焦点还给它
+    s_hPreviousForeground = GetForegroundWindow();
+    RebuildHistoryMenu();
+    
     // 获取鼠标位置
     POINT pt;
     GetCursorPos(&pt);
@@ -188,7 +251,17 @@ void SystemTray::HandleMenuCommand(UINT commandId)
         PostQuitMessage(0);
         break;
     
+    case ID_TRAY_USAGE:
+        // 在托盘通知中显示各配置档的token和流量用量
+        ShowNotification(L"用量统计", TranslationService::FormatUsageReport());
+        break;
+    
     default:
+        // 最近翻译：重新粘贴选中的历史译文
+        if (commandId >= ID_TRAY_HISTORY_BASE && commandId < ID_TRAY_HISTORY_BASE + s_recentRecords.size())
+        {
+            TranslationManager::RepasteHistory(s_recentRecords[commandId - ID_TRAY_HISTORY_BASE], s_hPreviousForeground);
+        }
         break;
     }
 }
@@ -234,6 +307,66 @@ LRESULT CALLBACK SystemTray::TrayWndProc(HWND hWnd, UINT message, WPARAM wParam,
     return 0;
 }
 
+/**
+ * @brief 显示托盘气泡通知
+ * @param title 通知标题
+ * @param text 通知内容
+ * 
+ * 用于"仅显示"配置档展示翻译结果
+ */
+void SystemTray::ShowNotification(const std::wstring& title, const std::wstring& text)
+{
+    if (!s_bTrayCreated || s_hWnd == nullptr)
+        return;
+    
+    NOTIFYICONDATAW nid = {};
+    nid.cbSize = sizeof(NOTIFYICONDATAW);
+    nid.hWnd = s_hWnd;
+    nid.uID = 1;
+    nid.uFlags = NIF_INFO;
+    nid.dwInfoFlags = NIIF_INFO;
+    
+    // 超出长度时截断，保留结尾的空字符
+    wcsncpy_s(nid.szInfoTitle, title.c_str(), _TRUNCATE);
+    wcsncpy_s(nid.szInfo, text.c_str(), _TRUNCATE);
+    
+    Shell_NotifyIconW(NIM_MODIFY, &nid);
+}
+
+/**
+ * @brief 更新离线指示
+ * @param offline 网络是否不可用
+ * @param pendingCount 离线队列中等待重放的请求数
+ * 
+ * 离线时托盘图标换成警告图标，提示文本显示离线状态和待重放数量
+ */
+void SystemTray::SetOfflineState(bool offline, size_t pendingCount)
+{
+    if (!s_bTrayCreated || s_hWnd == nullptr)
+        return;
+    if (offline == s_bOffline && pendingCount == s_pendingCount)
+        return;
+    
+    s_bOffline = offline;
+    s_pendingCount = pendingCount;
+    
+    NOTIFYICONDATAW nid = {};
+    nid.cbSize = sizeof(NOTIFYICONDATAW);
+    nid.hWnd = s_hWnd;
+    nid.uID = 1;
+    nid.uFlags = NIF_ICON | NIF_TIP;
+    nid.hIcon = offline ? LoadIconW(nullptr, IDI_WARNING) : LoadApplicationIcon();
+    
+    std::wstring tip = L"元析翻译";
+    if (offline)
+        tip += L" - 网络不可用";
+    if (pendingCount > 0)
+        tip += L" - 离线队列" + std::to_wstring(pendingCount) + L"条";
+    wcsncpy_s(nid.szTip, tip.c_str(), _TRUNCATE);
+    
+    Shell_NotifyIconW(NIM_MODIFY, &nid);
+}
+
 /**
  * @brief 清理系统托盘资源
  * 
@@ -252,12 +385,14 @@ void SystemTray::Cleanup()
         s_bTrayCreated = false;
     }
     
-    // 销毁菜单
+    // 销毁菜单（子菜单随父菜单一起销毁）
     if (s_hMenu)
     {
         DestroyMenu(s_hMenu);
         s_hMenu = nullptr;
+        s_hHistoryMenu = nullptr;
     }
+    s_recentRecords.clear();
     
     // 销毁窗口
     if (s_hWnd)
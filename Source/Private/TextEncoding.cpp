@@ -0,0 +1,68 @@
+﻿#include "TextEncoding.h"
+
+/**
+ * @brief UTF-16转UTF-8
+ * @param text 宽字符文本
+ * @param out 输出UTF-8文本
+ * @return 成功返回true，失败返回false
+ */
+bool TextEncoding::WideToUtf8(const std::wstring& text, std::string& out)
+{
+    out.clear();
+    if (text.empty())
+        return true;
+
+    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.length()), nullptr, 0, nullptr, nullptr);
+    if (utf8Size <= 0)
+        return false;
+
+    out.resize(utf8Size);
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.length()), &out[0], utf8Size, nullptr, nullptr);
+    return true;
+}
+
+/**
+ * @brief UTF-8转UTF-16
+ * @param data UTF-8数据
+ * @param length 数据长度
+ * @param out 输出宽字符文本
+ * @return 成功返回true，失败返回false
+ */
+bool TextEncoding::Utf8ToWide(const char* data, size_t length, std::wstring& out)
+{
+    out.clear();
+    if (length == 0)
+        return true;
+
+    int wideSize = MultiByteToWideChar(CP_UTF8, 0, data, static_cast<int>(length), nullptr, 0);
+    if (wideSize <= 0)
+        return false;
+
+    out.resize(wideSize);
+    MultiByteToWideChar(CP_UTF8, 0, data, static_cast<int>(length), &out[0], wideSize);
+    return true;
+}
+
+/**
+ * @brief UTF-8转UTF-16（便捷版本）
+ * @param text UTF-8文本
+ * @return 宽字符文本
+ */
+std::wstring TextEncoding::Utf8ToWide(const std::string& text)
+{
+    std::wstring result;
+    Utf8ToWide(text.data(), text.length(), result);
+    return result;
+}
+
+/**
+ * @brief UTF-16转UTF-8（便捷版本）
+ * @param text 宽字符文本
+ * @return UTF-8文本
+ */
+std::string TextEncoding::WideToUtf8(const std::wstring& text)
+{
+    std::string result;
+    WideToUtf8(text, result);
+    return result;
+}
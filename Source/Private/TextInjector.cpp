@@ -0,0 +1,104 @@
+﻿#include "TextInjector.h"
+#include <algorithm>
+#include <cwctype>
+
+/**
+ * @brief 选择输出方式
+ * @param text 译文
+ * @param policy 策略参数
+ * @param targetTypes 目标窗口是否接受逐字符输入
+ * @return 输出方式
+ */
+InjectionMethod TextInjector::ChooseMethod(const std::wstring& text, const InjectionPolicy& policy, bool targetTypes)
+{
+    if (!targetTypes || text.empty() || text.length() > policy.maxTypedUnits || policy.batchUnits == 0)
+        return InjectionMethod::Clipboard;
+
+    // 控制字符（换行、制表符等）交给剪切板，保持与粘贴完全相同的效果
+    for (wchar_t ch : text)
+    {
+        if (ch < 0x20 || ch == 0x7F)
+            return InjectionMethod::Clipboard;
+    }
+    return InjectionMethod::Type;
+}
+
+/**
+ * @brief 生成按键事件
+ * @param text 译文
+ * @param events 输出事件
+ */
+void TextInjector::BuildEvents(const std::wstring& text, std::vector<KeyEvent>& events)
+{
+    events.clear();
+    events.reserve(text.length() * 2);
+    for (wchar_t ch : text)
+    {
+        uint16_t unit = static_cast<uint16_t>(ch);
+        events.push_back({ unit, false });
+        events.push_back({ unit, true });
+    }
+}
+
+/**
+ * @brief 分批注入按键事件
+ * @param events 按键事件
+ * @param sink 接收端
+ * @param policy 策略参数
+ * @return 注入结果
+ */
+InjectionOutcome TextInjector::Type(const std::vector<KeyEvent>& events, InputSink& sink, const InjectionPolicy& policy)
+{
+    size_t batchEvents = std::max<size_t>(policy.batchUnits, 1) * 2;
+    size_t position = 0;
+    while (position < events.size())
+    {
+        size_t end = std::min(position + batchEvents, events.size());
+
+        // 批次末尾是高代理项时带上对应的低代理项，目标程序才能组合出完整字符
+        if (end < events.size() && events[end - 1].unit >= 0xD800 && events[end - 1].unit <= 0xDBFF)
+            end = std::min(end + 2, events.size());
+
+        if (position > 0)
+            sink.Pause(policy.batchPauseMs);
+        size_t sent = sink.Send(events.data() + position, end - position);
+        if (sent < end - position)
+            return position == 0 && sent == 0 ? InjectionOutcome::Rejected : InjectionOutcome::Partial;
+        position = end;
+    }
+    return InjectionOutcome::Typed;
+}
+
+/**
+ * @brief 判断窗口类名是否在名单中
+ * @param className 窗口类名
+ * @param list 分号分隔的名单
+ * @return 在名单中返回true
+ */
+bool TextInjector::MatchesClassList(const std::wstring& className, const std::wstring& list)
+{
+    if (className.empty())
+        return false;
+
+    size_t start = 0;
+    while (start <= list.length())
+    {
+        size_t end = list.find(L';', start);
+        if (end == std::wstring::npos)
+            end = list.length();
+
+        // 去除条目首尾空白后逐字符比较
+        size_t begin = start;
+        size_t last = end;
+        while (begin < last && std::iswspace(list[begin]))
+            begin++;
+        while (last > begin && std::iswspace(list[last - 1]))
+            last--;
+        if (last - begin == className.length() &&
+            std::equal(className.begin(), className.end(), list.begin() + begin,
+                [](wchar_t a, wchar_t b) { return std::towlower(a) == std::towlower(b); }))
+            return true;
+        start = end + 1;
+    }
+    return false;
+}
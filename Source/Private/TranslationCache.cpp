@@ -0,0 +1,117 @@
+﻿#include "TranslationCache.h"
+
+// 静态成员变量定义
+std::list<TranslationCache::Entry> TranslationCache::s_entries;
+std::unordered_map<std::wstring, std::list<TranslationCache::Entry>::iterator> TranslationCache::s_index;
+size_t TranslationCache::s_capacity = 1000;
+std::mutex TranslationCache::s_mutex;
+
+/**
+ * @brief 设置缓存容量
+ * @param capacity 最大条目数，0表示禁用缓存
+ */
+void TranslationCache::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_capacity = capacity;
+    EvictLocked();
+}
+
+/**
+ * @brief 查找缓存
+ * @param cacheNamespace 命名空间
+ * @param source 原文
+ * @param result 命中时输出译文
+ * @return 命中返回true
+ */
+bool TranslationCache::Lookup(const std::string& cacheNamespace, const std::wstring& source, std::wstring& result)
+{
+    std::wstring key;
+    MakeKey(cacheNamespace, source, key);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_index.find(key);
+    if (it == s_index.end())
+        return false;
+
+    // 移动到表头，标记为最近使用
+    s_entries.splice(s_entries.begin(), s_entries, it->second);
+    result = it->second->second;
+    return true;
+}
+
+/**
+ * @brief 写入缓存
+ * @param cacheNamespace 命名空间
+ * @param source 原文
+ * @param result 译文
+ */
+void TranslationCache::Store(const std::string& cacheNamespace, const std::wstring& source, const std::wstring& result)
+{
+    std::wstring key;
+    MakeKey(cacheNamespace, source, key);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_capacity == 0)
+        return;
+
+    auto it = s_index.find(key);
+    if (it != s_index.end())
+    {
+        it->second->second = result;
+        s_entries.splice(s_entries.begin(), s_entries, it->second);
+        return;
+    }
+
+    s_entries.emplace_front(key, result);
+    s_index.emplace(std::move(key), s_entries.begin());
+    EvictLocked();
+}
+
+/**
+ * @brief 清空缓存
+ */
+void TranslationCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_index.clear();
+    s_entries.clear();
+}
+
+/**
+ * @brief 获取当前条目数
+ * @return 条目数
+ */
+size_t TranslationCache::GetSize()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_entries.size();
+}
+
+/**
+ * @brief 生成缓存键：命名空间 + 分隔符 + 原文
+ * @param cacheNamespace 命名空间
+ * @param source 原文
+ * @param key 输出缓存键
+ */
+void TranslationCache::MakeKey(const std::string& cacheNamespace, const std::wstring& source, std::wstring& key)
+{
+    key.clear();
+    key.reserve(cacheNamespace.length() + 1 + source.length());
+    for (char c : cacheNamespace)
+        key += static_cast<wchar_t>(static_cast<unsigned char>(c));
+    key += L'\x1F';     // 单元分隔符，不会出现在命名空间中
+    key += source;
+}
+
+/**
+ * @brief 淘汰超出容量的条目
+ */
+void TranslationCache::EvictLocked()
+{
+    while (s_entries.size() > s_capacity)
+    {
+        s_index.erase(s_entries.back().first);
+        s_entries.pop_back();
+    }
+}
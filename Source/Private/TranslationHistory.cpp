@@ -0,0 +1,329 @@
+﻿#include "TranslationHistory.h"
+#include "ConfigManager.h"
+#include "AppConfig.h"
+#include "TranslationCache.h"
+#include "TextEncoding.h"
+#include "TranslationMemory.h"
+#include "CodeLexer.h"
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+// 静态成员变量定义
+HANDLE TranslationHistory::s_hFile = INVALID_HANDLE_VALUE;
+HANDLE TranslationHistory::s_hMapping = nullptr;
+char* TranslationHistory::s_pView = nullptr;
+size_t TranslationHistory::s_mappingSize = 0;
+std::vector<uint64_t> TranslationHistory::s_offsets;
+HistoryIndex TranslationHistory::s_index;
+std::mutex TranslationHistory::s_mutex;
+bool TranslationHistory::s_bInitialized = false;
+
+// 历史日志文件名
+static const wchar_t* HISTORY_FILE_NAME = L"YunsioTranslation.history";
+
+/**
+ * @brief 打开历史日志，建立索引并预热翻译缓存
+ * @return 成功返回true，失败返回false
+ */
+bool TranslationHistory::Initialize()
+{
+    if (s_bInitialized)
+        return true;
+
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    if (config->historyMaxKB == 0)
+        return false;   // 历史功能已禁用
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!OpenMapping(static_cast<size_t>(config->historyMaxKB) * 1024))
+            return false;
+        RebuildIndexLocked();
+        s_bInitialized = true;
+    }
+
+    WarmCache();
+    return true;
+}
+
+/**
+ * @brief 将映射内容写回磁盘并关闭日志
+ */
+void TranslationHistory::Cleanup()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_bInitialized)
+        return;
+
+    CloseMapping();
+    s_offsets.clear();
+    s_index.Clear();
+    s_bInitialized = false;
+}
+
+/**
+ * @brief 追加一条记录
+ * @param record 历史记录
+ */
+void TranslationHistory::Append(const HistoryRecord& record)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_bInitialized)
+        return;
+
+    size_t dataCapacity = s_mappingSize - HistoryCodec::HEADER_SIZE;
+    size_t recordSize = HistoryCodec::EncodedSize(record);
+    if (recordSize > dataCapacity / 2)
+        return;     // 单条记录过大，不写入历史
+
+    char* header = s_pView;
+    if (HistoryCodec::GetUsedBytes(header) + recordSize > dataCapacity)
+        CompactLocked();
+
+    // 先写记录内容，再更新已使用字节数作为提交点
+    uint64_t usedBytes = HistoryCodec::GetUsedBytes(header);
+    char* dest = s_pView + HistoryCodec::HEADER_SIZE + usedBytes;
+    HistoryCodec::Encode(record, dest);
+    HistoryCodec::SetUsedBytes(header, usedBytes + recordSize);
+
+    HistoryRecordView view;
+    size_t consumed = 0;
+    if (HistoryCodec::Decode(dest, recordSize, view, consumed))
+    {
+        s_index.Add(static_cast<uint32_t>(s_offsets.size()), view);
+        s_offsets.push_back(usedBytes);
+    }
+}
+
+/**
+ * @brief 获取最近的记录
+ * @param maxCount 最大条数
+ * @param records 输出记录（最新在前）
+ */
+void TranslationHistory::GetRecent(size_t maxCount, std::vector<HistoryRecord>& records)
+{
+    records.clear();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_bInitialized)
+        return;
+
+    for (size_t i = s_offsets.size(); i > 0 && records.size() < maxCount; i--)
+    {
+        HistoryRecordView view;
+        if (!ReadLocked(static_cast<uint32_t>(i - 1), view))
+            continue;
+        records.push_back({ view.timestamp, view.latencyMs, std::string(view.profile), std::string(view.source), std::string(view.result) });
+    }
+}
+
+/**
+ * @brief 搜索原文或译文中包含查询串的记录
+ * @param query UTF-8查询字符串
+ * @param maxCount 最大条数
+ * @param records 输出记录（最新在前）
+ */
+void TranslationHistory::Search(const std::string& query, size_t maxCount, std::vector<HistoryRecord>& records)
+{
+    records.clear();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_bInitialized)
+        return;
+
+    std::vector<uint32_t> candidates;
+    s_index.FindCandidates(query, candidates);
+
+    for (uint32_t id : candidates)
+    {
+        if (records.size() >= maxCount)
+            break;
+
+        HistoryRecordView view;
+        if (!ReadLocked(id, view))
+            continue;
+
+        // bigram交集可能误报，逐条校验
+        if (HistoryIndex::ContainsIgnoreCase(view.source, query) || HistoryIndex::ContainsIgnoreCase(view.result, query))
+            records.push_back({ view.timestamp, view.latencyMs, std::string(view.profile), std::string(view.source), std::string(view.result) });
+    }
+}
+
+/**
+ * @brief 获取当前时间（Unix毫秒）
+ * @return 时间戳
+ */
+int64_t TranslationHistory::GetCurrentTimestamp()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 创建或打开日志文件并映射到内存
+ * @param capacity 文件大小（字节）
+ * @return 成功返回true，失败返回false
+ */
+bool TranslationHistory::OpenMapping(size_t capacity)
+{
+    std::wstring path = ConfigManager::GetAppDirectory() + HISTORY_FILE_NAME;
+    s_hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (s_hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    // 文件预分配到配置的大小；配置调小时沿用现有大小，由压缩控制实际用量
+    LARGE_INTEGER fileSize = {};
+    GetFileSizeEx(s_hFile, &fileSize);
+    bool isNewFile = fileSize.QuadPart < static_cast<LONGLONG>(HistoryCodec::HEADER_SIZE);
+    s_mappingSize = capacity;
+    if (!isNewFile && static_cast<size_t>(fileSize.QuadPart) > capacity)
+        s_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+
+    ULARGE_INTEGER mappingSize = {};
+    mappingSize.QuadPart = s_mappingSize;
+    s_hMapping = CreateFileMappingW(s_hFile, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+    if (s_hMapping == nullptr)
+    {
+        CloseMapping();
+        return false;
+    }
+
+    s_pView = static_cast<char*>(MapViewOfFile(s_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    if (s_pView == nullptr)
+    {
+        CloseMapping();
+        return false;
+    }
+
+    // 新文件或格式不符时重新初始化
+    if (isNewFile || !HistoryCodec::ValidateHeader(s_pView, s_mappingSize - HistoryCodec::HEADER_SIZE))
+        HistoryCodec::InitializeHeader(s_pView);
+
+    return true;
+}
+
+/**
+ * @brief 解除映射并关闭文件
+ */
+void TranslationHistory::CloseMapping()
+{
+    if (s_pView != nullptr)
+    {
+        FlushViewOfFile(s_pView, 0);
+        UnmapViewOfFile(s_pView);
+        s_pView = nullptr;
+    }
+    if (s_hMapping != nullptr)
+    {
+        CloseHandle(s_hMapping);
+        s_hMapping = nullptr;
+    }
+    if (s_hFile != INVALID_HANDLE_VALUE)
+    {
+        FlushFileBuffers(s_hFile);
+        CloseHandle(s_hFile);
+        s_hFile = INVALID_HANDLE_VALUE;
+    }
+    s_mappingSize = 0;
+}
+
+/**
+ * @brief 扫描日志中的全部记录，重建偏移表和索引
+ */
+void TranslationHistory::RebuildIndexLocked()
+{
+    s_offsets.clear();
+    s_index.Clear();
+
+    const char* data = s_pView + HistoryCodec::HEADER_SIZE;
+    uint64_t usedBytes = HistoryCodec::GetUsedBytes(s_pView);
+    uint64_t offset = 0;
+    while (offset < usedBytes)
+    {
+        HistoryRecordView view;
+        size_t consumed = 0;
+        if (!HistoryCodec::Decode(data + offset, static_cast<size_t>(usedBytes - offset), view, consumed))
+        {
+            // 记录损坏（例如写入中途断电），丢弃其后的内容
+            HistoryCodec::SetUsedBytes(s_pView, offset);
+            break;
+        }
+        s_index.Add(static_cast<uint32_t>(s_offsets.size()), view);
+        s_offsets.push_back(offset);
+        offset += consumed;
+    }
+}
+
+/**
+ * @brief 压缩日志：保留最新的记录，使已用空间不超过数据区的一半
+ */
+void TranslationHistory::CompactLocked()
+{
+    size_t dataCapacity = s_mappingSize - HistoryCodec::HEADER_SIZE;
+    uint64_t usedBytes = HistoryCodec::GetUsedBytes(s_pView);
+
+    // 从最新的记录向前找到保留区间的起点
+    size_t keepFrom = s_offsets.size();
+    while (keepFrom > 0 && usedBytes - s_offsets[keepFrom - 1] <= dataCapacity / 2)
+        keepFrom--;
+
+    uint64_t keepOffset = keepFrom < s_offsets.size() ? s_offsets[keepFrom] : usedBytes;
+    uint64_t keepBytes = usedBytes - keepOffset;
+
+    // 先将已用字节数清零再搬移数据，搬移中途崩溃只会丢失历史而不会读到半条记录
+    char* data = s_pView + HistoryCodec::HEADER_SIZE;
+    HistoryCodec::SetUsedBytes(s_pView, 0);
+    std::memmove(data, data + keepOffset, static_cast<size_t>(keepBytes));
+    HistoryCodec::SetUsedBytes(s_pView, keepBytes);
+    FlushViewOfFile(s_pView, 0);
+
+    RebuildIndexLocked();
+}
+
+/**
+ * @brief 用最近的记录预热翻译缓存
+ */
+void TranslationHistory::WarmCache()
+{
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    size_t cacheCount = static_cast<size_t>(config->cacheCapacity);
+    size_t warmCount = std::max(cacheCount, static_cast<size_t>(config->memoryCapacity));
+
+    std::vector<HistoryRecord> records;
+    GetRecent(warmCount, records);
+
+    // 从旧到新写入，使最新的记录在LRU中最近使用；缓存只接收最新的cacheCount条
+    std::vector<CodeSegment> segments;
+    for (size_t i = records.size(); i-- > 0;)
+    {
+        const HistoryRecord& record = records[i];
+        std::shared_ptr<const TranslationProfile> profile = config->FindProfile(record.profile);
+        if (!profile)
+            continue;
+        if (i < cacheCount)
+            TranslationCache::Store(profile->cacheNamespace, TextEncoding::Utf8ToWide(record.source), TextEncoding::Utf8ToWide(record.result));
+
+        // 代码的译文是整段代码，不进入翻译记忆
+        if (!profile->codeAware || !CodeLexer::Analyze(record.source, segments))
+            TranslationMemory::Add(profile->cacheNamespace, record.source, record.result);
+    }
+}
+
+/**
+ * @brief 按记录ID读取记录视图
+ * @param id 记录ID
+ * @param view 输出记录视图
+ * @return 成功返回true
+ */
+bool TranslationHistory::ReadLocked(uint32_t id, HistoryRecordView& view)
+{
+    if (id >= s_offsets.size())
+        return false;
+
+    uint64_t usedBytes = HistoryCodec::GetUsedBytes(s_pView);
+    uint64_t offset = s_offsets[id];
+    size_t consumed = 0;
+    return HistoryCodec::Decode(s_pView + HistoryCodec::HEADER_SIZE + offset, static_cast<size_t>(usedBytes - offset), view, consumed);
+}
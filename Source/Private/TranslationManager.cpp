@@ -1,25 +1,131 @@
 ﻿#include "TranslationManager.h"
 #include "TranslationService.h"
+#include "SystemTray.h"
+#include "TranslationCache.h"
+#include "IdentifierCase.h"
+#include "TextEncoding.h"
+#include "AppConfig.h"
+#include "TranslationHistory.h"
+#include "Instrumentation.h"
+#include "RateLimiter.h"
+#include "ConfigManager.h"
+#include "Outbox.h"
+#include "Glossary.h"
+#include "CodeLexer.h"
+#include "TranslationMemory.h"
+#include "SentenceDelta.h"
+#include "TextInjector.h"
+#include "SendInputSink.h"
+#include <algorithm>
+#include <filesystem>
 #ifdef _DEBUG
 #include <crtdbg.h>
 #endif
 
 // 静态成员变量定义
-bool TranslationManager::s_bInitialized = false;
-bool TranslationManager::s_bTranslationInProgress = false;
+std::atomic<bool> TranslationManager::s_bInitialized{ false };
+std::atomic<bool> TranslationManager::s_bTranslationInProgress{ false };
+std::shared_ptr<const TranslationProfile> TranslationManager::s_pActiveProfile;
+std::wstring TranslationManager::s_sourceText;
+bool TranslationManager::s_bCodeSelection = false;
+ULONGLONG TranslationManager::s_startTick = 0;
+HANDLE TranslationManager::s_hWarmupThread = nullptr;
+HANDLE TranslationManager::s_hServiceReady = nullptr;
+std::atomic<bool> TranslationManager::s_bServiceAvailable{ false };
+DWORD TranslationManager::s_notifyThreadId = 0;
+RequestScheduler TranslationManager::s_scheduler;
+UINT_PTR TranslationManager::s_outboxTimer = 0;
+UINT_PTR TranslationManager::s_quotaTimer = 0;
+std::atomic<bool> TranslationManager::s_bReplaying{ false };
+std::vector<std::wstring> TranslationManager::s_typeRejectedClasses;
+
+// 首次翻译等待翻译服务就绪的最长时间（毫秒）
+static const DWORD SERVICE_READY_TIMEOUT_MS = 5000;
+
+// 当日用量文件名（位于程序所在目录）
+static const wchar_t* QUOTA_FILE_NAME = L"YunsioTranslation.quota";
+
+// 离线队列文件名（位于程序所在目录）
+static const wchar_t* OUTBOX_FILE_NAME = L"YunsioTranslation.outbox";
+
+// 离线队列检查间隔（毫秒）
+static const UINT OUTBOX_CHECK_INTERVAL_MS = 5000;
+
+// 离线时在翻译历史中查找旧译文的最大候选数
+static const size_t STALE_SEARCH_LIMIT = 20;
+
+// 增量翻译时用于检索翻译历史的最长句子数，以及每个句子检索的最大记录数
+static const size_t DELTA_SEARCH_SENTENCES = 3;
+static const size_t DELTA_SEARCH_LIMIT = 8;
+
+// 模拟Ctrl+C后等待目标程序写入剪切板的期限和轮询间隔（毫秒）
+static const ULONGLONG COPY_TIMEOUT_MS = 500;
+static const DWORD COPY_POLL_MS = 5;
+
+/**
+ * @brief 将超时毫秒数转换为时长
+ * @param timeoutMs 毫秒数，INFINITE表示无限
+ * @return 时长
+ */
+static std::chrono::milliseconds ToTimeout(DWORD timeoutMs)
+{
+    return timeoutMs == INFINITE ? std::chrono::milliseconds::max() : std::chrono::milliseconds(timeoutMs);
+}
 
 /**
- * @brief 初始化翻译管理器
+ * @brief 从配置读取调度器的并发上限
+ * @param config 配置
+ * @return 并发设置
+ */
+static RequestScheduler::Limits SchedulerLimits(const AppConfig& config)
+{
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = config.interactiveConcurrency;
+    limits.clientConcurrency = config.clientConcurrency;
+    limits.backgroundConcurrency = config.backgroundConcurrency;
+    return limits;
+}
+
+// 通过WM_TRANSLATION_DONE投递的翻译结果
+struct TranslationOutcome
+{
+    bool success;
+    std::wstring result;
+};
+
+/**
+ * @brief 初始化翻译管理器，耗时的初始化交给后台预热线程
+ * @param notifyThreadId 接收WM_STARTUP_WARM的线程ID
  * @return 成功返回true，失败返回false
  */
-bool TranslationManager::Initialize()
+bool TranslationManager::Initialize(DWORD notifyThreadId)
 {
     if (s_bInitialized)
         return true;
     
-    // 初始化翻译服务
-    if (!TranslationService::Initialize())
+    RateLimiter::Initialize(TextEncoding::WideToUtf8(ConfigManager::GetAppDirectory() + QUOTA_FILE_NAME));
+    Outbox::Initialize(TextEncoding::WideToUtf8(ConfigManager::GetAppDirectory() + OUTBOX_FILE_NAME));
+    ApplyConfig();
+    
+    s_notifyThreadId = notifyThreadId;
+    s_hServiceReady = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (s_hServiceReady == nullptr)
+        return false;
+    
+    s_scheduler.Start(SchedulerLimits(*ConfigStore::Current()));
+    
+    s_hWarmupThread = CreateThread(nullptr, 0, WarmupThreadProc, nullptr, 0, nullptr);
+    if (s_hWarmupThread == nullptr)
+    {
+        s_scheduler.Stop();
+        CloseHandle(s_hServiceReady);
+        s_hServiceReady = nullptr;
         return false;
+    }
+    
+    // 定时检查离线队列（线程定时器，由主线程消息循环分发）
+    s_outboxTimer = SetTimer(nullptr, 0, OUTBOX_CHECK_INTERVAL_MS, OutboxTimerProc);
+    s_quotaTimer = SetTimer(nullptr, 0, RateLimiter::FLUSH_INTERVAL_MS, QuotaTimerProc);
     
     s_bInitialized = true;
     return true;
@@ -27,36 +133,639 @@ bool TranslationManager::Initialize()
 
 /**
  * @brief 清理翻译管理器资源
+ * @param drainTimeoutMs 等待进行中的请求完成的最长时间（毫秒）
+ * @param cancelTimeoutMs 取消后等待请求返回的最长时间（毫秒）
+ * @return 全部请求已结束返回true，仍有请求阻塞时返回false
  */
-void TranslationManager::Cleanup()
+bool TranslationManager::Cleanup(DWORD drainTimeoutMs, DWORD cancelTimeoutMs)
 {
     if (!s_bInitialized)
-        return;
+        return true;
+    
+    if (s_outboxTimer != 0)
+    {
+        KillTimer(nullptr, s_outboxTimer);
+        s_outboxTimer = 0;
+    }
+    if (s_quotaTimer != 0)
+    {
+        KillTimer(nullptr, s_quotaTimer);
+        s_quotaTimer = 0;
+    }
     
+    // 等待预热线程结束后才能释放它正在初始化的资源（不超过排空和取消的总时限）
+    DWORD warmupTimeoutMs = (drainTimeoutMs == INFINITE || cancelTimeoutMs == INFINITE) ? INFINITE : drainTimeoutMs + cancelTimeoutMs;
+    if (WaitForSingleObject(s_hWarmupThread, warmupTimeoutMs) != WAIT_OBJECT_0)
+    {
+        RateLimiter::Cleanup();
+        return false;
+    }
+    CloseHandle(s_hWarmupThread);
+    CloseHandle(s_hServiceReady);
+    s_hWarmupThread = nullptr;
+    s_hServiceReady = nullptr;
+    
+    // 关闭顺序：限时排空调度器中的请求 -> 翻译服务等待其余调用方离开后关闭会话
+    if (!s_scheduler.Stop(ToTimeout(drainTimeoutMs), ToTimeout(cancelTimeoutMs)))
+    {
+        // 仍有请求阻塞在网络调用中：只落盘，不释放它们正在使用的翻译服务
+        TranslationHistory::Cleanup();
+        RateLimiter::Cleanup();
+        return false;
+    }
     TranslationService::Cleanup();
+    
+    // 工作线程已全部退出：排空期间完成的译文写入缓存和历史，不再粘贴
+    MSG msg;
+    while (PeekMessageW(&msg, nullptr, WM_TRANSLATION_DONE, WM_TRANSLATION_DONE, PM_REMOVE))
+    {
+        std::unique_ptr<TranslationOutcome> outcome(reinterpret_cast<TranslationOutcome*>(msg.lParam));
+        if (outcome && outcome->success)
+            RecordTranslation(outcome->result);
+    }
+    
+    TranslationHistory::Cleanup();
+    RateLimiter::Cleanup();
+    Outbox::Cleanup();
+    TranslationCache::Clear();
+    TranslationMemory::Clear();
+    Glossary::Publish(nullptr);
     s_bInitialized = false;
+    return true;
 }
 
 /**
- * @brief 执行翻译流程（复制->翻译->粘贴替换）
+ * @brief 按当前配置调整缓存容量
  */
-void TranslationManager::ExecuteTranslation()
+void TranslationManager::ApplyConfig()
 {
-    if (!s_bInitialized || s_bTranslationInProgress)
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    TranslationCache::SetCapacity(static_cast<size_t>(config->cacheCapacity));
+    TranslationMemory::SetCapacity(static_cast<size_t>(config->memoryCapacity));
+    RateLimiter::SetLimits(config->requestsPerMinute, config->tokensPerMinute);
+    s_scheduler.SetLimits(SchedulerLimits(*config));
+    
+    // 术语表文件不单独监视，随配置文件保存一起重新加载；首次加载由预热线程完成
+    if (s_bInitialized)
+        SubmitBackground([](const std::atomic<bool>&) { LoadGlossary(); return true; });
+}
+
+/**
+ * @brief 按当前配置加载术语表
+ */
+void TranslationManager::LoadGlossary()
+{
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    if (config->glossaryMode == GlossaryMode::Off)
+    {
+        Glossary::Publish(nullptr);
+        return;
+    }
+    
+    std::filesystem::path path = std::filesystem::u8path(config->glossaryFile);
+    if (path.is_relative())
+        path = std::filesystem::path(ConfigManager::GetAppDirectory()) / path;
+    Glossary::Load(TextEncoding::WideToUtf8(path.wstring()));
+}
+
+/**
+ * @brief 选中文本恰好是一条术语时直接使用约定译法
+ * @param text 选中文本
+ * @param result 输出约定译法
+ * @return 命中返回true
+ */
+bool TranslationManager::LookupGlossary(const std::wstring& text, std::wstring& result)
+{
+    std::shared_ptr<const GlossaryMatcher> glossary = Glossary::Current();
+    std::string utf8Text;
+    std::string translation;
+    if (!glossary || ConfigStore::Current()->glossaryMode == GlossaryMode::Off ||
+        !TextEncoding::WideToUtf8(text, utf8Text) || !glossary->LookupExact(utf8Text, translation))
+    {
+        return false;
+    }
+    result = TextEncoding::Utf8ToWide(translation);
+    return true;
+}
+
+/**
+ * @brief 判断选中文本是否按代码处理
+ * @param profile 翻译配置档
+ * @param text 选中文本
+ * @return 是含可翻译片段的代码返回true
+ */
+bool TranslationManager::IsCodeSelection(const TranslationProfile& profile, const std::wstring& text)
+{
+    std::string utf8Text;
+    std::vector<CodeSegment> segments;
+    return profile.codeAware && TextEncoding::WideToUtf8(text, utf8Text) && CodeLexer::Analyze(utf8Text, segments);
+}
+
+/**
+ * @brief 执行翻译流程（复制->翻译->按配置档粘贴替换或显示）
+ * @param profile 热键对应的翻译配置档
+ */
+void TranslationManager::ExecuteTranslation(std::shared_ptr<const TranslationProfile> profile)
+{
+    if (!s_bInitialized || s_bTranslationInProgress || !profile)
         return;
     
     s_bTranslationInProgress = true;
+    s_pActiveProfile = profile;
     
     // 获取当前选中的文本
     std::wstring selectedText;
     if (!GetSelectedText(selectedText) || selectedText.empty())
     {
         s_bTranslationInProgress = false;
+        s_pActiveProfile.reset();
         return;
     }
     
-    // 开始翻译
-    TranslationService::TranslateAsync(selectedText, OnTranslationComplete);
+    // 选中代码时只翻译注释和字符串，译文是写回后的整段代码
+    s_bCodeSelection = IsCodeSelection(*profile, selectedText);
+    
+    // 选中的恰好是一条术语时直接使用约定译法，优先于缓存中可能过时的译文（仍按配置档转换命名风格）
+    std::wstring glossaryResult;
+    if (!s_bCodeSelection && LookupGlossary(selectedText, glossaryResult))
+    {
+        Instrumentation::AddCounter("glossary.exact");
+        OnTranslationComplete(true, glossaryResult);
+        return;
+    }
+    
+    // 命中缓存时直接输出，不发起网络请求
+    std::wstring cachedResult;
+    if (TranslationCache::Lookup(profile->cacheNamespace, selectedText, cachedResult))
+    {
+        OnTranslationComplete(true, cachedResult);
+        return;
+    }
+    
+    // 与翻译过的原文只差大小写、空白或标点（或达到Answer阈值）时沿用其译文
+    std::wstring memoryResult;
+    if (!s_bCodeSelection && LookupMemory(*profile, selectedText, memoryResult))
+    {
+        OnTranslationComplete(true, memoryResult);
+        return;
+    }
+    
+    // 首次翻译时服务可能仍在后台初始化，只等待网络请求真正需要的部分
+    if (!WaitForService())
+    {
+        SystemTray::ShowNotification(L"翻译失败", L"翻译服务初始化失败");
+        s_bTranslationInProgress = false;
+        s_pActiveProfile.reset();
+        return;
+    }
+    
+    // 离线时先用翻译历史中的旧译文应急；仅显示模式不需要当场粘贴，直接加入离线队列
+    if (!TranslationService::IsOnline())
+    {
+        std::wstring staleResult;
+        if (FindStaleResult(*profile, selectedText, staleResult))
+        {
+            Instrumentation::AddCounter("outbox.stale_served");
+            OnTranslationComplete(true, staleResult);
+            return;
+        }
+        
+        if (profile->output == OutputMode::Show)
+        {
+            Outbox::Enqueue(profile->name, TextEncoding::WideToUtf8(selectedText));
+            OnTranslationComplete(false, L"网络不可用，已加入离线队列，恢复后自动翻译");
+            UpdateOfflineIndicator();
+            return;
+        }
+    }
+    
+    // 开始翻译：请求在调度器的工作线程上执行，主线程继续处理消息
+    s_sourceText = selectedText;
+    s_startTick = GetTickCount64();
+    
+    // 编辑过的段落只翻译改动的句子；只改了空白时直接拼出译文（原文不同，仍写入缓存和历史）
+    std::shared_ptr<const SentenceDelta> delta = s_bCodeSelection ? nullptr : PlanDelta(*profile, selectedText);
+    if (delta && delta->GetChangedCount() == 0)
+    {
+        std::string output;
+        delta->Assemble(std::string(), output);
+        OnTranslationComplete(true, TextEncoding::Utf8ToWide(output));
+        return;
+    }
+    
+    bool submitted = s_scheduler.Submit(RequestPriority::Interactive,
+        [selectedText, profile, delta, code = s_bCodeSelection](const std::atomic<bool>& cancelled)
+        {
+            TranslationService::TranslationCallback callback = [&](bool success, const std::wstring& result)
+            {
+                // 仅显示模式的请求因网络不可用失败时加入离线队列，恢复后重放
+                if (!success && profile->output == OutputMode::Show && !TranslationService::IsOnline() &&
+                    Outbox::Enqueue(profile->name, TextEncoding::WideToUtf8(selectedText)))
+                {
+                    PostTranslationResult(false, L"网络不可用，已加入离线队列，恢复后自动翻译");
+                    return;
+                }
+                PostTranslationResult(success, result);
+            };
+            if (delta)
+                TranslationService::TranslateDeltaAsync(*delta, *profile, callback, &cancelled);
+            else if (code)
+                TranslationService::TranslateCodeAsync(selectedText, *profile, callback, &cancelled);
+            else
+                TranslationService::TranslateAsync(selectedText, *profile, callback, &cancelled);
+            return true;
+        });
+    if (!submitted)
+    {
+        s_bTranslationInProgress = false;
+        s_pActiveProfile.reset();
+        s_sourceText.clear();
+        s_bCodeSelection = false;
+    }
+}
+
+/**
+ * @brief 将工作线程上的翻译结果投递到主线程
+ * @param success 翻译是否成功
+ * @param result 翻译结果
+ */
+void TranslationManager::PostTranslationResult(bool success, const std::wstring& result)
+{
+    TranslationOutcome* outcome = new TranslationOutcome{ success, result };
+    if (!PostThreadMessageW(s_notifyThreadId, WM_TRANSLATION_DONE, 0, reinterpret_cast<LPARAM>(outcome)))
+        delete outcome;
+}
+
+/**
+ * @brief 处理WM_TRANSLATION_DONE，在主线程上输出翻译结果
+ * @param lParam 消息参数
+ */
+void TranslationManager::OnTranslationMessage(LPARAM lParam)
+{
+    std::unique_ptr<TranslationOutcome> outcome(reinterpret_cast<TranslationOutcome*>(lParam));
+    if (outcome)
+        OnTranslationComplete(outcome->success, outcome->result);
+    UpdateOfflineIndicator();
+}
+
+/**
+ * @brief 离线时在翻译历史中查找同一原文的旧译文
+ * @param profile 配置档
+ * @param source 原文
+ * @param result 找到时输出命名风格转换前的译文
+ * @return 找到返回true
+ */
+bool TranslationManager::FindStaleResult(const TranslationProfile& profile, const std::wstring& source, std::wstring& result)
+{
+    std::string utf8Source;
+    if (!TextEncoding::WideToUtf8(source, utf8Source))
+        return false;
+    
+    // 搜索按子串匹配，逐条确认原文完全相同（记录最新在前）
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    std::vector<HistoryRecord> records;
+    TranslationHistory::Search(utf8Source, STALE_SEARCH_LIMIT, records);
+    for (const HistoryRecord& record : records)
+    {
+        if (record.source != utf8Source || record.result.empty())
+            continue;
+        
+        // 同一命名空间的配置档共享译文，标识符配置档不会用到普通文本的译文
+        std::shared_ptr<const TranslationProfile> owner = config->FindProfile(record.profile);
+        if (owner && owner->cacheNamespace == profile.cacheNamespace)
+        {
+            result = TextEncoding::Utf8ToWide(record.result);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 在翻译记忆中查找可直接沿用的译文
+ * @param profile 配置档
+ * @param source 原文
+ * @param result 找到时输出命名风格转换前的译文
+ * @return 找到返回true
+ */
+bool TranslationManager::LookupMemory(const TranslationProfile& profile, const std::wstring& source, std::wstring& result)
+{
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    MemoryMatch match;
+    if (!TranslationMemory::Lookup(profile.cacheNamespace, TextEncoding::WideToUtf8(source), config->memoryAnswer, match))
+        return false;
+    
+    Instrumentation::AddCounter("memory.answered");
+    result = TextEncoding::Utf8ToWide(match.result);
+    return true;
+}
+
+/**
+ * @brief 为编辑过的段落生成增量计划
+ * @param profile 配置档
+ * @param source 原文
+ * @return 增量计划，不适合增量翻译时返回nullptr
+ */
+std::shared_ptr<const SentenceDelta> TranslationManager::PlanDelta(const TranslationProfile& profile, const std::wstring& source)
+{
+    if (!profile.deltaAware)
+        return nullptr;
+    
+    std::string utf8Source;
+    std::vector<SentenceSpan> sentences;
+    if (!TextEncoding::WideToUtf8(source, utf8Source))
+        return nullptr;
+    SentenceDelta::Split(utf8Source, sentences);
+    if (sentences.size() < 2)
+        return nullptr;
+    
+    // 改动的句子可能恰好最长，依次用最长的几句检索，记录最新在前
+    std::sort(sentences.begin(), sentences.end(), [](const SentenceSpan& a, const SentenceSpan& b)
+    {
+        return a.end - a.begin > b.end - b.begin;
+    });
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    std::shared_ptr<SentenceDelta> best;
+    int64_t bestTimestamp = 0;
+    auto candidate = std::make_shared<SentenceDelta>();
+    std::vector<HistoryRecord> records;
+    for (size_t i = 0; i < sentences.size() && i < DELTA_SEARCH_SENTENCES; ++i)
+    {
+        TranslationHistory::Search(utf8Source.substr(sentences[i].begin, sentences[i].end - sentences[i].begin), DELTA_SEARCH_LIMIT, records);
+        for (const HistoryRecord& record : records)
+        {
+            if (best && record.timestamp <= bestTimestamp)
+                break;
+            
+            // 同一命名空间的配置档共享译文
+            std::shared_ptr<const TranslationProfile> owner = config->FindProfile(record.profile);
+            if (!owner || owner->cacheNamespace != profile.cacheNamespace)
+                continue;
+            
+            // 逐句翻译会损失段落上下文，至少一半内容沿用上次译文时才值得
+            if (candidate->Build(utf8Source, record.source, record.result) && candidate->GetReusedBytes() * 2 >= utf8Source.length())
+            {
+                bestTimestamp = record.timestamp;
+                best = std::move(candidate);
+                candidate = std::make_shared<SentenceDelta>();
+                break;
+            }
+        }
+    }
+    if (best)
+        Instrumentation::AddCounter("delta.planned");
+    return best;
+}
+
+/**
+ * @brief 离线队列定时器：更新离线指示，有到期请求时提交后台重放
+ * @param hWnd 未使用
+ * @param message 未使用
+ * @param timerId 未使用
+ * @param time 未使用
+ */
+VOID CALLBACK TranslationManager::OutboxTimerProc(HWND hWnd, UINT message, UINT_PTR timerId, DWORD time)
+{
+    UNREFERENCED_PARAMETER(hWnd);
+    UNREFERENCED_PARAMETER(message);
+    UNREFERENCED_PARAMETER(timerId);
+    UNREFERENCED_PARAMETER(time);
+    
+    UpdateOfflineIndicator();
+    
+    // 翻译服务初始化完成前不重放
+    if (s_bReplaying || WaitForSingleObject(s_hServiceReady, 0) != WAIT_OBJECT_0 || !s_bServiceAvailable)
+        return;
+    if (!Outbox::HasDue(Outbox::Clock::now()))
+        return;
+    
+    s_bReplaying = true;
+    if (!SubmitBackground(ReplayOutbox))
+        s_bReplaying = false;
+}
+
+/**
+ * @brief 当日用量定时器：提交后台任务保存累计的用量
+ * @param hWnd 未使用
+ * @param message 未使用
+ * @param timerId 未使用
+ * @param time 未使用
+ */
+VOID CALLBACK TranslationManager::QuotaTimerProc(HWND hWnd, UINT message, UINT_PTR timerId, DWORD time)
+{
+    UNREFERENCED_PARAMETER(hWnd);
+    UNREFERENCED_PARAMETER(message);
+    UNREFERENCED_PARAMETER(timerId);
+    UNREFERENCED_PARAMETER(time);
+    
+    // 等待其他进程释放文件锁可能长达1秒，不在主线程上进行
+    SubmitBackground([](const std::atomic<bool>&) { RateLimiter::Flush(); return true; });
+}
+
+/**
+ * @brief 后台任务：依次重放离线队列中到期的请求
+ * @param cancelled 取消信号
+ * @return 始终返回true
+ */
+bool TranslationManager::ReplayOutbox(const std::atomic<bool>& cancelled)
+{
+    OutboxEntry entry;
+    while (!cancelled && Outbox::TakeDue(Outbox::Clock::now(), entry))
+    {
+        // 配置档已删除的请求无法重放，直接移出队列
+        std::shared_ptr<const TranslationProfile> profile = ConfigStore::Current()->FindProfile(entry.profile);
+        if (!profile)
+        {
+            Outbox::Complete(entry.id);
+            continue;
+        }
+        
+        std::wstring source = TextEncoding::Utf8ToWide(entry.source);
+        ULONGLONG startTick = GetTickCount64();
+        bool translated = false;
+        auto translate = IsCodeSelection(*profile, source) ? TranslationService::TranslateCodeAsync : TranslationService::TranslateAsync;
+        translate(source, *profile, [&](bool success, const std::wstring& result)
+        {
+            if (success && !result.empty())
+            {
+                StoreResult(*profile, source, result, static_cast<uint32_t>(GetTickCount64() - startTick));
+                translated = true;
+            }
+        }, &cancelled);
+        
+        if (translated)
+        {
+            Outbox::Complete(entry.id);
+        }
+        else if (cancelled)
+        {
+            // 被交互请求抢占：放回队列，定时器稍后重新提交
+            Outbox::Release(entry.id);
+            break;
+        }
+        else
+        {
+            // 仍然离线时结束本轮，其余请求不必逐个超时
+            Outbox::Retry(entry.id, Outbox::Clock::now());
+            if (!TranslationService::IsOnline())
+                break;
+        }
+    }
+    
+    s_bReplaying = false;
+    return true;
+}
+
+/**
+ * @brief 按翻译服务的连通状态和离线队列长度更新托盘指示
+ */
+void TranslationManager::UpdateOfflineIndicator()
+{
+    SystemTray::SetOfflineState(!TranslationService::IsOnline(), Outbox::GetCount());
+}
+
+/**
+ * @brief 提交后台请求
+ * @param job 任务
+ * @return 已排队返回true
+ */
+bool TranslationManager::SubmitBackground(RequestScheduler::Job job)
+{
+    return s_scheduler.Submit(RequestPriority::Background, std::move(job));
+}
+
+/**
+ * @brief 提交本地IPC客户端的单条翻译
+ * @param job 任务
+ * @return 已排队返回true
+ */
+bool TranslationManager::SubmitClient(RequestScheduler::Job job)
+{
+    return s_scheduler.Submit(RequestPriority::Client, std::move(job));
+}
+
+/**
+ * @brief 在调用线程上翻译一段文本
+ * @param profile 翻译配置档
+ * @param source 原文
+ * @param result 输出译文或错误信息
+ * @param cached 输出译文是否来自术语表或缓存
+ * @param cancel 取消信号，可为nullptr
+ * @param progress 流式翻译的进度回调，可为空
+ * @return 成功返回true
+ */
+bool TranslationManager::TranslateText(const TranslationProfile& profile, const std::wstring& source, std::wstring& result,
+    bool& cached, const std::atomic<bool>* cancel, TranslationService::ProgressCallback progress)
+{
+    cached = TranslateLocally(profile, source, result);
+    if (cached)
+        return true;
+    
+    bool code = IsCodeSelection(profile, source);
+    bool success = false;
+    bool completed = false;
+    auto callback = [&](bool ok, const std::wstring& text)
+    {
+        success = ok;
+        completed = true;
+        result = text;
+    };
+    if (code)
+        TranslationService::TranslateCodeAsync(source, profile, callback, cancel);
+    else if (progress)
+        TranslationService::TranslateStreamAsync(source, profile, std::move(progress), callback, cancel);
+    else
+        TranslationService::TranslateAsync(source, profile, callback, cancel);
+    
+    // 被取消时不调用回调
+    if (!completed)
+    {
+        if (cancel != nullptr && *cancel)
+            result.clear();
+        else
+            result = L"翻译服务不可用";
+        return false;
+    }
+    if (!success)
+        return false;
+    TranslationCache::Store(profile.cacheNamespace, source, result);
+    if (!code)
+        TranslationMemory::Add(profile.cacheNamespace, TextEncoding::WideToUtf8(source), TextEncoding::WideToUtf8(result));
+    
+    // 代码的译文是写回后的整段代码，不转换命名风格
+    if (!code)
+        result = FormatResult(&profile, result);
+    return true;
+}
+
+/**
+ * @brief 不发起请求，只从术语表、缓存和翻译记忆中查找译文
+ * @param profile 翻译配置档
+ * @param source 原文
+ * @param result 命中时输出按配置档处理后的译文
+ * @return 命中返回true
+ */
+bool TranslationManager::TranslateLocally(const TranslationProfile& profile, const std::wstring& source, std::wstring& result)
+{
+    bool code = IsCodeSelection(profile, source);
+    if (!(!code && LookupGlossary(source, result)) && !TranslationCache::Lookup(profile.cacheNamespace, source, result) &&
+        !(!code && LookupMemory(profile, source, result)))
+    {
+        return false;
+    }
+    
+    // 代码的译文是写回后的整段代码，不做后处理
+    if (!code)
+        result = FormatResult(&profile, result);
+    return true;
+}
+
+/**
+ * @brief 后台预热线程：创建翻译服务会话、打开翻译历史、提交预连接请求
+ * @param param 未使用
+ * @return 线程退出码
+ */
+DWORD WINAPI TranslationManager::WarmupThreadProc(LPVOID param)
+{
+    UNREFERENCED_PARAMETER(param);
+    
+    // 会话创建完成即放行首次翻译，历史加载和预连接与之并行
+    s_bServiceAvailable = TranslationService::Initialize();
+    SetEvent(s_hServiceReady);
+    Instrumentation::MarkStartup("session");
+    
+    // 打开翻译历史并预热缓存（失败时仅历史功能不可用，预热前的翻译只是缓存未命中）
+    // 本地加载较快，先于网络预连接完成
+    TranslationHistory::Initialize();
+    Instrumentation::MarkStartup("history");
+    
+    LoadGlossary();
+    Instrumentation::MarkStartup("glossary");
+    
+    // 预连接作为后台请求执行，首个热键翻译到来时让路（交互请求自行建立连接）
+    bool submitted = s_bServiceAvailable && SubmitBackground([](const std::atomic<bool>& cancelled)
+    {
+        if (!TranslationService::Preconnect(&cancelled))
+            return false;
+        Instrumentation::MarkStartup("preconnect");
+        PostThreadMessageW(s_notifyThreadId, WM_STARTUP_WARM, 0, 0);
+        return true;
+    });
+    
+    if (!submitted)
+        PostThreadMessageW(s_notifyThreadId, WM_STARTUP_WARM, 0, 0);
+    return 0;
+}
+
+/**
+ * @brief 等待翻译服务就绪
+ * @return 服务可用返回true
+ */
+bool TranslationManager::WaitForService()
+{
+    if (WaitForSingleObject(s_hServiceReady, SERVICE_READY_TIMEOUT_MS) != WAIT_OBJECT_0)
+        return false;
+    return s_bServiceAvailable;
 }
 
 /**
@@ -87,12 +796,9 @@ bool TranslationManager::CopySelectedText()
     inputs[3].ki.wVk = VK_CONTROL;
     inputs[3].ki.dwFlags = KEYEVENTF_KEYUP;
     
-    // 发送按键序列
+    // 发送按键序列（目标程序何时写入剪切板由调用方轮询剪切板序列号判断）
     UINT result = SendInput(4, inputs, sizeof(INPUT));
     
-    // 添加短暂延时确保按键被处理
-    Sleep(50);
-    
     return result == 4;
 }
 
@@ -130,6 +836,7 @@ bool TranslationManager::GetSelectedText(std::wstring& text)
     {
         return false;
     }
+    DWORD sequence = GetClipboardSequenceNumber();
     
     // 模拟Ctrl+C复制选中文本，增加重试机制
     bool copySuccess = false;
@@ -148,14 +855,15 @@ bool TranslationManager::GetSelectedText(std::wstring& text)
         return false;
     }
     
-    // 等待复制完成，增加超时检查
-    for (int wait = 0; wait < 10; ++wait)
+    // 等待复制完成：剪切板序列号变化后立即读取（目标程序可能仍占用剪切板或分多次写入，读不到内容时继续轮询）
+    ULONGLONG deadline = GetTickCount64() + COPY_TIMEOUT_MS;
+    while (GetTickCount64() < deadline)
     {
-        Sleep(50);
-        if (GetClipboardText(text) && !text.empty())
+        if (GetClipboardSequenceNumber() != sequence && GetClipboardText(text) && !text.empty())
         {
             return true;
         }
+        Sleep(COPY_POLL_MS);
     }
     
     return false;
@@ -328,6 +1036,9 @@ void TranslationManager::OnTranslationComplete(bool success, const std::wstring&
         ~StateResetter() 
         { 
             s_bTranslationInProgress = false;
+            s_pActiveProfile.reset();
+            s_sourceText.clear();
+            s_bCodeSelection = false;
             // 强制垃圾回收，清理可能的内存碎片
             #ifdef _DEBUG
             _CrtCheckMemory();
@@ -335,46 +1046,197 @@ void TranslationManager::OnTranslationComplete(bool success, const std::wstring&
         }
     } resetter;
     
-    if (success && !result.empty())
+    if (success)
+        RecordTranslation(result);
+    
+    // 按配置档的后处理和命名风格在本地处理译文（代码的译文原样输出）
+    std::wstring output = success && !s_bCodeSelection ? FormatResult(s_pActiveProfile.get(), result) : result;
+    
+    // 仅显示模式：在托盘通知中展示结果（失败时展示错误信息），不触碰剪切板
+    if (s_pActiveProfile && s_pActiveProfile->output == OutputMode::Show)
+    {
+        SystemTray::ShowNotification(success ? L"翻译结果" : L"翻译失败", output);
+        return;
+    }
+    
+    if (success && !output.empty())
+    {
+        PasteResult(output);
+    }
+    
+    // 显式清理局部变量，释放内存
+    // 注意：这里不需要手动清理，RAII会自动处理
+}
+
+/**
+ * @brief 将当前翻译的原始译文写入缓存和历史
+ * @param result 后处理和命名风格转换前的译文
+ */
+void TranslationManager::RecordTranslation(const std::wstring& result)
+{
+    // 缓存命中或使用旧译文时原文为空，无需重复写入
+    if (result.empty() || !s_pActiveProfile || s_sourceText.empty())
+        return;
+    
+    StoreResult(*s_pActiveProfile, s_sourceText, result, static_cast<uint32_t>(GetTickCount64() - s_startTick));
+}
+
+/**
+ * @brief 将原始译文写入缓存和历史（线程安全）
+ * @param profile 配置档
+ * @param source 原文
+ * @param result 后处理和命名风格转换前的译文
+ * @param latencyMs 翻译耗时（毫秒）
+ */
+void TranslationManager::StoreResult(const TranslationProfile& profile, const std::wstring& source, const std::wstring& result, uint32_t latencyMs)
+{
+    TranslationCache::Store(profile.cacheNamespace, source, result);
+    
+    HistoryRecord record;
+    record.timestamp = TranslationHistory::GetCurrentTimestamp();
+    record.latencyMs = latencyMs;
+    record.profile = profile.name;
+    TextEncoding::WideToUtf8(source, record.source);
+    TextEncoding::WideToUtf8(result, record.result);
+    TranslationHistory::Append(record);
+    
+    // 代码的译文是整段代码，不适合作为相似原文的参考
+    if (!IsCodeSelection(profile, source))
+        TranslationMemory::Add(profile.cacheNamespace, record.source, record.result);
+}
+
+/**
+ * @brief 按配置档的后处理流水线清理译文，再转换命名风格
+ * @param profile 配置档
+ * @param rawResult 模型返回的原始译文
+ * @return 输出的文本；清理后为空时原样返回，译文含非ASCII字符（英译中）或风格为None时不转换命名风格
+ */
+std::wstring TranslationManager::FormatResult(const TranslationProfile* profile, const std::wstring& rawResult)
+{
+    std::string utf8Result;
+    if (!profile || !TextEncoding::WideToUtf8(rawResult, utf8Result))
+        return rawResult;
+    
+    profile->resultPipeline.Apply(utf8Result);
+    if (utf8Result.empty())
+        return rawResult;
+    if (profile->caseStyle == CaseStyle::None || !IdentifierCase::IsAsciiText(utf8Result))
+        return TextEncoding::Utf8ToWide(utf8Result);
+    
+    std::string converted;
+    IdentifierCase::Convert(utf8Result, profile->caseStyle, converted);
+    return TextEncoding::Utf8ToWide(converted.empty() ? utf8Result : converted);
+}
+
+/**
+ * @brief 输出文本以替换选中内容（按键输入或剪切板粘贴）
+ * @param text 要输出的文本
+ */
+void TranslationManager::PasteResult(const std::wstring& text)
+{
+    // 短的单行文本直接按键输入，不经过剪切板，也不需要等待粘贴和恢复
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    InjectionPolicy policy;
+    policy.maxTypedUnits = static_cast<size_t>(config->pasteMaxTypedChars);
+    
+    wchar_t className[256] = {};
+    HWND target = GetForegroundWindow();
+    if (target != nullptr)
+        GetClassNameW(target, className, static_cast<int>(sizeof(className) / sizeof(className[0])));
+    bool targetTypes = !TextInjector::MatchesClassList(className, TextEncoding::Utf8ToWide(config->pasteClipboardClasses)) &&
+        std::find(s_typeRejectedClasses.begin(), s_typeRejectedClasses.end(), className) == s_typeRejectedClasses.end();
+    
+    if (TextInjector::ChooseMethod(text, policy, targetTypes) == InjectionMethod::Type)
     {
-        // 备份当前剪切板内容以便后续恢复
-        std::wstring originalClipboard;
-        GetClipboardText(originalClipboard);
+        std::vector<KeyEvent> events;
+        TextInjector::BuildEvents(text, events);
+        SendInputSink sink;
+        InjectionOutcome outcome = TextInjector::Type(events, sink, policy);
+        if (outcome == InjectionOutcome::Typed)
+        {
+            Instrumentation::AddCounter("paste.typed");
+            return;
+        }
+        if (outcome == InjectionOutcome::Partial)
+        {
+            // 已输入部分字符，再粘贴会重复：把完整译文留在剪切板上并提示用户，该窗口以后改用剪切板
+            Instrumentation::AddCounter("paste.partial");
+            if (className[0] != L'\0')
+                s_typeRejectedClasses.push_back(className);
+            bool copied = SetClipboardText(text);
+            SystemTray::ShowNotification(L"译文未完整输入",
+                copied ? L"目标程序中途拒绝了按键输入，完整译文已复制到剪切板" : L"目标程序中途拒绝了按键输入：" + text);
+            return;
+        }
         
-        // 使用RAII确保剪切板内容最终恢复
-        struct ClipboardRestorer
+        // 目标拒绝了按键输入（如权限更高的进程），记住类名并改用剪切板
+        if (className[0] != L'\0')
+            s_typeRejectedClasses.push_back(className);
+    }
+    Instrumentation::AddCounter("paste.clipboard");
+    
+    // 备份当前剪切板内容以便后续恢复
+    std::wstring originalClipboard;
+    GetClipboardText(originalClipboard);
+    
+    // 使用RAII确保剪切板内容最终恢复
+    struct ClipboardRestorer
+    {
+        std::wstring original;
+        ClipboardRestorer(const std::wstring& orig) : original(orig) {}
+        ~ClipboardRestorer() 
         {
-            std::wstring original;
-            ClipboardRestorer(const std::wstring& orig) : original(orig) {}
-            ~ClipboardRestorer() 
-            {
-                // 延迟恢复原始剪切板内容，确保粘贴操作完成
-                Sleep(200);
-                SetClipboardText(original);
-            }
-        } clipboardRestorer(originalClipboard);
+            // 延迟恢复原始剪切板内容，确保粘贴操作完成
+            Sleep(200);
+            SetClipboardText(original);
+        }
+    } clipboardRestorer(originalClipboard);
+    
+    // 设置翻译结果到剪切板，增加错误处理
+    if (SetClipboardText(text))
+    {
+        // 等待设置完成
+        Sleep(50);
         
-        // 设置翻译结果到剪切板，增加错误处理
-        if (SetClipboardText(result))
+        // 粘贴翻译结果，增加重试机制
+        for (int retry = 0; retry < 3; ++retry)
         {
-            // 等待设置完成
-            Sleep(50);
-            
-            // 粘贴翻译结果，增加重试机制
-            for (int retry = 0; retry < 3; ++retry)
+            if (PasteText())
             {
-                if (PasteText())
-                {
-                    break;
-                }
-                Sleep(50); // 重试前等待
+                break;
             }
-            
-            // 等待粘贴完成
-            Sleep(100);
+            Sleep(50); // 重试前等待
         }
+        
+        // 等待粘贴完成
+        Sleep(100);
     }
+}
+
+/**
+ * @brief 将历史记录中的译文重新粘贴到目标窗口，无需网络请求
+ * @param record 历史记录
+ * @param targetWindow 粘贴目标窗口（弹出托盘菜单前的前台窗口）
+ */
+void TranslationManager::RepasteHistory(const HistoryRecord& record, HWND targetWindow)
+{
+    if (!s_bInitialized || s_bTranslationInProgress || record.result.empty())
+        return;
     
-    // 显式清理局部变量，释放内存
-    // 注意：这里不需要手动清理，RAII会自动处理
+    // 按记录所属配置档的命名风格输出，配置档已删除或原文是代码时输出原始译文
+    std::shared_ptr<const TranslationProfile> profile = ConfigStore::Current()->FindProfile(record.profile);
+    std::wstring output = TextEncoding::Utf8ToWide(record.result);
+    if (profile && !IsCodeSelection(*profile, TextEncoding::Utf8ToWide(record.source)))
+        output = FormatResult(profile.get(), output);
+    
+    // 托盘菜单会夺取焦点，先将焦点还给原窗口
+    if (targetWindow != nullptr)
+    {
+        SetForegroundWindow(targetWindow);
+        Sleep(50);
+    }
+    
+    s_bTranslationInProgress = true;
+    PasteResult(output);
+    s_bTranslationInProgress = false;
 }
\ No newline at end of file
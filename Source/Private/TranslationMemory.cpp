@@ -0,0 +1,508 @@
+﻿#include "TranslationMemory.h"
+#include <algorithm>
+#include <utility>
+
+// 静态成员变量定义
+std::unique_ptr<MemoryIndex> TranslationMemory::s_pIndex;
+std::mutex TranslationMemory::s_mutex;
+
+// 类内初始化的静态常量在取地址时需要定义
+const size_t MemoryIndex::MIN_CHARS;
+const size_t MemoryIndex::MAX_CHARS;
+const uint32_t MemoryIndex::NONE;
+
+// 每段桶链表最多检查的记录数（常见特征的桶很长，只看最新的部分）
+static const size_t MAX_CHAIN_WALK = 256;
+
+// 最多校验编辑距离的候选数（按命中段数从多到少）
+static const size_t MAX_VERIFY = 32;
+
+// 每段的初始桶数
+static const size_t INITIAL_BUCKETS = 1024;
+
+// MinHash第h个哈希函数的种子为 (h + 1) * HASH_SEED_STEP
+static const uint64_t HASH_SEED_STEP = 0x9E3779B97F4A7C15ull;
+
+/**
+ * @brief 64位整数混合（SplitMix64的终结函数）
+ * @param x 输入
+ * @return 混合后的值
+ */
+static uint64_t Mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief 计算命名空间哈希（FNV-1a）
+ * @param text 命名空间
+ * @return 哈希值
+ */
+static uint32_t HashNamespace(const std::string& text)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char ch : text)
+    {
+        hash ^= ch;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 判断码点是否为空白或标点
+ * @param cp 码点
+ * @return 是空白或标点返回true
+ */
+static bool IsIgnoredChar(uint32_t cp)
+{
+    if (cp < 0x80)
+        return !((cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z'));
+    return cp == 0x00A0 ||
+        (cp >= 0x2000 && cp <= 0x206F) ||      // 通用标点
+        (cp >= 0x3000 && cp <= 0x303F) ||      // 中日韩标点
+        (cp >= 0xFF01 && cp <= 0xFF0F) || (cp >= 0xFF1A && cp <= 0xFF20) ||
+        (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65);   // 全角标点
+}
+
+/**
+ * @brief 构造索引
+ * @param capacity 最大记录数
+ */
+MemoryIndex::MemoryIndex(size_t capacity)
+    : m_capacity(std::max<size_t>(capacity, 2))
+{
+    RebuildBuckets(INITIAL_BUCKETS);
+}
+
+/**
+ * @brief 归一化：ASCII转小写，去除空白和标点
+ * @param text UTF-8文本
+ * @param out 输出码点
+ */
+void MemoryIndex::Normalize(const std::string& text, std::vector<uint32_t>& out)
+{
+    out.clear();
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    size_t i = 0;
+    while (i < length)
+    {
+        // 解码UTF-8，非法字节按单字节处理
+        uint32_t cp = data[i];
+        size_t extra = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : cp >= 0xC0 ? 1 : 0;
+        if (extra > 0)
+        {
+            bool valid = i + extra < length;
+            for (size_t k = 1; k <= extra && valid; ++k)
+                valid = (data[i + k] & 0xC0) == 0x80;
+            if (valid)
+            {
+                cp &= (0x3F >> extra);
+                for (size_t k = 1; k <= extra; ++k)
+                    cp = (cp << 6) | (data[i + k] & 0x3F);
+                i += extra;
+            }
+        }
+        ++i;
+
+        if (IsIgnoredChar(cp))
+            continue;
+        if (cp >= 'A' && cp <= 'Z')
+            cp += 'a' - 'A';
+        out.push_back(cp);
+    }
+}
+
+/**
+ * @brief 带状编辑距离
+ * @param a 码点序列
+ * @param b 码点序列
+ * @param maxDistance 允许的最大距离
+ * @return 编辑距离，超过maxDistance时返回maxDistance + 1
+ */
+size_t MemoryIndex::BoundedEditDistance(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, size_t maxDistance)
+{
+    const std::vector<uint32_t>& shorter = a.size() <= b.size() ? a : b;
+    const std::vector<uint32_t>& longer = a.size() <= b.size() ? b : a;
+    size_t n = shorter.size();
+    size_t m = longer.size();
+    size_t limit = maxDistance + 1;
+    if (m - n > maxDistance)
+        return limit;
+    if (maxDistance == 0)
+        return shorter == longer ? 0 : limit;
+
+    // 只计算 |i - j| <= maxDistance 的对角带，带外视为limit
+    std::vector<size_t> prev(m + 1, limit);
+    std::vector<size_t> cur(m + 1, limit);
+    for (size_t j = 0; j <= std::min(m, maxDistance); ++j)
+        prev[j] = j;
+
+    for (size_t i = 1; i <= n; ++i)
+    {
+        size_t lo = i > maxDistance ? i - maxDistance : 1;
+        size_t hi = std::min(m, i + maxDistance);
+        cur[lo - 1] = lo == 1 ? (i <= maxDistance ? i : limit) : limit;
+        size_t rowMin = cur[lo - 1];
+        uint32_t ch = shorter[i - 1];
+        for (size_t j = lo; j <= hi; ++j)
+        {
+            size_t value = prev[j - 1] + (ch == longer[j - 1] ? 0 : 1);
+            value = std::min(value, prev[j] + 1);
+            value = std::min(value, cur[j - 1] + 1);
+            cur[j] = std::min(value, limit);
+            rowMin = std::min(rowMin, cur[j]);
+        }
+        if (hi < m)
+            cur[hi + 1] = limit;
+        if (rowMin >= limit)
+            return limit;
+        std::swap(prev, cur);
+    }
+    return std::min(prev[m], limit);
+}
+
+/**
+ * @brief 计算各段的键
+ * @param chars 归一化后的码点
+ * @param namespaceHash 命名空间哈希
+ * @param keys 输出BAND_COUNT个键
+ */
+void MemoryIndex::ComputeBandKeys(const std::vector<uint32_t>& chars, uint32_t namespaceHash, uint64_t* keys)
+{
+    uint64_t minHashes[HASH_COUNT];
+    std::fill(minHashes, minHashes + HASH_COUNT, ~0ull);
+    for (size_t i = 0; i + 1 < chars.size(); ++i)
+    {
+        uint64_t shingle = Mix64((static_cast<uint64_t>(chars[i]) << 32) | chars[i + 1]);
+        for (size_t h = 0; h < HASH_COUNT; ++h)
+            minHashes[h] = std::min(minHashes[h], Mix64(shingle ^ ((h + 1) * HASH_SEED_STEP)));
+    }
+
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        uint64_t key = Mix64(namespaceHash ^ (static_cast<uint64_t>(band) << 32));
+        for (size_t row = 0; row < BAND_ROWS; ++row)
+            key = Mix64(key ^ minHashes[band * BAND_ROWS + row]);
+        keys[band] = key;
+    }
+}
+
+/**
+ * @brief 计算精确去重用的键
+ * @param chars 归一化后的码点
+ * @param namespaceHash 命名空间哈希
+ * @return 键
+ */
+uint64_t MemoryIndex::ComputeExactKey(const std::vector<uint32_t>& chars, uint32_t namespaceHash)
+{
+    uint64_t key = Mix64(namespaceHash ^ 0x6A09E667F3BCC908ull);
+    for (uint32_t cp : chars)
+        key = Mix64(key ^ cp);
+    return key;
+}
+
+/**
+ * @brief 加入一条记录
+ * @param cacheNamespace 命名空间
+ * @param source 原文（UTF-8）
+ * @param result 译文（UTF-8）
+ * @return 加入返回true
+ */
+bool MemoryIndex::Add(const std::string& cacheNamespace, const std::string& source, const std::string& result)
+{
+    std::vector<uint32_t> chars;
+    Normalize(source, chars);
+    if (chars.size() < MIN_CHARS || chars.size() > MAX_CHARS || result.empty())
+        return false;
+
+    uint32_t namespaceHash = HashNamespace(cacheNamespace);
+    uint64_t keys[BAND_COUNT];
+    ComputeBandKeys(chars, namespaceHash, keys);
+
+    if (m_entries.size() >= m_capacity)
+        DropOldest();
+
+    // 归一化后相同的旧记录只保留最新的译文
+    uint64_t exactKey = ComputeExactKey(chars, namespaceHash);
+    auto it = m_exact.find(exactKey);
+    if (it != m_exact.end())
+    {
+        m_entries[it->second].live = false;
+        --m_liveCount;
+    }
+    if (m_entries.size() >= m_bucketMask + 1)
+        RebuildBuckets((m_bucketMask + 1) * 2);
+
+    uint32_t id = static_cast<uint32_t>(m_entries.size());
+    Entry entry;
+    entry.textOffset = m_text.length();
+    entry.exactKey = exactKey;
+    entry.sourceLength = static_cast<uint32_t>(source.length());
+    entry.resultLength = static_cast<uint32_t>(result.length());
+    entry.namespaceHash = namespaceHash;
+    entry.charCount = static_cast<uint32_t>(chars.size());
+    entry.live = true;
+    m_entries.push_back(entry);
+    m_text += source;
+    m_text += result;
+    m_exact[exactKey] = id;
+    ++m_liveCount;
+
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        uint32_t& head = m_heads[band * (m_bucketMask + 1) + (keys[band] & m_bucketMask)];
+        m_entryKeys.push_back(keys[band]);
+        m_next.push_back(head);
+        head = id;
+    }
+    return true;
+}
+
+/**
+ * @brief 查找最相似的记录
+ * @param cacheNamespace 命名空间
+ * @param source 原文（UTF-8）
+ * @param minSimilarity 最低相似度
+ * @param match 输出最相似的记录
+ * @return 找到返回true
+ */
+bool MemoryIndex::Lookup(const std::string& cacheNamespace, const std::string& source, double minSimilarity, MemoryMatch& match) const
+{
+    std::vector<uint32_t> chars;
+    Normalize(source, chars);
+    if (chars.size() < MIN_CHARS || chars.size() > MAX_CHARS)
+        return false;
+
+    uint32_t namespaceHash = HashNamespace(cacheNamespace);
+    uint64_t keys[BAND_COUNT];
+    ComputeBandKeys(chars, namespaceHash, keys);
+
+    uint32_t bestId = NONE;
+    double bestSimilarity = 0.0;
+    if (!FindBest(chars, namespaceHash, keys, minSimilarity, bestId, bestSimilarity))
+        return false;
+
+    const Entry& entry = m_entries[bestId];
+    match.similarity = bestSimilarity;
+    match.source.assign(m_text, static_cast<size_t>(entry.textOffset), entry.sourceLength);
+    match.result.assign(m_text, static_cast<size_t>(entry.textOffset) + entry.sourceLength, entry.resultLength);
+    return true;
+}
+
+/**
+ * @brief 查找最相似的记录
+ * @param chars 归一化后的码点
+ * @param namespaceHash 命名空间哈希
+ * @param keys 各段的键
+ * @param minSimilarity 最低相似度
+ * @param bestId 输出记录编号
+ * @param bestSimilarity 输出相似度
+ * @return 找到返回true
+ */
+bool MemoryIndex::FindBest(const std::vector<uint32_t>& chars, uint32_t namespaceHash, const uint64_t* keys,
+    double minSimilarity, uint32_t& bestId, double& bestSimilarity) const
+{
+    // 收集候选：同一记录命中的段数越多，相似的可能越大
+    std::vector<uint32_t> hits;
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        uint32_t id = m_heads[band * (m_bucketMask + 1) + (keys[band] & m_bucketMask)];
+        for (size_t walked = 0; id != NONE && walked < MAX_CHAIN_WALK; ++walked)
+        {
+            const Entry& entry = m_entries[id];
+            if (m_entryKeys[id * BAND_COUNT + band] == keys[band] && entry.live && entry.namespaceHash == namespaceHash)
+            {
+                // 长度差本身就是编辑距离的下界
+                size_t longer = std::max<size_t>(entry.charCount, chars.size());
+                size_t lengthGap = entry.charCount > chars.size() ? entry.charCount - chars.size() : chars.size() - entry.charCount;
+                if (lengthGap <= static_cast<size_t>((1.0 - minSimilarity) * longer + 1e-9))
+                    hits.push_back(id);
+            }
+            id = m_next[id * BAND_COUNT + band];
+        }
+    }
+    if (hits.empty())
+        return false;
+
+    std::sort(hits.begin(), hits.end());
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;     // （命中段数，记录编号）
+    for (size_t i = 0; i < hits.size();)
+    {
+        size_t j = i;
+        while (j < hits.size() && hits[j] == hits[i])
+            ++j;
+        candidates.emplace_back(static_cast<uint32_t>(j - i), hits[i]);
+        i = j;
+    }
+    // 命中段数多的优先，相同时较新的记录优先
+    std::sort(candidates.begin(), candidates.end(), [](const std::pair<uint32_t, uint32_t>& x, const std::pair<uint32_t, uint32_t>& y)
+    {
+        return x.first != y.first ? x.first > y.first : x.second > y.second;
+    });
+
+    bestId = NONE;
+    bestSimilarity = 0.0;
+    std::vector<uint32_t> other;
+    std::string source;
+    for (size_t i = 0; i < candidates.size() && i < MAX_VERIFY; ++i)
+    {
+        const Entry& entry = m_entries[candidates[i].second];
+        size_t longer = std::max<size_t>(entry.charCount, chars.size());
+
+        // 已有更好的结果时只接受更小的距离
+        double floor = std::max(minSimilarity, bestSimilarity);
+        size_t maxDistance = static_cast<size_t>((1.0 - floor) * longer + 1e-9);
+        source.assign(m_text, static_cast<size_t>(entry.textOffset), entry.sourceLength);
+        Normalize(source, other);
+        size_t distance = BoundedEditDistance(chars, other, maxDistance);
+        if (distance > maxDistance)
+            continue;
+
+        double similarity = 1.0 - static_cast<double>(distance) / longer;
+        if (bestId == NONE || similarity > bestSimilarity)
+        {
+            bestId = candidates[i].second;
+            bestSimilarity = similarity;
+            if (distance == 0)
+                break;
+        }
+    }
+    return bestId != NONE && bestSimilarity + 1e-9 >= minSimilarity;
+}
+
+/**
+ * @brief 按当前记录重建各段的桶
+ * @param bucketCount 每段的桶数（2的幂）
+ */
+void MemoryIndex::RebuildBuckets(size_t bucketCount)
+{
+    m_bucketMask = bucketCount - 1;
+    m_heads.assign(BAND_COUNT * bucketCount, NONE);
+    m_next.assign(m_entries.size() * BAND_COUNT, NONE);
+
+    // 按编号从小到大插入链表头部，最新的记录排在最前
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+    {
+        if (!m_entries[id].live)
+            continue;
+        for (size_t band = 0; band < BAND_COUNT; ++band)
+        {
+            uint32_t& head = m_heads[band * bucketCount + (m_entryKeys[id * BAND_COUNT + band] & m_bucketMask)];
+            m_next[id * BAND_COUNT + band] = head;
+            head = id;
+        }
+    }
+}
+
+/**
+ * @brief 丢弃较早的一半记录并压缩文本缓冲区
+ */
+void MemoryIndex::DropOldest()
+{
+    size_t keep = m_capacity / 2;
+    std::vector<Entry> entries;
+    std::vector<uint64_t> entryKeys;
+    std::string text;
+
+    // 从新到旧数出要保留的有效记录，再按原顺序搬移
+    size_t first = m_entries.size();
+    size_t kept = 0;
+    while (first > 0 && kept < keep)
+    {
+        --first;
+        if (m_entries[first].live)
+            ++kept;
+    }
+
+    entries.reserve(kept);
+    entryKeys.reserve(kept * BAND_COUNT);
+    for (size_t id = first; id < m_entries.size(); ++id)
+    {
+        Entry entry = m_entries[id];
+        if (!entry.live)
+            continue;
+        size_t length = static_cast<size_t>(entry.sourceLength) + entry.resultLength;
+        text.append(m_text, static_cast<size_t>(entry.textOffset), length);
+        entry.textOffset = text.length() - length;
+        entries.push_back(entry);
+        entryKeys.insert(entryKeys.end(), m_entryKeys.begin() + id * BAND_COUNT, m_entryKeys.begin() + (id + 1) * BAND_COUNT);
+    }
+
+    m_entries.swap(entries);
+    m_entryKeys.swap(entryKeys);
+    m_text.swap(text);
+    m_liveCount = m_entries.size();
+    m_exact.clear();
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+        m_exact[m_entries[id].exactKey] = id;
+    RebuildBuckets(m_bucketMask + 1);
+}
+
+/**
+ * @brief 设置容量
+ * @param capacity 最大记录数，0表示禁用
+ */
+void TranslationMemory::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (capacity == 0)
+        s_pIndex.reset();
+    else if (!s_pIndex || s_pIndex->GetCapacity() != capacity)
+        s_pIndex.reset(new MemoryIndex(capacity));
+}
+
+/**
+ * @brief 加入一条记录
+ * @param cacheNamespace 命名空间
+ * @param source 原文（UTF-8）
+ * @param result 译文（UTF-8）
+ */
+void TranslationMemory::Add(const std::string& cacheNamespace, const std::string& source, const std::string& result)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_pIndex)
+        s_pIndex->Add(cacheNamespace, source, result);
+}
+
+/**
+ * @brief 查找最相似的记录
+ * @param cacheNamespace 命名空间
+ * @param source 原文（UTF-8）
+ * @param minSimilarity 最低相似度
+ * @param match 输出最相似的记录
+ * @return 找到返回true
+ */
+bool TranslationMemory::Lookup(const std::string& cacheNamespace, const std::string& source, double minSimilarity, MemoryMatch& match)
+{
+    if (minSimilarity <= 0.0)
+        return false;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_pIndex && s_pIndex->Lookup(cacheNamespace, source, minSimilarity, match);
+}
+
+/**
+ * @brief 清空记忆
+ */
+void TranslationMemory::Clear()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_pIndex)
+        s_pIndex.reset(new MemoryIndex(s_pIndex->GetCapacity()));
+}
+
+/**
+ * @brief 获取记录数
+ * @return 记录数
+ */
+size_t TranslationMemory::GetSize()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_pIndex ? s_pIndex->GetSize() : 0;
+}
@@ -0,0 +1,78 @@
+﻿#include "TranslationProfile.h"
+#include "AppConfig.h"
+#include "RequestTemplate.h"
+#include "CodeLexer.h"
+#include "SentenceDelta.h"
+
+/**
+ * @brief 根据当前字段生成请求体模板（含代码和改动句子批量翻译使用的模板）
+ */
+void TranslationProfile::BuildRequestTemplate()
+{
+    requestTemplate = std::make_shared<const RequestTemplate>(*this);
+    codeRequestTemplate = std::make_shared<const RequestTemplate>(*this, CodeLexer::BATCH_SYSTEM_PROMPT);
+    deltaRequestTemplate = std::make_shared<const RequestTemplate>(*this, SentenceDelta::BATCH_SYSTEM_PROMPT);
+}
+
+/**
+ * @brief 由配置快照构建分发表
+ * @param config 配置快照
+ */
+HotkeyDispatchTable::HotkeyDispatchTable(std::shared_ptr<const AppConfig> config)
+    : m_pConfig(std::move(config))
+{
+}
+
+/**
+ * @brief 获取条目数量
+ * @return 配置档数量
+ */
+size_t HotkeyDispatchTable::GetCount() const
+{
+    return m_pConfig ? m_pConfig->profiles.size() : 0;
+}
+
+/**
+ * @brief 获取第index个条目的热键绑定
+ * @param index 条目索引
+ * @return 热键绑定
+ */
+const HotkeyBinding& HotkeyDispatchTable::GetBinding(size_t index) const
+{
+    return m_pConfig->profiles[index]->hotkey;
+}
+
+/**
+ * @brief 按热键ID查找配置档
+ * @param hotkeyId WM_HOTKEY消息中的热键ID
+ * @return 对应的配置档，不属于本表时返回nullptr
+ */
+std::shared_ptr<const TranslationProfile> HotkeyDispatchTable::Lookup(int hotkeyId) const
+{
+    if (hotkeyId < HOTKEY_ID_BASE)
+        return nullptr;
+
+    size_t index = static_cast<size_t>(hotkeyId - HOTKEY_ID_BASE);
+    if (index >= GetCount())
+        return nullptr;
+
+    return m_pConfig->profiles[index];
+}
+
+/**
+ * @brief 判断两张表的热键ID与绑定是否完全一致
+ * @param other 另一张分发表
+ * @return 一致返回true
+ */
+bool HotkeyDispatchTable::HasSameBindings(const HotkeyDispatchTable& other) const
+{
+    if (GetCount() != other.GetCount())
+        return false;
+
+    for (size_t i = 0; i < GetCount(); i++)
+    {
+        if (GetBinding(i) != other.GetBinding(i))
+            return false;
+    }
+    return true;
+}
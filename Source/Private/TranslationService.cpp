@@ -1,70 +1,77 @@
 ﻿#include "TranslationService.h"
-#include <winhttp.h>
+#include "AppConfig.h"
+#include "RequestTemplate.h"
+#include "TextEncoding.h"
+#include "RequestArena.h"
+#include "WinHttpTransport.h"
+#include "HttpRecording.h"
+#include "Instrumentation.h"
+#include "RateLimiter.h"
+#include "CodeLexer.h"
+#include "TranslationMemory.h"
+#include "SentenceDelta.h"
 #include <string>
-#include <vector>
 #ifdef _DEBUG
 #include <crtdbg.h>
 #endif
 
-#pragma comment(lib, "winhttp.lib")
-
-// RAII类用于自动管理WinHTTP句柄
-class WinHttpHandle
+// 由配置预构建的请求设置，配置热重载时整体替换
+struct TranslationService::RequestSettings
 {
-public:
-    WinHttpHandle(HINTERNET handle = nullptr) : m_handle(handle) {}
-    ~WinHttpHandle() { if (m_handle) WinHttpCloseHandle(m_handle); }
-    
-    // 禁止拷贝
-    WinHttpHandle(const WinHttpHandle&) = delete;
-    WinHttpHandle& operator=(const WinHttpHandle&) = delete;
-    
-    // 支持移动
-    WinHttpHandle(WinHttpHandle&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
-    WinHttpHandle& operator=(WinHttpHandle&& other) noexcept
+    std::wstring host;              // API主机名
+    INTERNET_PORT port;             // 端口
+    std::wstring path;              // 请求路径
+    std::wstring headers;           // 完整请求头（含Authorization）
+    bool hasApiKey;                 // 是否已配置API密钥
+    int resolveTimeoutMs;           // 各阶段超时（毫秒）
+    int connectTimeoutMs;
+    int sendTimeoutMs;
+    int receiveTimeoutMs;
+    GlossaryMode glossaryMode;      // 术语表使用方式
+    double memoryHint;              // 附带参考译文的最低相似度，0表示不附带
+    bool adaptiveTimeouts;          // 是否按耗时分布收紧超时
+
+    explicit RequestSettings(const AppConfig& config)
+        : host(TextEncoding::Utf8ToWide(config.host))
+        , port(config.port)
+        , path(TextEncoding::Utf8ToWide(config.path))
+        , hasApiKey(!config.apiKey.empty())
+        , resolveTimeoutMs(config.resolveTimeoutMs)
+        , connectTimeoutMs(config.connectTimeoutMs)
+        , sendTimeoutMs(config.sendTimeoutMs)
+        , receiveTimeoutMs(config.receiveTimeoutMs)
+        , glossaryMode(config.glossaryMode)
+        , memoryHint(config.memoryHint)
+        , adaptiveTimeouts(config.adaptiveTimeouts)
     {
-        if (this != &other)
-        {
-            if (m_handle) WinHttpCloseHandle(m_handle);
-            m_handle = other.m_handle;
-            other.m_handle = nullptr;
-        }
-        return *this;
+        headers = L"Content-Type: application/json\r\n"
+                  L"Authorization: Bearer " + TextEncoding::Utf8ToWide(config.apiKey) + L"\r\n"
+                  L"User-Agent: YunsioTranslation/1.0\r\n";
     }
-    
-    // 重置句柄
-    void reset(HINTERNET handle = nullptr)
+
+    // 填写除方法、请求头和请求体之外的请求描述
+    void FillRequest(HttpRequest& request) const
     {
-        if (m_handle) WinHttpCloseHandle(m_handle);
-        m_handle = handle;
+        request.host = host.c_str();
+        request.port = port;
+        request.path = path.c_str();
+        request.resolveTimeoutMs = resolveTimeoutMs;
+        request.connectTimeoutMs = connectTimeoutMs;
+        request.sendTimeoutMs = sendTimeoutMs;
+        request.receiveTimeoutMs = receiveTimeoutMs;
+        request.idleTimeoutMs = receiveTimeoutMs;
     }
-    
-    // 获取句柄
-    HINTERNET get() const { return m_handle; }
-    
-    // 检查是否有效
-    bool valid() const { return m_handle != nullptr; }
-    
-    // 隐式转换为HINTERNET
-    operator HINTERNET() const { return m_handle; }
-    
-private:
-    HINTERNET m_handle;
 };
 
-// API配置常量定义
-
-///////////////////////////////////////////////填写你的阿里百炼APIKey/////////////////////////////////////////////////////////////////
-/**
- * APIKey获取地址，阿里百炼：https://bailian.console.aliyun.com
- */
-
-const wchar_t* TranslationService::API_KEY = L"这里填写你的阿里百炼APIKey";
-const char* TranslationService::SYSTEM_PROMPT = "The Following Dialogue Enters Translation Mode, Answering Questions Is Prohibited, Only The Translation Is Returned. If I Send Chinese, You Translate It Into English (Please Convert The English Translation Result To PascalCase Format, For Example: GetObject, Remove All Spaces And Special Symbols). If I Send English, You Translate It Into Chinese. If The Word Is Misspelled Or You Don't Recognize It, You Need To Judge The Probable Meaning And Translate It. Only The Translation Result Is Returned, And No Explanation Or Additional Content Is Allowed.";
-
 // 静态成员变量定义
-HINTERNET TranslationService::s_hSession = nullptr;
-bool TranslationService::s_bInitialized = false;
+std::unique_ptr<HttpTransport> TranslationService::s_pTransport;
+RequestGate TranslationService::s_gate;
+std::atomic<bool> TranslationService::s_bOnline{ true };
+std::shared_ptr<const TranslationService::RequestSettings> TranslationService::s_pSettings;
+AdaptiveTimeouts TranslationService::s_timeouts;
+std::string TranslationService::s_recordPath;
+std::string TranslationService::s_replayPath;
+double TranslationService::s_replayTimeScale = 1.0;
 
 /**
  * @brief 初始化翻译服务
@@ -72,243 +79,414 @@ bool TranslationService::s_bInitialized = false;
  */
 bool TranslationService::Initialize()
 {
-    if (s_bInitialized)
+    if (s_gate.IsOpen())
         return true;
     
-    // 创建HTTP会话
-    s_hSession = WinHttpOpen(
-        L"YunsioTranslation/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-        WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS,
-        0
-    );
-    
-    if (s_hSession == nullptr)
-        return false;
+    if (!s_replayPath.empty())
+    {
+        // 回放：请求由录制文件应答，不创建HTTP会话
+        std::unique_ptr<ReplayTransport> replay(new ReplayTransport());
+        if (!replay->Load(s_replayPath, s_replayTimeScale))
+            return false;
+        s_pTransport = std::move(replay);
+    }
+    else
+    {
+        // 创建HTTP会话（启用响应自动解压）
+        std::unique_ptr<WinHttpTransport> transport(new WinHttpTransport());
+        if (!transport->Open(L"YunsioTranslation/1.0"))
+            return false;
+        s_pTransport = std::move(transport);
+        
+        // 录制：请求照常发送，请求和响应同时写入录制文件
+        if (!s_recordPath.empty())
+        {
+            std::unique_ptr<RecordingTransport> recording(new RecordingTransport(std::move(s_pTransport)));
+            if (!recording->Open(s_recordPath))
+                return false;
+            s_pTransport = std::move(recording);
+        }
+    }
     
-    // 设置超时时间（毫秒）
-    WinHttpSetTimeouts(s_hSession, 10000, 10000, 30000, 30000);
+    // 由当前配置构建请求设置（超时在每个请求上单独设置，以便热重载生效）
+    ApplyConfig();
     
-    s_bInitialized = true;
+    // 打开闸门后其他线程才能进入，此前写入的传输层和设置对它们可见
+    s_gate.Open();
     return true;
 }
 
+/**
+ * @brief 设置传输层的录制或回放
+ * @param recordPath 录制文件路径，为空时不录制
+ * @param replayPath 回放文件路径，不为空时不访问网络
+ * @param replayTimeScale 回放耗时系数
+ */
+void TranslationService::SetCapture(const std::string& recordPath, const std::string& replayPath, double replayTimeScale)
+{
+    s_recordPath = recordPath;
+    s_replayPath = replayPath;
+    s_replayTimeScale = replayTimeScale;
+}
+
 /**
  * @brief 清理翻译服务资源
  */
 void TranslationService::Cleanup()
 {
-    if (!s_bInitialized)
+    if (!s_gate.IsOpen())
         return;
     
-    if (s_hSession != nullptr)
+    // 拒绝新的调用并等待进行中的请求结束，之后才能关闭会话句柄
+    s_gate.CloseAndDrain();
+    s_pTransport.reset();
+    std::atomic_store(&s_pSettings, std::shared_ptr<const RequestSettings>());
+}
+
+/**
+ * @brief 预连接API服务器，连接保留在会话连接池中供后续请求复用
+ * @param cancel 取消信号，可为nullptr
+ * @return 完成返回true，被取消返回false
+ */
+bool TranslationService::Preconnect(const std::atomic<bool>* cancel)
+{
+    RequestGate::Pass pass = s_gate.TryEnter();
+    if (!pass)
+        return true;
+    
+    std::shared_ptr<const RequestSettings> settings = std::atomic_load(&s_pSettings);
+    if (!settings || !settings->hasApiKey)
+        return true;
+    
+    // HEAD请求不产生计费，只为建立连接；响应状态码无关紧要，读完响应后连接归还连接池
+    HttpRequest request;
+    settings->FillRequest(request);
+    request.method = L"HEAD";
+    request.cancel = cancel;
+    
+    HttpResult result;
+    s_pTransport->Send(request, [](const char*, size_t) {}, result);
+    UpdateConnectivity(result);
+    return result.failure != HttpFailure::Cancelled;
+}
+
+/**
+ * @brief 按术语表处理待翻译文本
+ *
+ * 术语只进入用户消息，系统提示词所在的请求前缀不变，服务端前缀缓存仍可命中
+ * @param settings 请求设置
+ * @param text 待发送的UTF-8文本
+ * @param arena 当前线程的缓冲区
+ * @return 实际发送的文本（未命中术语时即text）
+ */
+const std::string& TranslationService::ApplyGlossary(const RequestSettings& settings, const std::string& text, RequestArena& arena)
+{
+    if (settings.glossaryMode == GlossaryMode::Off)
+        return text;
+    
+    std::shared_ptr<const GlossaryMatcher> glossary = Glossary::Current();
+    if (!glossary || glossary->FindMatches(text, arena.glossaryMatches) == 0)
+        return text;
+    
+    Instrumentation::AddCounter("glossary.matched", arena.glossaryMatches.size());
+    if (settings.glossaryMode == GlossaryMode::Substitute)
+    {
+        glossary->Substitute(text, arena.glossaryMatches, arena.requestText);
+    }
+    else
     {
-        WinHttpCloseHandle(s_hSession);
-        s_hSession = nullptr;
+        arena.requestText = text;
+        glossary->AppendHints(arena.glossaryMatches, arena.requestText);
     }
+    return arena.requestText;
+}
+
+/**
+ * @brief 在待发送文本后附上翻译记忆中相似原文的已有译文
+ *
+ * 与术语表提示相同，参考译文只进入用户消息。原文与记录完全相同时由缓存或Answer阈值处理，
+ * 走到这里的都是有差异的原文，因此只作为用词参考，不要求照搬
+ * @param settings 请求设置
+ * @param profile 翻译配置档
+ * @param text 待发送的UTF-8文本（ApplyGlossary的结果）
+ * @param arena 当前线程的缓冲区（utf8Text为原文）
+ * @return 实际发送的文本（没有足够相似的记录时即text）
+ */
+const std::string& TranslationService::ApplyMemory(const RequestSettings& settings, const TranslationProfile& profile,
+    const std::string& text, RequestArena& arena)
+{
+    if (!TranslationMemory::Lookup(profile.cacheNamespace, arena.utf8Text, settings.memoryHint, arena.memoryMatch))
+        return text;
     
-    s_bInitialized = false;
+    Instrumentation::AddCounter("memory.hinted");
+    if (&text != &arena.requestText)
+        arena.requestText = text;
+    arena.requestText += "\n\n参考译文（相似原文的已有译文，沿用其用词，不要输出本段）：";
+    arena.requestText += arena.memoryMatch.source;
+    arena.requestText += " => ";
+    arena.requestText += arena.memoryMatch.result;
+    return arena.requestText;
+}
+
+/**
+ * @brief 根据当前配置重建请求设置（请求体模板随配置档预构建，不在此处）
+ */
+void TranslationService::ApplyConfig()
+{
+    std::shared_ptr<const AppConfig> config = ConfigStore::Current();
+    std::shared_ptr<RequestSettings> settings = std::make_shared<RequestSettings>(*config);
+    
+    // 换了服务地址后旧的耗时分布不再适用
+    std::shared_ptr<const RequestSettings> previous = std::atomic_load(&s_pSettings);
+    if (previous && (previous->host != settings->host || previous->port != settings->port || previous->path != settings->path))
+        s_timeouts.Reset();
+    
+    // 回放不需要真实的密钥（请求头不参与匹配）
+    if (!s_replayPath.empty())
+        settings->hasApiKey = true;
+    std::atomic_store(&s_pSettings, std::shared_ptr<const RequestSettings>(std::move(settings)));
 }
 
 /**
  * @brief 异步翻译文本
  * @param text 待翻译的文本
+ * @param profile 翻译配置档（提供预构建的请求体模板）
+ * @param callback 翻译完成后的回调函数（被取消时不调用）
+ * @param cancel 取消信号，可为nullptr
+ * @return 请求发送成功返回true，失败或被取消返回false
+ */
+bool TranslationService::TranslateAsync(const std::wstring& text, const TranslationProfile& profile, TranslationCallback callback,
+    const std::atomic<bool>* cancel)
+{
+    return Translate(text, profile, false, nullptr, std::move(callback), cancel, nullptr);
+}
+
+/**
+ * @brief 异步翻译文本，流式返回
+ * @param text 待翻译的文本
+ * @param profile 翻译配置档
+ * @param progress 进度回调
+ * @param callback 翻译完成后的回调函数（被取消时不调用）
+ * @param cancel 取消信号，可为nullptr
+ * @return 请求发送成功返回true，失败或被取消返回false
+ */
+bool TranslationService::TranslateStreamAsync(const std::wstring& text, const TranslationProfile& profile, ProgressCallback progress,
+    TranslationCallback callback, const std::atomic<bool>* cancel)
+{
+    return Translate(text, profile, false, nullptr, std::move(callback), cancel, progress);
+}
+
+/**
+ * @brief 异步翻译选中代码中的注释和字符串
+ * @param text 选中的代码
+ * @param profile 翻译配置档
+ * @param callback 翻译完成后的回调函数（被取消时不调用）
+ * @param cancel 取消信号，可为nullptr
+ * @return 请求发送成功返回true，失败或被取消返回false
+ */
+bool TranslationService::TranslateCodeAsync(const std::wstring& text, const TranslationProfile& profile, TranslationCallback callback,
+    const std::atomic<bool>* cancel)
+{
+    return Translate(text, profile, true, nullptr, std::move(callback), cancel, nullptr);
+}
+
+/**
+ * @brief 异步翻译编辑过的段落中改动的句子
+ * @param delta 增量计划
+ * @param profile 翻译配置档
+ * @param callback 翻译完成后的回调函数（被取消时不调用）
+ * @param cancel 取消信号，可为nullptr
+ * @return 请求发送成功返回true，失败或被取消返回false
+ */
+bool TranslationService::TranslateDeltaAsync(const SentenceDelta& delta, const TranslationProfile& profile, TranslationCallback callback,
+    const std::atomic<bool>* cancel)
+{
+    return Translate(std::wstring(), profile, false, &delta, std::move(callback), cancel, nullptr);
+}
+
+/**
+ * @brief 执行一次翻译请求
+ * @param text 待翻译的文本
+ * @param profile 翻译配置档
+ * @param codeOnly 是否只翻译代码中的注释和字符串
+ * @param delta 增量计划，为nullptr时翻译整段text
  * @param callback 翻译完成后的回调函数
- * @return 请求发送成功返回true，失败返回false
+ * @param cancel 取消信号，可为nullptr
+ * @param progress 进度回调，可为空
+ * @return 请求发送成功返回true，失败或被取消返回false
  */
-bool TranslationService::TranslateAsync(const std::wstring& text, TranslationCallback callback)
+bool TranslationService::Translate(const std::wstring& text, const TranslationProfile& profile, bool codeOnly, const SentenceDelta* delta,
+    TranslationCallback callback, const std::atomic<bool>* cancel, const ProgressCallback& progress)
 {
-    if (!s_bInitialized || !callback || text.empty())
+    const RequestTemplate* requestTemplate = delta != nullptr ? profile.deltaRequestTemplate.get() :
+        codeOnly ? profile.codeRequestTemplate.get() : profile.requestTemplate.get();
+    if (!callback || (text.empty() && delta == nullptr) || !requestTemplate)
+        return false;
+    
+    // 持有通行证直到回调返回，期间Cleanup不会释放传输层
+    RequestGate::Pass pass = s_gate.TryEnter();
+    if (!pass)
         return false;
     
+    // 本次请求的全部临时缓冲区，请求结束时清空并保留容量供下次复用
+    RequestArena& arena = RequestArena::ForCurrentThread();
+    
     // 使用RAII确保资源清理
     struct ResourceCleaner
     {
+        RequestArena& arena;
         ~ResourceCleaner()
         {
-            // 强制内存清理
+            arena.Reset();
             #ifdef _DEBUG
             _CrtCheckMemory();
             #endif
         }
-    } cleaner;
+    } cleaner{ arena };
+    
+    // 获取当前请求设置快照，整个请求期间保持一致
+    std::shared_ptr<const RequestSettings> settings = std::atomic_load(&s_pSettings);
+    if (!settings)
+        return false;
+    
+    if (!settings->hasApiKey)
+    {
+        callback(false, L"未配置API密钥");
+        return false;
+    }
     
     try
     {
-        // 连接到API服务器
-        WinHttpHandle hConnect(WinHttpConnect(
-            s_hSession,
-            L"dashscope.aliyuncs.com",
-            INTERNET_DEFAULT_HTTPS_PORT,
-            0
-        ));
-        
-        if (!hConnect.valid())
+        // 将待翻译文本转换为UTF-8，由配置档预构建的模板生成JSON请求体
+        if (delta != nullptr)
+            arena.utf8Text = delta->GetSource();
+        else
+            TextEncoding::WideToUtf8(text, arena.utf8Text);
+        const std::string* payload = &arena.utf8Text;
+        if (delta != nullptr)
         {
-            callback(false, L"连接服务器失败");
-            return false;
+            // 只发送改动的句子，每句一行
+            delta->BuildBatch(arena.deltaBatch);
+            payload = &arena.deltaBatch;
+            Instrumentation::AddCounter("delta.selected_bytes", static_cast<int64_t>(arena.utf8Text.length()));
+            Instrumentation::AddCounter("delta.sent_bytes", static_cast<int64_t>(arena.deltaBatch.length()));
         }
-        
-        // 创建请求
-        WinHttpHandle hRequest(WinHttpOpenRequest(
-            hConnect,
-            L"POST",
-            L"/compatible-mode/v1/chat/completions",
-            nullptr,
-            WINHTTP_NO_REFERER,
-            WINHTTP_DEFAULT_ACCEPT_TYPES,
-            WINHTTP_FLAG_SECURE
-        ));
-        
-        if (!hRequest.valid())
+        else if (codeOnly)
         {
-            callback(false, L"创建请求失败");
-            return false;
-        }
-    
-    // 设置请求头
-    std::wstring authHeader = L"Authorization: Bearer ";
-    authHeader += API_KEY;
-    
-    WinHttpAddRequestHeaders(
-        hRequest,
-        L"Content-Type: application/json",
-        -1,
-        WINHTTP_ADDREQ_FLAG_ADD
-    );
-    
-    WinHttpAddRequestHeaders(
-        hRequest,
-        authHeader.c_str(),
-        -1,
-        WINHTTP_ADDREQ_FLAG_ADD
-    );
-    
-    WinHttpAddRequestHeaders(
-        hRequest,
-        L"User-Agent: YunsioTranslation/1.0",
-        -1,
-        WINHTTP_ADDREQ_FLAG_ADD
-    );
-
-        // 将待翻译文本转换为UTF-8并进行JSON转义
-        std::string escapedText;
-        int utf8Size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (utf8Size > 0)
-        {
-            std::string utf8Text(utf8Size - 1, '\0');
-            WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, &utf8Text[0], utf8Size, nullptr, nullptr);
-            
-            // 转义JSON特殊字符
-            escapedText.reserve(utf8Text.length() * 2); // 预分配内存
-            for (char c : utf8Text)
+            // 只发送注释和字符串，每个片段一行
+            if (!CodeLexer::Analyze(arena.utf8Text, arena.codeSegments))
             {
-                switch (c)
-                {
-                    case '"': escapedText += "\\\""; break;
-                    case '\\': escapedText += "\\\\"; break;
-                    case '\n': escapedText += "\\n"; break;
-                    case '\r': escapedText += "\\r"; break;
-                    case '\t': escapedText += "\\t"; break;
-                    default: escapedText += c; break;
-                }
+                callback(false, L"未找到可翻译的注释或字符串");
+                return false;
             }
-            
-            // 清理utf8Text，释放内存
-            utf8Text.clear();
-            utf8Text.shrink_to_fit();
+            CodeLexer::BuildBatch(arena.utf8Text, arena.codeSegments, arena.codeBatch);
+            payload = &arena.codeBatch;
+            Instrumentation::AddCounter("code.selected_bytes", static_cast<int64_t>(arena.utf8Text.length()));
+            Instrumentation::AddCounter("code.sent_bytes", static_cast<int64_t>(arena.codeBatch.length()));
         }
+        const std::string& requestText = ApplyGlossary(*settings, *payload, arena);
+        bool plainText = !codeOnly && delta == nullptr;
+        bool stream = plainText && progress;
+        requestTemplate->BuildBody(plainText ? ApplyMemory(*settings, profile, requestText, arena) : requestText, arena.body, stream);
         
-        // 构建JSON请求体
-        std::string jsonData;
-        jsonData.reserve(1024 + strlen(SYSTEM_PROMPT) + escapedText.length()); // 预分配内存
-        jsonData = "{"
-            "\"model\":\"qwen-plus\","
-            "\"temperature\":0.3,"
-            "\"max_tokens\":1000,"
-            "\"messages\":["
-                "{"
-                    "\"role\":\"system\","
-                    "\"content\":\"" + std::string(SYSTEM_PROMPT) + "\""
-                "},"
-                "{"
-                    "\"role\":\"user\","
-                    "\"content\":\"" + escapedText + "\""
-                "}"
-            "]"
-        "}";
+        HttpRequest request;
+        settings->FillRequest(request);
+        request.method = L"POST";
+        request.headers = settings->headers;
+        request.body = arena.body;
+        request.cancel = cancel;
+        size_t expectedTokens = AdaptiveTimeouts::EstimateOutputTokens(requestText.length(), profile.maxTokens);
+        bool tightened = settings->adaptiveTimeouts && ApplyAdaptiveTimeouts(*settings, expectedTokens, request);
         
-        // 清理escapedText，释放内存
-        escapedText.clear();
-        escapedText.shrink_to_fit();
+        // 响应数据（已解压）每到达一块就地送入增量解析器，解析与网络读取交替进行；流式请求每块报告一次进度
+        ChatResponseParser& parser = arena.parser;
+        auto feed = [&parser, &progress, stream](const char* data, size_t length)
+        {
+            parser.Feed(data, length);
+            if (stream)
+                progress(parser.GetContent());
+        };
+        HttpResult result;
         
-        // 发送请求
-        BOOL result = WinHttpSendRequest(
-            hRequest,
-            WINHTTP_NO_ADDITIONAL_HEADERS,
-            0,
-            (LPVOID)jsonData.c_str(),
-            jsonData.length(),
-            jsonData.length(),
-            0
-        );
+        // 每次发往服务端的请求（含超时后的重试）各占一个请求令牌，配额不足时在本线程等待，等待中被取消按取消处理
+        auto send = [&]()
+        {
+            if (!RateLimiter::Acquire(cancel))
+            {
+                result.failure = HttpFailure::Cancelled;
+                return false;
+            }
+            return s_pTransport->Send(request, feed, result);
+        };
+        bool received = send();
         
-        if (!result)
+        // 收紧的超时到期：放弃这条可能已停滞的连接，按配置的超时在新连接上重试一次，不必等满配置的超时才失败
+        if (!received && result.timedOut && tightened)
         {
-            callback(false, L"发送请求失败");
-            return false;
+            Instrumentation::AddCounter("timeout.retried");
+            parser.Reset();
+            if (stream)
+                progress(parser.GetContent());  // 告知调用方译文从头开始
+            settings->FillRequest(request);
+            result = HttpResult();
+            received = send();
         }
-        
-        // 接收响应
-        result = WinHttpReceiveResponse(hRequest, nullptr);
-        if (!result)
+        UpdateConnectivity(result);
+        if (!received)
         {
-            callback(false, L"接收响应失败");
+            // 被取消的请求由调用方决定是否重试，不报告失败
+            if (result.failure != HttpFailure::Cancelled)
+                callback(false, GetFailureMessage(result.failure));
             return false;
         }
+        RecordUsage(profile.name, result, parser.GetUsage());
         
-        // 清理jsonData，释放内存
-        jsonData.clear();
-        jsonData.shrink_to_fit();
-        
-        // 读取响应数据
-        std::string responseData;
-        responseData.reserve(4096); // 预分配内存
-        DWORD bytesAvailable = 0;
-        DWORD bytesRead = 0;
+        // 成功的请求计入耗时分布
+        if (parser.Finish() && result.statusCode < 400)
+            s_timeouts.Record(result.sendMs, result.responseMs, result.maxGapMs, expectedTokens);
         
-        do
+        if (parser.Finish() && codeOnly)
         {
-            if (!WinHttpQueryDataAvailable(hRequest, &bytesAvailable))
-                break;
-            
-            if (bytesAvailable > 0)
+            // 译文按编号写回原代码，缺少编号时整体失败，不写回错位的译文
+            if (!CodeLexer::Splice(arena.utf8Text, arena.codeSegments, parser.GetContent(), arena.codeOutput))
             {
-                size_t oldSize = responseData.size();
-                responseData.resize(oldSize + bytesAvailable);
-                if (!WinHttpReadData(hRequest, &responseData[oldSize], bytesAvailable, &bytesRead))
-                    break;
-                responseData.resize(oldSize + bytesRead); // 调整到实际读取的大小
+                callback(false, L"译文与注释和字符串数量不一致");
+                return true;
             }
-        } while (bytesAvailable > 0);
-        
-        // WinHttpHandle会自动释放句柄
-        
-        // 解析JSON响应
-        std::wstring translatedText;
-        if (ParseJsonResponse(responseData, translatedText))
+            TextEncoding::Utf8ToWide(arena.codeOutput.data(), arena.codeOutput.length(), arena.result);
+            callback(true, arena.result);
+        }
+        else if (parser.Finish() && delta != nullptr)
+        {
+            // 改动句子的译文按编号与沿用的译文拼回整段（与整段翻译相同，后处理在输出前进行）
+            if (!delta->Assemble(parser.GetContent(), arena.deltaOutput))
+            {
+                callback(false, L"译文与改动的句子数量不一致");
+                return true;
+            }
+            TextEncoding::Utf8ToWide(arena.deltaOutput.data(), arena.deltaOutput.length(), arena.result);
+            callback(true, arena.result);
+        }
+        else if (parser.Finish())
+        {
+            // 回调收到模型的原始译文：缓存和历史按命名空间共享，配置档各自的后处理在输出前进行
+            const std::string& content = parser.GetContent();
+            if (content.find_first_not_of(" \t\r\n") == std::string::npos)
+            {
+                callback(false, L"译文为空");
+                return true;
+            }
+            TextEncoding::Utf8ToWide(content.data(), content.length(), arena.result);
+            callback(true, arena.result);
+        }
+        else if (!parser.GetErrorMessage().empty())
         {
-            callback(true, translatedText);
+            callback(false, L"API错误：" + TextEncoding::Utf8ToWide(parser.GetErrorMessage()));
         }
         else
         {
             callback(false, L"解析响应失败");
         }
-    
-        // 显式清理大型字符串，释放内存
-        responseData.clear();
-        responseData.shrink_to_fit();
         
         return true;
     }
@@ -321,83 +499,144 @@ bool TranslationService::TranslateAsync(const std::wstring& text, TranslationCal
 }
 
 /**
- * @brief 解析JSON响应获取翻译结果
- * @param jsonResponse JSON响应字符串
- * @param result 输出翻译结果
- * @return 解析成功返回true，失败返回false
+ * @brief 获取传输失败阶段对应的提示信息
+ * @param failure 失败阶段
+ * @return 提示信息
  */
-bool TranslationService::ParseJsonResponse(const std::string& jsonResponse, std::wstring& result)
+const wchar_t* TranslationService::GetFailureMessage(HttpFailure failure)
 {
-    // 简单的JSON解析，查找choices[0].message.content
-    size_t choicesPos = jsonResponse.find("\"choices\"");
-    if (choicesPos == std::string::npos)
-        return false;
-    
-    size_t messagePos = jsonResponse.find("\"message\"", choicesPos);
-    if (messagePos == std::string::npos)
-        return false;
-    
-    size_t contentPos = jsonResponse.find("\"content\"", messagePos);
-    if (contentPos == std::string::npos)
-        return false;
-    
-    size_t valueStart = jsonResponse.find(':', contentPos);
-    if (valueStart == std::string::npos)
-        return false;
-    
-    valueStart = jsonResponse.find('"', valueStart);
-    if (valueStart == std::string::npos)
-        return false;
-    
-    valueStart++; // 跳过开始的引号
+    switch (failure)
+    {
+        case HttpFailure::Connect: return L"连接服务器失败";
+        case HttpFailure::OpenRequest: return L"创建请求失败";
+        case HttpFailure::Send: return L"发送请求失败";
+        case HttpFailure::Receive: return L"接收响应失败";
+        default: return L"翻译过程中发生异常";
+    }
+}
+
+/**
+ * @brief 最近一次请求是否连通了API服务器
+ * @return 在线返回true
+ */
+bool TranslationService::IsOnline()
+{
+    return s_bOnline;
+}
+
+/**
+ * @brief 根据传输结果更新连通状态
+ * @param result 传输结果
+ */
+void TranslationService::UpdateConnectivity(const HttpResult& result)
+{
+    // 创建请求失败和被取消不说明网络状况，不改变连通状态
+    bool online;
+    switch (result.failure)
+    {
+        case HttpFailure::None: online = true; break;
+        case HttpFailure::Connect:
+        case HttpFailure::Send:
+        case HttpFailure::Receive: online = false; break;
+        default: return;
+    }
     
-    size_t valueEnd = valueStart;
-    while (valueEnd < jsonResponse.length())
+    if (s_bOnline.exchange(online) != online)
     {
-        if (jsonResponse[valueEnd] == '"' && (valueEnd == 0 || jsonResponse[valueEnd - 1] != '\\'))
-            break;
-        valueEnd++;
+        Instrumentation::AddCounter(online ? "http.reconnected" : "http.disconnected");
+        Instrumentation::SetGauge("http.online", online ? 1.0 : 0.0);
     }
+}
+
+/**
+ * @brief 按最近的耗时分布收紧请求的各阶段超时
+ * @param settings 请求设置
+ * @param expectedTokens 预计输出token数
+ * @param request 请求描述
+ * @return 至少一个阶段的超时比配置的短返回true
+ */
+bool TranslationService::ApplyAdaptiveTimeouts(const RequestSettings& settings, size_t expectedTokens, HttpRequest& request)
+{
+    PhaseTimeouts ceilings;
+    ceilings.connectMs = settings.connectTimeoutMs;
+    ceilings.sendMs = settings.sendTimeoutMs;
+    ceilings.responseMs = settings.receiveTimeoutMs;
+    ceilings.idleMs = settings.receiveTimeoutMs;
+    PhaseTimeouts timeouts = s_timeouts.Compute(ceilings, expectedTokens);
     
-    if (valueEnd >= jsonResponse.length())
-        return false;
+    request.connectTimeoutMs = timeouts.connectMs;
+    request.sendTimeoutMs = timeouts.sendMs;
+    request.receiveTimeoutMs = timeouts.responseMs;
+    request.idleTimeoutMs = timeouts.idleMs;
+    Instrumentation::SetGauge("timeout.response_ms", timeouts.responseMs);
+    Instrumentation::SetGauge("timeout.idle_ms", timeouts.idleMs);
+    return timeouts.connectMs != ceilings.connectMs || timeouts.sendMs != ceilings.sendMs ||
+        timeouts.responseMs != ceilings.responseMs || timeouts.idleMs != ceilings.idleMs;
+}
+
+/**
+ * @brief 将一次请求的token和字节用量累加到配置档的计数器
+ * @param profileName 配置档名称
+ * @param result 传输结果
+ * @param usage 响应中的token用量
+ */
+void TranslationService::RecordUsage(const std::string& profileName, const HttpResult& result, const TokenUsage& usage)
+{
+    std::string prefix = "profile." + profileName + ".";
+    Instrumentation::AddCounter(prefix + "requests");
+    Instrumentation::AddCounter(prefix + "bytes_sent", static_cast<int64_t>(result.bytesSent));
+    Instrumentation::AddCounter(prefix + "bytes_received", static_cast<int64_t>(result.wireBytesReceived));
+    if (usage.reported)
+    {
+        Instrumentation::AddCounter(prefix + "prompt_tokens", usage.promptTokens);
+        Instrumentation::AddCounter(prefix + "completion_tokens", usage.completionTokens);
+        Instrumentation::AddCounter(prefix + "cached_tokens", usage.cachedTokens);
+        RateLimiter::RecordUsage(usage.promptTokens, usage.completionTokens);
+    }
     
-    std::string utf8Content = jsonResponse.substr(valueStart, valueEnd - valueStart);
+    // 服务端限流：暂停启动新请求，避免连续触发429
+    if (result.statusCode == 429)
+        RateLimiter::OnThrottled();
+}
+
+/**
+ * @brief 生成本次运行各配置档的用量报告
+ * @return 报告文本
+ */
+std::wstring TranslationService::FormatUsageReport()
+{
+    std::wstring report;
+    wchar_t line[256];
     
-    // 处理转义字符
-    std::string unescapedContent;
-    unescapedContent.reserve(utf8Content.length()); // 预分配内存
-    for (size_t i = 0; i < utf8Content.length(); i++)
+    DailyUsage daily = RateLimiter::GetDailyUsage();
+    if (daily.requests > 0)
     {
-        if (utf8Content[i] == '\\' && i + 1 < utf8Content.length())
-        {
-            switch (utf8Content[i + 1])
-            {
-                case '"': unescapedContent += '"'; i++; break;
-                case '\\': unescapedContent += '\\'; i++; break;
-                case 'n': unescapedContent += '\n'; i++; break;
-                case 'r': unescapedContent += '\r'; i++; break;
-                case 't': unescapedContent += '\t'; i++; break;
-                default: unescapedContent += utf8Content[i]; break;
-            }
-        }
-        else
-        {
-            unescapedContent += utf8Content[i];
-        }
+        swprintf_s(line, L"今日累计：%lld次 输入%lld 输出%lld tokens\n",
+            daily.requests, daily.promptTokens, daily.completionTokens);
+        report += line;
     }
     
-    // 转换UTF-8到宽字符
-    if (unescapedContent.empty())
-        return false;
-        
-    int wideSize = MultiByteToWideChar(CP_UTF8, 0, unescapedContent.c_str(), static_cast<int>(unescapedContent.length()), nullptr, 0);
-    if (wideSize > 0)
+    for (const auto& profile : ConfigStore::Current()->profiles)
     {
-        result.resize(wideSize);
-        MultiByteToWideChar(CP_UTF8, 0, unescapedContent.c_str(), static_cast<int>(unescapedContent.length()), &result[0], wideSize);
-        return true;
+        std::string prefix = "profile." + profile->name + ".";
+        int64_t requests = Instrumentation::GetCounter(prefix + "requests");
+        if (requests == 0)
+            continue;
+        
+        swprintf_s(line, L"%s：%lld次 输入%lld(缓存%lld) 输出%lld tokens ↑%.1fKB ↓%.1fKB\n",
+            TextEncoding::Utf8ToWide(profile->name).c_str(),
+            requests,
+            Instrumentation::GetCounter(prefix + "prompt_tokens"),
+            Instrumentation::GetCounter(prefix + "cached_tokens"),
+            Instrumentation::GetCounter(prefix + "completion_tokens"),
+            Instrumentation::GetCounter(prefix + "bytes_sent") / 1024.0,
+            Instrumentation::GetCounter(prefix + "bytes_received") / 1024.0);
+        report += line;
     }
     
-    return false;
+    if (report.empty())
+        report = L"本次运行尚未发起翻译请求";
+    else
+        report.pop_back();  // 去掉末尾换行
+    return report;
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+﻿#include "WinHttpTransport.h"
+#include "RequestArena.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <chrono>
+
+#pragma comment(lib, "winhttp.lib")
+
+// RAII类用于自动管理WinHTTP句柄
+class WinHttpHandle
+{
+public:
+    WinHttpHandle(HINTERNET handle = nullptr) : m_handle(handle) {}
+    ~WinHttpHandle() { if (m_handle) WinHttpCloseHandle(m_handle); }
+
+    // 禁止拷贝
+    WinHttpHandle(const WinHttpHandle&) = delete;
+    WinHttpHandle& operator=(const WinHttpHandle&) = delete;
+
+    // 支持移动
+    WinHttpHandle(WinHttpHandle&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+    WinHttpHandle& operator=(WinHttpHandle&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle) WinHttpCloseHandle(m_handle);
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+
+    // 重置句柄
+    void reset(HINTERNET handle = nullptr)
+    {
+        if (m_handle) WinHttpCloseHandle(m_handle);
+        m_handle = handle;
+    }
+
+    // 获取句柄
+    HINTERNET get() const { return m_handle; }
+
+    // 检查是否有效
+    bool valid() const { return m_handle != nullptr; }
+
+    // 隐式转换为HINTERNET
+    operator HINTERNET() const { return m_handle; }
+
+private:
+    HINTERNET m_handle;
+};
+
+/**
+ * @brief 关闭WinHTTP会话
+ */
+WinHttpTransport::~WinHttpTransport()
+{
+    if (m_hSession != nullptr)
+    {
+        WinHttpCloseHandle(m_hSession);
+        m_hSession = nullptr;
+    }
+}
+
+/**
+ * @brief 创建WinHTTP会话
+ * @param userAgent User-Agent
+ * @return 成功返回true，失败返回false
+ */
+bool WinHttpTransport::Open(const wchar_t* userAgent)
+{
+    m_hSession = WinHttpOpen(
+        userAgent,
+        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        WINHTTP_NO_PROXY_NAME,
+        WINHTTP_NO_PROXY_BYPASS,
+        0
+    );
+
+    if (m_hSession == nullptr)
+        return false;
+
+#ifdef WINHTTP_OPTION_DECOMPRESSION
+    // 启用gzip/deflate自动解压；Windows 8.1以前的系统不支持，按未压缩传输
+    DWORD decompression = WINHTTP_DECOMPRESSION_FLAG_ALL;
+    m_bDecompression = WinHttpSetOption(m_hSession, WINHTTP_OPTION_DECOMPRESSION, &decompression, sizeof(decompression)) != FALSE;
+#endif
+    Instrumentation::SetGauge("http.decompression", m_bDecompression ? 1.0 : 0.0);
+
+    return true;
+}
+
+/**
+ * @brief 发送请求并流式接收响应
+ * @param request 请求描述
+ * @param onData 响应数据回调（解压后）
+ * @param result 输出结果与传输统计
+ * @return 完整收到响应返回true
+ */
+bool WinHttpTransport::Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result)
+{
+    result = HttpResult();
+
+    // 无论在哪个阶段返回，都记录耗时并上报统计
+    struct MetricsReporter
+    {
+        HttpResult& result;
+        std::chrono::steady_clock::time_point start;
+        ~MetricsReporter()
+        {
+            result.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            ReportMetrics(result);
+        }
+    } reporter{ result, std::chrono::steady_clock::now() };
+
+    // 被抢占的请求在各阶段之间和每个数据块之后检查取消信号，关闭句柄即放弃该连接
+    auto isCancelled = [&request]() { return request.cancel != nullptr && request.cancel->load(); };
+    if (isCancelled())
+    {
+        result.failure = HttpFailure::Cancelled;
+        return false;
+    }
+
+    WinHttpHandle hConnect(WinHttpConnect(m_hSession, request.host, request.port, 0));
+    if (!hConnect.valid())
+    {
+        result.failure = HttpFailure::Connect;
+        return false;
+    }
+
+    WinHttpHandle hRequest(WinHttpOpenRequest(
+        hConnect,
+        request.method,
+        request.path,
+        nullptr,
+        WINHTTP_NO_REFERER,
+        WINHTTP_DEFAULT_ACCEPT_TYPES,
+        WINHTTP_FLAG_SECURE
+    ));
+
+    if (!hRequest.valid())
+    {
+        result.failure = HttpFailure::OpenRequest;
+        return false;
+    }
+
+    WinHttpSetTimeouts(hRequest, request.resolveTimeoutMs, request.connectTimeoutMs,
+        request.sendTimeoutMs, request.receiveTimeoutMs);
+
+    if (!request.headers.empty())
+    {
+        WinHttpAddRequestHeaders(
+            hRequest,
+            request.headers.data(),
+            static_cast<DWORD>(request.headers.length()),
+            WINHTTP_ADDREQ_FLAG_ADD
+        );
+    }
+
+    if (isCancelled())
+    {
+        result.failure = HttpFailure::Cancelled;
+        return false;
+    }
+
+    // 各阶段耗时供自适应超时统计；失败时区分是否超时，超时由调用方决定是否换连接重试
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from) { return std::chrono::duration<double, std::milli>(Clock::now() - from).count(); };
+    auto fail = [&result](HttpFailure failure)
+    {
+        result.failure = failure;
+        result.timedOut = GetLastError() == ERROR_WINHTTP_TIMEOUT;
+        return false;
+    };
+
+    Clock::time_point phaseStart = Clock::now();
+    DWORD bodyLength = static_cast<DWORD>(request.body.length());
+    LPVOID body = bodyLength > 0 ? const_cast<char*>(request.body.data()) : WINHTTP_NO_REQUEST_DATA;
+    if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0, body, bodyLength, bodyLength, 0))
+        return fail(HttpFailure::Send);
+    result.bytesSent = bodyLength;
+    result.sendMs = elapsedMs(phaseStart);
+
+    phaseStart = Clock::now();
+    if (!WinHttpReceiveResponse(hRequest, nullptr))
+        return fail(HttpFailure::Receive);
+    result.responseMs = elapsedMs(phaseStart);
+
+    // 响应头到达后，接收超时改为数据块之间的空闲超时
+    if (request.idleTimeoutMs > 0 && request.idleTimeoutMs != request.receiveTimeoutMs)
+    {
+        DWORD idleTimeout = static_cast<DWORD>(request.idleTimeoutMs);
+        WinHttpSetOption(hRequest, WINHTTP_OPTION_RECEIVE_TIMEOUT, &idleTimeout, sizeof(idleTimeout));
+    }
+
+    uint64_t statusCode = 0;
+    QueryNumberHeader(hRequest, WINHTTP_QUERY_STATUS_CODE, statusCode);
+    result.statusCode = static_cast<unsigned long>(statusCode);
+
+    // 自动解压后读到的是解压数据，网络字节数取自Content-Length（分块传输时无此字段）
+    uint64_t contentLength = 0;
+    bool hasContentLength = QueryNumberHeader(hRequest, WINHTTP_QUERY_CONTENT_LENGTH, contentLength);
+
+    wchar_t encoding[32] = {};
+    DWORD encodingSize = sizeof(encoding);
+    if (WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CONTENT_ENCODING, WINHTTP_HEADER_NAME_BY_INDEX,
+        encoding, &encodingSize, WINHTTP_NO_HEADER_INDEX))
+    {
+        result.compressed = _wcsicmp(encoding, L"identity") != 0;
+    }
+
+    // 响应数据读入当前线程复用的环形缓冲区，每读到一块就交给调用方就地处理
+    ByteRing& ring = RequestArena::ForCurrentThread().responseRing;
+    ring.Reset();
+    DWORD bytesAvailable = 0;
+    DWORD bytesRead = 0;
+
+    do
+    {
+        if (isCancelled())
+        {
+            result.failure = HttpFailure::Cancelled;
+            return false;
+        }
+
+        // 读取失败（空闲超时、连接中断）时响应不完整，按接收失败处理
+        phaseStart = Clock::now();
+        if (!WinHttpQueryDataAvailable(hRequest, &bytesAvailable))
+            return fail(HttpFailure::Receive);
+        result.maxGapMs = std::max<double>(result.maxGapMs, elapsedMs(phaseStart));
+        if (bytesAvailable == 0)
+            break;
+
+        size_t writable = 0;
+        char* dest = ring.GetWriteSpan(writable);
+        DWORD toRead = bytesAvailable < writable ? bytesAvailable : static_cast<DWORD>(writable);
+        if (!WinHttpReadData(hRequest, dest, toRead, &bytesRead))
+            return fail(HttpFailure::Receive);
+        if (bytesRead == 0)
+            break;
+        ring.CommitWrite(bytesRead);
+        result.decodedBytesReceived += bytesRead;
+
+        size_t readable = 0;
+        const char* src = ring.GetReadSpan(readable);
+        while (readable > 0)
+        {
+            onData(src, readable);
+            ring.ConsumeRead(readable);
+            src = ring.GetReadSpan(readable);
+        }
+    } while (bytesAvailable > 0);
+
+    result.wireBytesReceived = hasContentLength ? contentLength : result.decodedBytesReceived;
+    return true;
+}
+
+/**
+ * @brief 读取响应头中的数值字段
+ * @param hRequest 请求句柄
+ * @param infoLevel 字段（WINHTTP_QUERY_*）
+ * @param value 输出数值
+ * @return 字段存在返回true
+ */
+bool WinHttpTransport::QueryNumberHeader(HINTERNET hRequest, DWORD infoLevel, uint64_t& value)
+{
+    DWORD number = 0;
+    DWORD size = sizeof(number);
+    if (!WinHttpQueryHeaders(hRequest, infoLevel | WINHTTP_QUERY_FLAG_NUMBER, WINHTTP_HEADER_NAME_BY_INDEX,
+        &number, &size, WINHTTP_NO_HEADER_INDEX))
+    {
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+/**
+ * @brief 将一次请求的传输统计累加到Instrumentation
+ * @param result 请求结果
+ */
+void WinHttpTransport::ReportMetrics(const HttpResult& result)
+{
+    Instrumentation::AddCounter("http.requests");
+    if (result.failure == HttpFailure::Cancelled)
+    {
+        Instrumentation::AddCounter("http.cancelled");
+        return;
+    }
+    if (result.failure != HttpFailure::None)
+    {
+        Instrumentation::AddCounter("http.failures");
+        return;
+    }
+
+    Instrumentation::AddCounter("http.bytes_sent", static_cast<int64_t>(result.bytesSent));
+    Instrumentation::AddCounter("http.bytes_wire", static_cast<int64_t>(result.wireBytesReceived));
+    Instrumentation::AddCounter("http.bytes_decoded", static_cast<int64_t>(result.decodedBytesReceived));
+    if (result.compressed)
+        Instrumentation::AddCounter("http.compressed_responses");
+    Instrumentation::SetGauge("http.last_latency_ms", result.latencyMs);
+}
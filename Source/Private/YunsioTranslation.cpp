@@ -2,6 +2,15 @@
 #include "SystemTray.h"
 #include "GlobalHotkey.h"
 #include "TranslationManager.h"
+#include "TranslationService.h"
+#include "ConfigManager.h"
+#include "Instrumentation.h"
+#include "TextEncoding.h"
+#include "BatchRunner.h"
+#include "IpcServer.h"
+#include <shellapi.h>
+#include <chrono>
+#include <cstdio>
 
 // 静态变量保存Mutex句柄
 static HANDLE s_hMutex = nullptr;
@@ -22,16 +31,87 @@ bool YunsioTranslation::IsAlreadyRunning()
     return false;
 }
 
+// 启动耗时日志文件名，每次启动追加一行时间线
+static const wchar_t* STARTUP_LOG_FILE_NAME = L"YunsioTranslation.startup.log";
+
+// 记录启动时间线（输出到调试器并追加到日志文件）
+static void WriteStartupTimeline()
+{
+    std::string timeline = Instrumentation::FormatStartupTimeline();
+    OutputDebugStringW((L"[YunsioTranslation] 启动时间线: " + TextEncoding::Utf8ToWide(timeline) + L"\n").c_str());
+    
+    std::wstring logPath = ConfigManager::GetAppDirectory() + STARTUP_LOG_FILE_NAME;
+    Instrumentation::AppendLine(TextEncoding::WideToUtf8(logPath), timeline);
+}
+
+// 运行指标日志文件名，每次退出追加一行（退出耗时和本次运行的全部指标）
+static const wchar_t* METRICS_LOG_FILE_NAME = L"YunsioTranslation.metrics.log";
+
+// 退出时限（毫秒）：等待进行中的翻译完成、取消后等待请求返回，以及整个退出流程的硬上限
+static const DWORD SHUTDOWN_DRAIN_MS = 1500;
+static const DWORD SHUTDOWN_CANCEL_MS = 500;
+static const DWORD SHUTDOWN_HARD_LIMIT_MS = 5000;
+
+// 退出时等待本地IPC客户端读取线程退出的时限（毫秒）
+static const DWORD SHUTDOWN_IPC_MS = 500;
+
+// 退出看门狗：退出流程超过硬上限时直接结束进程
+static DWORD WINAPI ShutdownWatchdogProc(LPVOID param)
+{
+    HANDLE hDone = static_cast<HANDLE>(param);
+    if (WaitForSingleObject(hDone, SHUTDOWN_HARD_LIMIT_MS) == WAIT_TIMEOUT)
+    {
+        OutputDebugStringW(L"[YunsioTranslation] 退出超时，强制结束进程\n");
+        TerminateProcess(GetCurrentProcess(), 0);
+    }
+    return 0;
+}
+
+// 记录退出耗时和本次运行的全部指标（输出到调试器并追加到日志文件）
+static void WriteShutdownReport(double shutdownMs, bool drained)
+{
+    char summary[64];
+    snprintf(summary, sizeof(summary), "shutdown=%.1fms drained=%d", shutdownMs, drained ? 1 : 0);
+    OutputDebugStringW((L"[YunsioTranslation] 退出: " + TextEncoding::Utf8ToWide(summary) + L"\n").c_str());
+    
+    // 指标报告每项一行，日志中合并为一行
+    std::string line = summary;
+    std::string report = Instrumentation::FormatReport();
+    for (char& ch : report)
+    {
+        if (ch == '\n')
+            ch = ' ';
+    }
+    if (!report.empty())
+        line += " " + report;
+    
+    std::wstring logPath = ConfigManager::GetAppDirectory() + METRICS_LOG_FILE_NAME;
+    Instrumentation::AppendLine(TextEncoding::WideToUtf8(logPath), line);
+}
+
 // 运行应用程序
 int YunsioTranslation::Run()
 {
     if (IsAlreadyRunning())
         return 1;
     
-    // 初始化各个模块
-    if (!TranslationManager::Initialize())
+    // 确保主线程消息队列已创建，后台线程才能投递线程消息
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    
+    // 加载配置并监视配置文件变化，其他模块依赖配置，必须最先初始化
+    if (!ConfigManager::Initialize(GetCurrentThreadId()))
+    {
+        MessageBoxW(nullptr, L"配置管理器初始化失败", L"错误", MB_OK | MB_ICONERROR);
+        return 1;
+    }
+    Instrumentation::MarkStartup("config");
+    
+    // 初始化各个模块：热键和托盘立即可用，翻译服务和历史在后台预热
+    if (!TranslationManager::Initialize(GetCurrentThreadId()))
     {
         MessageBoxW(nullptr, L"翻译管理器初始化失败", L"错误", MB_OK | MB_ICONERROR);
+        ConfigManager::Cleanup();
         return 1;
     }
     
@@ -39,12 +119,17 @@ int YunsioTranslation::Run()
     {
         MessageBoxW(nullptr, L"全局热键初始化失败", L"错误", MB_OK | MB_ICONERROR);
         TranslationManager::Cleanup();
+        ConfigManager::Cleanup();
         return 1;
     }
+    Instrumentation::MarkStartup("hotkey");
     
     SystemTray::CreateTray();
+    Instrumentation::MarkStartup("tray");
+    
+    // 本地IPC翻译服务（配置开启时）
+    IpcServer::ApplyConfig();
     
-    MSG msg;
     while (true)
     {
         if (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
@@ -52,6 +137,28 @@ int YunsioTranslation::Run()
             if (msg.message == WM_QUIT)
                 break;
             
+            // 配置热重载：在主线程上应用新配置（热键注册与线程绑定）
+            if (msg.message == WM_CONFIG_CHANGED)
+            {
+                TranslationService::ApplyConfig();
+                TranslationManager::ApplyConfig();
+                GlobalHotkey::ApplyConfig();
+                IpcServer::ApplyConfig();
+            }
+            
+            // 后台预热完成（此时热键和托盘阶段必然已记录）
+            if (msg.message == WM_STARTUP_WARM)
+            {
+                Instrumentation::MarkStartup("ready");
+                WriteStartupTimeline();
+            }
+            
+            // 交互翻译完成，在主线程上粘贴或显示结果
+            if (msg.message == WM_TRANSLATION_DONE)
+            {
+                TranslationManager::OnTranslationMessage(msg.lParam);
+            }
+            
             // 处理热键消息
             GlobalHotkey::ProcessHotkeyMessage(&msg);
             
@@ -61,10 +168,29 @@ int YunsioTranslation::Run()
         Sleep(10);
     }
     
+    // 有序退出：先停止接收热键和托盘操作，再限时排空翻译请求，最后落盘；看门狗保证退出耗时有上限
+    std::chrono::steady_clock::time_point shutdownStart = std::chrono::steady_clock::now();
+    HANDLE hShutdownDone = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    HANDLE hWatchdog = hShutdownDone ? CreateThread(nullptr, 0, ShutdownWatchdogProc, hShutdownDone, 0, nullptr) : nullptr;
+    
     // 清理资源
     SystemTray::Cleanup();
     GlobalHotkey::Cleanup();
-    TranslationManager::Cleanup();
+    IpcServer::Cleanup(SHUTDOWN_IPC_MS);
+    bool drained = TranslationManager::Cleanup(SHUTDOWN_DRAIN_MS, SHUTDOWN_CANCEL_MS);
+    ConfigManager::Cleanup();
+    
+    double shutdownMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shutdownStart).count();
+    WriteShutdownReport(shutdownMs, drained);
+    
+    if (hWatchdog)
+    {
+        SetEvent(hShutdownDone);
+        WaitForSingleObject(hWatchdog, INFINITE);
+        CloseHandle(hWatchdog);
+    }
+    if (hShutdownDone)
+        CloseHandle(hShutdownDone);
     
     // 释放Mutex句柄
     if (s_hMutex)
@@ -73,6 +199,10 @@ int YunsioTranslation::Run()
         s_hMutex = nullptr;
     }
     
+    // 仍有请求阻塞在网络调用中：状态已全部落盘，直接结束进程而不等待网络超时
+    if (!drained)
+        TerminateProcess(GetCurrentProcess(), 0);
+    
     return 0;
 }
 
@@ -85,5 +215,17 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     UNREFERENCED_PARAMETER(lpCmdLine);
     UNREFERENCED_PARAMETER(nCmdShow);
     
+    // 命令行批量模式：不检查单实例，可与常驻实例同时运行
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv != nullptr && BatchRunner::IsBatchCommand(argc, argv))
+    {
+        int exitCode = BatchRunner::Run(argc, argv);
+        LocalFree(argv);
+        return exitCode;
+    }
+    if (argv != nullptr)
+        LocalFree(argv);
+    
     return YunsioTranslation::Run();
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class LatencyHistogram
+ * @brief 滚动窗口的耗时直方图（不依赖Windows API）
+ *
+ * 对数分桶（1毫秒到约100秒，相邻桶相差20%），保留当前和上一代两代计数，
+ * 当前代满GENERATION_SIZE个样本后丢弃上一代，因此百分位数只反映最近一到两代的样本
+ */
+class LatencyHistogram
+{
+public:
+    static const size_t BUCKET_COUNT = 64;
+    static const size_t GENERATION_SIZE = 128;
+
+    /**
+     * @brief 记录一个样本
+     * @param value 耗时（毫秒，或按token归一化后的值）
+     */
+    void Add(double value);
+
+    /**
+     * @brief 获取百分位数（取所在桶的上界，偏保守）
+     * @param quantile 分位（0到1）
+     * @return 百分位数，没有样本时返回0
+     */
+    double Percentile(double quantile) const;
+
+    /**
+     * @brief 获取窗口内的样本数
+     * @return 样本数
+     */
+    size_t GetCount() const { return m_currentCount + m_previousCount; }
+
+    /**
+     * @brief 获取桶的上界
+     * @param bucket 桶编号
+     * @return 上界
+     */
+    static double BucketLimit(size_t bucket);
+
+private:
+    uint32_t m_current[BUCKET_COUNT] = {};
+    uint32_t m_previous[BUCKET_COUNT] = {};
+    size_t m_currentCount = 0;
+    size_t m_previousCount = 0;
+};
+
+/**
+ * @struct PhaseTimeouts
+ * @brief 一次请求各阶段的超时（毫秒，0表示无限）
+ */
+struct PhaseTimeouts
+{
+    int connectMs = 0;      // 建立TCP连接
+    int sendMs = 0;         // 发送请求
+    int responseMs = 0;     // 发送完成到收到响应头（非流式响应包含整个生成过程）
+    int idleMs = 0;         // 响应体相邻两块数据之间
+};
+
+/**
+ * @class AdaptiveTimeouts
+ * @brief 按最近的耗时分布计算各阶段超时（不依赖Windows API）
+ *
+ * 每个阶段的超时为该阶段最近耗时的P99乘以FACTOR，不低于下限，不超过配置的超时。
+ * 等待响应的耗时随输出长度增长，按"每个预计输出token的耗时"统计，计算超时时再乘以本次的预计token数；
+ * 统计和计算用同一个估计值，估计的偏差也一并计入分布。
+ * 样本不足MIN_SAMPLES时使用配置的超时。所有方法线程安全
+ */
+class AdaptiveTimeouts
+{
+public:
+    static const size_t MIN_SAMPLES = 20;
+
+    // P99的倍数
+    static constexpr double FACTOR = 3.0;
+
+    // 各阶段超时的下限（毫秒）
+    static const int MIN_CONNECT_MS = 2000;
+    static const int MIN_RESPONSE_MS = 3000;
+    static const int MIN_IDLE_MS = 2000;
+
+    // 等待响应的固定开销折算的token数（排队、处理输入等与输出长度无关的部分）
+    static const size_t TOKEN_OVERHEAD = 32;
+
+    /**
+     * @brief 按输入长度估计输出token数
+     * @param inputBytes 发送的UTF-8文本字节数
+     * @param maxTokens 配置档的max_tokens
+     * @return 预计token数
+     */
+    static size_t EstimateOutputTokens(size_t inputBytes, int maxTokens);
+
+    /**
+     * @brief 记录一次成功请求的各阶段耗时
+     * @param sendMs 连接并发送请求的耗时
+     * @param responseMs 等待响应头的耗时
+     * @param maxGapMs 响应体相邻两块数据之间的最长间隔
+     * @param expectedTokens 发送时的预计输出token数（见EstimateOutputTokens）
+     */
+    void Record(double sendMs, double responseMs, double maxGapMs, size_t expectedTokens);
+
+    /**
+     * @brief 计算一次请求的各阶段超时
+     * @param ceilings 配置的超时（上限，responseMs和idleMs都以配置的接收超时为上限）
+     * @param expectedTokens 预计输出token数
+     * @return 各阶段超时
+     */
+    PhaseTimeouts Compute(const PhaseTimeouts& ceilings, size_t expectedTokens) const;
+
+    /**
+     * @brief 清除全部样本（配置的服务地址变化后调用）
+     */
+    void Reset();
+
+private:
+    /**
+     * @brief 由直方图计算一个阶段的超时
+     * @param histogram 直方图
+     * @param scale 样本值到毫秒的倍数
+     * @param floorMs 下限
+     * @param ceilingMs 上限（0表示无限）
+     * @return 超时（毫秒）
+     */
+    static int PhaseTimeout(const LatencyHistogram& histogram, double scale, int floorMs, int ceilingMs);
+
+    LatencyHistogram m_send;            // 连接并发送请求（复用连接时接近0）
+    LatencyHistogram m_responsePerToken;    // 等待响应头的耗时 / (预计输出token数 + TOKEN_OVERHEAD)
+    LatencyHistogram m_gap;             // 响应体数据块之间的最长间隔
+    mutable std::mutex m_mutex;
+};
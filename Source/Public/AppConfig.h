@@ -0,0 +1,149 @@
+﻿#pragma once
+
+#include "TranslationProfile.h"
+#include "Glossary.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @struct AppConfig
+ * @brief 运行时配置 - 原先编译在代码中的API参数、超时和热键配置档
+ *
+ * 配置对象一经构建即视为只读，热重载时整体替换（见ConfigStore）
+ */
+struct AppConfig
+{
+    // [Api]（模型参数和系统提示词同时作为各配置档的默认值）
+    std::string apiKey;                                             // API密钥
+    std::string host = "dashscope.aliyuncs.com";                    // API主机名
+    uint16_t port = 443;                                            // 端口
+    std::string path = "/compatible-mode/v1/chat/completions";      // 请求路径
+    std::string model = "qwen-plus";                                // 模型名称
+    double temperature = 0.3;                                       // 采样温度
+    int maxTokens = 1000;                                           // 最大输出token数
+    std::string systemPrompt;                                       // 系统提示词
+    int requestsPerMinute = 0;                                      // 服务商每分钟请求数配额，0表示不限
+    int tokensPerMinute = 0;                                        // 服务商每分钟token数配额，0表示不限
+
+    // [Timeouts]（毫秒，对应WinHttpSetTimeouts的四个阶段）
+    int resolveTimeoutMs = 10000;
+    int connectTimeoutMs = 10000;
+    int sendTimeoutMs = 30000;
+    int receiveTimeoutMs = 30000;
+    bool adaptiveTimeouts = true;                                   // 按最近的耗时分布收紧超时（以上述值为上限），超时后换连接重试一次
+
+    // [Cache]
+    int cacheCapacity = 1000;                                       // 翻译缓存最大条目数，0表示禁用
+
+    // [Memory]
+    int memoryCapacity = 100000;                                    // 翻译记忆最大条目数，0表示禁用
+    double memoryAnswer = 1.0;                                      // 相似度不低于该值时直接沿用已有译文（1只沿用仅大小写、空白或标点不同的原文），0表示不沿用
+    double memoryHint = 0.75;                                       // 相似度不低于该值时把已有译文附在请求中，0表示不附带
+
+    // [History]
+    int historyMaxKB = 4096;                                        // 历史日志文件上限（KB），0表示禁用，重启后生效
+
+    // [Glossary]
+    GlossaryMode glossaryMode = GlossaryMode::Substitute;           // 术语表使用方式
+    std::string glossaryFile = "YunsioTranslation.glossary";        // 术语表文件，相对路径相对于程序所在目录
+
+    // [Paste]
+    int pasteMaxTypedChars = 200;                                   // 不超过该字符数的单行译文以Unicode按键事件直接输入，0表示总是使用剪切板
+    std::string pasteClipboardClasses = "TscShellContainerClass;VMUIFrame";     // 总是使用剪切板的窗口类名（分号分隔，远程桌面和虚拟机窗口）
+
+    // [Scheduler]
+    int interactiveConcurrency = 2;                                 // 同时执行的热键翻译请求数上限
+    int clientConcurrency = 1;                                      // 同时执行的本地IPC单条翻译数上限（不占用热键翻译的名额）
+    int backgroundConcurrency = 1;                                  // 同时执行的后台请求（预连接、离线重放、IPC批量翻译）数上限
+
+    // [Server]
+    bool serverEnabled = false;                                     // 是否开放本地IPC翻译服务（命名管道）
+    int serverMaxClients = 16;                                      // 同时连接的客户端上限
+
+    // [Profile.名称]，至少包含一个配置档；未定义任何配置档时由[Api]和[Hotkey]生成默认配置档
+    std::vector<std::shared_ptr<const TranslationProfile>> profiles;
+
+    /**
+     * @brief 获取内置默认配置
+     * @return 默认配置
+     */
+    static AppConfig Defaults();
+
+    /**
+     * @brief 按名称查找配置档
+     * @param name 配置档名称（不区分大小写）
+     * @return 找到返回配置档，否则返回nullptr
+     */
+    std::shared_ptr<const TranslationProfile> FindProfile(const std::string& name) const;
+};
+
+/**
+ * @class ConfigParser
+ * @brief INI格式配置解析器（不依赖Windows API）
+ *
+ * 支持 [Section]、Key=Value、以 ; 或 # 开头的注释行，
+ * 值中的 \n 转义会被还原为换行符。未出现的键保留默认值。
+ */
+class ConfigParser
+{
+public:
+    /**
+     * @brief 解析配置文本
+     * @param text UTF-8编码的配置文件内容
+     * @param config 输入为基础配置，输出为覆盖后的配置
+     * @param error 失败时输出错误描述（包含行号）
+     * @return 解析成功返回true，失败返回false（此时config内容未定义）
+     */
+    static bool Parse(const std::string& text, AppConfig& config, std::string& error);
+
+    /**
+     * @brief 解析热键描述字符串，例如 "Ctrl+Space"、"Ctrl+Alt+T"、"Win+F8"
+     * @param text 热键描述
+     * @param binding 输出热键绑定
+     * @return 解析成功返回true，失败返回false
+     */
+    static bool ParseHotkey(const std::string& text, HotkeyBinding& binding);
+
+    /**
+     * @brief 生成默认配置文件内容（首次运行时写出，供用户编辑）
+     * @return UTF-8编码的INI文本
+     */
+    static std::string GenerateDefaultText();
+};
+
+/**
+ * @class ConfigStore
+ * @brief 当前生效配置的持有者 - 以原子方式整体替换
+ *
+ * 读取方通过Current()获得一份不可变快照，在一次请求内保持一致；
+ * 热重载时Publish()原子地替换快照，正在使用旧快照的请求不受影响
+ */
+class ConfigStore
+{
+public:
+    /**
+     * @brief 获取当前配置快照
+     * @return 当前配置（从未发布过时返回默认配置）
+     */
+    static std::shared_ptr<const AppConfig> Current();
+
+    /**
+     * @brief 发布新配置，原子替换当前快照
+     * @param config 新配置
+     * @return 新配置的版本号（从1开始递增）
+     */
+    static uint64_t Publish(std::shared_ptr<const AppConfig> config);
+
+    /**
+     * @brief 获取当前配置版本号，用于判断缓存的派生数据是否过期
+     * @return 版本号，未发布过时为0
+     */
+    static uint64_t Version();
+
+private:
+    static std::shared_ptr<const AppConfig> s_pConfig;
+    static std::atomic<uint64_t> s_nVersion;
+};
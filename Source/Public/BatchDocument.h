@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+
+/**
+ * @enum BatchSplit
+ * @brief 批量翻译时输入的拆分方式
+ */
+enum class BatchSplit
+{
+    Lines,          // 每个非空行一条记录（资源文件、字符串表、注释导出）
+    Paragraphs      // 以空行分隔的段落为一条记录，段内换行保留
+};
+
+/**
+ * @class BatchDocument
+ * @brief 批量翻译的一份输入 - 拆分记录并按原顺序拼接译文（不依赖Windows API）
+ *
+ * 记录是去除首尾空白后的字节区间，记录之间的缩进、空行和换行符原样保留，
+ * 因此输出与输入逐行对齐（包括CRLF和UTF-8 BOM）。译文可在任意线程上以任意顺序完成，
+ * 输出只按顺序取出已连续完成的前缀，已取出记录的译文随即释放。
+ * Complete、TakeReady和WaitForProgress线程安全
+ */
+class BatchDocument
+{
+public:
+    /**
+     * @brief 拆分输入
+     * @param input UTF-8文本
+     * @param split 拆分方式
+     */
+    BatchDocument(std::string input, BatchSplit split);
+
+    BatchDocument(const BatchDocument&) = delete;
+    BatchDocument& operator=(const BatchDocument&) = delete;
+
+    /**
+     * @brief 获取记录数量
+     * @return 记录数量
+     */
+    size_t GetRecordCount() const { return m_records.size(); }
+
+    /**
+     * @brief 获取记录原文
+     * @param index 记录索引
+     * @return 原文（UTF-8）
+     */
+    std::string GetRecord(size_t index) const;
+
+    /**
+     * @brief 记录翻译完成；失败的记录输出原文
+     *
+     * 按行拆分时译文中的换行替换为空格，保证输出行数不变
+     * @param index 记录索引
+     * @param success 是否成功
+     * @param result 译文（UTF-8），失败时忽略
+     */
+    void Complete(size_t index, bool success, std::string result);
+
+    /**
+     * @brief 取出按顺序已连续完成的输出，全部完成时连同末尾的空白一起取出
+     * @param out 追加到的输出
+     * @return 本次取出的记录数
+     */
+    size_t TakeReady(std::string& out);
+
+    /**
+     * @brief 等待新的记录完成
+     * @param timeout 最长等待时间
+     * @return 等待期间有记录完成或已全部完成返回true
+     */
+    bool WaitForProgress(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief 获取已完成的记录数
+     * @return 记录数
+     */
+    size_t GetCompletedCount() const;
+
+    /**
+     * @brief 获取失败的记录数
+     * @return 记录数
+     */
+    size_t GetFailedCount() const;
+
+    /**
+     * @brief 是否全部记录都已完成并取出
+     * @return 全部取出返回true
+     */
+    bool IsFinished() const;
+
+private:
+    // 一条记录
+    struct Record
+    {
+        size_t begin;           // 原文在输入中的字节区间
+        size_t end;
+        bool done = false;
+        bool success = false;
+        std::string result;
+    };
+
+    /**
+     * @brief 按行拆分
+     */
+    void SplitLines();
+
+    /**
+     * @brief 按段落拆分
+     */
+    void SplitParagraphs();
+
+    /**
+     * @brief 去除区间首尾空白后加入记录，全为空白时忽略
+     * @param begin 起始位置
+     * @param end 结束位置
+     */
+    void AddRecord(size_t begin, size_t end);
+
+    std::string m_input;
+    BatchSplit m_split;
+    size_t m_contentBegin = 0;          // 跳过UTF-8 BOM后的起始位置
+    std::vector<Record> m_records;
+    size_t m_nextFlush = 0;             // 下一条待取出的记录
+    size_t m_flushPos = 0;              // 输入中已取出的位置
+    size_t m_completed = 0;
+    size_t m_failed = 0;
+    bool m_tailFlushed = false;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_progress;
+};
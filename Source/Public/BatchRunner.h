@@ -0,0 +1,120 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "TranslationProfile.h"
+#include "BatchDocument.h"
+
+/**
+ * @class BatchRunner
+ * @brief 命令行批量翻译 - 不创建托盘和热键，逐行（或逐段）翻译文件和标准输入
+ *
+ * 用法：YunsioTranslation.exe --batch [--profile 名称] [--jobs N] [--paragraphs] [--output 文件]
+ *       [--record 文件 | --replay 文件 [--replay-scale 系数]] [输入文件|-]...
+ * 与常驻实例共用配置文件、翻译缓存预热、术语表和每分钟配额，记录由调度器的工作线程并发翻译，
+ * 输出按原顺序写出。进度和吞吐量统计写到标准错误。
+ * --record把API请求和响应录制到文件，--replay不访问网络、由录制文件应答，用于离线比较两个版本的耗时和CPU开销；
+ * 两者都不预热翻译历史、不使用翻译记忆（参考译文取决于完成顺序），使请求内容可重现
+ */
+class BatchRunner
+{
+public:
+    /**
+     * @brief 判断命令行是否请求批量模式
+     * @param argc 参数个数
+     * @param argv 参数（argv[0]为程序路径）
+     * @return 第一个参数为--batch时返回true
+     */
+    static bool IsBatchCommand(int argc, wchar_t** argv);
+
+    /**
+     * @brief 运行批量翻译
+     * @param argc 参数个数
+     * @param argv 参数（argv[0]为程序路径）
+     * @return 进程退出码：0全部成功，1参数或初始化错误，2部分记录失败（输出原文），3被Ctrl+C中断
+     */
+    static int Run(int argc, wchar_t** argv);
+
+private:
+    /**
+     * @struct Options
+     * @brief 命令行选项
+     */
+    struct Options
+    {
+        std::string profile;                // 配置档名称，为空时使用第一个配置档
+        int jobs = 4;                       // 并发请求数
+        BatchSplit split = BatchSplit::Lines;
+        std::wstring output;                // 输出文件，为空时写到标准输出
+        std::vector<std::wstring> inputs;   // 输入文件，"-"表示标准输入
+        std::wstring record;                // 录制文件，为空时不录制
+        std::wstring replay;                // 回放文件，为空时访问网络
+        double replayScale = 1.0;           // 回放耗时系数，0表示不等待
+    };
+
+    /**
+     * @brief 解析命令行
+     * @param argc 参数个数
+     * @param argv 参数
+     * @param options 输出选项
+     * @param error 失败时输出错误描述
+     * @return 成功返回true
+     */
+    static bool ParseOptions(int argc, wchar_t** argv, Options& options, std::wstring& error);
+
+    /**
+     * @brief 连接到父进程的控制台并取得标准输入输出句柄（窗口程序默认没有控制台）
+     */
+    static void AttachStdHandles();
+
+    /**
+     * @brief 读取输入文件或标准输入
+     * @param input 文件路径，"-"表示标准输入
+     * @param text 输出内容（UTF-8）
+     * @return 成功返回true
+     */
+    static bool ReadInput(const std::wstring& input, std::string& text);
+
+    /**
+     * @brief 写出UTF-8文本：控制台按UTF-16写出，文件和管道按原始字节写出
+     * @param handle 目标句柄
+     * @param text UTF-8文本
+     * @return 成功返回true
+     */
+    static bool WriteText(HANDLE handle, const std::string& text);
+
+    /**
+     * @brief 向标准错误写出一行提示
+     * @param text 提示文本
+     */
+    static void WriteError(const std::wstring& text);
+
+    /**
+     * @brief 翻译一条记录（在调度器的工作线程上执行）
+     * @param document 所属文档
+     * @param index 记录索引
+     * @param profile 翻译配置档
+     * @param cancelled 取消信号
+     */
+    static void TranslateRecord(BatchDocument& document, size_t index, const TranslationProfile& profile,
+        const std::atomic<bool>& cancelled);
+
+    /**
+     * @brief 控制台Ctrl+C处理：请求停止
+     * @param ctrlType 事件类型
+     * @return 已处理返回TRUE
+     */
+    static BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType);
+
+    static HANDLE s_hInput;                     // 标准输入
+    static HANDLE s_hOutput;                    // 标准输出
+    static HANDLE s_hError;                     // 标准错误
+    static std::atomic<bool> s_bInterrupted;    // 收到Ctrl+C
+    static std::atomic<size_t> s_cacheHits;     // 由缓存或术语表直接得到译文的记录数
+    static std::atomic<size_t> s_requests;      // 发起网络请求的记录数
+    static std::wstring s_firstError;           // 第一条失败原因（受s_errorMutex保护）
+    static std::mutex s_errorMutex;
+};
@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @enum CodeLanguage
+ * @brief 词法规则族
+ */
+enum class CodeLanguage
+{
+    CFamily,    // C、C++、C#、Java、JavaScript：// 和 /* */ 注释，"" '' `` 字符串
+    Python      // # 注释，'' "" 和三引号字符串
+};
+
+/**
+ * @enum CodeSegmentKind
+ * @brief 可翻译片段的种类，决定写回时的转义方式
+ */
+enum class CodeSegmentKind
+{
+    LineComment,        // 行注释，写回时换行替换为空格
+    BlockComment,       // 块注释的一行，写回时还要拆开 */
+    String,             // 普通字符串，写回时转义同种引号
+    VerbatimString,     // C#逐字字符串，写回时引号写作两个
+    TextBlock           // 三引号字符串的一行，只替换换行
+};
+
+/**
+ * @struct CodeSegment
+ * @brief 选中代码中的一段可翻译文本，[begin, end) 为单行内去除分隔符和首尾空白后的字节区间
+ */
+struct CodeSegment
+{
+    size_t begin;
+    size_t end;
+    CodeSegmentKind kind;
+    char quote;         // 字符串的引号字符，注释为0
+};
+
+/**
+ * @class CodeLexer
+ * @brief 代码感知的选中文本拆分 - 只翻译注释和字符串字面量（不依赖Windows API）
+ *
+ * 轻量词法分析器只识别注释、字符串和字符字面量的边界，其余代码原样跳过。
+ * 可翻译片段逐行编号拼成一个批量请求（N|文本），译文按编号写回原位置，代码本身不经过模型。
+ * 跨行的块注释和三引号字符串按行拆分，保持原有的缩进和行首星号
+ */
+class CodeLexer
+{
+public:
+    // 批量请求使用的系统提示词
+    static const char* const BATCH_SYSTEM_PROMPT;
+
+    /**
+     * @brief 根据特征猜测语言（#注释、def、import 等倾向Python，其余按C系处理）
+     * @param text UTF-8文本
+     * @return 语言
+     */
+    static CodeLanguage DetectLanguage(const std::string& text);
+
+    /**
+     * @brief 词法分析，输出全部注释和字符串片段（按位置排序）
+     * @param text UTF-8文本
+     * @param language 语言
+     * @param segments 输出片段（会先清空）
+     * @return 注释和字符串之外出现了代码标点（; { } = ( )）返回true
+     */
+    static bool Lex(const std::string& text, CodeLanguage language, std::vector<CodeSegment>& segments);
+
+    /**
+     * @brief 判断选中文本是否为代码，并输出其中值得翻译的片段
+     *
+     * 至少一半的非空行有代码特征（注释行、不计行尾注释时以 ; { } 结尾、关键字开头的语句头、行首的调用或赋值）时视为代码，
+     * 因此含网址、引号或括号的单行自然语言不会被当作代码；只保留含自然语言的片段
+     * （注释至少两个字母，字符串含非ASCII字符或含空格分隔的单词）。
+     * 紧跟在冒号等非空白字符后的 // 不是注释（网址）
+     * @param text UTF-8文本
+     * @param segments 输出可翻译片段（会先清空，复用其容量）
+     * @return 是代码且至少有一个可翻译片段返回true
+     */
+    static bool Analyze(const std::string& text, std::vector<CodeSegment>& segments);
+
+    /**
+     * @brief 生成批量请求文本，每个片段一行：编号|文本
+     * @param text UTF-8原文
+     * @param segments Analyze的结果
+     * @param batch 输出请求文本（会先清空，复用其容量）
+     */
+    static void BuildBatch(const std::string& text, const std::vector<CodeSegment>& segments, std::string& batch);
+
+    /**
+     * @brief 解析批量译文：每行 编号|译文，编号从1开始
+     * @param batchResult 模型返回的批量译文
+     * @param count 请求的条数
+     * @param translations 输出每个编号的译文在batchResult中的字节区间（已去除首尾空白）
+     * @return 每个编号都有非空译文返回true
+     */
+    static bool ParseBatch(const std::string& batchResult, size_t count, std::vector<std::pair<size_t, size_t>>& translations);
+
+    /**
+     * @brief 将批量译文按编号写回原文
+     * @param text UTF-8原文
+     * @param segments Analyze的结果
+     * @param batchResult 模型返回的批量译文
+     * @param out 输出写回后的代码（会先清空，复用其容量）
+     * @return 每个片段都有译文返回true
+     */
+    static bool Splice(const std::string& text, const std::vector<CodeSegment>& segments,
+        const std::string& batchResult, std::string& out);
+};
@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <string>
+
+// 配置已重新加载的线程消息（投递到主线程，wParam为新配置版本号）
+#define WM_CONFIG_CHANGED (WM_APP + 1)
+
+/**
+ * @class ConfigManager
+ * @brief 配置文件管理类 - 启动时加载配置，并监视文件变化进行热重载
+ *
+ * 配置文件位于程序所在目录（YunsioTranslation.ini），不存在时写出默认配置。
+ * 文件变化后在后台线程解析，成功则通过ConfigStore原子替换，并向主线程
+ * 投递WM_CONFIG_CHANGED，由主线程重新注册热键等需要线程亲和的操作
+ */
+class ConfigManager
+{
+public:
+    /**
+     * @brief 加载配置并启动文件监视
+     * @param notifyThreadId 配置变化时接收WM_CONFIG_CHANGED的线程ID
+     * @return 成功返回true，失败返回false
+     */
+    static bool Initialize(DWORD notifyThreadId);
+
+    /**
+     * @brief 只加载一次配置（批量模式使用）：不写出默认配置、不弹出对话框、不启动文件监视
+     * @param error 失败时输出错误描述
+     * @return 成功返回true，失败返回false
+     */
+    static bool LoadOnce(std::wstring& error);
+
+    /**
+     * @brief 停止文件监视并释放资源
+     */
+    static void Cleanup();
+
+    /**
+     * @brief 获取配置文件完整路径
+     * @return 配置文件路径
+     */
+    static const std::wstring& GetConfigPath();
+
+    /**
+     * @brief 获取程序所在目录（以反斜杠结尾），其他数据文件也存放在此
+     * @return 目录路径
+     */
+    static std::wstring GetAppDirectory();
+
+private:
+    /**
+     * @brief 读取并解析配置文件，成功后发布到ConfigStore
+     * @param error 失败时输出错误描述
+     * @return 成功返回true，失败返回false
+     */
+    static bool LoadConfigFile(std::wstring& error);
+
+    /**
+     * @brief 配置文件不存在时写出默认配置
+     */
+    static void WriteDefaultConfigFile();
+
+    /**
+     * @brief 获取配置文件最后修改时间
+     * @param lastWrite 输出修改时间
+     * @return 成功返回true，失败返回false
+     */
+    static bool GetLastWriteTime(FILETIME& lastWrite);
+
+    /**
+     * @brief 文件监视线程过程
+     * @param param 未使用
+     * @return 线程退出码
+     */
+    static DWORD WINAPI WatchThreadProc(LPVOID param);
+
+    // 静态成员变量
+    static std::wstring s_configPath;       // 配置文件路径
+    static HANDLE s_hWatchThread;           // 监视线程句柄
+    static HANDLE s_hStopEvent;             // 停止监视事件
+    static DWORD s_notifyThreadId;          // 接收通知的线程ID
+    static FILETIME s_lastWriteTime;        // 最近一次加载时的文件修改时间
+    static bool s_bInitialized;
+};
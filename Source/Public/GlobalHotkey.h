@@ -1,31 +1,72 @@
 ﻿#pragma once
 
 #include <windows.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "TranslationProfile.h"
+#include "ModifierTracker.h"
 
+// 热键的修饰键全部释放（键盘钩子投递到主线程，开始取词）
+#define WM_HOTKEY_RELEASED (WM_APP + 4)
+
+// 全局热键 - 热键注册与调用线程绑定，除SetHotkeyCallback外的方法都只在主线程调用
 class GlobalHotkey
 {
 public:
-    // 初始化全局热键监听
+    // 初始化全局热键监听（为每个翻译配置档注册一个热键）
     static bool Initialize();
     
     // 清理全局热键监听
     static void Cleanup();
     
-    // 设置热键回调函数
+    // 设置热键回调函数（可在任意线程调用）
     static void SetHotkeyCallback(void(*callback)());
     
-    // 处理热键消息（需要在主消息循环中调用）
+    // 处理热键消息和修饰键释放消息（需要在主消息循环中调用）
     static void ProcessHotkeyMessage(MSG* msg);
     
+    // 按当前配置重新注册热键（配置热重载后在主线程调用）
+    static void ApplyConfig();
+    
 
     
 private:
-    // 热键ID
-    static const int HOTKEY_ID = 1;
+    // 注册分发表中的全部热键，返回成功注册的数量，failedNames输出注册失败的配置档名称
+    static size_t RegisterTable(const HotkeyDispatchTable& table, std::wstring& failedNames);
+    
+    // 取消注册当前分发表中的全部热键
+    static void UnregisterTable();
+    
+    // 热键触发后等待修饰键释放再执行翻译，修饰键已释放或无法安装键盘钩子时立即执行
+    static void BeginRelease(std::shared_ptr<const TranslationProfile> profile);
+    
+    // 结束等待（卸载钩子和定时器）并执行翻译
+    static void FinishRelease();
     
-    // 热键回调函数指针
-    static void(*s_HotkeyCallback)();
+    // 执行热键对应的翻译并调用回调函数
+    static void Dispatch(std::shared_ptr<const TranslationProfile> profile);
     
-    // 初始化状态
+    // 低级键盘钩子：更新修饰键状态，全部释放时投递WM_HOTKEY_RELEASED
+    static LRESULT CALLBACK KeyboardHookProc(int code, WPARAM wParam, LPARAM lParam);
+    
+    // 等待期限定时器
+    static void CALLBACK ReleaseTimerProc(HWND hwnd, UINT message, UINT_PTR timerId, DWORD time);
+    
+    // 当前生效的热键分发表及各条目是否注册成功
+    static HotkeyDispatchTable s_table;
+    static std::vector<bool> s_registered;
+    
+    // 热键回调函数指针（原子替换，主线程读取）
+    static std::atomic<void(*)()> s_HotkeyCallback;
+    
+    // 初始化状态（只在主线程读写）
     static bool s_bInitialized;
+    
+    // 修饰键释放等待（只在主线程读写，键盘钩子回调也在主线程执行）
+    static ModifierTracker s_tracker;
+    static std::shared_ptr<const TranslationProfile> s_pPendingProfile;     // 等待中的热键配置档
+    static HHOOK s_hKeyboardHook;
+    static UINT_PTR s_releaseTimer;
+    static ULONGLONG s_releaseStart;
 };
\ No newline at end of file
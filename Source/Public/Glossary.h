@@ -0,0 +1,182 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum GlossaryMode
+ * @brief 术语表的使用方式
+ */
+enum class GlossaryMode
+{
+    Off,            // 不使用术语表
+    Substitute,     // 请求前把选中文本中的术语替换为约定译法，模型原样保留（默认）
+    Prompt          // 原文不变，在用户消息末尾附上命中的术语条目
+};
+
+/**
+ * @struct GlossaryEntry
+ * @brief 术语表条目
+ */
+struct GlossaryEntry
+{
+    std::string term;           // 术语（UTF-8）
+    std::string translation;    // 约定译法（UTF-8）
+};
+
+/**
+ * @struct GlossaryMatch
+ * @brief 文本中命中的术语，[begin, end) 为字节区间
+ */
+struct GlossaryMatch
+{
+    size_t begin;
+    size_t end;
+    uint32_t entry;
+};
+
+/**
+ * @class GlossaryMatcher
+ * @brief 术语多模式匹配器 - 按字节构建的Aho-Corasick自动机（不依赖Windows API）
+ *
+ * 构建后只读，可在多个线程上同时扫描。状态转移以CSR格式存放（每个状态的出边按字节
+ * 排序后连续存放），根状态使用256项直接索引表；十万条术语的自动机约数十MB以内，
+ * 扫描一次选中文本只需沿失败链前进，与术语数量无关。
+ *
+ * UTF-8的自同步性保证合法的术语只会在字符边界上命中。首尾为ASCII字母数字的术语
+ * 要求整词命中（user不会命中username）。重叠的命中按最左最长原则选取
+ */
+class GlossaryMatcher
+{
+public:
+    /**
+     * @brief 编译术语表，术语重复时保留第一条，空术语被忽略
+     * @param entries 术语条目
+     */
+    explicit GlossaryMatcher(std::vector<GlossaryEntry> entries);
+
+    GlossaryMatcher(const GlossaryMatcher&) = delete;
+    GlossaryMatcher& operator=(const GlossaryMatcher&) = delete;
+
+    /**
+     * @brief 查找文本中的术语（最左最长、互不重叠，按位置排序）
+     * @param text UTF-8文本
+     * @param matches 输出命中（会先清空，复用其容量）
+     * @return 命中数量
+     */
+    size_t FindMatches(const std::string& text, std::vector<GlossaryMatch>& matches) const;
+
+    /**
+     * @brief 整段文本（忽略首尾空白）恰好是一条术语时输出其译法
+     * @param text UTF-8文本
+     * @param translation 输出约定译法
+     * @return 是一条术语返回true
+     */
+    bool LookupExact(const std::string& text, std::string& translation) const;
+
+    /**
+     * @brief 把命中的术语替换为约定译法
+     * @param text UTF-8原文
+     * @param matches FindMatches的结果
+     * @param out 输出文本（会先清空，复用其容量）
+     */
+    void Substitute(const std::string& text, const std::vector<GlossaryMatch>& matches, std::string& out) const;
+
+    /**
+     * @brief 在文本末尾附上命中的术语条目（每条只出现一次）
+     * @param matches FindMatches的结果
+     * @param out 追加到的文本
+     */
+    void AppendHints(const std::vector<GlossaryMatch>& matches, std::string& out) const;
+
+    /**
+     * @brief 获取条目
+     * @param index 条目索引
+     * @return 条目
+     */
+    const GlossaryEntry& GetEntry(uint32_t index) const { return m_entries[index]; }
+
+    /**
+     * @brief 获取条目数量
+     * @return 条目数量
+     */
+    size_t GetEntryCount() const { return m_entries.size(); }
+
+    /**
+     * @brief 获取自动机状态数量
+     * @return 状态数量
+     */
+    size_t GetStateCount() const { return m_fail.size(); }
+
+private:
+    static const uint32_t NONE = 0xFFFFFFFFu;
+
+    /**
+     * @brief 查找状态在某字节上的出边（不沿失败链）
+     * @param state 状态
+     * @param byte 输入字节
+     * @return 目标状态，没有出边返回NONE
+     */
+    uint32_t FindEdge(uint32_t state, unsigned char byte) const;
+
+    std::vector<GlossaryEntry> m_entries;
+    uint32_t m_rootNext[256];               // 根状态的转移（没有出边时回到根状态）
+    std::vector<uint32_t> m_edgeBegin;      // 状态s的出边为 [m_edgeBegin[s], m_edgeBegin[s + 1])
+    std::vector<unsigned char> m_edgeByte;
+    std::vector<uint32_t> m_edgeTarget;
+    std::vector<uint32_t> m_fail;           // 失败链
+    std::vector<uint32_t> m_output;         // 在该状态结束的术语，没有时为NONE
+    std::vector<uint32_t> m_outputLink;     // 沿失败链最近的有输出的状态，没有时为NONE
+};
+
+/**
+ * @class Glossary
+ * @brief 当前生效的术语表（不依赖Windows API）
+ *
+ * 术语表文件为UTF-8文本，每行一条“术语=译法”（也可用制表符分隔），
+ * 以 ; 或 # 开头的行为注释。加载在后台线程上编译，完成后以原子方式整体替换，
+ * 正在进行的请求继续使用旧术语表
+ */
+class Glossary
+{
+public:
+    /**
+     * @brief 加载并编译术语表文件，文件不存在或为空时清空当前术语表
+     * @param path 术语表文件路径（UTF-8）
+     * @return 加载的条目数量
+     */
+    static size_t Load(const std::string& path);
+
+    /**
+     * @brief 解析术语表文本
+     * @param text 术语表文件内容（UTF-8）
+     * @param entries 输出条目
+     */
+    static void Parse(const std::string& text, std::vector<GlossaryEntry>& entries);
+
+    /**
+     * @brief 获取当前术语表
+     * @return 当前术语表，未加载时返回nullptr
+     */
+    static std::shared_ptr<const GlossaryMatcher> Current();
+
+    /**
+     * @brief 替换当前术语表
+     * @param matcher 新术语表，nullptr表示清空
+     */
+    static void Publish(std::shared_ptr<const GlossaryMatcher> matcher);
+
+    /**
+     * @brief 解析使用方式名称（Off、Substitute、Prompt，不区分大小写）
+     * @param name 名称
+     * @param mode 输出使用方式
+     * @return 解析成功返回true
+     */
+    static bool ParseMode(const std::string& name, GlossaryMode& mode);
+
+private:
+    static std::shared_ptr<const GlossaryMatcher> s_pMatcher;
+};
@@ -0,0 +1,158 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @struct HistoryRecord
+ * @brief 一条翻译历史记录（UTF-8文本）
+ */
+struct HistoryRecord
+{
+    int64_t timestamp = 0;      // 完成时间（Unix毫秒）
+    uint32_t latencyMs = 0;     // 翻译耗时（毫秒），缓存命中为0
+    std::string profile;        // 配置档名称
+    std::string source;         // 原文
+    std::string result;         // 命名风格转换前的译文
+};
+
+/**
+ * @struct HistoryRecordView
+ * @brief 历史记录的只读视图，文本直接指向日志内存（内存映射文件），不产生拷贝
+ */
+struct HistoryRecordView
+{
+    int64_t timestamp = 0;
+    uint32_t latencyMs = 0;
+    std::string_view profile;
+    std::string_view source;
+    std::string_view result;
+};
+
+/**
+ * @class HistoryCodec
+ * @brief 历史日志的二进制格式（不依赖Windows API）
+ *
+ * 文件布局：32字节文件头 + 依次追加的记录。文件头记录已使用的数据字节数，
+ * 记录先写入、再更新已使用字节数，因此中途崩溃最多丢失最后一条记录。
+ * 每条记录带校验和，加载时遇到损坏的记录即停止。
+ */
+class HistoryCodec
+{
+public:
+    static const size_t HEADER_SIZE = 32;           // 文件头大小
+    static const size_t RECORD_HEADER_SIZE = 32;    // 记录头大小
+    static const size_t MAX_PROFILE_LENGTH = 0xFFFF; // 配置名最多保存的字节数（记录头中为16位长度）
+
+    /**
+     * @brief 初始化文件头（已使用字节数为0）
+     * @param header 文件头内存，至少HEADER_SIZE字节
+     */
+    static void InitializeHeader(char* header);
+
+    /**
+     * @brief 校验文件头
+     * @param header 文件头内存
+     * @param dataCapacity 数据区容量，用于校验已使用字节数
+     * @return 合法返回true
+     */
+    static bool ValidateHeader(const char* header, size_t dataCapacity);
+
+    /**
+     * @brief 读取已使用的数据字节数
+     * @param header 文件头内存
+     * @return 已使用字节数
+     */
+    static uint64_t GetUsedBytes(const char* header);
+
+    /**
+     * @brief 写入已使用的数据字节数（提交点）
+     * @param header 文件头内存
+     * @param usedBytes 已使用字节数
+     */
+    static void SetUsedBytes(char* header, uint64_t usedBytes);
+
+    /**
+     * @brief 计算记录编码后的字节数（配置名按MAX_PROFILE_LENGTH截断，与Encode一致）
+     * @param record 记录
+     * @return 字节数
+     */
+    static size_t EncodedSize(const HistoryRecord& record);
+
+    /**
+     * @brief 编码记录
+     * @param record 记录
+     * @param dest 目标内存，至少EncodedSize(record)字节
+     */
+    static void Encode(const HistoryRecord& record, char* dest);
+
+    /**
+     * @brief 解码记录（零拷贝）
+     * @param data 记录起始地址
+     * @param available 可读字节数
+     * @param view 输出记录视图
+     * @param consumed 输出记录占用的字节数
+     * @return 记录完整且校验通过返回true
+     */
+    static bool Decode(const char* data, size_t available, HistoryRecordView& view, size_t& consumed);
+};
+
+/**
+ * @class HistoryIndex
+ * @brief 历史记录倒排索引 - 支持中英文子串（含前缀）搜索（不依赖Windows API）
+ *
+ * 以Unicode码点二元组（bigram）为键建立倒排表，ASCII字母统一按小写索引。
+ * 多字符查询取各bigram倒排表的交集作为候选，单字符查询使用单字倒排表，
+ * 候选结果需由调用方用ContainsIgnoreCase做最终校验（bigram交集可能有误报）
+ */
+class HistoryIndex
+{
+public:
+    /**
+     * @brief 添加记录到索引（记录ID必须递增）
+     * @param id 记录ID
+     * @param view 记录视图（索引原文和译文）
+     */
+    void Add(uint32_t id, const HistoryRecordView& view);
+
+    /**
+     * @brief 清空索引
+     */
+    void Clear();
+
+    /**
+     * @brief 查找候选记录
+     * @param query UTF-8查询字符串
+     * @param candidates 输出候选记录ID（按ID从大到小，即最新在前）
+     */
+    void FindCandidates(std::string_view query, std::vector<uint32_t>& candidates) const;
+
+    /**
+     * @brief ASCII不区分大小写的子串匹配
+     * @param text 被搜索文本
+     * @param pattern 模式串
+     * @return 包含返回true
+     */
+    static bool ContainsIgnoreCase(std::string_view text, std::string_view pattern);
+
+private:
+    /**
+     * @brief 解码UTF-8为规范化的码点序列（ASCII字母转小写）
+     * @param text UTF-8文本
+     * @param codePoints 输出码点（会先清空）
+     */
+    static void Normalize(std::string_view text, std::vector<uint32_t>& codePoints);
+
+    /**
+     * @brief 向倒排表追加ID（同一记录只追加一次）
+     * @param postings 倒排表
+     * @param id 记录ID
+     */
+    static void AddPosting(std::vector<uint32_t>& postings, uint32_t id);
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_bigrams;     // 码点二元组 -> 记录ID
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_unigrams;    // 单个码点 -> 记录ID
+};
@@ -0,0 +1,165 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+#include "HttpTransport.h"
+
+/**
+ * @struct HttpChunk
+ * @brief 录制的一块响应数据
+ */
+struct HttpChunk
+{
+    uint32_t delayUs = 0;       // 距上一块（第一块为发起请求）的耗时（微秒）
+    std::string data;           // 解压后的数据
+};
+
+/**
+ * @struct HttpExchange
+ * @brief 一次录制的请求和响应
+ *
+ * 请求只保存方法、主机、路径和脱敏后的请求头，请求体只保存长度（匹配用RequestKey）
+ */
+struct HttpExchange
+{
+    uint64_t key = 0;                   // 请求指纹（见HttpRecording::RequestKey）
+    std::string method;
+    std::string host;
+    uint16_t port = 0;
+    std::string path;
+    std::string headers;                // 脱敏后的请求头
+    uint64_t bodyLength = 0;
+    HttpFailure failure = HttpFailure::None;
+    unsigned long statusCode = 0;
+    bool compressed = false;
+    uint64_t wireBytesReceived = 0;
+    std::vector<HttpChunk> chunks;      // 响应数据块，保留原始的分块边界
+    uint32_t tailUs = 0;                // 最后一块（没有数据时为发起请求）到请求结束的耗时（微秒）
+};
+
+/**
+ * @class HttpRecording
+ * @brief 请求录制文件的格式（不依赖Windows API）
+ *
+ * 文件以"YTRR"和格式版本开头，之后每次请求一条记录：变长整数表示的记录长度加记录内容，
+ * 数值均为变长整数，字符串为长度加字节。记录整条追加，进程中途退出时只丢失最后一条不完整的记录
+ */
+class HttpRecording
+{
+public:
+    // 文件头（4字节标识加1字节版本）
+    static const char FILE_MAGIC[4];
+    static const uint8_t FILE_VERSION = 1;
+
+    /**
+     * @brief 计算请求指纹：方法、主机、端口、路径和请求体的64位FNV-1a散列（不含请求头和超时）
+     * @param request 请求描述
+     * @return 指纹
+     */
+    static uint64_t RequestKey(const HttpRequest& request);
+
+    /**
+     * @brief 请求头脱敏：Authorization、Proxy-Authorization、Cookie、X-Api-Key、Api-Key的值替换为<redacted>
+     * @param headers 请求头，每行以\r\n结尾
+     * @return 脱敏后的请求头（UTF-8）
+     */
+    static std::string RedactHeaders(std::wstring_view headers);
+
+    /**
+     * @brief 编码一条记录并追加到out
+     * @param exchange 录制的请求
+     * @param out 输出缓冲区
+     */
+    static void Encode(const HttpExchange& exchange, std::string& out);
+
+    /**
+     * @brief 从data的pos处解码一条记录
+     * @param data 文件内容（不含文件头）
+     * @param pos 读取位置，成功时移到下一条记录
+     * @param exchange 输出记录
+     * @return 成功返回true，数据不完整或损坏返回false
+     */
+    static bool Decode(const std::string& data, size_t& pos, HttpExchange& exchange);
+};
+
+/**
+ * @class RecordingTransport
+ * @brief 录制装饰器 - 请求照常交给内层传输层，同时把请求和响应（含分块边界和耗时）追加到录制文件
+ *
+ * 可在多个线程上并发调用；被取消的请求不录制
+ */
+class RecordingTransport : public HttpTransport
+{
+public:
+    /**
+     * @brief 构造录制装饰器
+     * @param inner 实际发送请求的传输层
+     */
+    explicit RecordingTransport(std::unique_ptr<HttpTransport> inner);
+
+    /**
+     * @brief 创建录制文件（已存在时覆盖）并写入文件头
+     * @param path 文件路径（UTF-8）
+     * @return 成功返回true
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief 发送请求并录制
+     * @param request 请求描述
+     * @param onData 响应数据回调
+     * @param result 输出结果与传输统计
+     * @return 内层传输层的返回值
+     */
+    bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) override;
+
+private:
+    std::unique_ptr<HttpTransport> m_pInner;
+    std::ofstream m_file;
+    std::mutex m_mutex;         // 保护m_file
+};
+
+/**
+ * @class ReplayTransport
+ * @brief 回放传输层 - 不访问网络，按请求指纹从录制文件中取出响应，按录制的分块和耗时（可缩放）交给回调
+ *
+ * 同一指纹录制了多次时按录制顺序轮流应答；没有录制的请求按连接失败处理。可在多个线程上并发调用
+ */
+class ReplayTransport : public HttpTransport
+{
+public:
+    /**
+     * @brief 加载录制文件
+     * @param path 文件路径（UTF-8）
+     * @param timeScale 耗时系数：1按原始耗时，0不等待（只比较CPU开销）
+     * @return 成功返回true（末尾不完整的记录忽略）
+     */
+    bool Load(const std::string& path, double timeScale);
+
+    /**
+     * @brief 获取加载的请求数
+     * @return 请求数
+     */
+    size_t GetExchangeCount() const { return m_exchanges.size(); }
+
+    /**
+     * @brief 回放请求
+     * @param request 请求描述
+     * @param onData 响应数据回调
+     * @param result 输出结果与传输统计
+     * @return 录制的请求完整收到响应时返回true
+     */
+    bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) override;
+
+private:
+    std::vector<HttpExchange> m_exchanges;
+    std::unordered_map<uint64_t, std::vector<size_t>> m_byKey;     // 指纹 -> 录制顺序的记录下标
+    std::unordered_map<uint64_t, size_t> m_nextUse;                 // 指纹 -> 已应答次数
+    std::mutex m_mutex;                                             // 保护m_nextUse
+    double m_timeScale = 1.0;
+};
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <string_view>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief HTTP请求描述（字符串由调用方持有，请求期间保持有效）
+ */
+struct HttpRequest
+{
+    const wchar_t* method = L"POST";
+    const wchar_t* host = L"";          // 主机名（以空字符结尾）
+    uint16_t port = 443;
+    const wchar_t* path = L"/";         // 请求路径（以空字符结尾）
+    std::wstring_view headers;          // 附加请求头，每行以\r\n结尾
+    std::string_view body;              // 请求体
+    int resolveTimeoutMs = 0;           // 各阶段超时（毫秒），0表示无限
+    int connectTimeoutMs = 60000;
+    int sendTimeoutMs = 30000;
+    int receiveTimeoutMs = 30000;       // 等待响应头
+    int idleTimeoutMs = 0;              // 响应体相邻两块数据之间，0表示与receiveTimeoutMs相同
+    const std::atomic<bool>* cancel = nullptr;  // 取消信号（可选），置位后在下一个阶段或数据块处中止
+};
+
+/**
+ * @brief 请求失败的阶段
+ */
+enum class HttpFailure
+{
+    None,
+    Connect,        // 连接服务器
+    OpenRequest,    // 创建请求
+    Send,           // 发送请求
+    Receive,        // 接收响应
+    Cancelled       // 被调用方取消
+};
+
+/**
+ * @brief HTTP请求结果与传输统计
+ */
+struct HttpResult
+{
+    HttpFailure failure = HttpFailure::None;
+    unsigned long statusCode = 0;
+    uint64_t bytesSent = 0;             // 请求体字节数
+    uint64_t wireBytesReceived = 0;     // 响应体在网络上的字节数（压缩时为压缩后大小）
+    uint64_t decodedBytesReceived = 0;  // 解压后交给调用方的字节数
+    bool compressed = false;            // 响应是否经过gzip/deflate压缩
+    bool timedOut = false;              // 失败是否因为某个阶段超时
+    double latencyMs = 0;               // 从发起连接到读完响应的耗时
+    double sendMs = 0;                  // 连接并发送请求的耗时（复用连接时接近0）
+    double responseMs = 0;              // 发送完成到收到响应头的耗时
+    double maxGapMs = 0;                // 响应体相邻两块数据之间的最长间隔
+};
+
+/**
+ * @class HttpTransport
+ * @brief HTTP传输层接口
+ *
+ * 负责连接、发送、响应解压和分块读取，解压后的数据按到达顺序交给回调，
+ * 上层只处理请求体和响应体内容。实现可以是真实网络或录制/回放等装饰器
+ */
+class HttpTransport
+{
+public:
+    /**
+     * @brief 响应数据回调（数据仅在回调期间有效）
+     */
+    using DataCallback = std::function<void(const char* data, size_t length)>;
+
+    virtual ~HttpTransport() = default;
+
+    /**
+     * @brief 发送请求并流式接收响应
+     * @param request 请求描述
+     * @param onData 响应数据回调（解压后）
+     * @param result 输出结果与传输统计
+     * @return 完整收到响应返回true（不论状态码），失败时result.failure指明阶段
+     */
+    virtual bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) = 0;
+};
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @enum CaseStyle
+ * @brief 标识符命名风格
+ */
+enum class CaseStyle
+{
+    None,           // 保持模型原样输出（用于英译中等非标识符场景）
+    Pascal,         // GetObjectName
+    Camel,          // getObjectName
+    Snake,          // get_object_name
+    ScreamingSnake, // GET_OBJECT_NAME
+    Kebab           // get-object-name
+};
+
+/**
+ * @class IdentifierCase
+ * @brief 标识符命名风格转换引擎（不依赖Windows API）
+ *
+ * 将模型返回的普通英文译文（如 "get object name"、"HTTP request handler"）
+ * 在本地确定性地转换为指定命名风格，同一份缓存的译文可服务所有风格。
+ *
+ * 分词规则：
+ * - 非字母数字的ASCII字符（空格、标点、下划线、连字符等）为分隔符，单词内的撇号直接删除
+ * - 小写到大写处断开（getName -> get Name），连续大写在最后一个大写字母前断开（HTTPServer -> HTTP Server）
+ * - 数字与前面的字母相连（utf8 Decoder、v2），位于单词开头的数字单独成词
+ * - 非ASCII字符视为单词字符原样保留，不做大小写转换
+ *
+ * 缩写处理：输入中全大写且长度至少为2的单词（HTTP、ID）在Pascal/Camel风格下保持全大写
+ * （camelCase的首个单词除外，统一小写）
+ */
+class IdentifierCase
+{
+public:
+    /**
+     * @brief 解析风格名称（Pascal、Camel、Snake、ScreamingSnake、Kebab、None，不区分大小写）
+     * @param name 风格名称
+     * @param style 输出风格
+     * @return 解析成功返回true，失败返回false
+     */
+    static bool ParseStyle(const std::string& name, CaseStyle& style);
+
+    /**
+     * @brief 转换为指定命名风格
+     * @param text UTF-8编码的英文译文
+     * @param style 目标风格
+     * @param out 输出结果（会先清空，复用其容量）；style为None时原样复制
+     */
+    static void Convert(const std::string& text, CaseStyle style, std::string& out);
+
+    /**
+     * @brief 判断文本是否适合转换为标识符（仅含ASCII字符）
+     * @param text UTF-8文本
+     * @return 全部为ASCII字符返回true；含中文等非ASCII字符（英译中结果）返回false
+     */
+    static bool IsAsciiText(const std::string& text);
+
+private:
+    // 分词结果：每个单词为 [begin, end) 区间
+    struct WordSpan
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    /**
+     * @brief 将文本切分为单词
+     * @param text 输入文本（撇号已删除）
+     * @param words 输出单词区间（会先清空）
+     */
+    static void SplitWords(const std::string& text, std::vector<WordSpan>& words);
+};
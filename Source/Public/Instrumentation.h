@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @class Instrumentation
+ * @brief 运行指标收集（不依赖Windows API）
+ *
+ * 提供启动时间线（各启动阶段相对进程启动即CRT初始化时刻的耗时）以及命名计数器和数值指标，
+ * 供各模块上报运行状态。所有方法线程安全
+ */
+class Instrumentation
+{
+public:
+    /**
+     * @brief 记录一个启动阶段完成
+     * @param phase 阶段名称（例如 "hotkey"、"session"）
+     */
+    static void MarkStartup(const char* phase);
+
+    /**
+     * @brief 格式化启动时间线，例如 "config=0.4ms hotkey=0.6ms tray=2.1ms ..."
+     * @return 时间线文本
+     */
+    static std::string FormatStartupTimeline();
+
+    /**
+     * @brief 累加计数器
+     * @param name 计数器名称
+     * @param delta 增量
+     */
+    static void AddCounter(const std::string& name, int64_t delta = 1);
+
+    /**
+     * @brief 读取计数器
+     * @param name 计数器名称
+     * @return 当前值，不存在时为0
+     */
+    static int64_t GetCounter(const std::string& name);
+
+    /**
+     * @brief 设置数值指标（覆盖旧值）
+     * @param name 指标名称
+     * @param value 数值
+     */
+    static void SetGauge(const std::string& name, double value);
+
+    /**
+     * @brief 格式化全部计数器和数值指标，每项一行 "名称=值"
+     * @return 指标文本
+     */
+    static std::string FormatReport();
+
+    /**
+     * @brief 追加一行带时间戳的文本到日志文件（用于跨版本跟踪启动耗时等）
+     * @param path 日志文件路径（UTF-8）
+     * @param line 文本行（不含换行符）
+     * @return 成功返回true
+     */
+    static bool AppendLine(const std::string& path, const std::string& line);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static Clock::time_point s_startupOrigin;
+    static std::vector<std::pair<std::string, double>> s_startupPhases;    // （阶段，毫秒）
+    static std::map<std::string, int64_t> s_counters;
+    static std::map<std::string, double> s_gauges;
+    static std::mutex s_mutex;
+};
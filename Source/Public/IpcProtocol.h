@@ -0,0 +1,172 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum IpcFrameType
+ * @brief 本地IPC帧类型（客户端请求 0x01-0x7F，服务端应答 0x81-0xFF）
+ */
+enum class IpcFrameType : uint8_t
+{
+    Translate = 0x01,   // 翻译一段文本：配置档名称、原文；应答一个Result
+    Batch = 0x02,       // 批量翻译：配置档名称、条数、逐条原文；每条完成时应答一个Result（完成顺序），最后应答Done
+    Cancel = 0x03,      // 取消同一请求编号中尚未开始的条目，无负载
+    Stream = 0x04,      // 流式翻译一段文本：负载同Translate；译文到达时应答Partial，最后应答一个Result
+    Result = 0x81,      // 一条译文：条目索引、状态、译文或错误信息
+    Done = 0x82,        // 批量请求结束：条数
+    Error = 0x83,       // 请求无法执行：错误信息
+    Partial = 0x84      // 流式译文片段：片段在原始译文中的字节偏移、片段
+};
+
+/**
+ * @enum IpcStatus
+ * @brief Result帧中的条目状态
+ */
+enum class IpcStatus : uint8_t
+{
+    Ok = 0,             // 翻译成功
+    Cached = 1,         // 由缓存或术语表直接得到
+    Failed = 2,         // 翻译失败，文本为错误信息
+    Cancelled = 3       // 被取消或服务正在退出
+};
+
+/**
+ * @struct IpcFrame
+ * @brief 解码后的一帧
+ */
+struct IpcFrame
+{
+    IpcFrameType type = IpcFrameType::Error;
+    uint32_t requestId = 0;         // 客户端选择的请求编号，应答原样带回，同一连接上可以同时有多个请求
+    std::string payload;
+};
+
+/**
+ * @class IpcProtocol
+ * @brief 本地IPC的帧格式（不依赖Windows API）
+ *
+ * 每帧为12字节小端帧头加负载：负载长度(u32)、类型(u8)、协议版本(u8)、保留(u16)、请求编号(u32)。
+ * 负载由u32整数和字符串（u32字节数加UTF-8字节）依次拼接，没有分隔符和转义，
+ * 一条Batch请求即可携带上千条原文
+ */
+class IpcProtocol
+{
+public:
+    static const uint8_t VERSION = 1;
+    static const size_t HEADER_SIZE = 12;
+
+    // 单帧负载上限，超出时视为协议错误并断开连接
+    static const uint32_t MAX_PAYLOAD = 16 * 1024 * 1024;
+
+    /**
+     * @brief 编码一帧并追加到输出
+     * @param type 帧类型
+     * @param requestId 请求编号
+     * @param payload 负载
+     * @param out 追加到的输出
+     */
+    static void EncodeFrame(IpcFrameType type, uint32_t requestId, const std::string& payload, std::string& out);
+
+    /**
+     * @brief 向负载追加u32
+     * @param value 值
+     * @param payload 负载
+     */
+    static void PutU32(uint32_t value, std::string& payload);
+
+    /**
+     * @brief 向负载追加字符串
+     * @param text UTF-8文本
+     * @param payload 负载
+     */
+    static void PutString(const std::string& text, std::string& payload);
+
+    /**
+     * @brief 从负载读取u32
+     * @param payload 负载
+     * @param offset 读取位置，成功后前移
+     * @param value 输出值
+     * @return 剩余字节足够返回true
+     */
+    static bool ReadU32(const std::string& payload, size_t& offset, uint32_t& value);
+
+    /**
+     * @brief 从负载读取字符串
+     * @param payload 负载
+     * @param offset 读取位置，成功后前移
+     * @param text 输出文本
+     * @return 剩余字节足够返回true
+     */
+    static bool ReadString(const std::string& payload, size_t& offset, std::string& text);
+
+    /**
+     * @brief 编码Result帧
+     * @param requestId 请求编号
+     * @param index 条目索引（Translate请求为0）
+     * @param status 状态
+     * @param text 译文或错误信息（UTF-8）
+     * @param out 追加到的输出
+     */
+    static void EncodeResult(uint32_t requestId, uint32_t index, IpcStatus status, const std::string& text, std::string& out);
+
+    /**
+     * @brief 编码Partial帧
+     * @param requestId 请求编号
+     * @param offset 片段在原始译文中的字节偏移（小于客户端已收到的长度时表示服务端重试，客户端先截断到该位置）
+     * @param data 片段（UTF-8，不含不完整的字符）
+     * @param length 片段字节数
+     * @param out 追加到的输出
+     */
+    static void EncodePartial(uint32_t requestId, uint32_t offset, const char* data, size_t length, std::string& out);
+
+    /**
+     * @brief 获取不以不完整字符结尾的最长前缀长度（流式译文可能断在多字节字符中间）
+     * @param text UTF-8文本
+     * @return 字节数
+     */
+    static size_t CompleteUtf8Length(const std::string& text);
+};
+
+/**
+ * @class IpcFrameDecoder
+ * @brief 增量帧解码器 - 从字节流中切出完整的帧
+ *
+ * 管道读取到的字节块可以在任意位置断开，解码器缓存不完整的帧，已取出的字节在缓冲区过半时整体前移
+ */
+class IpcFrameDecoder
+{
+public:
+    /**
+     * @brief 追加收到的字节
+     * @param data 数据
+     * @param length 字节数
+     */
+    void Feed(const char* data, size_t length);
+
+    /**
+     * @brief 取出下一帧
+     * @param frame 输出帧
+     * @return 有完整的帧返回true；数据不足或出现协议错误返回false
+     */
+    bool Next(IpcFrame& frame);
+
+    /**
+     * @brief 是否出现协议错误（版本不符或负载超过上限），出错后不再解码
+     * @return 出错返回true
+     */
+    bool HasError() const { return m_bError; }
+
+    /**
+     * @brief 获取缓存中未解码的字节数
+     * @return 字节数
+     */
+    size_t GetBufferedSize() const { return m_buffer.length() - m_offset; }
+
+private:
+    std::string m_buffer;
+    size_t m_offset = 0;
+    bool m_bError = false;
+};
@@ -0,0 +1,162 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "IpcProtocol.h"
+#include "TranslationProfile.h"
+
+/**
+ * @class IpcServer
+ * @brief 本地IPC翻译服务 - 编辑器插件和脚本通过命名管道复用常驻进程的连接、缓存和配额
+ *
+ * 管道名为 \\.\pipe\YunsioTranslation.<会话ID>，只接受本机客户端。每个连接一个读取线程，
+ * 请求交给TranslationManager的调度器：Translate和Stream作为客户端请求（排在热键翻译之后，不占用其名额），
+ * Batch的每一条作为后台请求（热键翻译和客户端请求到来时让路）。应答由完成请求的工作线程直接写回，同一连接上的多个请求可以交错完成。
+ * ApplyConfig和Cleanup在主线程上调用
+ */
+class IpcServer
+{
+public:
+    /**
+     * @brief 按当前配置启动或停止服务（启动时和配置热重载后调用）
+     */
+    static void ApplyConfig();
+
+    /**
+     * @brief 停止服务：不再接受连接，断开所有客户端并限时等待读取线程退出
+     *
+     * 已提交给调度器的请求由TranslationManager::Cleanup排空，写回时连接已关闭则直接丢弃
+     * @param timeoutMs 等待读取线程退出的最长时间（毫秒）
+     */
+    static void Cleanup(DWORD timeoutMs = 1000);
+
+    /**
+     * @brief 获取当前会话的管道名
+     * @return 管道名
+     */
+    static std::wstring GetPipeName();
+
+private:
+    /**
+     * @struct Generation
+     * @brief 一次启动的服务状态，由监听线程、读取线程和连接共同持有
+     *
+     * 停止时读取线程可能超时未退出，它们继续使用本代的事件；重新启动创建新的一代，两代互不影响
+     */
+    struct Generation
+    {
+        HANDLE hStopEvent = nullptr;            // 停止事件（手动重置），读取线程和写出也等待它
+        HANDLE hClientsIdle = nullptr;          // 本代所有读取线程已退出（手动重置）
+        std::atomic<int> clientCount{ 0 };      // 本代当前连接数
+
+        ~Generation();
+    };
+
+    /**
+     * @struct Connection
+     * @brief 一个客户端连接，由读取线程和尚未完成的请求共同持有
+     */
+    struct Connection
+    {
+        HANDLE hPipe = INVALID_HANDLE_VALUE;
+        std::shared_ptr<Generation> generation; // 所属的一代服务
+        std::atomic<bool> closed{ false };
+        std::mutex writeMutex;                  // 应答整帧写出，不同请求的帧不会交错
+        std::mutex requestMutex;
+        std::unordered_map<uint32_t, std::shared_ptr<std::atomic<bool>>> requests;   // 进行中的请求编号及其取消标志
+
+        ~Connection();
+    };
+
+    /**
+     * @brief 启动监听线程
+     * @return 成功返回true
+     */
+    static bool Start();
+
+    /**
+     * @brief 停止监听线程和所有读取线程
+     * @param timeoutMs 等待读取线程退出的最长时间（毫秒）
+     */
+    static void Stop(DWORD timeoutMs);
+
+    /**
+     * @brief 监听线程：逐个创建管道实例并等待客户端连接
+     * @param param Generation的shared_ptr（由线程释放）
+     * @return 线程退出码
+     */
+    static DWORD WINAPI ListenThreadProc(LPVOID param);
+
+    /**
+     * @brief 读取线程：解码请求帧并分发
+     * @param param Connection的shared_ptr（由线程释放）
+     * @return 线程退出码
+     */
+    static DWORD WINAPI ClientThreadProc(LPVOID param);
+
+    /**
+     * @brief 等待重叠I/O完成，停止事件触发时取消I/O
+     * @param generation 所属的一代服务
+     * @param hPipe 管道句柄
+     * @param overlapped 重叠结构
+     * @param transferred 输出传输的字节数
+     * @return I/O成功完成返回true
+     */
+    static bool WaitForIo(const Generation& generation, HANDLE hPipe, OVERLAPPED& overlapped, DWORD& transferred);
+
+    /**
+     * @brief 向客户端写出完整的帧（线程安全）
+     * @param connection 连接
+     * @param frames 已编码的帧
+     * @return 成功返回true
+     */
+    static bool Send(Connection& connection, const std::string& frames);
+
+    /**
+     * @brief 向客户端写出错误帧
+     * @param connection 连接
+     * @param requestId 请求编号
+     * @param message 错误信息（UTF-8）
+     */
+    static void SendError(Connection& connection, uint32_t requestId, const std::string& message);
+
+    /**
+     * @brief 处理一个请求帧
+     * @param connection 连接
+     * @param frame 请求帧
+     * @return 帧格式正确返回true；格式错误时返回false并断开连接
+     */
+    static bool HandleFrame(const std::shared_ptr<Connection>& connection, const IpcFrame& frame);
+
+    /**
+     * @brief 提交一条翻译
+     * @param connection 连接
+     * @param requestId 请求编号
+     * @param index 条目索引
+     * @param count 请求的总条数
+     * @param profile 翻译配置档
+     * @param text 原文（UTF-8）
+     * @param cancelled 请求的取消标志
+     * @param remaining 请求尚未完成的条数，降为0时发送Done（Translate和Stream请求为nullptr）
+     * @param stream 是否在译文到达时写出Partial帧（Stream请求）
+     * @return 已排队返回true
+     */
+    static bool SubmitItem(const std::shared_ptr<Connection>& connection, uint32_t requestId, uint32_t index, uint32_t count,
+        std::shared_ptr<const TranslationProfile> profile, std::string text,
+        std::shared_ptr<std::atomic<bool>> cancelled, std::shared_ptr<std::atomic<uint32_t>> remaining, bool stream);
+
+    /**
+     * @brief 请求的全部条目完成后注销请求编号
+     * @param connection 连接
+     * @param requestId 请求编号
+     */
+    static void FinishRequest(Connection& connection, uint32_t requestId);
+
+    static HANDLE s_hListenThread;                      // 监听线程句柄
+    static std::shared_ptr<Generation> s_generation;    // 运行中的一代服务（仅主线程访问）
+    static std::atomic<int> s_maxClients;               // 连接数上限
+};
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <cstdint>
+
+/**
+ * @class ModifierTracker
+ * @brief 热键修饰键的释放跟踪（不依赖Windows API）
+ *
+ * 热键触发时用户通常还按着Ctrl、Shift等修饰键，此时模拟Ctrl+C会变成Ctrl+Shift+C之类的
+ * 其他快捷键。触发后按物理键（左右分开）记录仍按下的修饰键，由键盘事件逐个清除，
+ * 需要等待的修饰键全部释放的那一刻即可取词；超过期限仍未释放时也结束等待，避免热键失去响应
+ */
+class ModifierTracker
+{
+public:
+    /**
+     * @enum State
+     * @brief 等待状态
+     */
+    enum class State
+    {
+        Idle,           // 未在等待
+        Waiting,        // 仍有修饰键按下
+        Released,       // 修饰键已全部释放
+        TimedOut        // 到达期限仍有修饰键按下
+    };
+
+    /**
+     * @brief 获取虚拟键码对应的修饰键（HotkeyBinding::MOD_*_FLAG）
+     * @param virtualKey 虚拟键码（左右键码或通用键码）
+     * @return 修饰键标志，不是修饰键返回0
+     */
+    static uint32_t ModifierOf(uint32_t virtualKey);
+
+    /**
+     * @brief 开始等待（清除之前的记录）
+     * @param now 当前时间（毫秒）
+     * @param timeoutMs 最长等待时间（毫秒）
+     * @param modifiers 需要等待释放的修饰键（HotkeyBinding::MOD_*_FLAG的组合），其余修饰键的事件忽略
+     */
+    void Arm(uint64_t now, uint32_t timeoutMs, uint32_t modifiers);
+
+    /**
+     * @brief 处理一个键盘事件（开始等待后用当前按下的修饰键各调用一次按下事件作为初始状态）
+     * @param virtualKey 虚拟键码
+     * @param keyDown 按下为true，抬起为false
+     * @return 处理后的状态
+     */
+    State OnKey(uint32_t virtualKey, bool keyDown);
+
+    /**
+     * @brief 检查是否已全部释放或到达期限（初始状态设置完成后和定时器到期时调用）
+     * @param now 当前时间（毫秒）
+     * @return 检查后的状态
+     */
+    State OnTick(uint64_t now);
+
+    /**
+     * @brief 结束等待，回到Idle
+     */
+    void Reset();
+
+    /**
+     * @brief 获取当前状态
+     * @return 状态
+     */
+    State GetState() const { return m_state; }
+
+    /**
+     * @brief 获取仍按下的修饰键（HotkeyBinding::MOD_*_FLAG的组合）
+     * @return 修饰键标志
+     */
+    uint32_t GetHeldModifiers() const;
+
+private:
+    State m_state = State::Idle;
+    uint32_t m_heldKeys = 0;        // 仍按下的物理修饰键，每个键一位（见KeyBit）
+    uint32_t m_modifiers = 0;       // 需要等待释放的修饰键
+    uint64_t m_deadline = 0;
+};
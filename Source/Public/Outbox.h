@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @struct OutboxEntry
+ * @brief 离线队列中等待重新翻译的请求
+ */
+struct OutboxEntry
+{
+    uint64_t id = 0;            // 本次运行内的唯一编号
+    std::string profile;        // 配置档名称
+    std::string source;         // 原文（UTF-8）
+    int attempts = 0;           // 已失败的重放次数
+};
+
+/**
+ * @class Outbox
+ * @brief 离线队列 - 保存网络不可用时失败的非交互翻译请求，恢复后重放（不依赖Windows API）
+ *
+ * 队列内容在每次变化后写入文件，重启后继续重放。重放失败按指数退避推迟
+ * （5秒起，每次翻倍，最长10分钟），失败次数达到上限的请求被丢弃。所有方法线程安全
+ */
+class Outbox
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 队列最大条目数，超出时丢弃最早的请求
+    static const size_t MAX_ENTRIES = 200;
+
+    // 单个请求最多重放的次数
+    static const int MAX_ATTEMPTS = 8;
+
+    /**
+     * @brief 从文件加载队列，加载的请求立即可以重放
+     * @param path 队列文件路径（UTF-8）
+     */
+    static void Initialize(const std::string& path);
+
+    /**
+     * @brief 清空内存中的队列（文件保留，下次启动继续重放）
+     */
+    static void Cleanup();
+
+    /**
+     * @brief 加入队列，相同配置档和原文的请求只保留一条
+     * @param profile 配置档名称
+     * @param source 原文（UTF-8）
+     * @return 新加入返回true，已在队列中返回false
+     */
+    static bool Enqueue(const std::string& profile, const std::string& source);
+
+    /**
+     * @brief 取出一条已到重放时间的请求，取出的请求在Complete/Retry/Release之前不会再被取出
+     * @param now 当前时间
+     * @param entry 输出请求
+     * @return 有到期请求返回true
+     */
+    static bool TakeDue(Clock::time_point now, OutboxEntry& entry);
+
+    /**
+     * @brief 重放成功，从队列移除
+     * @param id 请求编号
+     */
+    static void Complete(uint64_t id);
+
+    /**
+     * @brief 重放失败，按退避时间推迟；失败次数达到上限时丢弃
+     * @param id 请求编号
+     * @param now 当前时间
+     */
+    static void Retry(uint64_t id, Clock::time_point now);
+
+    /**
+     * @brief 重放被中断（不计失败次数），放回队列立即可以再次取出
+     * @param id 请求编号
+     */
+    static void Release(uint64_t id);
+
+    /**
+     * @brief 是否有已到重放时间且未被取出的请求
+     * @param now 当前时间
+     * @return 有返回true
+     */
+    static bool HasDue(Clock::time_point now);
+
+    /**
+     * @brief 获取队列中的请求数
+     * @return 请求数
+     */
+    static size_t GetCount();
+
+    /**
+     * @brief 计算第attempts次失败后的退避时间
+     * @param attempts 已失败次数（从1开始）
+     * @return 退避时间
+     */
+    static Clock::duration GetBackoff(int attempts);
+
+private:
+    // 队列中的请求及其调度状态
+    struct Slot
+    {
+        OutboxEntry entry;
+        Clock::time_point dueTime;
+        bool taken = false;
+    };
+
+    /**
+     * @brief 按编号查找请求（调用方持有锁）
+     * @param id 请求编号
+     * @return 找到返回下标，否则返回SIZE_MAX
+     */
+    static size_t FindLocked(uint64_t id);
+
+    /**
+     * @brief 将队列写入文件并上报队列长度（调用方持有锁）
+     */
+    static void SaveLocked();
+
+    static std::vector<Slot> s_slots;
+    static std::string s_path;
+    static uint64_t s_nextId;
+    static std::mutex s_mutex;
+};
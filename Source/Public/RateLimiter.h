@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @struct DailyUsage
+ * @brief 当日累计用量（跨进程重启保留，日期变化时清零）
+ */
+struct DailyUsage
+{
+    std::string date;               // 本地日期 YYYY-MM-DD
+    int64_t requests = 0;
+    int64_t promptTokens = 0;
+    int64_t completionTokens = 0;
+};
+
+/**
+ * @class RateLimiter
+ * @brief 客户端请求速率和token配额限制（不依赖Windows API）
+ *
+ * 每分钟请求数和每分钟token数各用一个令牌桶，容量为每分钟配额，按配额/60每秒匀速补充。
+ * 每次向服务端发送请求前扣除一个请求令牌（超时后的重试同样扣除）；token数在请求前未知，
+ * 响应解析出usage后再扣除，桶可以被扣成负数，之后的请求等到补充回正数才发送。
+ * 配额暂时用完时发送请求的线程等待而不是失败。当日用量先在内存中累计，由Flush（定时调用和Cleanup）
+ * 在不持有限流锁的情况下合并写入用量文件；文件可被多个进程共用，保存时合并各进程的增量。
+ * 所有方法线程安全
+ */
+class RateLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 建议的当日用量保存间隔（毫秒）
+    static const int FLUSH_INTERVAL_MS = 30000;
+
+    /**
+     * @brief 加载当日累计用量
+     * @param statePath 用量文件路径（UTF-8），文件不存在或日期不是今天时从零开始
+     */
+    static void Initialize(const std::string& statePath);
+
+    /**
+     * @brief 保存当日累计用量
+     */
+    static void Cleanup();
+
+    /**
+     * @brief 把上次保存以来的用量合并进用量文件（文件读写期间不持有限流锁，获取配额不会等待磁盘）
+     * @return 已保存或没有需要保存的用量返回true；拿不到文件锁或写入失败返回false，增量留到下次保存
+     */
+    static bool Flush();
+
+    /**
+     * @brief 设置配额（配置热重载时调用），新启用的桶按满桶开始
+     * @param requestsPerMinute 每分钟请求数，0表示不限
+     * @param tokensPerMinute 每分钟token数，0表示不限
+     */
+    static void SetLimits(int requestsPerMinute, int tokensPerMinute);
+
+    /**
+     * @brief 尝试为一个请求获取配额
+     * @param now 当前时间
+     * @param retryTime 配额不足时输出可重试的时间
+     * @return 获取成功返回true（已扣除一个请求令牌）
+     */
+    static bool TryAcquire(Clock::time_point now, Clock::time_point& retryTime);
+
+    /**
+     * @brief 为一个请求获取配额，配额不足时等待（每ACQUIRE_POLL检查一次取消信号）
+     * @param cancel 取消信号，可为nullptr
+     * @return 获取成功返回true，等待期间被取消返回false
+     */
+    static bool Acquire(const std::atomic<bool>* cancel);
+
+    /**
+     * @brief 按响应中的usage扣除token配额并累加当日用量
+     * @param promptTokens 输入token数
+     * @param completionTokens 输出token数
+     */
+    static void RecordUsage(int64_t promptTokens, int64_t completionTokens);
+
+    /**
+     * @brief 服务端返回429（请求过多）时调用：清空请求令牌并暂停一段时间
+     */
+    static void OnThrottled();
+
+    /**
+     * @brief 获取当日累计用量
+     * @return 当日用量
+     */
+    static DailyUsage GetDailyUsage();
+
+private:
+    // 令牌桶
+    struct Bucket
+    {
+        double capacity = 0;            // 容量（每分钟配额），0表示不限
+        double level = 0;               // 当前令牌数，可以为负
+        Clock::time_point lastRefill;
+
+        void Configure(int perMinute, Clock::time_point now);
+        void Refill(Clock::time_point now);
+        double SecondsUntil(double target) const;
+    };
+
+    /**
+     * @brief 日期变化时清零当日用量（调用方持有锁）
+     */
+    static void RollDate();
+
+    /**
+     * @brief 读取用量文件（调用方持有文件锁）
+     * @param path 用量文件路径（UTF-8）
+     * @param usage 文件中的日期与usage.date相同时输出文件中的用量
+     */
+    static void LoadDaily(const std::string& path, DailyUsage& usage);
+
+    /**
+     * @brief 上报令牌桶和当日用量（调用方持有锁）
+     */
+    static void ReportGauges();
+
+    static Bucket s_requests;
+    static Bucket s_tokens;
+    static Clock::time_point s_pausedUntil;     // 429后暂停到此时间
+    static bool s_bDelaying;                    // 上次获取是否因配额不足失败（用于只计数一次延迟）
+    static DailyUsage s_daily;
+    static DailyUsage s_unsaved;                // 上次保存以来本进程新增的用量
+    static std::string s_statePath;
+    static std::mutex s_mutex;
+    static std::mutex s_flushMutex;             // 本进程内的保存依次进行（不与s_mutex同时等待）
+};
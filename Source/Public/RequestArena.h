@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "ResponseStream.h"
+#include "Glossary.h"
+#include "CodeLexer.h"
+#include "TranslationMemory.h"
+
+/**
+ * @class RequestArena
+ * @brief 单次翻译请求的临时缓冲区集合（不依赖Windows API）
+ *
+ * 每个线程持有一个实例，请求结束时只清空内容而保留容量，
+ * 稳定状态下一次翻译不再产生堆分配。单次超大请求把容量撑到上限以上时才真正释放
+ */
+class RequestArena
+{
+public:
+    // 请求结束后保留的最大总容量（字节），超出则释放全部缓冲区
+    static const size_t MAX_RETAINED_BYTES = 256 * 1024;
+
+    /**
+     * @brief 获取当前线程的缓冲区集合
+     * @return 线程局部实例
+     */
+    static RequestArena& ForCurrentThread();
+
+    /**
+     * @brief 清空全部缓冲区并保留容量，容量增长时上报到Instrumentation
+     */
+    void Reset();
+
+    /**
+     * @brief 获取全部缓冲区的总容量
+     * @return 字节数
+     */
+    size_t GetCapacityBytes() const;
+
+    std::string utf8Text;       // UTF-8编码的待翻译文本
+    std::vector<GlossaryMatch> glossaryMatches; // 待翻译文本中命中的术语
+    std::string requestText;    // 应用术语表和参考译文后实际发送的文本
+    MemoryMatch memoryMatch;    // 翻译记忆中与原文最相似的记录
+    std::vector<CodeSegment> codeSegments;      // 选中代码中的可翻译片段
+    std::string codeBatch;      // 代码片段的批量请求文本
+    std::string codeOutput;     // 译文写回后的代码
+    std::string deltaBatch;     // 改动句子的批量请求文本
+    std::string deltaOutput;    // 拼回后的整段译文
+    std::string body;           // JSON请求体
+    ByteRing responseRing;      // 响应数据环形缓冲区（固定容量）
+    ChatResponseParser parser;  // 增量响应解析器（持有反转义后的译文）
+    std::wstring result;        // 译文（UTF-16）
+
+private:
+    size_t m_retainedBytes = 0; // 上次Reset后保留的容量
+};
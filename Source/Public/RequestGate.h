@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @class RequestGate
+ * @brief 服务入口闸门 - 跟踪进行中的调用，关闭时等待其全部结束（不依赖Windows API）
+ *
+ * 服务的每个入口先通过闸门取得通行证，通行证析构时离开。Cleanup先关闭闸门并等待
+ * 进行中的调用结束，之后才能释放这些调用正在使用的句柄。
+ * 进入和离开只有一次原子操作，只有关闭后的最后一次离开会加锁唤醒等待方
+ */
+class RequestGate
+{
+public:
+    /**
+     * @class Pass
+     * @brief 通行证，持有期间计入进行中的调用（只能移动）
+     */
+    class Pass
+    {
+    public:
+        Pass() = default;
+        Pass(Pass&& other) noexcept : m_pGate(other.m_pGate) { other.m_pGate = nullptr; }
+        Pass& operator=(Pass&& other) noexcept;
+        ~Pass() { Release(); }
+
+        Pass(const Pass&) = delete;
+        Pass& operator=(const Pass&) = delete;
+
+        /**
+         * @brief 是否成功进入
+         */
+        explicit operator bool() const { return m_pGate != nullptr; }
+
+        /**
+         * @brief 提前离开
+         */
+        void Release();
+
+    private:
+        friend class RequestGate;
+        explicit Pass(RequestGate* gate) : m_pGate(gate) {}
+
+        RequestGate* m_pGate = nullptr;
+    };
+
+    RequestGate() = default;
+
+    RequestGate(const RequestGate&) = delete;
+    RequestGate& operator=(const RequestGate&) = delete;
+
+    /**
+     * @brief 打开闸门，之后的TryEnter可以成功
+     */
+    void Open();
+
+    /**
+     * @brief 尝试进入
+     * @return 闸门打开时返回有效通行证，否则返回空通行证
+     */
+    Pass TryEnter();
+
+    /**
+     * @brief 关闭闸门并等待进行中的调用全部离开
+     * @param timeout 最长等待时间
+     * @return 全部离开返回true，超时返回false（闸门保持关闭）
+     */
+    bool CloseAndDrain(std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+
+    /**
+     * @brief 闸门是否打开
+     * @return 打开返回true
+     */
+    bool IsOpen() const;
+
+    /**
+     * @brief 获取进行中的调用数
+     * @return 调用数
+     */
+    uint32_t GetInFlight() const;
+
+private:
+    // 最高位为打开标志，其余位为进行中的调用数
+    static const uint32_t OPEN_FLAG = 0x80000000u;
+
+    /**
+     * @brief 离开闸门
+     */
+    void Leave();
+
+    std::atomic<uint32_t> m_state{ 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_drained;
+};
@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 请求优先级
+ */
+enum class RequestPriority
+{
+    Interactive,    // 热键触发，用户正在等待结果
+    Client,         // 本地IPC客户端的单条翻译，有人等待结果但不能挤占热键的名额
+    Background      // 预连接、批量翻译、缓存预热等后台工作
+};
+
+/**
+ * @class RequestScheduler
+ * @brief 按优先级调度网络请求的工作线程池（不依赖Windows API）
+ *
+ * 三类请求各有独立的并发上限和队列。有交互请求排队时其他请求都不会被启动，交互请求不排在客户端请求之后；
+ * 只要有交互或客户端请求在排队或执行，后台请求就不会被启动，正在执行的后台请求收到取消信号，中断后重新排到后台队首。
+ * 调度器只管并发，不扣除配额：任务可能不访问网络（术语表加载、缓存命中），也可能发出多个请求，
+ * RateLimiter的配额由TranslationService在每次发送请求前获取
+ */
+class RequestScheduler
+{
+public:
+    /**
+     * @brief 请求任务
+     * @param cancelled 取消信号（被抢占或调度器停止时置位），任务应尽快检查并返回
+     * @return 执行完毕返回true；因取消而中断返回false（被抢占的后台任务会重新排队）
+     */
+    using Job = std::function<bool(const std::atomic<bool>& cancelled)>;
+
+    /**
+     * @brief 并发设置
+     */
+    struct Limits
+    {
+        int interactiveConcurrency = 2;     // 同时执行的交互请求数上限
+        int clientConcurrency = 1;          // 同时执行的客户端请求数上限
+        int backgroundConcurrency = 1;      // 同时执行的后台请求数上限
+    };
+
+    RequestScheduler() = default;
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    /**
+     * @brief 按并发上限创建工作线程
+     * @param limits 并发设置（可用SetLimits调整）
+     * @return 成功返回true，已启动时返回false
+     */
+    bool Start(const Limits& limits);
+
+    /**
+     * @brief 调整运行中的调度器的并发上限（配置热重载时调用），执行中的任务不受影响
+     * @param limits 并发设置
+     */
+    void SetLimits(const Limits& limits);
+
+    /**
+     * @brief 停止调度器：丢弃排队任务，限时等待执行中的任务完成，超时后发出取消信号再限时等待
+     * @param drainTimeout 等待执行中的任务自然完成的最长时间，0表示立即取消
+     * @param cancelTimeout 发出取消信号后等待的最长时间
+     * @return 工作线程全部退出返回true；仍有任务阻塞时返回false，此时调度器不可再用，调用方应结束进程
+     */
+    bool Stop(std::chrono::milliseconds drainTimeout = std::chrono::milliseconds::zero(),
+        std::chrono::milliseconds cancelTimeout = std::chrono::milliseconds::max());
+
+    /**
+     * @brief 提交任务
+     * @param priority 优先级
+     * @param job 任务，在工作线程上执行
+     * @return 已排队返回true，调度器未启动时返回false
+     */
+    bool Submit(RequestPriority priority, Job job);
+
+    /**
+     * @brief 获取排队中的任务数
+     * @param priority 优先级
+     * @return 任务数
+     */
+    size_t GetQueuedCount(RequestPriority priority) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 排队或执行中的任务
+    struct Task
+    {
+        RequestPriority priority;
+        Job job;
+        Clock::time_point submitTime;
+        std::atomic<bool> cancelled{ false };
+    };
+
+    /**
+     * @brief 工作线程主循环
+     */
+    void WorkerLoop();
+
+    /**
+     * @brief 按并发上限补足工作线程（调用方持有锁）
+     */
+    void AddWorkers();
+
+    /**
+     * @brief 获取某一优先级的排队队列
+     * @param priority 优先级
+     * @return 队列
+     */
+    std::deque<std::shared_ptr<Task>>& QueueOf(RequestPriority priority);
+
+    /**
+     * @brief 获取某一优先级执行中的任务数
+     * @param priority 优先级
+     * @return 任务数
+     */
+    int& RunningOf(RequestPriority priority);
+
+    /**
+     * @brief 取出下一个可以启动的任务（调用方持有锁）
+     * @return 任务，暂无可启动任务时返回nullptr
+     */
+    std::shared_ptr<Task> TakeNextTask();
+
+    /**
+     * @brief 向正在执行的后台任务发出取消信号（调用方持有锁）
+     */
+    void PreemptBackground();
+
+    /**
+     * @brief 上报排队长度和执行数（调用方持有锁）
+     */
+    void ReportGauges() const;
+
+    Limits m_limits;
+    bool m_bRunning = false;
+    bool m_bStopping = false;
+    int m_runningInteractive = 0;
+    int m_runningClient = 0;
+    int m_runningBackground = 0;
+    std::deque<std::shared_ptr<Task>> m_interactiveQueue;
+    std::deque<std::shared_ptr<Task>> m_clientQueue;
+    std::deque<std::shared_ptr<Task>> m_backgroundQueue;
+    std::vector<std::shared_ptr<Task>> m_running;           // 执行中的任务（用于发出取消信号）
+    std::vector<std::thread> m_workers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+};
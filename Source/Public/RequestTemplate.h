@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <string>
+
+struct TranslationProfile;
+
+/**
+ * @class RequestTemplate
+ * @brief 预构建的请求体模板（不依赖Windows API）
+ *
+ * 请求体中除用户文本外的部分（模型、温度、系统提示词等）在配置档加载时一次性
+ * 拼接并转义好，翻译时只需 前缀 + 转义后的用户文本 + 后缀，避免每次请求重复构建。
+ * 前缀（含系统提示词）在配置档生命周期内逐字节不变，请求相关的内容只出现在用户消息中，
+ * 使服务端的前缀缓存可以命中
+ */
+class RequestTemplate
+{
+public:
+    /**
+     * @brief 根据配置档构建请求体模板
+     * @param profile 配置档
+     */
+    explicit RequestTemplate(const TranslationProfile& profile);
+
+    /**
+     * @brief 使用配置档的模型参数和指定的系统提示词构建请求体模板
+     * @param profile 配置档
+     * @param systemPrompt 系统提示词
+     */
+    RequestTemplate(const TranslationProfile& profile, const std::string& systemPrompt);
+
+    /**
+     * @brief 生成完整请求体
+     * @param utf8Text UTF-8编码的待翻译文本
+     * @param body 输出请求体（会先清空，复用其容量）
+     * @param stream 是否要求服务端以SSE流式返回译文（前缀不变，不影响前缀缓存）
+     */
+    void BuildBody(const std::string& utf8Text, std::string& body, bool stream = false) const;
+
+    /**
+     * @brief 追加JSON转义后的字符串内容（不含两侧引号）
+     * @param out 输出缓冲区
+     * @param data UTF-8数据
+     * @param length 数据长度
+     */
+    static void AppendJsonEscaped(std::string& out, const char* data, size_t length);
+
+    const std::string& GetPrefix() const { return m_prefix; }
+    const std::string& GetSuffix() const { return m_suffix; }
+
+private:
+    std::string m_prefix;   // 用户文本之前的部分（以 "content":" 结尾）
+    std::string m_suffix;   // 用户文本之后的部分
+    std::string m_streamSuffix;     // 流式请求的用户文本之后的部分
+};
@@ -0,0 +1,176 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "StreamingJson.h"
+
+/**
+ * @class ByteRing
+ * @brief 固定容量的环形字节缓冲区（不依赖Windows API）
+ *
+ * 网络数据直接读入可写区间，解析器就地消费可读区间，缓冲区分配一次后跨请求复用
+ */
+class ByteRing
+{
+public:
+    // 默认容量（字节）
+    static const size_t DEFAULT_CAPACITY = 16 * 1024;
+
+    /**
+     * @brief 构造缓冲区
+     * @param capacity 容量（字节）
+     */
+    explicit ByteRing(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief 获取连续的可写区间
+     * @param length 输出可写字节数（缓冲区已满时为0）
+     * @return 可写区间起始地址
+     */
+    char* GetWriteSpan(size_t& length);
+
+    /**
+     * @brief 提交已写入的字节
+     * @param length 字节数（不超过GetWriteSpan返回的长度）
+     */
+    void CommitWrite(size_t length);
+
+    /**
+     * @brief 获取连续的可读区间
+     * @param length 输出可读字节数（回绕时只返回到缓冲区末尾的部分）
+     * @return 可读区间起始地址
+     */
+    const char* GetReadSpan(size_t& length) const;
+
+    /**
+     * @brief 消费已读取的字节
+     * @param length 字节数（不超过GetReadSpan返回的长度）
+     */
+    void ConsumeRead(size_t length);
+
+    /**
+     * @brief 清空缓冲区（不释放内存）
+     */
+    void Reset();
+
+    /**
+     * @brief 获取未消费的字节数
+     * @return 字节数
+     */
+    size_t GetSize() const { return m_size; }
+
+    /**
+     * @brief 获取容量
+     * @return 字节数
+     */
+    size_t GetCapacity() const { return m_data.size(); }
+
+private:
+    std::vector<char> m_data;
+    size_t m_head = 0;      // 可读区起点
+    size_t m_size = 0;      // 未消费字节数
+};
+
+/**
+ * @brief 响应中的token用量（usage字段）
+ */
+struct TokenUsage
+{
+    bool reported = false;          // 响应是否包含usage
+    int64_t promptTokens = 0;       // 输入token数
+    int64_t completionTokens = 0;   // 输出token数
+    int64_t cachedTokens = 0;       // 输入中命中服务端前缀缓存的token数
+};
+
+/**
+ * @class ChatResponseParser
+ * @brief 聊天补全响应的增量解析器（不依赖Windows API）
+ *
+ * 同时支持普通JSON响应（choices[0].message.content）和SSE流式响应
+ * （每个 data: 事件中的 choices[0].delta.content 依次拼接），按首个非空白字符自动识别。
+ * 响应体可按任意边界分块送入，译文片段直接从输入数据追加到结果中，同时提取usage中的token用量
+ */
+class ChatResponseParser : private JsonHandler
+{
+public:
+    ChatResponseParser();
+
+    // 解析器持有指向自身的引用，禁止拷贝
+    ChatResponseParser(const ChatResponseParser&) = delete;
+    ChatResponseParser& operator=(const ChatResponseParser&) = delete;
+
+    /**
+     * @brief 重置以解析新响应（保留已分配的容量）
+     */
+    void Reset();
+
+    /**
+     * @brief 释放缓冲区内存
+     */
+    void ReleaseMemory();
+
+    /**
+     * @brief 送入一块响应数据
+     * @param data 数据
+     * @param length 长度
+     */
+    void Feed(const char* data, size_t length);
+
+    /**
+     * @brief 响应结束后判断是否得到完整译文
+     * @return 得到译文返回true
+     */
+    bool Finish() const;
+
+    /**
+     * @brief 获取译文（UTF-8）
+     * @return 译文
+     */
+    const std::string& GetContent() const { return m_content; }
+    std::string& GetContent() { return m_content; }
+
+    /**
+     * @brief 获取API返回的错误信息（error.message，UTF-8）
+     * @return 错误信息，无错误时为空
+     */
+    const std::string& GetErrorMessage() const { return m_errorMessage; }
+
+    /**
+     * @brief 获取token用量（usage.prompt_tokens、completion_tokens、prompt_tokens_details.cached_tokens）
+     * @return token用量
+     */
+    const TokenUsage& GetUsage() const { return m_usage; }
+
+    /**
+     * @brief 获取缓冲区占用的容量
+     * @return 字节数
+     */
+    size_t GetCapacityBytes() const { return m_content.capacity() + m_errorMessage.capacity(); }
+
+private:
+    enum class Mode { Unknown, Json, Sse };
+    enum class LineState { Start, Space, Data, Skip };
+
+    bool OnStringBegin(const JsonPath& path) override;
+    void OnStringFragment(std::string_view fragment) override;
+    void OnNumber(const JsonPath& path, std::string_view number) override;
+
+    /**
+     * @brief 按SSE格式处理数据
+     * @param data 数据
+     * @param length 长度
+     */
+    void FeedSse(const char* data, size_t length);
+
+    StreamingJsonParser m_json;
+    Mode m_mode = Mode::Unknown;
+    LineState m_lineState = LineState::Start;
+    size_t m_fieldLength = 0;           // 当前行已匹配的 "data:" 字符数
+    bool m_hasContent = false;          // 是否遇到过content字段
+    std::string* m_pTarget = nullptr;   // 当前字符串值的接收缓冲区
+    std::string m_content;
+    std::string m_errorMessage;
+    TokenUsage m_usage;
+};
@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class ResultPipeline
+ * @brief 译文后处理流水线 - 在输出之前清理模型输出（不依赖Windows API）
+ *
+ * 缓存、历史和翻译记忆保存原始译文，各配置档在读取之后按自己的流水线处理，
+ * 共享命名空间的配置档之间不会互相看到对方后处理的结果。
+ * 每个阶段都是独立的静态函数，直接在UTF-8译文缓冲区上原地修改（只删除或移动字节，
+ * 不产生堆分配；替换阶段的目标词比原词长时才可能扩容）。配置档在加载时确定启用的阶段，
+ * 此后只读，可在多个线程上同时使用。
+ *
+ * 面向标识符的阶段（Explanation、Period、Charset）只处理纯ASCII的译文（中译英方向），
+ * 英译中的中文译文原样保留
+ */
+class ResultPipeline
+{
+public:
+    static const uint32_t STAGE_TRIM = 0x01;           // 去除首尾空白（含全角空格和不换行空格）
+    static const uint32_t STAGE_FENCES = 0x02;         // 去除包裹全文的Markdown代码块标记
+    static const uint32_t STAGE_QUOTES = 0x04;         // 去除包裹全文的成对引号
+    static const uint32_t STAGE_EXPLANATION = 0x08;    // 去除模型附加的解释（后续行、末尾括号说明）
+    static const uint32_t STAGE_PERIOD = 0x10;         // 去除单行译文末尾的句点
+    static const uint32_t STAGE_CHARSET = 0x20;        // 只保留标识符字符（字母、数字、下划线和空格）
+
+    // 所有配置档默认启用的阶段（清理模型包在译文外的内容）
+    static const uint32_t DEFAULT_TEXT_STAGES = STAGE_TRIM | STAGE_FENCES | STAGE_QUOTES;
+
+    // 译文要转换为标识符的配置档另外默认启用的阶段（会去除句末标点）
+    static const uint32_t IDENTIFIER_STAGES = STAGE_EXPLANATION | STAGE_PERIOD | STAGE_CHARSET;
+
+    /**
+     * @struct Replacement
+     * @brief 译文中的整词替换（如模型习惯输出的缩写替换为项目约定的写法）
+     */
+    struct Replacement
+    {
+        std::string from;
+        std::string to;
+    };
+
+    ResultPipeline() = default;
+
+    /**
+     * @brief 构造流水线
+     * @param stages 启用的阶段（STAGE_*组合）
+     * @param maxLength 译文最大字符数，0表示不限
+     * @param replacements 整词替换表
+     */
+    ResultPipeline(uint32_t stages, size_t maxLength, std::vector<Replacement> replacements);
+
+    /**
+     * @brief 解析阶段列表（逗号分隔：Trim、Fences、Quotes、Explanation、Period、Charset，不区分大小写；None表示全部关闭）
+     * @param list 阶段列表
+     * @param stages 输出阶段组合
+     * @return 解析成功返回true
+     */
+    static bool ParseStages(const std::string& list, uint32_t& stages);
+
+    /**
+     * @brief 解析替换表（分号分隔的 原词>新词）
+     * @param list 替换表文本
+     * @param replacements 输出替换表
+     * @return 解析成功返回true
+     */
+    static bool ParseReplacements(const std::string& list, std::vector<Replacement>& replacements);
+
+    /**
+     * @brief 按固定顺序依次执行启用的阶段：代码块、解释、引号、句点、字符集、替换、长度（启用Trim时每个阶段后都去除首尾空白）
+     * @param text UTF-8译文，原地修改
+     */
+    void Apply(std::string& text) const;
+
+    /**
+     * @brief 获取启用的阶段
+     * @return STAGE_*组合
+     */
+    uint32_t GetStages() const { return m_stages; }
+
+    /**
+     * @brief 去除首尾空白
+     * @param text UTF-8文本
+     */
+    static void Trim(std::string& text);
+
+    /**
+     * @brief 去除包裹全文的代码块标记（```lang ... ```），只有开头是代码块标记时处理
+     * @param text UTF-8文本
+     */
+    static void StripFences(std::string& text);
+
+    /**
+     * @brief 去除包裹全文的一层成对引号（"" '' `` “” ‘’ 「」 『』），内部含同种引号时不处理
+     * @param text UTF-8文本
+     * @return 去除了引号返回true
+     */
+    static bool StripQuotes(std::string& text);
+
+    /**
+     * @brief 纯ASCII首行后还有内容时只保留首行；单行末尾为括号说明时去除括号部分
+     * @param text UTF-8文本
+     */
+    static void StripExplanation(std::string& text);
+
+    /**
+     * @brief 去除纯ASCII单行文本末尾的一个句点（省略号保留）
+     * @param text UTF-8文本
+     */
+    static void StripTrailingPeriod(std::string& text);
+
+    /**
+     * @brief 纯ASCII文本中删除撇号，其余非标识符字符替换为空格，并合并连续空格
+     * @param text UTF-8文本
+     */
+    static void EnforceIdentifierCharset(std::string& text);
+
+    /**
+     * @brief 按整词替换（原词首尾为ASCII字母数字时要求相邻字符不是字母数字）
+     * @param text UTF-8文本
+     * @param replacements 替换表，按顺序逐项替换
+     */
+    static void ApplyReplacements(std::string& text, const std::vector<Replacement>& replacements);
+
+    /**
+     * @brief 截断到最多maxLength个字符（按UTF-8字符边界）
+     * @param text UTF-8文本
+     * @param maxLength 最大字符数
+     */
+    static void LimitLength(std::string& text, size_t maxLength);
+
+private:
+    uint32_t m_stages = 0;
+    size_t m_maxLength = 0;
+    std::vector<Replacement> m_replacements;
+};
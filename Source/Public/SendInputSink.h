@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <vector>
+#include "TextInjector.h"
+
+/**
+ * @class SendInputSink
+ * @brief 基于SendInput的按键事件接收端，每个事件以KEYEVENTF_UNICODE发送（目标收到VK_PACKET和WM_CHAR）
+ */
+class SendInputSink : public InputSink
+{
+public:
+    /**
+     * @brief 注入一批按键事件
+     * @param events 事件
+     * @param count 事件数
+     * @return SendInput实际注入的事件数
+     */
+    size_t Send(const KeyEvent* events, size_t count) override;
+
+    /**
+     * @brief 两批之间等待目标程序处理
+     * @param milliseconds 毫秒
+     */
+    void Pause(uint32_t milliseconds) override;
+
+private:
+    std::vector<INPUT> m_inputs;    // 复用的INPUT数组
+};
@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @struct SentenceSpan
+ * @brief 一个句子：[begin, end) 为去除首尾空白的句子字节区间，[end, next) 为其后的空白（含换行）
+ */
+struct SentenceSpan
+{
+    size_t begin;
+    size_t end;
+    size_t next;
+};
+
+/**
+ * @class SentenceDelta
+ * @brief 编辑后段落的增量翻译计划（不依赖Windows API）
+ *
+ * 新原文和上次的原文、译文各自按句拆分，上次的原文与译文句数和换行位置一致时逐句对应；
+ * 新旧原文按句求最长公共子序列，未改动的句子沿用上次的译文，只有改动和新增的句子
+ * 编号拼成批量请求（N|句子），译文返回后按原顺序拼回整段
+ */
+class SentenceDelta
+{
+public:
+    // 批量请求使用的系统提示词
+    static const char* const BATCH_SYSTEM_PROMPT;
+
+    // 任意一方超过该句数时不做增量（逐句比较的代价按句数平方增长）
+    static const size_t MAX_SENTENCES = 256;
+
+    // 沿用的句子对应的上次译文句子编号，需要翻译的句子为NONE
+    static const size_t NONE = static_cast<size_t>(-1);
+
+    /**
+     * @brief 按句拆分：句末标点（. ! ? 后接空白或结尾，。！？ 及其后的引号括号）和换行处断开
+     * @param text UTF-8文本
+     * @param sentences 输出句子（会先清空）
+     */
+    static void Split(const std::string& text, std::vector<SentenceSpan>& sentences);
+
+    /**
+     * @brief 生成增量计划
+     * @param source 新原文（UTF-8）
+     * @param previousSource 上次的原文
+     * @param previousResult 上次的译文
+     * @return 上次的原文和译文能逐句对应且至少沿用一句返回true
+     */
+    bool Build(const std::string& source, const std::string& previousSource, const std::string& previousResult);
+
+    /**
+     * @brief 获取新原文的句数
+     * @return 句数
+     */
+    size_t GetSentenceCount() const { return m_sentences.size(); }
+
+    /**
+     * @brief 获取需要翻译的句数
+     * @return 句数
+     */
+    size_t GetChangedCount() const { return m_changedCount; }
+
+    /**
+     * @brief 获取沿用译文的句子在新原文中的字节数
+     * @return 字节数
+     */
+    size_t GetReusedBytes() const { return m_reusedBytes; }
+
+    /**
+     * @brief 获取新原文
+     * @return UTF-8原文
+     */
+    const std::string& GetSource() const { return m_source; }
+
+    /**
+     * @brief 生成批量请求文本，每个需要翻译的句子一行：编号|句子
+     * @param batch 输出请求文本（会先清空，复用其容量）
+     */
+    void BuildBatch(std::string& batch) const;
+
+    /**
+     * @brief 用批量译文和沿用的译文拼出整段译文
+     *
+     * 换行沿用新原文的空白；同一行内相邻的两句在上次译文中也相邻时沿用其间的空白，
+     * 否则前一句译文以ASCII字符结尾（英文）时补一个空格
+     * @param batchResult 模型返回的批量译文（没有需要翻译的句子时可为空）
+     * @param out 输出整段译文（会先清空，复用其容量）
+     * @return 每个需要翻译的句子都有译文返回true
+     */
+    bool Assemble(const std::string& batchResult, std::string& out) const;
+
+private:
+    std::string m_source;
+    std::string m_previousResult;
+    std::vector<SentenceSpan> m_sentences;          // 新原文的句子
+    std::vector<SentenceSpan> m_resultSentences;    // 上次译文的句子
+    std::vector<size_t> m_reuse;                    // 每个新句子沿用的上次译文句子编号
+    size_t m_changedCount = 0;
+    size_t m_reusedBytes = 0;
+};
@@ -0,0 +1,212 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief JSON路径中的一级：对象中的当前键或数组中的当前下标
+ */
+struct JsonPathSegment
+{
+    bool isArray = false;
+    size_t index = 0;           // 数组下标（isArray为true时有效）
+    std::string key;            // 对象键（isArray为false时有效）
+};
+
+/**
+ * @class JsonPath
+ * @brief 当前值在文档中的路径，例如 choices[0].message.content
+ *
+ * 层级对象在解析过程中复用，深度变浅时不释放，键字符串的容量跨文档保留
+ */
+class JsonPath
+{
+public:
+    /**
+     * @brief 获取路径深度
+     * @return 层数
+     */
+    size_t GetDepth() const { return m_depth; }
+
+    /**
+     * @brief 判断指定层是否为对象中的指定键
+     * @param level 层级（从0开始）
+     * @param key 键名
+     * @return 匹配返回true
+     */
+    bool IsKey(size_t level, std::string_view key) const
+    {
+        return level < m_depth && !m_segments[level].isArray && m_segments[level].key == key;
+    }
+
+    /**
+     * @brief 判断指定层是否为数组中的指定下标
+     * @param level 层级（从0开始）
+     * @param index 下标
+     * @return 匹配返回true
+     */
+    bool IsIndex(size_t level, size_t index) const
+    {
+        return level < m_depth && m_segments[level].isArray && m_segments[level].index == index;
+    }
+
+private:
+    friend class StreamingJsonParser;
+
+    std::vector<JsonPathSegment> m_segments;
+    size_t m_depth = 0;
+};
+
+/**
+ * @class JsonHandler
+ * @brief 流式JSON解析事件接收者
+ */
+class JsonHandler
+{
+public:
+    virtual ~JsonHandler() = default;
+
+    /**
+     * @brief 字符串值开始
+     * @param path 字符串值的路径
+     * @return 需要接收该字符串内容时返回true
+     */
+    virtual bool OnStringBegin(const JsonPath& path) = 0;
+
+    /**
+     * @brief 已反转义的字符串片段（可能指向输入数据本身，仅在回调期间有效）
+     * @param fragment UTF-8片段
+     */
+    virtual void OnStringFragment(std::string_view fragment) = 0;
+
+    /**
+     * @brief 数值
+     * @param path 数值的路径
+     * @param number 数值原文
+     */
+    virtual void OnNumber(const JsonPath& path, std::string_view number) { (void)path; (void)number; }
+};
+
+/**
+ * @class StreamingJsonParser
+ * @brief 增量JSON解析器（不依赖Windows API）
+ *
+ * 数据可按任意边界分块送入，解析器保存跨块的状态；字符串中不含转义的连续片段
+ * 直接以指向输入数据的视图交给处理器，整个文档无需拼接或复制
+ */
+class StreamingJsonParser
+{
+public:
+    // 最大嵌套深度
+    static const size_t MAX_DEPTH = 64;
+
+    /**
+     * @brief 构造解析器
+     * @param handler 事件接收者
+     */
+    explicit StreamingJsonParser(JsonHandler& handler);
+
+    /**
+     * @brief 重置为初始状态以解析新文档（保留已分配的容量）
+     */
+    void Reset();
+
+    /**
+     * @brief 送入一块数据
+     * @param data 数据
+     * @param length 长度
+     * @return 语法正确返回true；出错后后续调用均返回false，直到Reset
+     */
+    bool Feed(const char* data, size_t length);
+
+    /**
+     * @brief 根值是否已完整解析
+     * @return 完整返回true
+     */
+    bool IsComplete() const { return m_state == State::Done; }
+
+    /**
+     * @brief 是否遇到语法错误
+     * @return 出错返回true
+     */
+    bool HasError() const { return m_state == State::Error; }
+
+private:
+    enum class State
+    {
+        Value,          // 期望一个值
+        ValueOrEnd,     // 数组开头：期望值或 ]
+        KeyOrEnd,       // 对象开头：期望键或 }
+        Key,            // 期望键
+        Colon,          // 期望 :
+        String,         // 字符串内部（键或值）
+        Escape,         // 反斜杠之后
+        Unicode,        // \u 之后的4位十六进制
+        Number,         // 数值内部
+        Literal,        // true/false/null内部
+        CommaOrEnd,     // 值之后：期望 , 或容器结尾
+        Done,           // 根值已结束
+        Error
+    };
+
+    /**
+     * @brief 开始一个值（根据首字符分派）
+     * @param c 首字符
+     * @return 首字符已被消费返回true
+     */
+    bool BeginValue(char c);
+
+    /**
+     * @brief 进入对象或数组
+     * @param isArray 是否为数组
+     */
+    void PushContainer(bool isArray);
+
+    /**
+     * @brief 结束当前对象或数组
+     * @param isArray 结束符是否为 ]
+     */
+    void PopContainer(bool isArray);
+
+    /**
+     * @brief 一个值结束后更新状态
+     */
+    void EndValue();
+
+    /**
+     * @brief 追加字符串内容（键写入当前路径层，值交给处理器）
+     * @param data 数据
+     * @param length 长度
+     */
+    void AppendString(const char* data, size_t length);
+
+    /**
+     * @brief 以UTF-8追加一个码点
+     * @param codePoint Unicode码点
+     */
+    void AppendCodePoint(uint32_t codePoint);
+
+    /**
+     * @brief 处理 \uXXXX 解出的UTF-16码元（合并代理对）
+     * @param codeUnit 码元
+     */
+    void HandleCodeUnit(uint32_t codeUnit);
+
+    /**
+     * @brief 输出未配对的高代理项（替换为U+FFFD）
+     */
+    void FlushPendingSurrogate();
+
+    JsonHandler& m_handler;
+    JsonPath m_path;
+    State m_state = State::Value;
+    bool m_inKey = false;           // 当前字符串是否为键
+    bool m_capture = false;         // 处理器是否接收当前字符串值
+    uint32_t m_codeUnit = 0;        // 正在解析的\u码元
+    int m_unicodeDigits = 0;        // 已读取的十六进制位数
+    uint32_t m_highSurrogate = 0;   // 等待配对的高代理项
+    std::string m_token;            // 数值或字面量原文
+};
@@ -2,10 +2,14 @@
 
 #include <windows.h>
 #include <shellapi.h>
+#include <string>
 
 // 托盘消息和菜单ID定义
 #define WM_TRAYICON (WM_USER + 1)  // 托盘图标消息
 #define ID_TRAY_EXIT 1001          // 退出菜单项ID
+#define ID_TRAY_USAGE 1002         // 用量统计菜单项ID
+#define ID_TRAY_HISTORY_BASE 1100  // 最近翻译菜单项起始ID
+#define TRAY_HISTORY_COUNT 10      // 最近翻译菜单项数量
 
 /**
  * @class SystemTray
@@ -31,6 +35,24 @@ public:
      * 删除托盘图标，销毁菜单和窗口，释放相关资源
      */
     static void Cleanup();
+    
+    /**
+     * @brief 显示托盘气泡通知
+     * @param title 通知标题
+     * @param text 通知内容（超出系统长度限制时截断）
+     * 
+     * 用于"仅显示"配置档展示翻译结果
+     */
+    static void ShowNotification(const std::wstring& title, const std::wstring& text);
+    
+    /**
+     * @brief 更新离线指示
+     * @param offline 网络是否不可用
+     * @param pendingCount 离线队列中等待重放的请求数
+     * 
+     * 离线时托盘图标换成警告图标，提示文本显示离线状态和待重放数量；状态未变化时不做任何事
+     */
+    static void SetOfflineState(bool offline, size_t pendingCount);
 
 private:
     /**
@@ -74,6 +96,13 @@ private:
      */
     static HMENU CreateTrayMenu();
     
+    /**
+     * @brief 重建"最近翻译"子菜单
+     * 
+     * 每次弹出菜单前从翻译历史读取最近的记录
+     */
+    static void RebuildHistoryMenu();
+    
     /**
      * @brief 显示托盘右键菜单
      * @param hWnd 窗口句柄
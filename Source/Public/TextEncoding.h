@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <string>
+
+/**
+ * @class TextEncoding
+ * @brief UTF-8与UTF-16（宽字符）之间的转换工具
+ */
+class TextEncoding
+{
+public:
+    /**
+     * @brief UTF-16转UTF-8
+     * @param text 宽字符文本
+     * @param out 输出UTF-8文本（会先清空，复用其容量）
+     * @return 成功返回true，失败返回false
+     */
+    static bool WideToUtf8(const std::wstring& text, std::string& out);
+
+    /**
+     * @brief UTF-8转UTF-16
+     * @param data UTF-8数据
+     * @param length 数据长度
+     * @param out 输出宽字符文本（会先清空，复用其容量）
+     * @return 成功返回true，失败返回false
+     */
+    static bool Utf8ToWide(const char* data, size_t length, std::wstring& out);
+
+    /**
+     * @brief UTF-8转UTF-16（便捷版本）
+     * @param text UTF-8文本
+     * @return 宽字符文本，转换失败时返回空字符串
+     */
+    static std::wstring Utf8ToWide(const std::string& text);
+
+    /**
+     * @brief UTF-16转UTF-8（便捷版本）
+     * @param text 宽字符文本
+     * @return UTF-8文本，转换失败时返回空字符串
+     */
+    static std::string WideToUtf8(const std::wstring& text);
+};
@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct KeyEvent
+ * @brief 一个Unicode按键事件（对应KEYEVENTF_UNICODE，unit为UTF-16码元）
+ */
+struct KeyEvent
+{
+    uint16_t unit;
+    bool keyUp;
+};
+
+/**
+ * @class InputSink
+ * @brief 按键事件的接收端接口
+ *
+ * 实现可以是SendInput（见SendInputSink），也可以是测试时模拟目标程序的接收端
+ */
+class InputSink
+{
+public:
+    virtual ~InputSink() = default;
+
+    /**
+     * @brief 注入一批按键事件（一批之内不会与用户的输入交错）
+     * @param events 事件
+     * @param count 事件数
+     * @return 实际注入的事件数，少于count表示被目标拒绝或系统输入队列已满
+     */
+    virtual size_t Send(const KeyEvent* events, size_t count) = 0;
+
+    /**
+     * @brief 两批之间等待目标程序处理
+     * @param milliseconds 毫秒
+     */
+    virtual void Pause(uint32_t milliseconds) = 0;
+};
+
+/**
+ * @enum InjectionMethod
+ * @brief 输出译文的方式
+ */
+enum class InjectionMethod
+{
+    Clipboard,      // 备份剪切板、写入译文、模拟Ctrl+V、延时恢复
+    Type            // 逐字符发送Unicode按键事件，不经过剪切板
+};
+
+/**
+ * @enum InjectionOutcome
+ * @brief 逐字符输入的结果
+ */
+enum class InjectionOutcome
+{
+    Typed,          // 全部输入
+    Rejected,       // 第一批就被拒绝，目标中没有输入任何字符，可以改用剪切板
+    Partial         // 中途被拒绝，已输入部分字符，不能再粘贴（否则重复）
+};
+
+/**
+ * @struct InjectionPolicy
+ * @brief 输出方式的选择和分批参数
+ */
+struct InjectionPolicy
+{
+    size_t maxTypedUnits = 200;     // 不超过该UTF-16码元数的译文逐字符输入，0表示总是使用剪切板
+    size_t batchUnits = 64;         // 每批的码元数（每个码元按下和抬起两个事件）
+    uint32_t batchPauseMs = 2;      // 两批之间的等待（毫秒）
+};
+
+/**
+ * @class TextInjector
+ * @brief 译文输出策略 - 短译文直接以Unicode按键事件输入，长译文和不接受的程序使用剪切板（不依赖Windows API）
+ *
+ * 剪切板路径需要备份和延时恢复剪切板、等待目标处理Ctrl+V，总计数百毫秒，还会触发剪切板监视程序；
+ * 逐字符输入只发送若干批SendInput。含换行、制表符等控制字符的译文仍走剪切板：
+ * 逐字符输入的回车在单行输入框中会触发提交（如聊天窗口直接发送消息）
+ */
+class TextInjector
+{
+public:
+    /**
+     * @brief 选择输出方式
+     * @param text 译文
+     * @param policy 策略参数
+     * @param targetTypes 目标窗口是否接受逐字符输入（不在剪切板名单中且此前未拒绝过）
+     * @return 输出方式
+     */
+    static InjectionMethod ChooseMethod(const std::wstring& text, const InjectionPolicy& policy, bool targetTypes);
+
+    /**
+     * @brief 生成按键事件：每个UTF-16码元一次按下和一次抬起（代理对的两个码元各自成对）
+     * @param text 译文
+     * @param events 输出事件（会先清空）
+     */
+    static void BuildEvents(const std::wstring& text, std::vector<KeyEvent>& events);
+
+    /**
+     * @brief 分批注入按键事件，批次边界不拆开代理对
+     * @param events BuildEvents的结果
+     * @param sink 接收端
+     * @param policy 策略参数
+     * @return 注入结果
+     */
+    static InjectionOutcome Type(const std::vector<KeyEvent>& events, InputSink& sink, const InjectionPolicy& policy);
+
+    /**
+     * @brief 判断窗口类名是否在名单中（分号分隔，不区分大小写）
+     * @param className 窗口类名
+     * @param list 名单
+     * @return 在名单中返回true
+     */
+    static bool MatchesClassList(const std::wstring& className, const std::wstring& list);
+};
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+/**
+ * @class TranslationCache
+ * @brief 翻译结果缓存 - 按（命名空间，原文）缓存模型返回的原始译文（不依赖Windows API）
+ *
+ * 缓存的是命名风格转换之前的译文，因此同一命名空间下不同命名风格的配置档共享缓存。
+ * 采用LRU淘汰策略，所有方法线程安全
+ */
+class TranslationCache
+{
+public:
+    /**
+     * @brief 设置缓存容量，超出部分按LRU淘汰
+     * @param capacity 最大条目数，0表示禁用缓存
+     */
+    static void SetCapacity(size_t capacity);
+
+    /**
+     * @brief 查找缓存
+     * @param cacheNamespace 命名空间
+     * @param source 原文
+     * @param result 命中时输出译文
+     * @return 命中返回true
+     */
+    static bool Lookup(const std::string& cacheNamespace, const std::wstring& source, std::wstring& result);
+
+    /**
+     * @brief 写入缓存
+     * @param cacheNamespace 命名空间
+     * @param source 原文
+     * @param result 译文
+     */
+    static void Store(const std::string& cacheNamespace, const std::wstring& source, const std::wstring& result);
+
+    /**
+     * @brief 清空缓存
+     */
+    static void Clear();
+
+    /**
+     * @brief 获取当前条目数
+     * @return 条目数
+     */
+    static size_t GetSize();
+
+private:
+    /**
+     * @brief 生成缓存键
+     * @param cacheNamespace 命名空间
+     * @param source 原文
+     * @param key 输出缓存键
+     */
+    static void MakeKey(const std::string& cacheNamespace, const std::wstring& source, std::wstring& key);
+
+    /**
+     * @brief 淘汰超出容量的条目（调用方需持有锁）
+     */
+    static void EvictLocked();
+
+    // LRU链表，表头为最近使用的条目
+    using Entry = std::pair<std::wstring, std::wstring>;    // （缓存键，译文）
+    static std::list<Entry> s_entries;
+    static std::unordered_map<std::wstring, std::list<Entry>::iterator> s_index;
+    static size_t s_capacity;
+    static std::mutex s_mutex;
+};
@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "HistoryStore.h"
+
+/**
+ * @class TranslationHistory
+ * @brief 翻译历史管理类 - 基于内存映射文件的追加式历史日志
+ *
+ * 日志文件（YunsioTranslation.history）预分配为配置的最大大小并整体映射到内存，
+ * 新记录直接写入映射区域；空间不足时保留最新的一半记录进行压缩。
+ * 加载时建立倒排索引支持中英文子串搜索，并用最近的记录预热翻译缓存
+ */
+class TranslationHistory
+{
+public:
+    /**
+     * @brief 打开历史日志，建立索引并预热翻译缓存
+     * @return 成功返回true，失败返回false（失败时历史功能不可用，不影响翻译）
+     */
+    static bool Initialize();
+
+    /**
+     * @brief 将映射内容写回磁盘并关闭日志
+     */
+    static void Cleanup();
+
+    /**
+     * @brief 追加一条记录
+     * @param record 历史记录
+     */
+    static void Append(const HistoryRecord& record);
+
+    /**
+     * @brief 获取最近的记录
+     * @param maxCount 最大条数
+     * @param records 输出记录（最新在前）
+     */
+    static void GetRecent(size_t maxCount, std::vector<HistoryRecord>& records);
+
+    /**
+     * @brief 搜索原文或译文中包含查询串的记录（中英文子串/前缀，ASCII不区分大小写）
+     * @param query UTF-8查询字符串
+     * @param maxCount 最大条数
+     * @param records 输出记录（最新在前）
+     */
+    static void Search(const std::string& query, size_t maxCount, std::vector<HistoryRecord>& records);
+
+    /**
+     * @brief 获取当前时间（Unix毫秒），用于填写记录时间戳
+     * @return 时间戳
+     */
+    static int64_t GetCurrentTimestamp();
+
+private:
+    /**
+     * @brief 创建或打开日志文件并映射到内存
+     * @param capacity 文件大小（字节）
+     * @return 成功返回true，失败返回false
+     */
+    static bool OpenMapping(size_t capacity);
+
+    /**
+     * @brief 解除映射并关闭文件
+     */
+    static void CloseMapping();
+
+    /**
+     * @brief 扫描日志中的全部记录，重建偏移表和索引（调用方需持有锁）
+     */
+    static void RebuildIndexLocked();
+
+    /**
+     * @brief 压缩日志：保留最新的记录，使已用空间不超过数据区的一半（调用方需持有锁）
+     */
+    static void CompactLocked();
+
+    /**
+     * @brief 用最近的记录预热翻译缓存和翻译记忆
+     */
+    static void WarmCache();
+
+    /**
+     * @brief 按记录ID读取记录视图（调用方需持有锁）
+     * @param id 记录ID
+     * @param view 输出记录视图
+     * @return 成功返回true
+     */
+    static bool ReadLocked(uint32_t id, HistoryRecordView& view);
+
+    // 静态成员变量
+    static HANDLE s_hFile;                  // 日志文件句柄
+    static HANDLE s_hMapping;               // 文件映射句柄
+    static char* s_pView;                   // 映射视图
+    static size_t s_mappingSize;            // 映射大小（字节）
+    static std::vector<uint64_t> s_offsets; // 记录ID -> 数据区偏移
+    static HistoryIndex s_index;            // 倒排索引
+    static std::mutex s_mutex;
+    static bool s_bInitialized;
+};
@@ -2,6 +2,20 @@
 
 #include <windows.h>
 #include <string>
+#include <memory>
+#include <vector>
+#include "TranslationProfile.h"
+#include "HistoryStore.h"
+#include "RequestScheduler.h"
+#include "TranslationService.h"
+
+class SentenceDelta;
+
+// 后台预热完成后投递给主线程的消息
+#define WM_STARTUP_WARM (WM_APP + 2)
+
+// 交互翻译完成后投递给主线程的消息，lParam为结果（由OnTranslationMessage释放）
+#define WM_TRANSLATION_DONE (WM_APP + 3)
 
 /**
  * @class TranslationManager
@@ -12,19 +26,121 @@ class TranslationManager
 public:
     /**
      * @brief 初始化翻译管理器
+     *
+     * 只做轻量工作并立即返回；翻译服务会话、预连接和翻译历史在后台线程上初始化，
+     * 全部完成后向notifyThreadId投递WM_STARTUP_WARM
+     * @param notifyThreadId 接收WM_STARTUP_WARM的线程ID
      * @return 成功返回true，失败返回false
      */
-    static bool Initialize();
+    static bool Initialize(DWORD notifyThreadId);
     
     /**
      * @brief 清理翻译管理器资源
+     *
+     * 退出顺序：限时等待进行中的翻译请求完成（完成的译文仍写入缓存和历史，但不再粘贴），
+     * 超时后取消并限时等待请求返回，然后关闭翻译服务、刷新历史和当日用量
+     * @param drainTimeoutMs 等待进行中的请求完成的最长时间（毫秒）
+     * @param cancelTimeoutMs 取消后等待请求返回的最长时间（毫秒）
+     * @return 全部请求已结束返回true；仍有请求阻塞在网络调用中时返回false，
+     *         此时历史和用量已落盘但翻译服务未释放，调用方应直接结束进程
+     */
+    static bool Cleanup(DWORD drainTimeoutMs = 0, DWORD cancelTimeoutMs = INFINITE);
+    
+    /**
+     * @brief 按当前配置调整翻译缓存等设置（配置热重载后调用）
+     */
+    static void ApplyConfig();
+    
+    /**
+     * @brief 执行翻译流程（复制->翻译->按配置档粘贴替换或显示）
+     *
+     * 网络请求作为交互请求交给调度器，完成后通过WM_TRANSLATION_DONE回到主线程输出结果
+     * @param profile 热键对应的翻译配置档
+     */
+    static void ExecuteTranslation(std::shared_ptr<const TranslationProfile> profile);
+    
+    /**
+     * @brief 处理WM_TRANSLATION_DONE，在主线程上输出翻译结果
+     * @param lParam 消息参数
+     */
+    static void OnTranslationMessage(LPARAM lParam);
+    
+    /**
+     * @brief 提交后台请求（预连接、批量翻译、缓存预热等），有交互请求时自动让路
+     * @param job 任务
+     * @return 已排队返回true
      */
-    static void Cleanup();
+    static bool SubmitBackground(RequestScheduler::Job job);
     
     /**
-     * @brief 执行翻译流程（复制->翻译->粘贴替换）
+     * @brief 提交本地IPC客户端的单条翻译，优先于后台请求，但排在热键翻译之后且不占用其名额
+     * @param job 任务
+     * @return 已排队返回true
      */
-    static void ExecuteTranslation();
+    static bool SubmitClient(RequestScheduler::Job job);
+    
+    /**
+     * @brief 等待翻译服务就绪（仅首次翻译可能需要等待）
+     * @return 服务可用返回true
+     */
+    static bool WaitForService();
+    
+    /**
+     * @brief 在调用线程上翻译一段文本（批量模式和本地IPC使用）
+     *
+     * 与热键翻译共用术语表、缓存和代码感知：术语表整条命中或缓存命中时不发起请求；
+     * 网络译文写入缓存但不写入翻译历史
+     * @param profile 翻译配置档
+     * @param source 原文
+     * @param result 成功时输出按命名风格转换后的译文，失败时输出错误信息，被取消时为空
+     * @param cached 输出译文是否来自术语表或缓存
+     * @param cancel 取消信号，可为nullptr
+     * @param progress 流式翻译的进度回调（原始译文，未经后处理），为空时不要求流式返回；命中和选中代码时不调用
+     * @return 成功返回true
+     */
+    static bool TranslateText(const TranslationProfile& profile, const std::wstring& source, std::wstring& result,
+        bool& cached, const std::atomic<bool>* cancel, TranslationService::ProgressCallback progress = nullptr);
+    
+    /**
+     * @brief 不发起请求，只从术语表、缓存和翻译记忆中查找译文（线程安全）
+     *
+     * 批量模式在提交调度器之前调用，命中的记录不占用并发名额
+     * @param profile 翻译配置档
+     * @param source 原文
+     * @param result 命中时输出按配置档处理后的译文
+     * @return 命中返回true
+     */
+    static bool TranslateLocally(const TranslationProfile& profile, const std::wstring& source, std::wstring& result);
+    
+    /**
+     * @brief 将历史记录中的译文重新粘贴到目标窗口，无需网络请求
+     * @param record 历史记录
+     * @param targetWindow 粘贴目标窗口（弹出托盘菜单前的前台窗口）
+     */
+    static void RepasteHistory(const HistoryRecord& record, HWND targetWindow);
+    
+    /**
+     * @brief 按当前配置加载术语表（在后台线程或批量模式中调用，编译大术语表需要数百毫秒）
+     */
+    static void LoadGlossary();
+    
+    /**
+     * @brief 文本恰好是一条术语时直接使用约定译法
+     * @param text 待翻译文本
+     * @param result 输出约定译法
+     * @return 命中返回true
+     */
+    static bool LookupGlossary(const std::wstring& text, std::wstring& result);
+    
+    /**
+     * @brief 按配置档的后处理流水线清理译文，再转换命名风格
+     *
+     * 缓存、历史和翻译记忆保存原始译文，由共享同一命名空间的配置档各自在输出前处理
+     * @param profile 配置档，为nullptr时原样返回
+     * @param rawResult 模型返回的原始译文
+     * @return 输出的文本
+     */
+    static std::wstring FormatResult(const TranslationProfile* profile, const std::wstring& rawResult);
     
 private:
     /**
@@ -61,13 +177,127 @@ private:
     static bool PasteText();
     
     /**
-     * @brief 翻译完成回调函数
+     * @brief 后台预热线程：创建翻译服务会话、打开翻译历史、提交预连接请求
+     * @param param 未使用
+     * @return 线程退出码
+     */
+    static DWORD WINAPI WarmupThreadProc(LPVOID param);
+    
+    /**
+     * @brief 翻译完成回调函数（在主线程上调用）
      * @param success 翻译是否成功
      * @param result 翻译结果
      */
     static void OnTranslationComplete(bool success, const std::wstring& result);
     
+    /**
+     * @brief 将当前翻译的原始译文写入缓存和历史
+     * @param result 后处理和命名风格转换前的译文
+     */
+    static void RecordTranslation(const std::wstring& result);
+    
+    /**
+     * @brief 将原始译文写入缓存和历史（线程安全）
+     * @param profile 配置档
+     * @param source 原文
+     * @param result 后处理和命名风格转换前的译文
+     * @param latencyMs 翻译耗时（毫秒）
+     */
+    static void StoreResult(const TranslationProfile& profile, const std::wstring& source, const std::wstring& result, uint32_t latencyMs);
+    
+    /**
+     * @brief 离线时在翻译历史中查找同一原文的旧译文（只取与配置档同一缓存命名空间的记录）
+     * @param profile 配置档
+     * @param source 原文
+     * @param result 找到时输出命名风格转换前的译文
+     * @return 找到返回true
+     */
+    static bool FindStaleResult(const TranslationProfile& profile, const std::wstring& source, std::wstring& result);
+    
+    /**
+     * @brief 在翻译记忆中查找可直接沿用的译文（相似度达到[Memory] Answer）
+     * @param profile 配置档
+     * @param source 原文
+     * @param result 找到时输出命名风格转换前的译文
+     * @return 找到返回true
+     */
+    static bool LookupMemory(const TranslationProfile& profile, const std::wstring& source, std::wstring& result);
+    
+    /**
+     * @brief 为编辑过的段落生成增量计划：在翻译历史中查找含有其中较长句子的最近记录，逐句比较
+     * @param profile 配置档
+     * @param source 原文
+     * @return 至少一半内容可沿用上次译文时返回计划，否则返回nullptr
+     */
+    static std::shared_ptr<const SentenceDelta> PlanDelta(const TranslationProfile& profile, const std::wstring& source);
+    
+    /**
+     * @brief 离线队列定时器：更新离线指示，有到期请求时提交后台重放
+     * @param hWnd 未使用
+     * @param message 未使用
+     * @param timerId 未使用
+     * @param time 未使用
+     */
+    static VOID CALLBACK OutboxTimerProc(HWND hWnd, UINT message, UINT_PTR timerId, DWORD time);
+    
+    /**
+     * @brief 当日用量定时器：提交后台任务把累计的用量写入用量文件（文件读写不在主线程和请求线程上进行）
+     * @param hWnd 未使用
+     * @param message 未使用
+     * @param timerId 未使用
+     * @param time 未使用
+     */
+    static VOID CALLBACK QuotaTimerProc(HWND hWnd, UINT message, UINT_PTR timerId, DWORD time);
+    
+    /**
+     * @brief 后台任务：依次重放离线队列中到期的请求，译文写入缓存和历史
+     * @param cancelled 取消信号
+     * @return 始终返回true（被抢占时结束本轮，由定时器稍后重新提交）
+     */
+    static bool ReplayOutbox(const std::atomic<bool>& cancelled);
+    
+    /**
+     * @brief 按翻译服务的连通状态和离线队列长度更新托盘指示
+     */
+    static void UpdateOfflineIndicator();
+    
+    /**
+     * @brief 判断选中文本是否按代码处理（只翻译其中的注释和字符串）
+     * @param profile 翻译配置档
+     * @param text 选中文本
+     * @return 配置档启用代码感知且文本是含可翻译片段的代码时返回true
+     */
+    static bool IsCodeSelection(const TranslationProfile& profile, const std::wstring& text);
+    
+    /**
+     * @brief 将工作线程上的翻译结果投递到主线程
+     * @param success 翻译是否成功
+     * @param result 翻译结果
+     */
+    static void PostTranslationResult(bool success, const std::wstring& result);
+    
+    /**
+     * @brief 输出文本以替换选中内容：短的单行文本直接以Unicode按键事件输入，
+     *        其余通过剪切板粘贴（完成后恢复原剪切板内容）
+     * @param text 要输出的文本
+     */
+    static void PasteResult(const std::wstring& text);
+    
     // 静态成员变量
-    static bool s_bInitialized;
-    static bool s_bTranslationInProgress;     // 翻译进行中标志
+    // 以下状态除特别注明外只在主线程读写
+    static std::atomic<bool> s_bInitialized;
+    static std::atomic<bool> s_bTranslationInProgress;     // 翻译进行中标志
+    static std::shared_ptr<const TranslationProfile> s_pActiveProfile;   // 当前翻译使用的配置档
+    static std::wstring s_sourceText;                                   // 当前翻译的原文（用于写入缓存和历史）
+    static bool s_bCodeSelection;                                       // 当前翻译的原文是代码（译文不转换命名风格）
+    static ULONGLONG s_startTick;                                       // 当前翻译开始时间（用于记录耗时）
+    static HANDLE s_hWarmupThread;            // 后台预热线程句柄（预热线程退出前只读）
+    static HANDLE s_hServiceReady;            // 翻译服务初始化结束事件（手动重置，启动预热线程前创建）
+    static std::atomic<bool> s_bServiceAvailable;          // 翻译服务是否初始化成功（预热线程写入，事件触发后才可读取）
+    static DWORD s_notifyThreadId;            // 接收WM_STARTUP_WARM和WM_TRANSLATION_DONE的线程ID（启动线程前写入，之后只读）
+    static RequestScheduler s_scheduler;      // 网络请求调度器（交互请求优先，自身线程安全）
+    static UINT_PTR s_outboxTimer;            // 离线队列定时器
+    static UINT_PTR s_quotaTimer;             // 当日用量保存定时器
+    static std::atomic<bool> s_bReplaying;    // 重放任务是否已提交（主线程置位，重放任务结束时清除）
+    static std::vector<std::wstring> s_typeRejectedClasses;     // 拒绝过按键输入的窗口类名（本次运行内改用剪切板）
 };
\ No newline at end of file
@@ -0,0 +1,213 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct MemoryMatch
+ * @brief 翻译记忆中与原文相似的一条记录
+ */
+struct MemoryMatch
+{
+    double similarity = 0.0;    // 1 - 编辑距离 / 较长一方的字符数（按归一化后的字符计算）
+    std::string source;         // 记录的原文（UTF-8）
+    std::string result;         // 记录的译文（UTF-8）
+};
+
+/**
+ * @class MemoryIndex
+ * @brief 模糊翻译记忆索引 - MinHash分段候选加带状编辑距离校验（不依赖Windows API，非线程安全）
+ *
+ * 原文先归一化（ASCII转小写，去除空白和标点），以相邻两个字符为特征计算40个MinHash值，
+ * 每5个一组分为8段；任意一段相同的记录成为候选，再按长度过滤，最后只在对角带内计算编辑距离，
+ * 超过阈值允许的距离时提前结束。每段的桶以链表形式存放在连续数组中（最新的记录在前），
+ * 原文和译文存放在同一块文本缓冲区里，一百万条句子长度的记录约占三百MB
+ */
+class MemoryIndex
+{
+public:
+    // 归一化后少于该字符数的原文不进入索引（短文本由精确缓存处理）
+    static const size_t MIN_CHARS = 4;
+
+    // 归一化后超过该字符数的原文不进入索引（整段文章不适合作为记忆）
+    static const size_t MAX_CHARS = 1000;
+
+    /**
+     * @brief 构造索引
+     * @param capacity 最大记录数，达到后丢弃较早的一半记录
+     */
+    explicit MemoryIndex(size_t capacity);
+
+    MemoryIndex(const MemoryIndex&) = delete;
+    MemoryIndex& operator=(const MemoryIndex&) = delete;
+
+    /**
+     * @brief 加入一条记录，同一命名空间中归一化后相同的旧记录被替换
+     * @param cacheNamespace 命名空间（与翻译缓存一致，不同命名空间互不命中）
+     * @param source 原文（UTF-8）
+     * @param result 译文（UTF-8）
+     * @return 加入返回true；原文过短或过长时返回false
+     */
+    bool Add(const std::string& cacheNamespace, const std::string& source, const std::string& result);
+
+    /**
+     * @brief 查找最相似的记录
+     * @param cacheNamespace 命名空间
+     * @param source 原文（UTF-8）
+     * @param minSimilarity 最低相似度（0-1）
+     * @param match 输出最相似的记录
+     * @return 找到相似度不低于minSimilarity的记录返回true
+     */
+    bool Lookup(const std::string& cacheNamespace, const std::string& source, double minSimilarity, MemoryMatch& match) const;
+
+    /**
+     * @brief 获取有效记录数
+     * @return 记录数
+     */
+    size_t GetSize() const { return m_liveCount; }
+
+    /**
+     * @brief 获取容量
+     * @return 最大记录数
+     */
+    size_t GetCapacity() const { return m_capacity; }
+
+    /**
+     * @brief 归一化：ASCII转小写，去除空白和标点，输出Unicode码点
+     * @param text UTF-8文本
+     * @param out 输出码点（会先清空）
+     */
+    static void Normalize(const std::string& text, std::vector<uint32_t>& out);
+
+    /**
+     * @brief 带状编辑距离：只计算距离不超过maxDistance的情况
+     * @param a 码点序列
+     * @param b 码点序列
+     * @param maxDistance 允许的最大距离
+     * @return 编辑距离，超过maxDistance时返回maxDistance + 1
+     */
+    static size_t BoundedEditDistance(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, size_t maxDistance);
+
+private:
+    static const size_t HASH_COUNT = 40;
+    static const size_t BAND_COUNT = 8;
+    static const size_t BAND_ROWS = HASH_COUNT / BAND_COUNT;
+    static const uint32_t NONE = 0xFFFFFFFFu;
+
+    // 一条记录
+    struct Entry
+    {
+        uint64_t textOffset;        // 原文和译文在m_text中的起始位置（原文在前）
+        uint64_t exactKey;          // 归一化原文和命名空间的哈希
+        uint32_t sourceLength;      // 原文字节数
+        uint32_t resultLength;      // 译文字节数
+        uint32_t namespaceHash;
+        uint32_t charCount;         // 归一化后的字符数
+        bool live;                  // 被同一原文的新记录替换后为false
+    };
+
+    /**
+     * @brief 计算各段的键
+     * @param chars 归一化后的码点
+     * @param namespaceHash 命名空间哈希
+     * @param keys 输出BAND_COUNT个键
+     */
+    static void ComputeBandKeys(const std::vector<uint32_t>& chars, uint32_t namespaceHash, uint64_t* keys);
+
+    /**
+     * @brief 计算精确去重用的键
+     * @param chars 归一化后的码点
+     * @param namespaceHash 命名空间哈希
+     * @return 键
+     */
+    static uint64_t ComputeExactKey(const std::vector<uint32_t>& chars, uint32_t namespaceHash);
+
+    /**
+     * @brief 查找最相似的记录
+     * @param chars 归一化后的码点
+     * @param namespaceHash 命名空间哈希
+     * @param keys 各段的键
+     * @param minSimilarity 最低相似度
+     * @param bestId 输出记录编号
+     * @param bestSimilarity 输出相似度
+     * @return 找到返回true
+     */
+    bool FindBest(const std::vector<uint32_t>& chars, uint32_t namespaceHash, const uint64_t* keys,
+        double minSimilarity, uint32_t& bestId, double& bestSimilarity) const;
+
+    /**
+     * @brief 按当前记录重建各段的桶（扩容或丢弃旧记录后调用）
+     * @param bucketCount 每段的桶数（2的幂）
+     */
+    void RebuildBuckets(size_t bucketCount);
+
+    /**
+     * @brief 丢弃较早的一半记录并压缩文本缓冲区
+     */
+    void DropOldest();
+
+    size_t m_capacity;
+    size_t m_liveCount = 0;
+    std::vector<Entry> m_entries;
+    std::string m_text;
+    std::vector<uint64_t> m_entryKeys;      // 每条记录的BAND_COUNT个键
+    std::vector<uint32_t> m_next;           // 每条记录在每段桶链表中的下一条
+    std::vector<uint32_t> m_heads;          // BAND_COUNT段，每段m_bucketMask + 1个桶
+    std::unordered_map<uint64_t, uint32_t> m_exact;     // 精确键 -> 最新的记录编号
+    size_t m_bucketMask = 0;
+};
+
+/**
+ * @class TranslationMemory
+ * @brief 全局翻译记忆（线程安全）
+ *
+ * 精确缓存未命中时，相似度达到Answer阈值的记录直接作为译文，
+ * 达到Hint阈值的记录作为参考译文附在请求中，使模型沿用已有的用词
+ */
+class TranslationMemory
+{
+public:
+    /**
+     * @brief 设置容量，容量变化时清空记忆
+     * @param capacity 最大记录数，0表示禁用
+     */
+    static void SetCapacity(size_t capacity);
+
+    /**
+     * @brief 加入一条记录
+     * @param cacheNamespace 命名空间
+     * @param source 原文（UTF-8）
+     * @param result 译文（UTF-8）
+     */
+    static void Add(const std::string& cacheNamespace, const std::string& source, const std::string& result);
+
+    /**
+     * @brief 查找最相似的记录
+     * @param cacheNamespace 命名空间
+     * @param source 原文（UTF-8）
+     * @param minSimilarity 最低相似度（0-1），不大于0时不查找
+     * @param match 输出最相似的记录
+     * @return 找到返回true
+     */
+    static bool Lookup(const std::string& cacheNamespace, const std::string& source, double minSimilarity, MemoryMatch& match);
+
+    /**
+     * @brief 清空记忆
+     */
+    static void Clear();
+
+    /**
+     * @brief 获取记录数
+     * @return 记录数
+     */
+    static size_t GetSize();
+
+private:
+    static std::unique_ptr<MemoryIndex> s_pIndex;
+    static std::mutex s_mutex;
+};
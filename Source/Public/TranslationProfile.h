@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "IdentifierCase.h"
+#include "ResultPipeline.h"
+
+class RequestTemplate;
+struct AppConfig;
+
+/**
+ * @struct HotkeyBinding
+ * @brief 热键绑定描述（与平台无关）
+ *
+ * 修饰键取值与Win32的MOD_ALT/MOD_CONTROL/MOD_SHIFT/MOD_WIN保持一致，
+ * 虚拟键码与VK_*保持一致，因此可直接传给RegisterHotKey
+ */
+struct HotkeyBinding
+{
+    static const uint32_t MOD_ALT_FLAG = 0x0001;
+    static const uint32_t MOD_CONTROL_FLAG = 0x0002;
+    static const uint32_t MOD_SHIFT_FLAG = 0x0004;
+    static const uint32_t MOD_WIN_FLAG = 0x0008;
+
+    uint32_t modifiers = MOD_CONTROL_FLAG;  // 修饰键组合
+    uint32_t virtualKey = 0x20;             // 虚拟键码（默认VK_SPACE）
+
+    bool operator==(const HotkeyBinding& other) const
+    {
+        return modifiers == other.modifiers && virtualKey == other.virtualKey;
+    }
+    bool operator!=(const HotkeyBinding& other) const { return !(*this == other); }
+};
+
+/**
+ * @enum OutputMode
+ * @brief 翻译结果的输出方式
+ */
+enum class OutputMode
+{
+    Paste,  // 替换选中文本（默认）
+    Show    // 仅在托盘通知中显示，不粘贴
+};
+
+/**
+ * @struct TranslationProfile
+ * @brief 翻译配置档 - 一个热键对应一套提示词、模型、缓存命名空间和输出方式
+ *
+ * 配置档在配置加载时构建完成并预生成请求体模板，此后只读，
+ * 热键触发时直接使用，切换配置档不产生额外开销
+ */
+struct TranslationProfile
+{
+    std::string name;                   // 配置档名称（[Profile.名称]）
+    HotkeyBinding hotkey;               // 触发热键
+    std::string model;                  // 模型名称
+    double temperature = 0.3;           // 采样温度
+    int maxTokens = 1000;               // 最大输出token数
+    std::string systemPrompt;           // 系统提示词
+    std::string cacheNamespace;         // 缓存命名空间，相同命名空间的配置档共享翻译缓存
+    CaseStyle caseStyle = CaseStyle::Pascal;    // 英文译文在本地转换的命名风格
+    OutputMode output = OutputMode::Paste;
+    ResultPipeline resultPipeline;      // 译文后处理流水线（读取缓存之后、输出之前执行）
+    bool codeAware = true;              // 选中代码时只翻译注释和字符串
+    bool deltaAware = true;             // 重新翻译编辑过的段落时只发送改动的句子
+
+    std::shared_ptr<const RequestTemplate> requestTemplate;     // 预构建的请求体模板
+    std::shared_ptr<const RequestTemplate> codeRequestTemplate; // 代码注释和字符串批量翻译的请求体模板
+    std::shared_ptr<const RequestTemplate> deltaRequestTemplate;    // 改动句子批量翻译的请求体模板
+
+    /**
+     * @brief 根据当前字段生成请求体模板和两种批量翻译模板（字段填写完毕后调用）
+     */
+    void BuildRequestTemplate();
+};
+
+/**
+ * @class HotkeyDispatchTable
+ * @brief 热键ID到配置档的分发表（不依赖Windows API）
+ *
+ * 由一份配置快照构建，第i个配置档使用热键ID HOTKEY_ID_BASE + i。
+ * 分发表持有配置快照，因此即使配置在热键消息到达前被替换，
+ * 查到的配置档也与注册热键时保持一致
+ */
+class HotkeyDispatchTable
+{
+public:
+    // 第一个配置档的热键ID
+    static const int HOTKEY_ID_BASE = 1;
+
+    HotkeyDispatchTable() = default;
+
+    /**
+     * @brief 由配置快照构建分发表
+     * @param config 配置快照
+     */
+    explicit HotkeyDispatchTable(std::shared_ptr<const AppConfig> config);
+
+    /**
+     * @brief 获取条目数量
+     * @return 配置档数量
+     */
+    size_t GetCount() const;
+
+    /**
+     * @brief 获取第index个条目的热键ID
+     * @param index 条目索引
+     * @return 热键ID
+     */
+    int GetHotkeyId(size_t index) const { return HOTKEY_ID_BASE + static_cast<int>(index); }
+
+    /**
+     * @brief 获取第index个条目的热键绑定
+     * @param index 条目索引
+     * @return 热键绑定
+     */
+    const HotkeyBinding& GetBinding(size_t index) const;
+
+    /**
+     * @brief 按热键ID查找配置档
+     * @param hotkeyId WM_HOTKEY消息中的热键ID
+     * @return 对应的配置档，不属于本表时返回nullptr
+     */
+    std::shared_ptr<const TranslationProfile> Lookup(int hotkeyId) const;
+
+    /**
+     * @brief 判断两张表的热键ID与绑定是否完全一致（一致时无需重新注册热键）
+     * @param other 另一张分发表
+     * @return 一致返回true
+     */
+    bool HasSameBindings(const HotkeyDispatchTable& other) const;
+
+private:
+    std::shared_ptr<const AppConfig> m_pConfig;
+};
@@ -5,10 +5,24 @@
 #include <string>
 #include <functional>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include "TranslationProfile.h"
+#include "HttpTransport.h"
+#include "ResponseStream.h"
+#include "RequestGate.h"
+#include "AdaptiveTimeouts.h"
+
+class RequestArena;
+class SentenceDelta;
 
 /**
  * @class TranslationService
  * @brief 翻译服务类 - 调用通义千问API进行文本翻译
+ *
+ * 线程约定：Initialize在预热线程上调用，Cleanup和ApplyConfig在主线程上调用；
+ * TranslateAsync和Preconnect可在任意线程上并发调用。每次调用持有闸门通行证，
+ * Cleanup先关闭闸门并等待进行中的调用全部结束，再释放传输层
  */
 class TranslationService
 {
@@ -20,12 +34,26 @@ public:
      */
     using TranslationCallback = std::function<void(bool success, const std::wstring& result)>;
     
+    /**
+     * @brief 流式翻译的进度回调函数类型，每收到一块响应数据调用一次
+     * @param content 目前为止收到的原始译文（UTF-8，末尾可能是不完整的字符；超时重试时先以空文本调用一次，再从头开始）
+     */
+    using ProgressCallback = std::function<void(const std::string& content)>;
+    
     /**
      * @brief 初始化翻译服务
      * @return 成功返回true，失败返回false
      */
     static bool Initialize();
     
+    /**
+     * @brief 设置传输层的录制或回放（在Initialize之前调用，供批量模式的--record和--replay使用）
+     * @param recordPath 录制文件路径（UTF-8），为空时不录制
+     * @param replayPath 回放文件路径（UTF-8），不为空时不访问网络，请求由录制文件应答，也不需要API密钥
+     * @param replayTimeScale 回放耗时系数：1按录制时的耗时，0不等待
+     */
+    static void SetCapture(const std::string& recordPath, const std::string& replayPath, double replayTimeScale);
+    
     /**
      * @brief 清理翻译服务资源
      */
@@ -33,28 +61,165 @@ public:
     
     /**
      * @brief 异步翻译文本
+     *
+     * 在调用线程上完成请求并调用回调，可以在多个线程上同时调用（由RequestScheduler的工作线程执行）。
+     * 回调收到模型的原始译文，配置档的后处理由调用方在输出前进行
      * @param text 待翻译的文本
-     * @param callback 翻译完成后的回调函数
-     * @return 请求发送成功返回true，失败返回false
+     * @param profile 翻译配置档（提供预构建的请求体模板）
+     * @param callback 翻译完成后的回调函数（被取消时不调用）
+     * @param cancel 取消信号，可为nullptr
+     * @return 请求发送成功返回true，失败或被取消返回false
+     */
+    static bool TranslateAsync(const std::wstring& text, const TranslationProfile& profile, TranslationCallback callback,
+        const std::atomic<bool>* cancel = nullptr);
+    
+    /**
+     * @brief 异步翻译文本，要求服务端以SSE流式返回，每收到一块译文调用一次进度回调
+     *
+     * 完成时与TranslateAsync相同，回调收到完整的原始译文
+     * @param text 待翻译的文本
+     * @param profile 翻译配置档
+     * @param progress 进度回调（在调用线程上执行）
+     * @param callback 翻译完成后的回调函数（被取消时不调用）
+     * @param cancel 取消信号，可为nullptr
+     * @return 请求发送成功返回true，失败或被取消返回false
      */
-    static bool TranslateAsync(const std::wstring& text, TranslationCallback callback);
+    static bool TranslateStreamAsync(const std::wstring& text, const TranslationProfile& profile, ProgressCallback progress,
+        TranslationCallback callback, const std::atomic<bool>* cancel = nullptr);
+    
+    /**
+     * @brief 异步翻译选中代码中的注释和字符串，译文写回原位置后整段交给回调
+     *
+     * 只有注释和字符串以批量请求发给模型，代码本身不经过模型，输出时也不经过配置档的后处理
+     * @param text 选中的代码
+     * @param profile 翻译配置档（提供代码批量翻译模板）
+     * @param callback 翻译完成后的回调函数（被取消时不调用）
+     * @param cancel 取消信号，可为nullptr
+     * @return 请求发送成功返回true，失败或被取消返回false
+     */
+    static bool TranslateCodeAsync(const std::wstring& text, const TranslationProfile& profile, TranslationCallback callback,
+        const std::atomic<bool>* cancel = nullptr);
+    
+    /**
+     * @brief 异步翻译编辑过的段落中改动的句子，与沿用的译文拼回整段后交给回调
+     *
+     * 回调收到拼回的原始整段译文，与整段翻译相同，配置档的后处理在输出前进行
+     * @param delta 增量计划（至少有一个需要翻译的句子）
+     * @param profile 翻译配置档（提供改动句子批量翻译模板）
+     * @param callback 翻译完成后的回调函数（被取消时不调用）
+     * @param cancel 取消信号，可为nullptr
+     * @return 请求发送成功返回true，失败或被取消返回false
+     */
+    static bool TranslateDeltaAsync(const SentenceDelta& delta, const TranslationProfile& profile, TranslationCallback callback,
+        const std::atomic<bool>* cancel = nullptr);
+    
+    /**
+     * @brief 预连接API服务器（完成DNS解析、TCP和TLS握手），连接保留在会话连接池中供首个翻译请求复用
+     *
+     * 作为后台请求调用；未配置API密钥时不做任何事
+     * @param cancel 取消信号，可为nullptr
+     * @return 完成返回true，被取消返回false
+     */
+    static bool Preconnect(const std::atomic<bool>* cancel = nullptr);
+    
+    /**
+     * @brief 根据ConfigStore中的当前配置重建请求设置（主机、路径、请求头、超时）
+     *
+     * 新设置以原子方式整体替换，正在进行的请求继续使用旧设置
+     */
+    static void ApplyConfig();
+    
+    /**
+     * @brief 最近一次请求是否连通了API服务器
+     *
+     * 发送或接收失败（无法解析主机、连接被拒绝、超时等）后视为离线，收到任何响应后恢复在线
+     * @return 在线返回true（尚未发起请求时视为在线）
+     */
+    static bool IsOnline();
+    
+    /**
+     * @brief 生成用量报告：当日累计用量，以及本次运行各配置档的请求数、输入/输出/缓存命中token数、上下行字节数
+     * @return 报告文本，当日累计和每个配置档各一行
+     */
+    static std::wstring FormatUsageReport();
     
 private:
-    // API配置常量
-    static const wchar_t* API_KEY;
-    static const char* SYSTEM_PROMPT;
+    // 由配置预构建的请求设置（定义见TranslationService.cpp）
+    struct RequestSettings;
+    
+    /**
+     * @brief 获取传输失败阶段对应的提示信息
+     * @param failure 失败阶段
+     * @return 提示信息
+     */
+    static const wchar_t* GetFailureMessage(HttpFailure failure);
+    
+    /**
+     * @brief 将一次请求的token和字节用量累加到配置档的计数器
+     * @param profileName 配置档名称
+     * @param result 传输结果
+     * @param usage 响应中的token用量
+     */
+    static void RecordUsage(const std::string& profileName, const HttpResult& result, const TokenUsage& usage);
+    
+    /**
+     * @brief 根据传输结果更新连通状态
+     * @param result 传输结果
+     */
+    static void UpdateConnectivity(const HttpResult& result);
+    
+    /**
+     * @brief 按最近的耗时分布收紧请求的各阶段超时（配置的超时为上限）
+     * @param settings 请求设置
+     * @param expectedTokens 预计输出token数
+     * @param request 已填写配置超时的请求描述
+     * @return 至少一个阶段的超时比配置的短返回true
+     */
+    static bool ApplyAdaptiveTimeouts(const RequestSettings& settings, size_t expectedTokens, HttpRequest& request);
+    
+    /**
+     * @brief 按术语表处理待翻译文本（Substitute替换术语，Prompt附上命中的术语条目）
+     * @param settings 请求设置
+     * @param text 待发送的UTF-8文本
+     * @param arena 当前线程的缓冲区
+     * @return 实际发送的文本（未命中术语时即text）
+     */
+    static const std::string& ApplyGlossary(const RequestSettings& settings, const std::string& text, RequestArena& arena);
+    
+    /**
+     * @brief 在待发送文本后附上翻译记忆中相似原文的已有译文
+     * @param settings 请求设置
+     * @param profile 翻译配置档
+     * @param text 待发送的UTF-8文本（ApplyGlossary的结果）
+     * @param arena 当前线程的缓冲区（utf8Text为原文）
+     * @return 实际发送的文本（没有足够相似的记录时即text）
+     */
+    static const std::string& ApplyMemory(const RequestSettings& settings, const TranslationProfile& profile,
+        const std::string& text, RequestArena& arena);
     
     /**
-     * @brief 解析JSON响应获取翻译结果
-     * @param jsonResponse JSON响应字符串
-     * @param result 输出翻译结果
-     * @return 解析成功返回true，失败返回false
+     * @brief 执行一次翻译请求（TranslateAsync、TranslateCodeAsync和TranslateDeltaAsync的共同实现）
+     * @param text 待翻译的文本（delta不为nullptr时不使用）
+     * @param profile 翻译配置档
+     * @param codeOnly 是否只翻译代码中的注释和字符串
+     * @param delta 增量计划，为nullptr时翻译整段text
+     * @param callback 翻译完成后的回调函数
+     * @param cancel 取消信号，可为nullptr
+     * @param progress 进度回调，可为空（只用于整段翻译）
+     * @return 请求发送成功返回true，失败或被取消返回false
      */
-    static bool ParseJsonResponse(const std::string& jsonResponse, std::wstring& result);
+    static bool Translate(const std::wstring& text, const TranslationProfile& profile, bool codeOnly, const SentenceDelta* delta,
+        TranslationCallback callback, const std::atomic<bool>* cancel, const ProgressCallback& progress);
     
     // 静态成员变量
-    static HINTERNET s_hSession;
-    static bool s_bInitialized;
+    static std::unique_ptr<HttpTransport> s_pTransport;     // 传输层（WinHTTP会话），闸门打开期间不变
+    static RequestGate s_gate;                              // 服务入口闸门，打开即表示已初始化
+    static std::atomic<bool> s_bOnline;                     // 最近一次请求是否连通
+    static std::shared_ptr<const RequestSettings> s_pSettings;
+    static AdaptiveTimeouts s_timeouts;                     // 各阶段耗时分布（自身线程安全）
+    static std::string s_recordPath;                        // 录制文件路径（Initialize之前写入）
+    static std::string s_replayPath;                        // 回放文件路径（Initialize之前写入）
+    static double s_replayTimeScale;
 };
 
 // 链接WinHTTP库
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <windows.h>
+#include <winhttp.h>
+#include "HttpTransport.h"
+
+/**
+ * @class WinHttpTransport
+ * @brief 基于WinHTTP的传输层实现
+ *
+ * 会话级启用gzip/deflate自动解压（Windows 8.1及以上），请求头自动带上Accept-Encoding，
+ * 解压在读取时流式进行。连接由WinHTTP会话连接池复用
+ */
+class WinHttpTransport : public HttpTransport
+{
+public:
+    WinHttpTransport() = default;
+    ~WinHttpTransport() override;
+
+    WinHttpTransport(const WinHttpTransport&) = delete;
+    WinHttpTransport& operator=(const WinHttpTransport&) = delete;
+
+    /**
+     * @brief 创建WinHTTP会话
+     * @param userAgent User-Agent
+     * @return 成功返回true，失败返回false
+     */
+    bool Open(const wchar_t* userAgent);
+
+    /**
+     * @brief 发送请求并流式接收响应
+     * @param request 请求描述
+     * @param onData 响应数据回调（解压后）
+     * @param result 输出结果与传输统计
+     * @return 完整收到响应返回true
+     */
+    bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) override;
+
+private:
+    /**
+     * @brief 读取响应头中的数值字段
+     * @param hRequest 请求句柄
+     * @param infoLevel 字段（WINHTTP_QUERY_*）
+     * @param value 输出数值
+     * @return 字段存在返回true
+     */
+    static bool QueryNumberHeader(HINTERNET hRequest, DWORD infoLevel, uint64_t& value);
+
+    /**
+     * @brief 将一次请求的传输统计累加到Instrumentation
+     * @param result 请求结果
+     */
+    static void ReportMetrics(const HttpResult& result);
+
+    HINTERNET m_hSession = nullptr;
+    bool m_bDecompression = false;      // 系统是否支持自动解压
+};
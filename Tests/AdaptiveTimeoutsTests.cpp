@@ -0,0 +1,125 @@
+﻿#include "TestHarness.h"
+#include "AdaptiveTimeouts.h"
+#include <cmath>
+
+namespace
+{
+    PhaseTimeouts Ceilings()
+    {
+        PhaseTimeouts ceilings;
+        ceilings.connectMs = 60000;
+        ceilings.sendMs = 30000;
+        ceilings.responseMs = 30000;
+        ceilings.idleMs = 30000;
+        return ceilings;
+    }
+}
+
+TEST_CASE(HistogramBucketsAreLogarithmic)
+{
+    CHECK_EQ(LatencyHistogram::BucketLimit(0), 1.0);
+    CHECK(std::fabs(LatencyHistogram::BucketLimit(1) - 1.2) < 1e-9);
+    CHECK(LatencyHistogram::BucketLimit(LatencyHistogram::BUCKET_COUNT - 1) > 90000.0);
+
+    LatencyHistogram histogram;
+    CHECK_EQ(histogram.Percentile(0.99), 0.0);
+    histogram.Add(0.2);
+    CHECK_EQ(histogram.Percentile(0.5), 1.0);
+
+    // 百分位数取所在桶的上界：不小于样本值，且不超过样本值的1.2倍
+    histogram = LatencyHistogram();
+    histogram.Add(100.0);
+    double p = histogram.Percentile(0.99);
+    CHECK(p >= 100.0 && p <= 120.0);
+
+    // 超出范围的样本落在最后一个桶
+    histogram.Add(1e9);
+    CHECK_EQ(histogram.Percentile(1.0), LatencyHistogram::BucketLimit(LatencyHistogram::BUCKET_COUNT - 1));
+}
+
+TEST_CASE(HistogramPercentileFollowsRank)
+{
+    LatencyHistogram histogram;
+    for (int i = 0; i < 99; ++i)
+        histogram.Add(10.0);
+    histogram.Add(1000.0);
+    CHECK(histogram.Percentile(0.99) <= 12.0);
+    CHECK(histogram.Percentile(1.0) >= 1000.0);
+}
+
+TEST_CASE(HistogramKeepsTwoGenerations)
+{
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < LatencyHistogram::GENERATION_SIZE; ++i)
+        histogram.Add(5000.0);
+    for (size_t i = 0; i < LatencyHistogram::GENERATION_SIZE; ++i)
+        histogram.Add(10.0);
+    CHECK_EQ(histogram.GetCount(), LatencyHistogram::GENERATION_SIZE * 2);
+    CHECK(histogram.Percentile(0.99) >= 5000.0);
+
+    // 第三代开始时最早的一代被丢弃，之前的慢样本不再影响百分位数
+    histogram.Add(10.0);
+    CHECK_EQ(histogram.GetCount(), LatencyHistogram::GENERATION_SIZE + 1);
+    CHECK(histogram.Percentile(0.99) <= 12.0);
+}
+
+TEST_CASE(EstimatesOutputTokensFromInput)
+{
+    CHECK_EQ(AdaptiveTimeouts::EstimateOutputTokens(0, 0), static_cast<size_t>(16));
+    CHECK_EQ(AdaptiveTimeouts::EstimateOutputTokens(200, 0), static_cast<size_t>(116));
+    CHECK_EQ(AdaptiveTimeouts::EstimateOutputTokens(200, 50), static_cast<size_t>(50));
+}
+
+TEST_CASE(UsesConfiguredTimeoutsUntilEnoughSamples)
+{
+    AdaptiveTimeouts timeouts;
+    for (size_t i = 0; i + 1 < AdaptiveTimeouts::MIN_SAMPLES; ++i)
+        timeouts.Record(50, 800, 20, 40);
+    PhaseTimeouts result = timeouts.Compute(Ceilings(), 40);
+    CHECK_EQ(result.connectMs, 60000);
+    CHECK_EQ(result.responseMs, 30000);
+
+    timeouts.Record(50, 800, 20, 40);
+    result = timeouts.Compute(Ceilings(), 40);
+    CHECK(result.responseMs < 30000);
+}
+
+TEST_CASE(TightensToFloorsForFastRequests)
+{
+    AdaptiveTimeouts timeouts;
+    for (int i = 0; i < 100; ++i)
+        timeouts.Record(40, 600, 15, 40);
+    PhaseTimeouts result = timeouts.Compute(Ceilings(), 40);
+    CHECK_EQ(result.connectMs, AdaptiveTimeouts::MIN_CONNECT_MS);
+    CHECK_EQ(result.sendMs, AdaptiveTimeouts::MIN_CONNECT_MS);
+    CHECK_EQ(result.idleMs, AdaptiveTimeouts::MIN_IDLE_MS);
+    CHECK_EQ(result.responseMs, AdaptiveTimeouts::MIN_RESPONSE_MS);
+}
+
+TEST_CASE(ScalesResponseTimeoutWithExpectedTokens)
+{
+    // 每个token约50毫秒：短请求约3.6秒，长请求按token数放大
+    AdaptiveTimeouts timeouts;
+    for (int i = 0; i < 100; ++i)
+        timeouts.Record(40, 50.0 * (40 + AdaptiveTimeouts::TOKEN_OVERHEAD), 15, 40);
+    PhaseTimeouts shortRequest = timeouts.Compute(Ceilings(), 40);
+    PhaseTimeouts longRequest = timeouts.Compute(Ceilings(), 120);
+    CHECK(shortRequest.responseMs >= 3 * 50 * 72 && shortRequest.responseMs <= 3 * 60 * 72);
+    CHECK(longRequest.responseMs > shortRequest.responseMs * 2);
+
+    // 不超过配置的超时；配置为0（无限）时不设上限
+    PhaseTimeouts huge = timeouts.Compute(Ceilings(), 10000);
+    CHECK_EQ(huge.responseMs, 30000);
+    PhaseTimeouts unlimited = Ceilings();
+    unlimited.responseMs = 0;
+    CHECK(timeouts.Compute(unlimited, 10000).responseMs > 30000);
+}
+
+TEST_CASE(ResetRestoresConfiguredTimeouts)
+{
+    AdaptiveTimeouts timeouts;
+    for (int i = 0; i < 100; ++i)
+        timeouts.Record(40, 600, 15, 40);
+    timeouts.Reset();
+    CHECK_EQ(timeouts.Compute(Ceilings(), 40).responseMs, 30000);
+}
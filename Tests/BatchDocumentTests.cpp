@@ -0,0 +1,147 @@
+﻿#include "TestHarness.h"
+#include "BatchDocument.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace
+{
+    // 逐条完成并取出全部输出，译文为"<原文>"
+    std::string TranslateAll(BatchDocument& document)
+    {
+        for (size_t i = 0; i < document.GetRecordCount(); ++i)
+            document.Complete(i, true, "<" + document.GetRecord(i) + ">");
+        std::string out;
+        document.TakeReady(out);
+        return out;
+    }
+}
+
+TEST_CASE(SplitsNonEmptyLinesAndKeepsLayout)
+{
+    BatchDocument document("  first line\r\n\n\tsecond \r\nthird", BatchSplit::Lines);
+    REQUIRE(document.GetRecordCount() == 3);
+    CHECK_EQ(document.GetRecord(0), std::string("first line"));
+    CHECK_EQ(document.GetRecord(1), std::string("second"));
+    CHECK_EQ(document.GetRecord(2), std::string("third"));
+    CHECK_EQ(TranslateAll(document), std::string("  <first line>\r\n\n\t<second> \r\n<third>"));
+    CHECK(document.IsFinished());
+}
+
+TEST_CASE(SplitsParagraphsOnBlankLines)
+{
+    BatchDocument document("one\ntwo\n  \nthree\n\n\nfour\n", BatchSplit::Paragraphs);
+    REQUIRE(document.GetRecordCount() == 3);
+    CHECK_EQ(document.GetRecord(0), std::string("one\ntwo"));
+    CHECK_EQ(document.GetRecord(1), std::string("three"));
+    CHECK_EQ(document.GetRecord(2), std::string("four"));
+    CHECK_EQ(TranslateAll(document), std::string("<one\ntwo>\n  \n<three>\n\n\n<four>\n"));
+}
+
+TEST_CASE(KeepsByteOrderMarkOutsideFirstRecord)
+{
+    BatchDocument document("\xEF\xBB\xBFhello\nworld\n", BatchSplit::Lines);
+    REQUIRE(document.GetRecordCount() == 2);
+    CHECK_EQ(document.GetRecord(0), std::string("hello"));
+    CHECK_EQ(TranslateAll(document), std::string("\xEF\xBB\xBF<hello>\n<world>\n"));
+}
+
+TEST_CASE(LineModeFoldsNewlinesInResult)
+{
+    BatchDocument document("a\nb\n", BatchSplit::Lines);
+    document.Complete(0, true, "x\r\ny \n");
+    document.Complete(1, true, "z");
+    std::string out;
+    document.TakeReady(out);
+    CHECK_EQ(out, std::string("x y\nz\n"));
+}
+
+TEST_CASE(FailedAndEmptyResultsFallBackToSource)
+{
+    BatchDocument document("a\nb\nc", BatchSplit::Lines);
+    document.Complete(0, false, "ignored");
+    document.Complete(1, true, std::string());
+    document.Complete(2, true, "C");
+    // 重复完成不改变结果也不重复计数
+    document.Complete(2, false, std::string());
+    std::string out;
+    document.TakeReady(out);
+    CHECK_EQ(out, std::string("a\nb\nC"));
+    CHECK_EQ(document.GetCompletedCount(), static_cast<size_t>(3));
+    CHECK_EQ(document.GetFailedCount(), static_cast<size_t>(2));
+}
+
+TEST_CASE(TakesOnlyContiguousPrefix)
+{
+    BatchDocument document("a\nb\nc\n", BatchSplit::Lines);
+    std::string out;
+    document.Complete(1, true, "B");
+    CHECK_EQ(document.TakeReady(out), static_cast<size_t>(0));
+    CHECK_EQ(out, std::string());
+
+    document.Complete(0, true, "A");
+    CHECK_EQ(document.TakeReady(out), static_cast<size_t>(2));
+    CHECK_EQ(out, std::string("A\nB"));
+    CHECK(!document.IsFinished());
+
+    document.Complete(2, true, "C");
+    CHECK_EQ(document.TakeReady(out), static_cast<size_t>(1));
+    CHECK_EQ(out, std::string("A\nB\nC\n"));
+    CHECK(document.IsFinished());
+}
+
+TEST_CASE(BlankInputFinishesImmediately)
+{
+    BatchDocument document(" \n\t\n", BatchSplit::Paragraphs);
+    CHECK_EQ(document.GetRecordCount(), static_cast<size_t>(0));
+    CHECK(document.WaitForProgress(std::chrono::milliseconds(0)));
+    std::string out;
+    document.TakeReady(out);
+    CHECK_EQ(out, std::string(" \n\t\n"));
+    CHECK(document.IsFinished());
+}
+
+TEST_CASE(ConcurrentCompletionPreservesOrder)
+{
+    std::string input;
+    std::string expected;
+    const size_t count = 2000;
+    for (size_t i = 0; i < count; ++i)
+    {
+        input += "line " + std::to_string(i) + "\n";
+        expected += "LINE " + std::to_string(i) + "\n";
+    }
+    BatchDocument document(input, BatchSplit::Lines);
+    REQUIRE(document.GetRecordCount() == count);
+
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+    const size_t threadCount = 4;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (size_t k = t; k < count; k += threadCount)
+            {
+                size_t index = order[k];
+                document.Complete(index, true, "LINE " + document.GetRecord(index).substr(5));
+            }
+        });
+    }
+
+    // 主线程与批量模式相同：等待进度并按顺序取出
+    std::string out;
+    while (!document.IsFinished())
+    {
+        document.WaitForProgress(std::chrono::milliseconds(10));
+        document.TakeReady(out);
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    CHECK(out == expected);
+    CHECK_EQ(document.GetFailedCount(), static_cast<size_t>(0));
+}
@@ -0,0 +1,55 @@
+﻿/**
+ * 代码拆分基准：对给定的源文件整体执行Analyze，输出词法分析吞吐量和批量请求占选中文本的比例。
+ * 用法：CodeLexerThroughput 文件...（如 Source/Private/*.cpp）
+ */
+#include "CodeLexer.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s file...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<CodeSegment> segments;
+    std::string batch;
+    size_t totalBytes = 0;
+    double totalSeconds = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        std::string text = content.str();
+        if (text.empty())
+            continue;
+
+        // 重复执行到至少50毫秒，减小计时误差
+        bool code = false;
+        int runs = 0;
+        auto begin = std::chrono::steady_clock::now();
+        double seconds = 0;
+        while (seconds < 0.05)
+        {
+            code = CodeLexer::Analyze(text, segments);
+            runs++;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        CodeLexer::BuildBatch(text, segments, batch);
+        totalBytes += text.length() * runs;
+        totalSeconds += seconds;
+        std::printf("%-48s %8zu bytes  %s  %4zu segments  batch %5.1f%%  %6.1f MB/s\n", argv[i], text.length(),
+            code ? "code" : "text", segments.size(), code ? 100.0 * batch.length() / text.length() : 0.0,
+            text.length() * runs / seconds / 1e6);
+    }
+    if (totalSeconds > 0)
+        std::printf("overall %.1f MB/s\n", totalBytes / totalSeconds / 1e6);
+    return 0;
+}
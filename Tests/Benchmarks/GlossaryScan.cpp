@@ -0,0 +1,89 @@
+﻿/**
+ * 术语表基准：编译十万条随机中文术语的耗时和状态数，以及扫描一段选中文本的耗时，
+ * 并与逐位置比较所有术语的朴素实现对照
+ */
+#include "Glossary.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedUs(Clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    }
+
+    // 常用汉字区间内的随机字符（UTF-8三字节）
+    void AppendCjk(std::mt19937& random, std::string& out)
+    {
+        uint32_t code = 0x4E00 + random() % 3000;
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+
+    size_t BruteForceCount(const std::vector<GlossaryEntry>& entries, const std::string& text)
+    {
+        size_t count = 0;
+        size_t position = 0;
+        while (position < text.length())
+        {
+            size_t best = 0;
+            for (const GlossaryEntry& entry : entries)
+            {
+                if (entry.term.length() > best && text.compare(position, entry.term.length(), entry.term) == 0)
+                    best = entry.term.length();
+            }
+            count += best > 0;
+            position += best > 0 ? best : 1;
+        }
+        return count;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::vector<GlossaryEntry> entries;
+    for (int i = 0; i < 100000; ++i)
+    {
+        GlossaryEntry entry;
+        int length = 2 + random() % 3;
+        for (int c = 0; c < length; ++c)
+            AppendCjk(random, entry.term);
+        entry.translation = "term" + std::to_string(i);
+        entries.push_back(std::move(entry));
+    }
+
+    auto begin = Clock::now();
+    GlossaryMatcher matcher(entries);
+    std::printf("compile: %zu terms, %zu states, %.1f ms\n", matcher.GetEntryCount(), matcher.GetStateCount(), ElapsedUs(begin) / 1000);
+
+    // 约214字节的选中文本：随机汉字中夹杂几条术语和ASCII
+    std::string text = "GetUserName: ";
+    while (text.length() < 200)
+    {
+        if (random() % 8 == 0)
+            text += entries[random() % entries.size()].term;
+        else
+            AppendCjk(random, text);
+    }
+    text += " (v2)";
+
+    std::vector<GlossaryMatch> matches;
+    const int iterations = 20000;
+    begin = Clock::now();
+    size_t found = 0;
+    for (int i = 0; i < iterations; ++i)
+        found = matcher.FindMatches(text, matches);
+    std::printf("scan %zu bytes: %zu matches, %.2f us\n", text.length(), found, ElapsedUs(begin) / iterations);
+
+    begin = Clock::now();
+    size_t reference = BruteForceCount(entries, text);
+    std::printf("brute force: %zu matches, %.0f us\n", reference, ElapsedUs(begin));
+    return reference == found ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+﻿/**
+ * 热键取词模型：十万次按下热键，用户在热键触发后40-220毫秒内松开各个修饰键，
+ * 1%的情况下某个键按住超过1秒；目标程序在收到Ctrl+C后5-40毫秒内写入剪切板。
+ * 修改前：触发时立即发送Ctrl+C，固定等待50毫秒后每50毫秒检查一次剪切板；
+ * 修改后：ModifierTracker等到Shift、Alt、Win全部松开（最多1秒）再发送Ctrl+C，每5毫秒检查剪切板序列号。
+ * 统计取到选中文本的时间，以及发送Ctrl+C时仍按着Shift的比例
+ */
+#include "ModifierTracker.h"
+#include "TranslationProfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const int RUNS = 100000;
+    const uint32_t RELEASE_TIMEOUT_MS = 1000;
+    const uint32_t WAITED = HotkeyBinding::MOD_SHIFT_FLAG | HotkeyBinding::MOD_ALT_FLAG | HotkeyBinding::MOD_WIN_FLAG;
+
+    struct KeyRelease
+    {
+        uint32_t virtualKey;
+        uint64_t time;
+    };
+
+    // 从发送Ctrl+C的时刻起按固定间隔轮询，首次看到剪切板已写入的时刻
+    uint64_t PolledReady(uint64_t copyTime, uint64_t firstPoll, uint64_t interval, uint64_t written)
+    {
+        uint64_t poll = copyTime + firstPoll;
+        while (poll < written)
+            poll += interval;
+        return poll;
+    }
+
+    void Report(const char* name, std::vector<uint64_t>& ready, int shiftHeld)
+    {
+        double sum = 0;
+        for (uint64_t value : ready)
+            sum += static_cast<double>(value);
+        std::sort(ready.begin(), ready.end());
+        std::printf("%-34s ready mean %5.1f ms, p50 %4llu ms, p99 %4llu ms; Shift held during copy %6.2f%%\n", name,
+            sum / ready.size(), static_cast<unsigned long long>(ready[ready.size() / 2]),
+            static_cast<unsigned long long>(ready[ready.size() * 99 / 100]), 100.0 * shiftHeld / ready.size());
+    }
+
+    void Simulate(const char* name, const std::vector<uint32_t>& keys, std::mt19937& random)
+    {
+        std::uniform_int_distribution<uint64_t> releaseTime(40, 220);
+        std::uniform_int_distribution<uint64_t> clipboardDelay(5, 40);
+        std::vector<uint64_t> before;
+        std::vector<uint64_t> after;
+        int shiftBefore = 0;
+        int shiftAfter = 0;
+
+        for (int run = 0; run < RUNS; ++run)
+        {
+            std::vector<KeyRelease> releases;
+            for (uint32_t key : keys)
+                releases.push_back({ key, random() % 100 == 0 ? 1000 + releaseTime(random) : releaseTime(random) });
+            std::sort(releases.begin(), releases.end(), [](const KeyRelease& a, const KeyRelease& b) { return a.time < b.time; });
+            uint64_t delay = clipboardDelay(random);
+
+            bool shiftInHotkey = false;
+            for (uint32_t key : keys)
+                shiftInHotkey |= ModifierTracker::ModifierOf(key) == HotkeyBinding::MOD_SHIFT_FLAG;
+
+            // 修改前：时刻0发送Ctrl+C
+            shiftBefore += shiftInHotkey;
+            before.push_back(PolledReady(0, 100, 50, delay));
+
+            // 修改后：初始状态为热键的全部修饰键按下，键盘事件依次抬起，定时器按期限检查
+            ModifierTracker tracker;
+            tracker.Arm(0, RELEASE_TIMEOUT_MS, WAITED);
+            for (uint32_t key : keys)
+                tracker.OnKey(key, true);
+            uint64_t copyTime = 0;
+            if (tracker.OnTick(0) == ModifierTracker::State::Waiting)
+            {
+                copyTime = RELEASE_TIMEOUT_MS;
+                for (const KeyRelease& release : releases)
+                {
+                    if (release.time >= RELEASE_TIMEOUT_MS)
+                        break;
+                    if (tracker.OnKey(release.virtualKey, false) == ModifierTracker::State::Released)
+                    {
+                        copyTime = release.time;
+                        break;
+                    }
+                }
+            }
+            bool held = false;
+            for (const KeyRelease& release : releases)
+                held |= ModifierTracker::ModifierOf(release.virtualKey) == HotkeyBinding::MOD_SHIFT_FLAG && release.time > copyTime;
+            shiftAfter += held;
+            after.push_back(PolledReady(copyTime, 0, 5, copyTime + delay));
+        }
+
+        std::printf("%s\n", name);
+        Report("  before (copy at once, 50 ms polls)", before, shiftBefore);
+        Report("  after (wait release, 5 ms polls)", after, shiftAfter);
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    Simulate("Ctrl+Space", { 0xA2 }, random);
+    Simulate("Ctrl+Shift+Space", { 0xA2, 0xA0 }, random);
+    return 0;
+}
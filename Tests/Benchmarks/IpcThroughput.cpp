@@ -0,0 +1,145 @@
+﻿/**
+ * 本地IPC帧编解码基准：用socketpair代替命名管道，每个客户端发送一条Batch请求，
+ * 服务端线程解码后由桩翻译逐条应答Result帧，客户端解码全部应答后结束；
+ * 统计不同客户端数下每秒往返的Result帧数（只衡量协议和读写路径，不含翻译本身）
+ */
+#include "IpcProtocol.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const uint32_t ITEMS_PER_CLIENT = 10000;
+
+    bool WriteAll(int fd, const std::string& data)
+    {
+        size_t written = 0;
+        while (written < data.length())
+        {
+            ssize_t result = write(fd, data.data() + written, data.length() - written);
+            if (result <= 0)
+                return false;
+            written += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    // 服务端：读出Batch帧后逐条应答（桩翻译把原文原样返回），每攒满64KB写出一次
+    void Serve(int fd)
+    {
+        IpcFrameDecoder decoder;
+        char buffer[65536];
+        IpcFrame frame;
+        while (!decoder.Next(frame))
+        {
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0)
+                return;
+            decoder.Feed(buffer, static_cast<size_t>(length));
+        }
+
+        size_t offset = 0;
+        std::string profile;
+        uint32_t count = 0;
+        IpcProtocol::ReadString(frame.payload, offset, profile);
+        IpcProtocol::ReadU32(frame.payload, offset, count);
+        std::string out;
+        std::string text;
+        for (uint32_t i = 0; i < count && IpcProtocol::ReadString(frame.payload, offset, text); ++i)
+        {
+            IpcProtocol::EncodeResult(frame.requestId, i, IpcStatus::Ok, text, out);
+            if (out.length() >= sizeof(buffer))
+            {
+                WriteAll(fd, out);
+                out.clear();
+            }
+        }
+        std::string payload;
+        IpcProtocol::PutU32(count, payload);
+        IpcProtocol::EncodeFrame(IpcFrameType::Done, frame.requestId, payload, out);
+        WriteAll(fd, out);
+    }
+
+    // 客户端：发送一条Batch请求并读到Done为止，返回收到的Result帧数
+    size_t Request(int fd, uint32_t requestId)
+    {
+        std::string payload;
+        IpcProtocol::PutString("default", payload);
+        IpcProtocol::PutU32(ITEMS_PER_CLIENT, payload);
+        for (uint32_t i = 0; i < ITEMS_PER_CLIENT; ++i)
+            IpcProtocol::PutString("Translate line " + std::to_string(i), payload);
+        std::string request;
+        IpcProtocol::EncodeFrame(IpcFrameType::Batch, requestId, payload, request);
+        if (!WriteAll(fd, request))
+            return 0;
+
+        IpcFrameDecoder decoder;
+        char buffer[65536];
+        size_t results = 0;
+        for (;;)
+        {
+            IpcFrame frame;
+            while (decoder.Next(frame))
+            {
+                if (frame.type == IpcFrameType::Done)
+                    return results;
+                ++results;
+            }
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0)
+                return results;
+            decoder.Feed(buffer, static_cast<size_t>(length));
+        }
+    }
+}
+
+int main()
+{
+    for (int clients : { 1, 4, 16, 64 })
+    {
+        std::vector<int> serverEnds;
+        std::vector<int> clientEnds;
+        for (int i = 0; i < clients; ++i)
+        {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+            {
+                std::perror("socketpair");
+                return 1;
+            }
+            serverEnds.push_back(fds[0]);
+            clientEnds.push_back(fds[1]);
+        }
+
+        std::vector<size_t> received(clients, 0);
+        std::vector<std::thread> threads;
+        auto begin = Clock::now();
+        for (int i = 0; i < clients; ++i)
+        {
+            threads.emplace_back(Serve, serverEnds[i]);
+            threads.emplace_back([&, i] { received[i] = Request(clientEnds[i], static_cast<uint32_t>(i + 1)); });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+        size_t total = 0;
+        for (size_t count : received)
+            total += count;
+        std::printf("%2d clients: %zu result frames in %.1f ms, %.2fM frames/s%s\n", clients, total, seconds * 1000,
+            total / seconds / 1e6, total == static_cast<size_t>(clients) * ITEMS_PER_CLIENT ? "" : " (INCOMPLETE)");
+
+        for (int fd : serverEnds)
+            close(fd);
+        for (int fd : clientEnds)
+            close(fd);
+    }
+    return 0;
+}
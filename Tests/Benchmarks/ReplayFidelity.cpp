@@ -0,0 +1,150 @@
+﻿/**
+ * 录制回放基准：模拟的SSE服务端按随机的首字节耗时和分块间隔应答，4个线程并发录制40次请求；
+ * 统计录制文件大小，按系数1回放时与录制时延迟的偏差，以及系数0时一万次回放经ChatResponseParser解析的耗时
+ */
+#include "HttpRecording.h"
+#include "ResponseStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int THREADS = 4;
+    const int EXCHANGES = 40;
+    const int REPLAYS = 10000;
+
+    // 模拟的流式聊天补全接口：首字节10-60毫秒，之后每块间隔1-8毫秒
+    class FakeSseTransport : public HttpTransport
+    {
+    public:
+        bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) override
+        {
+            std::mt19937 random(static_cast<uint32_t>(request.body.length() * 7919 + request.body[request.body.length() - 1]));
+            result = HttpResult();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10 + random() % 51));
+            int chunks = 10 + random() % 30;
+            for (int i = 0; i < chunks; ++i)
+            {
+                std::string event = "data: {\"choices\":[{\"delta\":{\"content\":\"token" + std::to_string(i) + " \"}}]}\n\n";
+                onData(event.data(), event.length());
+                std::this_thread::sleep_for(std::chrono::microseconds(1000 + random() % 7000));
+            }
+            std::string tail = "data: {\"choices\":[],\"usage\":{\"prompt_tokens\":30,\"completion_tokens\":" +
+                std::to_string(chunks) + "}}\n\ndata: [DONE]\n\n";
+            onData(tail.data(), tail.length());
+            result.statusCode = 200;
+            return true;
+        }
+    };
+
+    HttpRequest MakeRequest(const std::string& body)
+    {
+        HttpRequest request;
+        request.host = L"api.example.com";
+        request.path = L"/v1/chat/completions";
+        request.headers = L"Content-Type: application/json\r\nAuthorization: Bearer sk-benchmark-secret\r\n";
+        request.body = body;
+        return request;
+    }
+
+    std::string Body(int index)
+    {
+        return "{\"model\":\"m\",\"stream\":true,\"messages\":[{\"role\":\"user\",\"content\":\"sentence " + std::to_string(index) + "\"}]}";
+    }
+}
+
+int main()
+{
+    std::string path = (std::filesystem::temp_directory_path() / "YunsioReplayFidelity.ytrr").string();
+    std::vector<double> recorded(EXCHANGES, 0);
+    {
+        RecordingTransport recorder(std::unique_ptr<HttpTransport>(new FakeSseTransport()));
+        if (!recorder.Open(path))
+        {
+            std::printf("cannot create %s\n", path.c_str());
+            return 1;
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                for (int i = t; i < EXCHANGES; i += THREADS)
+                {
+                    std::string body = Body(i);
+                    HttpResult result;
+                    auto begin = Clock::now();
+                    recorder.Send(MakeRequest(body), [](const char*, size_t) {}, result);
+                    recorded[i] = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    ReplayTransport replay;
+    if (!replay.Load(path, 1.0))
+        return 1;
+    size_t payload = 0;
+    {
+        ReplayTransport counter;
+        counter.Load(path, 0);
+        for (int i = 0; i < EXCHANGES; ++i)
+        {
+            std::string body = Body(i);
+            HttpResult result;
+            counter.Send(MakeRequest(body), [&](const char*, size_t length) { payload += length; }, result);
+        }
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::printf("recorded %zu exchanges: %.0f KB file, %.0f KB payload, API key %s\n", replay.GetExchangeCount(),
+        content.length() / 1024.0, payload / 1024.0, content.find("sk-benchmark-secret") == std::string::npos ? "redacted" : "LEAKED");
+
+    double sumError = 0;
+    double maxError = 0;
+    for (int i = 0; i < EXCHANGES; ++i)
+    {
+        std::string body = Body(i);
+        HttpResult result;
+        auto begin = Clock::now();
+        replay.Send(MakeRequest(body), [](const char*, size_t) {}, result);
+        double error = std::fabs(std::chrono::duration<double, std::milli>(Clock::now() - begin).count() - recorded[i]);
+        sumError += error;
+        maxError = std::max(maxError, error);
+    }
+    std::printf("scale 1: latency error mean %.2f ms, max %.2f ms\n", sumError / EXCHANGES, maxError);
+
+    ReplayTransport fast;
+    fast.Load(path, 0);
+    std::vector<std::string> bodies;
+    for (int i = 0; i < EXCHANGES; ++i)
+        bodies.push_back(Body(i));
+    ChatResponseParser parser;
+    for (int run = 0; run < 3; ++run)
+    {
+        size_t parsed = 0;
+        auto begin = Clock::now();
+        for (int i = 0; i < REPLAYS; ++i)
+        {
+            parser.Reset();
+            HttpResult result;
+            fast.Send(MakeRequest(bodies[i % EXCHANGES]), [&](const char* data, size_t length) { parser.Feed(data, length); }, result);
+            parsed += parser.Finish();
+        }
+        std::printf("scale 0: %d replays parsed (%zu complete) in %.1f ms\n", REPLAYS, parsed,
+            std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,199 @@
+﻿/**
+ * 请求缓冲区基准：两万次模拟翻译请求（原文50-4000字节，0.5%为400KB的超大选中内容），
+ * 每次把原文写入请求体模板，SSE响应按1460字节分块经环形缓冲区送入解析器，再把译文拓宽为宽字符串。
+ * 修改前：每次请求使用新的缓冲区；修改后：复用线程局部的RequestArena，请求结束时Reset。
+ * 用计数的operator new统计每次请求的堆分配次数和字节数，两种方式各在一个子进程中运行以分别统计峰值RSS
+ */
+#include "RequestArena.h"
+#include "RequestTemplate.h"
+#include "TranslationProfile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    std::atomic<uint64_t> s_allocations{ 0 };
+    std::atomic<uint64_t> s_allocatedBytes{ 0 };
+
+    const int REQUESTS = 20000;
+    const size_t POOL_SIZE = 64;
+    const size_t HUGE_BYTES = 400 * 1024;
+    const size_t PACKET_BYTES = 1460;
+
+    struct Exchange
+    {
+        std::string source;
+        std::string response;
+    };
+
+    // 译文按每20字节一个SSE事件返回，最后附带usage
+    std::string MakeResponse(const std::string& content)
+    {
+        std::string response;
+        for (size_t i = 0; i < content.length(); i += 20)
+        {
+            response += "data: {\"choices\":[{\"delta\":{\"content\":\"";
+            RequestTemplate::AppendJsonEscaped(response, content.data() + i, std::min<size_t>(20, content.length() - i));
+            response += "\"}}]}\n\n";
+        }
+        response += "data: {\"choices\":[],\"usage\":{\"prompt_tokens\":120,\"completion_tokens\":80}}\n\ndata: [DONE]\n\n";
+        return response;
+    }
+
+    Exchange MakeExchange(size_t bytes, std::mt19937& random)
+    {
+        static const char* const words[] = { "object ", "name ", "returns ", "the ", "value ", "of ", "config ", "when ", "\"quoted\" ", "line\n" };
+        Exchange exchange;
+        while (exchange.source.length() < bytes)
+            exchange.source += words[random() % 10];
+        exchange.response = MakeResponse(exchange.source);
+        return exchange;
+    }
+
+    // 一次请求经过的全部缓冲区（与TranslationService::Translate使用的字段相同）
+    size_t RunRequest(RequestArena& arena, const RequestTemplate& requestTemplate, const Exchange& exchange)
+    {
+        arena.utf8Text.assign(exchange.source);
+        requestTemplate.BuildBody(arena.utf8Text, arena.body);
+
+        size_t offset = 0;
+        while (offset < exchange.response.length() || arena.responseRing.GetSize() > 0)
+        {
+            size_t writable = 0;
+            char* span = arena.responseRing.GetWriteSpan(writable);
+            size_t length = std::min({ writable, PACKET_BYTES, exchange.response.length() - offset });
+            std::copy(exchange.response.data() + offset, exchange.response.data() + offset + length, span);
+            arena.responseRing.CommitWrite(length);
+            offset += length;
+
+            size_t readable = 0;
+            const char* data = arena.responseRing.GetReadSpan(readable);
+            arena.parser.Feed(data, readable);
+            arena.responseRing.ConsumeRead(readable);
+        }
+        if (!arena.parser.Finish())
+            return 0;
+
+        // 测试文本为ASCII，按字节拓宽等同于UTF-8转UTF-16（逐个写入，assign迭代器区间会先构造临时字符串）
+        const std::string& content = arena.parser.GetContent();
+        arena.result.resize(content.length());
+        std::copy(content.begin(), content.end(), arena.result.begin());
+        return arena.body.length() + arena.result.length();
+    }
+
+    long PeakRssKb()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    void Measure(const char* name, bool reuse)
+    {
+        std::mt19937 random(42);
+        std::lognormal_distribution<double> sourceBytes(std::log(400.0), 0.9);
+        std::vector<Exchange> pool;
+        for (size_t i = 0; i < POOL_SIZE; ++i)
+            pool.push_back(MakeExchange(std::min<size_t>(std::max<size_t>(static_cast<size_t>(sourceBytes(random)), 50), 4000), random));
+        Exchange huge = MakeExchange(HUGE_BYTES, random);
+
+        TranslationProfile profile;
+        profile.model = "gpt-4o-mini";
+        profile.systemPrompt = "You are a translation engine. Translate the user's text between Chinese and English. Output only the translation.";
+        RequestTemplate requestTemplate(profile);
+
+        // 预热：线程局部实例先处理一次普通请求，让稳态容量就位
+        if (reuse)
+        {
+            RunRequest(RequestArena::ForCurrentThread(), requestTemplate, pool[0]);
+            RequestArena::ForCurrentThread().Reset();
+        }
+
+        long startRss = PeakRssKb();
+        uint64_t allocations = s_allocations;
+        uint64_t allocatedBytes = s_allocatedBytes;
+        size_t checksum = 0;
+        size_t hugeCount = 0;
+        size_t maxRetained = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < REQUESTS; ++i)
+        {
+            bool isHuge = random() % 200 == 0;
+            hugeCount += isHuge;
+            const Exchange& exchange = isHuge ? huge : pool[random() % POOL_SIZE];
+            if (reuse)
+            {
+                RequestArena& arena = RequestArena::ForCurrentThread();
+                checksum += RunRequest(arena, requestTemplate, exchange);
+                arena.Reset();
+                maxRetained = std::max(maxRetained, arena.GetCapacityBytes());
+            }
+            else
+            {
+                RequestArena arena;
+                checksum += RunRequest(arena, requestTemplate, exchange);
+            }
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+        std::printf("%s\n", name);
+        std::printf("  %d requests (%zu huge): %.2f allocations and %.1f KB allocated per request, %.1f us per request\n",
+            REQUESTS, hugeCount, static_cast<double>(s_allocations - allocations) / REQUESTS,
+            (s_allocatedBytes - allocatedBytes) / 1024.0 / REQUESTS, elapsed / REQUESTS);
+        std::printf("  peak RSS %ld KB (%ld KB above the start of the run)", PeakRssKb(), PeakRssKb() - startRss);
+        if (reuse)
+            std::printf(", retained capacity after Reset at most %.1f KB (cap %zu KB)", maxRetained / 1024.0, RequestArena::MAX_RETAINED_BYTES / 1024);
+        std::printf(", checksum %zu\n", checksum);
+        std::fflush(stdout);
+    }
+
+    // 各在一个子进程中运行，峰值RSS互不影响
+    void MeasureInChild(const char* name, bool reuse)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            Measure(name, reuse);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+
+void* operator new(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int main()
+{
+    MeasureInChild("before: new buffers for every request", false);
+    MeasureInChild("after: thread-local RequestArena reset between requests", true);
+    return 0;
+}
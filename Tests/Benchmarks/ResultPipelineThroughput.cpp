@@ -0,0 +1,85 @@
+﻿/**
+ * 译文后处理基准：每个阶段单独处理有代表性的输入（标识符方向的短译文和一段约1KB的段落译文），
+ * 最后是标识符配置档的完整流水线。每次从同一个预留容量的缓冲区复制输入后原地处理，稳态下不分配内存；
+ * 单独列出只复制输入的耗时作为基线
+ */
+#include "ResultPipeline.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace
+{
+    const int ITERATIONS = 500000;
+
+    // 重复拼接段落，得到约1KB的长译文
+    std::string Paragraph(const std::string& sentence)
+    {
+        std::string text;
+        while (text.length() < 1000)
+            text += sentence;
+        return text;
+    }
+
+    void Time(const char* stage, const char* kind, const std::string& input, const std::function<void(std::string&)>& apply)
+    {
+        std::string text;
+        text.reserve(input.length() * 2);
+        size_t checksum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            text.assign(input);
+            apply(text);
+            checksum += text.length();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("%-12s %-10s %5zu -> %5zu bytes  %8.1f ns per run (checksum %zu)\n", stage, kind, input.length(),
+            text.length(), elapsed / ITERATIONS, checksum);
+    }
+}
+
+int main()
+{
+    const std::string chinese = "该函数返回对象的名称，如果对象尚未初始化则返回空字符串。";
+    const std::string english = "Returns the name of the object, or an empty string if it is not initialized yet. ";
+    const std::vector<ResultPipeline::Replacement> replacements = { { "config", "configuration" }, { "id", "identifier" }, { "msg", "message" } };
+
+    Time("Copy", "short", "get object name", [](std::string&) {});
+    Time("Copy", "paragraph", Paragraph(chinese), [](std::string&) {});
+
+    Time("Trim", "short", "\xE3\x80\x80  get object name \xC2\xA0\n", ResultPipeline::Trim);
+    Time("Trim", "paragraph", "\n  " + Paragraph(chinese) + "  \n", ResultPipeline::Trim);
+
+    Time("Fences", "short", "```text\nget object name\n```", ResultPipeline::StripFences);
+    Time("Fences", "paragraph", "```\n" + Paragraph(english) + "\n```", ResultPipeline::StripFences);
+
+    Time("Explanation", "short", "get object name (returns the name of the object)", ResultPipeline::StripExplanation);
+    Time("Explanation", "multiline", "get object name\n" + Paragraph(english), ResultPipeline::StripExplanation);
+    Time("Explanation", "paragraph", Paragraph(chinese), ResultPipeline::StripExplanation);
+
+    auto quotes = [](std::string& text) { ResultPipeline::StripQuotes(text); };
+    Time("Quotes", "short", "\xE2\x80\x9Cget object name\xE2\x80\x9D", quotes);
+    Time("Quotes", "paragraph", "\xE3\x80\x8C" + Paragraph(chinese) + "\xE3\x80\x8D", quotes);
+
+    Time("Period", "short", "Get the object name.", ResultPipeline::StripTrailingPeriod);
+    Time("Period", "paragraph", Paragraph(english), ResultPipeline::StripTrailingPeriod);
+
+    Time("Charset", "short", "get the object's name/id - v2", ResultPipeline::EnforceIdentifierCharset);
+    Time("Charset", "paragraph", Paragraph(english), ResultPipeline::EnforceIdentifierCharset);
+
+    auto replace = [&replacements](std::string& text) { ResultPipeline::ApplyReplacements(text, replacements); };
+    Time("Replace", "short", "load config by id", replace);
+    Time("Replace", "paragraph", Paragraph("Send the msg with the config id to the server. "), replace);
+
+    auto limit = [](std::string& text) { ResultPipeline::LimitLength(text, 64); };
+    Time("MaxLength", "short", "get object name", limit);
+    Time("MaxLength", "paragraph", Paragraph(chinese), limit);
+
+    ResultPipeline pipeline(ResultPipeline::DEFAULT_TEXT_STAGES | ResultPipeline::IDENTIFIER_STAGES, 64, replacements);
+    auto full = [&pipeline](std::string& text) { pipeline.Apply(text); };
+    Time("Pipeline", "short", "```text\n\"`GetObjectName`\" (returns the name of the object).\nThis is the PascalCase form.\n```\n", full);
+    Time("Pipeline", "paragraph", "\"" + Paragraph(english) + "\"", full);
+    return 0;
+}
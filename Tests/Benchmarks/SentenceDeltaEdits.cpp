@@ -0,0 +1,115 @@
+﻿/**
+ * 增量翻译基准：每行2000个段落，按比例随机替换或插入句子后生成增量计划，
+ * 统计批量请求占整段原文的字节比例，以及生成计划、拼接请求和拼回译文的本地耗时
+ */
+#include "SentenceDelta.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int PARAGRAPHS = 2000;
+
+    std::string RandomSentence(std::mt19937& random)
+    {
+        size_t words = 6 + random() % 15;
+        std::string sentence;
+        for (size_t w = 0; w < words; ++w)
+        {
+            if (w > 0)
+                sentence += ' ';
+            size_t length = 2 + random() % 8;
+            for (size_t c = 0; c < length; ++c)
+                sentence += static_cast<char>('a' + random() % 26);
+        }
+        sentence[0] = static_cast<char>(sentence[0] - 'a' + 'A');
+        return sentence + '.';
+    }
+
+    std::string Join(const std::vector<std::string>& sentences, const char* separator)
+    {
+        std::string text;
+        for (size_t i = 0; i < sentences.size(); ++i)
+        {
+            if (i > 0)
+                text += separator;
+            text += sentences[i];
+        }
+        return text;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    for (size_t sentenceCount : { 5, 10, 50 })
+    {
+        for (int percent : { 10, 20, 50 })
+        {
+            uint64_t selectedBytes = 0;
+            uint64_t sentBytes = 0;
+            int planned = 0;
+            std::vector<double> micros;
+            for (int p = 0; p < PARAGRAPHS; ++p)
+            {
+                std::vector<std::string> previous;
+                std::vector<std::string> translated;
+                for (size_t s = 0; s < sentenceCount; ++s)
+                {
+                    previous.push_back(RandomSentence(random));
+                    translated.push_back("T" + std::to_string(s) + "。");
+                }
+
+                // 至少改动一句：一半替换，一半在该句之后插入新句
+                std::vector<std::string> edited = previous;
+                size_t edits = std::max<size_t>(1, (sentenceCount * percent + 50) / 100);
+                for (size_t e = 0; e < edits; ++e)
+                {
+                    size_t position = random() % edited.size();
+                    if (random() % 2 == 0)
+                        edited[position] = RandomSentence(random);
+                    else
+                        edited.insert(edited.begin() + position + 1, RandomSentence(random));
+                }
+
+                std::string source = Join(edited, " ");
+                auto begin = Clock::now();
+                SentenceDelta delta;
+                std::string batch;
+                std::string batchResult;
+                std::string out;
+                bool usable = delta.Build(source, Join(previous, " "), Join(translated, ""));
+                if (usable)
+                {
+                    delta.BuildBatch(batch);
+                    for (size_t n = 1; n <= delta.GetChangedCount(); ++n)
+                        batchResult += std::to_string(n) + "|N" + std::to_string(n) + "。\n";
+                    delta.Assemble(batchResult, out);
+                }
+                micros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+
+                // 沿用部分不足一半时整段翻译（与TranslationManager的判断一致）
+                selectedBytes += source.length();
+                if (usable && delta.GetReusedBytes() * 2 >= source.length())
+                {
+                    ++planned;
+                    sentBytes += batch.length();
+                }
+                else
+                    sentBytes += source.length();
+            }
+
+            std::sort(micros.begin(), micros.end());
+            std::printf("%2zu sentences, %2d%% edits: request %3.0f%% of paragraph, %4d/%d planned, local p50 %.0f us / max %.0f us\n",
+                sentenceCount, percent, 100.0 * sentBytes / selectedBytes, planned, PARAGRAPHS,
+                micros[micros.size() / 2], micros.back());
+        }
+    }
+    return 0;
+}
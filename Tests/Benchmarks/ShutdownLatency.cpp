@@ -0,0 +1,66 @@
+﻿/**
+ * 退出延迟基准：调度器满载时按程序退出时的时限（排空1500毫秒、取消后500毫秒）停止，
+ * 测量三种负载下Stop的耗时。用法：ShutdownLatency [排空毫秒] [取消毫秒]
+ */
+#include "RequestScheduler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+    using namespace std::chrono;
+
+    // 模拟一次请求：每10毫秒检查一次取消信号（与WinHTTP回调检查取消的粒度相当）
+    RequestScheduler::Job MakeJob(milliseconds length, bool honourCancel)
+    {
+        return [length, honourCancel](const std::atomic<bool>& cancelled)
+        {
+            auto end = steady_clock::now() + length;
+            while (steady_clock::now() < end)
+            {
+                if (honourCancel && cancelled)
+                    return false;
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+            return true;
+        };
+    }
+
+    void Measure(const char* name, milliseconds length, bool honourCancel, milliseconds drain, milliseconds cancel)
+    {
+        RequestScheduler* scheduler = new RequestScheduler();
+        scheduler->Start(RequestScheduler::Limits());
+        for (int i = 0; i < 20; ++i)
+            scheduler->Submit(RequestPriority::Interactive, MakeJob(length, honourCancel));
+        for (int i = 0; i < 20; ++i)
+            scheduler->Submit(RequestPriority::Background, MakeJob(length, honourCancel));
+
+        // 等所有并发名额都在执行中再停止
+        std::this_thread::sleep_for(milliseconds(30));
+        auto begin = steady_clock::now();
+        bool drained = scheduler->Stop(drain, cancel);
+        double elapsed = duration_cast<duration<double, std::milli>>(steady_clock::now() - begin).count();
+        std::printf("%-28s %8.1f ms  %s\n", name, elapsed, drained ? "drained" : "blocked");
+
+        // 仍有任务阻塞时与程序退出路径相同：放弃调度器
+        if (drained)
+            delete scheduler;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    milliseconds drain(argc > 1 ? std::atoi(argv[1]) : 1500);
+    milliseconds cancel(argc > 2 ? std::atoi(argv[2]) : 500);
+    std::printf("drain %lld ms, cancel %lld ms, 20 interactive + 20 background queued\n",
+        static_cast<long long>(drain.count()), static_cast<long long>(cancel.count()));
+
+    Measure("short requests (150 ms)", milliseconds(150), true, drain, cancel);
+    Measure("long requests (10 s)", seconds(10), true, drain, cancel);
+    Measure("requests ignoring cancel", seconds(10), false, drain, cancel);
+
+    // 阻塞的工作线程不等待，直接结束进程
+    std::fflush(stdout);
+    std::_Exit(0);
+}
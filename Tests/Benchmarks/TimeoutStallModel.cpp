@@ -0,0 +1,110 @@
+﻿/**
+ * 自适应超时模型：两万次请求，输入20-1200字节，等待响应的耗时为固定开销加按实际输出token数的对数正态耗时，
+ * 2%的请求停滞（服务端不再应答）。停滞的请求在收紧的超时到期后按配置的超时重试一次。
+ * 统计每次停滞损失的时间（固定30秒超时对照）、健康请求被误判超时的比例，
+ * 以及后半段整体变慢一倍时的误判比例；每次超时重试都会再向限流器获取一个请求令牌
+ */
+#include "AdaptiveTimeouts.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    const int REQUESTS = 20000;
+    const double STALL_RATE = 0.02;
+    const int MAX_TOKENS = 1024;
+
+    struct Outcome
+    {
+        double stallLossMs = 0;
+        double smallStallLossMs = 0;
+        int stalls = 0;
+        int smallStalls = 0;
+        int healthy = 0;
+        int falseTimeouts = 0;
+        int overCeiling = 0;
+        int retries = 0;
+    };
+
+    Outcome Simulate(bool slowdown, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<size_t> inputBytes(20, 1200);
+        std::uniform_real_distribution<double> tokenRatio(0.25, 0.45);
+        std::lognormal_distribution<double> perTokenMs(std::log(10.0), 0.35);
+        std::lognormal_distribution<double> sendMs(std::log(40.0), 0.4);
+        std::lognormal_distribution<double> gapMs(std::log(8.0), 0.5);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        PhaseTimeouts ceilings;
+        ceilings.connectMs = 60000;
+        ceilings.sendMs = 30000;
+        ceilings.responseMs = 30000;
+        ceilings.idleMs = 30000;
+
+        AdaptiveTimeouts timeouts;
+        Outcome outcome;
+        for (int i = 0; i < REQUESTS; ++i)
+        {
+            size_t bytes = inputBytes(random);
+            size_t expected = AdaptiveTimeouts::EstimateOutputTokens(bytes, MAX_TOKENS);
+            double factor = slowdown && i >= REQUESTS / 2 ? 2.0 : 1.0;
+            double send = sendMs(random);
+            double response = factor * (300.0 + bytes * tokenRatio(random) * perTokenMs(random));
+            double gap = gapMs(random);
+            PhaseTimeouts limits = timeouts.Compute(ceilings, expected);
+            bool tightened = limits.responseMs < ceilings.responseMs;
+
+            if (unit(random) < STALL_RATE)
+            {
+                // 停滞：等满本次的超时后重试，重试按正常耗时完成
+                outcome.stalls++;
+                outcome.stallLossMs += limits.responseMs;
+                if (bytes < 200)
+                {
+                    outcome.smallStalls++;
+                    outcome.smallStallLossMs += limits.responseMs;
+                }
+                if (tightened)
+                    outcome.retries++;
+                timeouts.Record(send, response, gap, expected);
+                continue;
+            }
+
+            // 超过配置超时的请求无论是否收紧都会失败，不算误判
+            if (response > ceilings.responseMs)
+            {
+                outcome.overCeiling++;
+                continue;
+            }
+            outcome.healthy++;
+            if (response > limits.responseMs)
+            {
+                outcome.falseTimeouts++;
+                outcome.retries++;
+            }
+            timeouts.Record(send, response, gap, expected);
+        }
+        return outcome;
+    }
+
+    void Report(const char* name, const Outcome& outcome)
+    {
+        std::printf("%s\n", name);
+        std::printf("  time lost per stall: %.1f s (fixed timeout 30.0 s), %.1f s for selections under 200 bytes\n",
+            outcome.stallLossMs / outcome.stalls / 1000, outcome.smallStallLossMs / std::max(outcome.smallStalls, 1) / 1000);
+        std::printf("  false timeouts: %d of %d healthy requests (%.2f%%), each recovered by the retry; %d slower than the configured timeout\n",
+            outcome.falseTimeouts, outcome.healthy, 100.0 * outcome.falseTimeouts / outcome.healthy, outcome.overCeiling);
+        std::printf("  retries charged to the rate limiter: %d (%.2f%% extra requests)\n", outcome.retries,
+            100.0 * outcome.retries / REQUESTS);
+    }
+}
+
+int main()
+{
+    Report("steady latency", Simulate(false, 42));
+    Report("2x slowdown halfway through", Simulate(true, 42));
+    return 0;
+}
@@ -0,0 +1,151 @@
+﻿/**
+ * 翻译记忆基准：用Zipf分布词表生成5-20个词的英文句子，加入一百万条记录后，
+ * 统计插入耗时、常驻内存，以及在Hint阈值0.75下三类查询的召回率和P50/P99耗时：
+ * 改动一个字符、替换一个词、不相关的句子
+ */
+#include "TranslationMemory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const size_t ENTRY_COUNT = 1000000;
+    const size_t QUERY_COUNT = 2000;
+    const double THRESHOLD = 0.75;
+
+    class SentenceGenerator
+    {
+    public:
+        explicit SentenceGenerator(uint32_t seed) : m_random(seed)
+        {
+            // 两万个随机小写词，按1/rank的权重抽取
+            std::uniform_int_distribution<int> length(2, 10);
+            std::vector<double> weights;
+            for (int rank = 1; rank <= 20000; ++rank)
+            {
+                std::string word;
+                int count = length(m_random);
+                for (int i = 0; i < count; ++i)
+                    word += static_cast<char>('a' + m_random() % 26);
+                m_words.push_back(word);
+                weights.push_back(1.0 / rank);
+            }
+            m_pick = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+        }
+
+        std::string Sentence()
+        {
+            size_t count = 5 + m_random() % 16;
+            std::string sentence;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (i > 0)
+                    sentence += ' ';
+                sentence += Word();
+            }
+            sentence += '.';
+            return sentence;
+        }
+
+        const std::string& Word() { return m_words[m_pick(m_random)]; }
+
+        std::mt19937& Random() { return m_random; }
+
+    private:
+        std::mt19937 m_random;
+        std::vector<std::string> m_words;
+        std::discrete_distribution<size_t> m_pick;
+    };
+
+    // 当前进程的常驻内存（MB），读不到时返回0
+    double ResidentMb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 6, "VmRSS:") == 0)
+                return std::stod(line.substr(6)) / 1024;
+        }
+        return 0;
+    }
+
+    void Report(const char* name, std::vector<double>& micros, size_t found)
+    {
+        std::sort(micros.begin(), micros.end());
+        std::printf("%-10s recall %.3f  p50 %6.1f us  p99 %6.1f us\n", name, static_cast<double>(found) / micros.size(),
+            micros[micros.size() / 2], micros[micros.size() * 99 / 100]);
+    }
+}
+
+int main()
+{
+    SentenceGenerator generator(42);
+    std::vector<std::string> sources;
+    sources.reserve(ENTRY_COUNT);
+    for (size_t i = 0; i < ENTRY_COUNT; ++i)
+        sources.push_back(generator.Sentence());
+
+    double baseMb = ResidentMb();
+    MemoryIndex index(ENTRY_COUNT + 1);
+    auto begin = Clock::now();
+    for (size_t i = 0; i < ENTRY_COUNT; ++i)
+        index.Add("default", sources[i], "译文" + std::to_string(i));
+    double insertUs = std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / ENTRY_COUNT;
+    std::printf("insert: %zu entries, %.1f us each, %.0f MB resident\n", index.GetSize(), insertUs, ResidentMb() - baseMb);
+
+    std::mt19937& random = generator.Random();
+    std::vector<double> typo;
+    std::vector<double> word;
+    std::vector<double> unrelated;
+    size_t typoFound = 0;
+    size_t wordFound = 0;
+    size_t unrelatedFound = 0;
+    MemoryMatch match;
+    for (size_t q = 0; q < QUERY_COUNT; ++q)
+    {
+        const std::string& original = sources[random() % ENTRY_COUNT];
+
+        // 改动一个字母
+        std::string query = original;
+        size_t position = random() % (query.length() - 1);
+        while (query[position] == ' ')
+            position = random() % (query.length() - 1);
+        query[position] = query[position] == 'z' ? 'a' : static_cast<char>(query[position] + 1);
+        begin = Clock::now();
+        bool found = index.Lookup("default", query, THRESHOLD, match);
+        typo.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+        typoFound += found && match.source == original;
+
+        // 替换一个词
+        query = original;
+        size_t space = query.find(' ', random() % query.length());
+        if (space == std::string::npos)
+            space = query.rfind(' ');
+        size_t wordEnd = query.find_first_of(" .", space + 1);
+        query.replace(space + 1, wordEnd - space - 1, generator.Word());
+        begin = Clock::now();
+        found = index.Lookup("default", query, THRESHOLD, match);
+        word.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+        wordFound += found && match.source == original;
+
+        query = generator.Sentence();
+        begin = Clock::now();
+        found = index.Lookup("default", query, THRESHOLD, match);
+        unrelated.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+        unrelatedFound += found;
+    }
+
+    Report("typo", typo, typoFound);
+    Report("word", word, wordFound);
+    Report("unrelated", unrelated, unrelatedFound);
+    return 0;
+}
@@ -0,0 +1,75 @@
+﻿/**
+ * 逐字符输入基准：模拟接收端按每个事件15微秒计费（接近SendInput注入一个事件的开销），
+ * 批次之间真实等待batchPauseMs，统计不同长度的译文全部输入所需的时间，
+ * 与剪切板路径固定的约350毫秒等待对照
+ */
+#include "TextInjector.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto EVENT_COST = std::chrono::microseconds(15);
+
+    class SimulatedSink : public InputSink
+    {
+    public:
+        size_t Send(const KeyEvent* events, size_t count) override
+        {
+            (void)events;
+            auto until = Clock::now() + EVENT_COST * count;
+            while (Clock::now() < until)
+            {
+            }
+            ++batches;
+            return count;
+        }
+
+        void Pause(uint32_t milliseconds) override
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        }
+
+        size_t batches = 0;
+    };
+
+    void Run(const char* name, const std::wstring& text)
+    {
+        InjectionPolicy policy;
+        policy.maxTypedUnits = text.length();
+        if (TextInjector::ChooseMethod(text, policy, true) != InjectionMethod::Type)
+        {
+            std::printf("%-20s uses the clipboard\n", name);
+            return;
+        }
+
+        std::vector<KeyEvent> events;
+        SimulatedSink sink;
+        auto begin = Clock::now();
+        TextInjector::BuildEvents(text, events);
+        InjectionOutcome outcome = TextInjector::Type(events, sink, policy);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        std::printf("%-20s %3zu units, %zu batches, %5.1f ms%s\n", name, text.length(), sink.batches, ms,
+            outcome == InjectionOutcome::Typed ? "" : " (not typed)");
+    }
+}
+
+int main()
+{
+    Run("11 characters", L"GetUserName");
+    Run("200 characters", std::wstring(200, L'a'));
+
+    std::wstring emoji;
+    for (int i = 0; i < 80; ++i)
+    {
+        emoji += static_cast<wchar_t>(0xD83D);
+        emoji += static_cast<wchar_t>(0xDE00);
+    }
+    Run("80 emoji plus text", emoji + L" done");
+    std::printf("clipboard path: at least 350 ms of fixed waits\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+﻿#include "TestHarness.h"
+#include "CodeLexer.h"
+
+namespace
+{
+    // 片段在原文中的文本
+    std::string SegmentText(const std::string& text, const CodeSegment& segment)
+    {
+        return text.substr(segment.begin, segment.end - segment.begin);
+    }
+}
+
+TEST_CASE(NaturalLanguageIsNotCode)
+{
+    // 网址中的 // 不是注释，引号和括号不是代码
+    const char* const prose[] =
+    {
+        "访问 http://example.com 获取帮助",
+        "See https://example.com/docs for the full list of options",
+        "点击\"保存按钮\"(右上角)即可",
+        "The function (see docs) returns \"not found\" on error",
+        "获取对象名称",
+        "get object name",
+        "它说：\"你好\"。然后离开了。\n第二段提到了 (括号) 和 'quotes'。",
+    };
+    std::vector<CodeSegment> segments;
+    for (const char* text : prose)
+    {
+        CHECK(!CodeLexer::Analyze(text, segments));
+        CHECK(segments.empty());
+    }
+}
+
+TEST_CASE(UrlInsideCodeIsNotAComment)
+{
+    std::string text = "const char* url = \"http://example.com/获取\"; // 服务地址\n";
+    std::vector<CodeSegment> segments;
+    REQUIRE(CodeLexer::Analyze(text, segments));
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[0].kind == CodeSegmentKind::String);
+    CHECK_EQ(SegmentText(text, segments[0]), std::string("http://example.com/获取"));
+    CHECK(segments[1].kind == CodeSegmentKind::LineComment);
+    CHECK_EQ(SegmentText(text, segments[1]), std::string("服务地址"));
+}
+
+TEST_CASE(RecognisesCodeSelections)
+{
+    std::vector<CodeSegment> segments;
+
+    std::string comment = "// 计算总和";
+    REQUIRE(CodeLexer::Analyze(comment, segments));
+    REQUIRE(segments.size() == 1);
+    CHECK_EQ(SegmentText(comment, segments[0]), std::string("计算总和"));
+
+    std::string call = "printf(\"你好\");";
+    REQUIRE(CodeLexer::Analyze(call, segments));
+    CHECK_EQ(SegmentText(call, segments[0]), std::string("你好"));
+
+    std::string block =
+        "/*\n"
+        " * 计算两个数的和\n"
+        " * 结果不会溢出\n"
+        " */\n"
+        "int Add(int a, int b);\n";
+    REQUIRE(CodeLexer::Analyze(block, segments));
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[0].kind == CodeSegmentKind::BlockComment);
+    CHECK_EQ(SegmentText(block, segments[1]), std::string("结果不会溢出"));
+
+    std::string python =
+        "def greet(name):\n"
+        "    # 打印问候语\n"
+        "    print(\"你好，\" + name)\n";
+    CHECK(CodeLexer::DetectLanguage(python) == CodeLanguage::Python);
+    REQUIRE(CodeLexer::Analyze(python, segments));
+    REQUIRE(segments.size() == 2);
+    CHECK_EQ(SegmentText(python, segments[0]), std::string("打印问候语"));
+    CHECK_EQ(SegmentText(python, segments[1]), std::string("你好，"));
+}
+
+TEST_CASE(MostlyProseWithOneCodeLikeLineIsNotCode)
+{
+    std::string text =
+        "请在配置文件中设置以下选项：\n"
+        "Port=8080\n"
+        "然后重新启动程序，修改会在下次请求时生效。\n"
+        "如果仍然失败，请查看日志。\n";
+    std::vector<CodeSegment> segments;
+    CHECK(!CodeLexer::Analyze(text, segments));
+}
+
+TEST_CASE(SplicesBatchTranslations)
+{
+    std::string text = "int x = 0; // 计数器\nputs(\"完成\");\n";
+    std::vector<CodeSegment> segments;
+    REQUIRE(CodeLexer::Analyze(text, segments));
+    REQUIRE(segments.size() == 2);
+
+    std::string batch;
+    CodeLexer::BuildBatch(text, segments, batch);
+    CHECK_EQ(batch, std::string("1|计数器\n2|完成\n"));
+
+    std::string out;
+    REQUIRE(CodeLexer::Splice(text, segments, "1|counter\n2|done\n", out));
+    CHECK_EQ(out, std::string("int x = 0; // counter\nputs(\"done\");\n"));
+
+    // 缺少编号时整体失败
+    CHECK(!CodeLexer::Splice(text, segments, "1|counter\n", out));
+}
@@ -0,0 +1,192 @@
+﻿#include "TestHarness.h"
+#include "AppConfig.h"
+
+namespace
+{
+    // 解析配置文本，失败时返回的配置无意义
+    bool ParseText(const std::string& text, AppConfig& config, std::string& error)
+    {
+        config = AppConfig::Defaults();
+        return ConfigParser::Parse(text, config, error);
+    }
+}
+
+TEST_CASE(DefaultTextParsesToDefaults)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ParseText(ConfigParser::GenerateDefaultText(), config, error));
+
+    AppConfig defaults = AppConfig::Defaults();
+    CHECK_EQ(config.host, defaults.host);
+    CHECK_EQ(config.port, defaults.port);
+    CHECK_EQ(config.path, defaults.path);
+    CHECK_EQ(config.model, defaults.model);
+    CHECK_EQ(config.systemPrompt, defaults.systemPrompt);
+    CHECK_EQ(config.receiveTimeoutMs, defaults.receiveTimeoutMs);
+    CHECK_EQ(config.cacheCapacity, defaults.cacheCapacity);
+    REQUIRE(config.profiles.size() == 1);
+    CHECK_EQ(config.profiles[0]->name, std::string("Default"));
+    CHECK(config.profiles[0]->hotkey == HotkeyBinding());
+}
+
+TEST_CASE(ParsesApiAndTimeoutValues)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ParseText(
+        "\xEF\xBB\xBF; comment\r\n"
+        "# another comment\n"
+        "[API]\n"
+        "  ApiKey = sk-test  \n"
+        "Host=example.com\n"
+        "Port=8443\n"
+        "Model=qwen-turbo\n"
+        "Temperature=0.7\n"
+        "SystemPrompt=line1\\nline2\\\\n\n"
+        "UnknownKey=ignored\n"
+        "[Timeouts]\n"
+        "Receive=5000\n"
+        "Adaptive=0\n"
+        "[Unknown]\n"
+        "Key=value\n",
+        config, error));
+
+    CHECK_EQ(config.apiKey, std::string("sk-test"));
+    CHECK_EQ(config.host, std::string("example.com"));
+    CHECK_EQ(config.port, static_cast<uint16_t>(8443));
+    CHECK_EQ(config.model, std::string("qwen-turbo"));
+    CHECK_EQ(config.temperature, 0.7);
+    CHECK_EQ(config.systemPrompt, std::string("line1\nline2\\n"));
+    CHECK_EQ(config.receiveTimeoutMs, 5000);
+    CHECK(!config.adaptiveTimeouts);
+
+    // 未定义配置档时默认配置档继承[Api]的设置
+    REQUIRE(config.profiles.size() == 1);
+    CHECK_EQ(config.profiles[0]->model, std::string("qwen-turbo"));
+    CHECK_EQ(config.profiles[0]->systemPrompt, config.systemPrompt);
+}
+
+TEST_CASE(ReportsErrorsWithLineNumbers)
+{
+    AppConfig config;
+    std::string error;
+    CHECK(!ParseText("[Api]\nPort=70000\n", config, error));
+    CHECK(error.find("第2行") != std::string::npos);
+
+    CHECK(!ParseText("[Api\n", config, error));
+    CHECK(error.find("第1行") != std::string::npos);
+
+    CHECK(!ParseText("[Api]\nHost\n", config, error));
+    CHECK(!ParseText("[Api]\nPath=no-slash\n", config, error));
+    CHECK(!ParseText("[Timeouts]\nReceive=-1\n", config, error));
+    CHECK(!ParseText("[Timeouts]\nReceive=12abc\n", config, error));
+}
+
+TEST_CASE(ProfilesInheritApiSettings)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ParseText(
+        "[Profile.Camel]\n"
+        "Hotkey=Ctrl+Alt+Space\n"
+        "Case=Camel\n"
+        "CacheNamespace=shared\n"
+        "[Profile.Show]\n"
+        "Hotkey=Ctrl+Shift+T\n"
+        "Output=Show\n"
+        "Model=qwen-max\n"
+        "[Api]\n"
+        "Model=qwen-turbo\n",
+        config, error));
+
+    REQUIRE(config.profiles.size() == 2);
+    std::shared_ptr<const TranslationProfile> camel = config.FindProfile("camel");
+    std::shared_ptr<const TranslationProfile> show = config.FindProfile("SHOW");
+    REQUIRE(camel && show);
+    CHECK_EQ(camel->model, std::string("qwen-turbo"));
+    CHECK(camel->caseStyle == CaseStyle::Camel);
+    CHECK_EQ(camel->cacheNamespace, std::string("shared"));
+    CHECK_EQ(show->model, std::string("qwen-max"));
+    CHECK(show->output == OutputMode::Show);
+    CHECK_EQ(show->cacheNamespace, std::string("show"));
+    CHECK(camel->requestTemplate != nullptr);
+    CHECK(config.FindProfile("missing") == nullptr);
+}
+
+TEST_CASE(RejectsInvalidProfiles)
+{
+    AppConfig config;
+    std::string error;
+    CHECK(!ParseText("[Profile.A]\nCase=Pascal\n", config, error));
+    CHECK(error.find("Hotkey") != std::string::npos);
+
+    CHECK(!ParseText("[Profile.A]\nHotkey=Ctrl+Space\n[Profile.B]\nHotkey=ctrl+space\n", config, error));
+    CHECK(!ParseText("[Profile.A]\nHotkey=F1\n[Profile.a]\nHotkey=F2\n", config, error));
+    CHECK(!ParseText("[Profile. ]\nHotkey=F1\n", config, error));
+    CHECK(!ParseText("[Profile.A]\nHotkey=F1\nOutput=Print\n", config, error));
+}
+
+TEST_CASE(ParsesSchedulerLimits)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ParseText("[Scheduler]\nInteractiveConcurrency=4\nClientConcurrency=2\nBackgroundConcurrency=3\n", config, error));
+    CHECK_EQ(config.interactiveConcurrency, 4);
+    CHECK_EQ(config.clientConcurrency, 2);
+    CHECK_EQ(config.backgroundConcurrency, 3);
+
+    CHECK(!ParseText("[Scheduler]\nInteractiveConcurrency=0\n", config, error));
+    CHECK(!ParseText("[Scheduler]\nBackgroundConcurrency=17\n", config, error));
+}
+
+TEST_CASE(ParsesHotkeys)
+{
+    HotkeyBinding binding;
+    REQUIRE(ConfigParser::ParseHotkey("Ctrl+Alt+T", binding));
+    CHECK_EQ(binding.modifiers, HotkeyBinding::MOD_CONTROL_FLAG | HotkeyBinding::MOD_ALT_FLAG);
+    CHECK_EQ(binding.virtualKey, static_cast<uint32_t>('T'));
+
+    REQUIRE(ConfigParser::ParseHotkey(" win + f8 ", binding));
+    CHECK_EQ(binding.modifiers, HotkeyBinding::MOD_WIN_FLAG);
+    CHECK_EQ(binding.virtualKey, 0x77u);
+
+    REQUIRE(ConfigParser::ParseHotkey("Shift+Space", binding));
+    CHECK_EQ(binding.virtualKey, 0x20u);
+
+    CHECK(!ConfigParser::ParseHotkey("Ctrl+Alt", binding));
+    CHECK(!ConfigParser::ParseHotkey("Ctrl+A+B", binding));
+    CHECK(!ConfigParser::ParseHotkey("Ctrl+F25", binding));
+    CHECK(!ConfigParser::ParseHotkey("", binding));
+}
+
+TEST_CASE(DispatchTableFollowsProfileOrder)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ParseText("[Profile.A]\nHotkey=F1\n[Profile.B]\nHotkey=F2\n", config, error));
+    auto snapshot = std::make_shared<const AppConfig>(config);
+    HotkeyDispatchTable table(snapshot);
+
+    REQUIRE(table.GetCount() == 2);
+    CHECK_EQ(table.Lookup(table.GetHotkeyId(1))->name, std::string("B"));
+    CHECK(table.Lookup(HotkeyDispatchTable::HOTKEY_ID_BASE - 1) == nullptr);
+    CHECK(table.Lookup(table.GetHotkeyId(2)) == nullptr);
+    CHECK(table.HasSameBindings(HotkeyDispatchTable(snapshot)));
+    CHECK(!table.HasSameBindings(HotkeyDispatchTable(std::make_shared<const AppConfig>(AppConfig::Defaults()))));
+}
+
+TEST_CASE(ConfigStorePublishesSnapshots)
+{
+    uint64_t before = ConfigStore::Version();
+    std::shared_ptr<const AppConfig> current = ConfigStore::Current();
+    CHECK(current != nullptr);
+
+    AppConfig config = AppConfig::Defaults();
+    config.model = "published";
+    CHECK_EQ(ConfigStore::Publish(std::make_shared<const AppConfig>(config)), before + 1);
+    CHECK_EQ(ConfigStore::Current()->model, std::string("published"));
+
+    // 旧快照不受替换影响
+    CHECK(current->model != "published");
+}
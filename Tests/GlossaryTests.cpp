@@ -0,0 +1,169 @@
+﻿#include "TestHarness.h"
+#include "Glossary.h"
+#include <random>
+
+namespace
+{
+    bool IsAsciiAlnum(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // 逐位置比较所有术语的参考实现：最左起点上满足整词规则的最长术语（相同术语保留第一条）
+    std::vector<GlossaryMatch> BruteForce(const std::vector<GlossaryEntry>& entries, const std::string& text)
+    {
+        std::vector<GlossaryMatch> matches;
+        size_t position = 0;
+        while (position < text.length())
+        {
+            size_t bestLength = 0;
+            uint32_t bestEntry = 0;
+            for (uint32_t e = 0; e < entries.size(); ++e)
+            {
+                const std::string& term = entries[e].term;
+                size_t end = position + term.length();
+                if (term.empty() || term.length() <= bestLength || text.compare(position, term.length(), term) != 0)
+                    continue;
+                if (IsAsciiAlnum(term.front()) && position > 0 && IsAsciiAlnum(text[position - 1]))
+                    continue;
+                if (IsAsciiAlnum(term.back()) && end < text.length() && IsAsciiAlnum(text[end]))
+                    continue;
+                bestLength = term.length();
+                bestEntry = e;
+            }
+            if (bestLength == 0)
+            {
+                position++;
+                continue;
+            }
+            matches.push_back({ position, position + bestLength, bestEntry });
+            position += bestLength;
+        }
+        return matches;
+    }
+
+    bool SameMatches(const GlossaryMatcher& matcher, const std::vector<GlossaryMatch>& actual, const std::vector<GlossaryMatch>& expected)
+    {
+        if (actual.size() != expected.size())
+            return false;
+        for (size_t i = 0; i < actual.size(); ++i)
+        {
+            // 比较术语文本而不是索引：去重后条目索引可能不同
+            if (actual[i].begin != expected[i].begin || actual[i].end != expected[i].end ||
+                actual[i].end - actual[i].begin != matcher.GetEntry(actual[i].entry).term.length())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(ParsesGlossaryText)
+{
+    std::vector<GlossaryEntry> entries;
+    Glossary::Parse("\xEF\xBB\xBF; 注释\n# 注释\n用户 = user\r\n\n会话\tsession\na=b\t公式\n缺少译法=\n=缺少术语\n无分隔符\n", entries);
+    REQUIRE(entries.size() == 3);
+    CHECK_EQ(entries[0].term, std::string("用户"));
+    CHECK_EQ(entries[0].translation, std::string("user"));
+    CHECK_EQ(entries[1].term, std::string("会话"));
+    CHECK_EQ(entries[1].translation, std::string("session"));
+    // 制表符优先于等号，术语本身可以含等号
+    CHECK_EQ(entries[2].term, std::string("a=b"));
+    CHECK_EQ(entries[2].translation, std::string("公式"));
+
+    GlossaryMode mode = GlossaryMode::Off;
+    CHECK(Glossary::ParseMode("prompt", mode));
+    CHECK(mode == GlossaryMode::Prompt);
+    CHECK(!Glossary::ParseMode("bogus", mode));
+}
+
+TEST_CASE(MatchesLeftmostLongestWholeWords)
+{
+    GlossaryMatcher matcher({
+        { "用户", "user" },
+        { "用户名", "username" },
+        { "名称", "name" },
+        { "user", "用户" },
+        { "user id", "用户ID" },
+        { "用户", "duplicate" },
+    });
+    CHECK_EQ(matcher.GetEntryCount(), static_cast<size_t>(6));
+
+    // 用户名称：最长的“用户名”优先，剩下的“称”不是术语
+    std::vector<GlossaryMatch> matches;
+    CHECK_EQ(matcher.FindMatches("用户名称", matches), static_cast<size_t>(1));
+    CHECK_EQ(matcher.GetEntry(matches[0].entry).term, std::string("用户名"));
+
+    // 重复的术语使用第一条的译法
+    std::string text = "用户和名称和用户名";
+    REQUIRE(matcher.FindMatches(text, matches) == 3);
+    CHECK_EQ(matcher.GetEntry(matches[0].entry).term, std::string("用户"));
+    CHECK_EQ(matcher.GetEntry(matches[1].entry).term, std::string("名称"));
+    CHECK_EQ(matcher.GetEntry(matches[2].entry).term, std::string("用户名"));
+
+    // ASCII术语要求整词：username、users中不命中user
+    CHECK_EQ(matcher.FindMatches("username users user_x", matches), static_cast<size_t>(1));
+    CHECK_EQ(matches[0].begin, static_cast<size_t>(15));
+    CHECK_EQ(matcher.FindMatches("the user id, a user", matches), static_cast<size_t>(2));
+    CHECK_EQ(matcher.GetEntry(matches[0].entry).term, std::string("user id"));
+
+    std::string out;
+    matcher.FindMatches(text, matches);
+    matcher.Substitute(text, matches, out);
+    CHECK_EQ(out, std::string("user和name和username"));
+
+    out = "原文";
+    matcher.AppendHints(matches, out);
+    CHECK_EQ(out, std::string("原文\n\n术语表（按此译法翻译，不要输出本段）：用户=user；名称=name；用户名=username"));
+}
+
+TEST_CASE(LookupExactIgnoresSurroundingWhitespace)
+{
+    GlossaryMatcher matcher({ { "用户名", "username" }, { "用户", "user" } });
+    std::string translation;
+    CHECK(matcher.LookupExact("  用户名\n", translation));
+    CHECK_EQ(translation, std::string("username"));
+    CHECK(!matcher.LookupExact("用户名称", translation));
+    CHECK(!matcher.LookupExact("用", translation));
+    CHECK(!matcher.LookupExact("   ", translation));
+}
+
+TEST_CASE(AgreesWithBruteForceOnRandomText)
+{
+    // 小字母表上的随机术语和文本，大量重叠、前缀和失败链跳转
+    std::mt19937 random(12345);
+    const char* alphabet[] = { "a", "b", "c", " ", "数", "据" };
+    auto randomString = [&](size_t maxPieces)
+    {
+        std::string s;
+        size_t pieces = 1 + random() % maxPieces;
+        for (size_t i = 0; i < pieces; ++i)
+            s += alphabet[random() % 6];
+        return s;
+    };
+
+    for (int round = 0; round < 200; ++round)
+    {
+        std::vector<GlossaryEntry> entries;
+        for (int i = 0; i < 20; ++i)
+        {
+            std::string term = randomString(4);
+            if (term.front() == ' ' || term.back() == ' ')
+                continue;
+            bool duplicate = false;
+            for (const GlossaryEntry& entry : entries)
+                duplicate = duplicate || entry.term == term;
+            if (!duplicate)
+                entries.push_back({ term, "x" });
+        }
+        GlossaryMatcher matcher(entries);
+        std::vector<GlossaryMatch> matches;
+        for (int t = 0; t < 10; ++t)
+        {
+            std::string text = randomString(60);
+            matcher.FindMatches(text, matches);
+            REQUIRE(SameMatches(matcher, matches, BruteForce(entries, text)));
+        }
+    }
+}
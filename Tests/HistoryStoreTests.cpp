@@ -0,0 +1,138 @@
+﻿#include "TestHarness.h"
+#include "HistoryStore.h"
+#include <algorithm>
+
+namespace
+{
+    HistoryRecord MakeRecord(const std::string& source, const std::string& result)
+    {
+        HistoryRecord record;
+        record.timestamp = 1700000000000;
+        record.latencyMs = 420;
+        record.profile = "Default";
+        record.source = source;
+        record.result = result;
+        return record;
+    }
+
+    // 编码后立即解码为视图（视图指向buffer）
+    bool RoundTrip(const HistoryRecord& record, std::string& buffer, HistoryRecordView& view)
+    {
+        buffer.assign(HistoryCodec::EncodedSize(record), '\0');
+        HistoryCodec::Encode(record, &buffer[0]);
+        size_t consumed = 0;
+        return HistoryCodec::Decode(buffer.data(), buffer.size(), view, consumed) && consumed == buffer.size();
+    }
+}
+
+TEST_CASE(RecordsRoundTrip)
+{
+    std::string buffer;
+    HistoryRecordView view;
+    REQUIRE(RoundTrip(MakeRecord("获取对象名称", "get object name"), buffer, view));
+    CHECK_EQ(view.timestamp, static_cast<int64_t>(1700000000000));
+    CHECK_EQ(view.latencyMs, 420u);
+    CHECK(view.profile == "Default");
+    CHECK(view.source == "获取对象名称");
+    CHECK(view.result == "get object name");
+}
+
+TEST_CASE(RejectsTruncatedAndCorruptRecords)
+{
+    std::string buffer;
+    HistoryRecordView view;
+    REQUIRE(RoundTrip(MakeRecord("source", "result"), buffer, view));
+
+    size_t consumed = 0;
+    for (size_t length = 0; length < buffer.size(); ++length)
+        CHECK(!HistoryCodec::Decode(buffer.data(), length, view, consumed));
+
+    // 任一字节损坏都应被校验和发现
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        std::string corrupt = buffer;
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x5A);
+        CHECK(!HistoryCodec::Decode(corrupt.data(), corrupt.size(), view, consumed));
+    }
+}
+
+TEST_CASE(TruncatesLongProfileNames)
+{
+    // 过长的配置名被截断，EncodedSize与实际写入的记录大小一致，下一条记录紧随其后
+    HistoryRecord record = MakeRecord("source", "result");
+    record.profile.assign(HistoryCodec::MAX_PROFILE_LENGTH + 100, 'p');
+    size_t size = HistoryCodec::EncodedSize(record);
+    CHECK_EQ(size, HistoryCodec::RECORD_HEADER_SIZE + HistoryCodec::MAX_PROFILE_LENGTH + 12);
+
+    std::string buffer(size * 2, '\0');
+    HistoryCodec::Encode(record, &buffer[0]);
+    HistoryCodec::Encode(MakeRecord("next", "record"), &buffer[size]);
+
+    HistoryRecordView view;
+    size_t consumed = 0;
+    REQUIRE(HistoryCodec::Decode(buffer.data(), buffer.size(), view, consumed));
+    CHECK_EQ(consumed, size);
+    CHECK_EQ(view.profile.length(), static_cast<size_t>(HistoryCodec::MAX_PROFILE_LENGTH));
+    REQUIRE(HistoryCodec::Decode(buffer.data() + size, buffer.size() - size, view, consumed));
+    CHECK(view.source == "next");
+}
+
+TEST_CASE(HeaderTracksUsedBytes)
+{
+    char header[HistoryCodec::HEADER_SIZE];
+    HistoryCodec::InitializeHeader(header);
+    CHECK(HistoryCodec::ValidateHeader(header, 4096));
+    CHECK_EQ(HistoryCodec::GetUsedBytes(header), 0u);
+
+    HistoryCodec::SetUsedBytes(header, 1024);
+    CHECK_EQ(HistoryCodec::GetUsedBytes(header), 1024u);
+    CHECK(HistoryCodec::ValidateHeader(header, 4096));
+    CHECK(!HistoryCodec::ValidateHeader(header, 512));
+
+    header[0] ^= 0x01;
+    CHECK(!HistoryCodec::ValidateHeader(header, 4096));
+}
+
+TEST_CASE(IndexFindsChineseAndEnglishSubstrings)
+{
+    std::vector<HistoryRecord> records =
+    {
+        MakeRecord("获取对象名称", "get object name"),
+        MakeRecord("设置窗口标题", "set window title"),
+        MakeRecord("HTTP请求处理器", "HTTP request handler"),
+    };
+    std::vector<std::string> buffers(records.size());
+    std::vector<HistoryRecordView> views(records.size());
+    HistoryIndex index;
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        REQUIRE(RoundTrip(records[i], buffers[i], views[i]));
+        index.Add(static_cast<uint32_t>(i), views[i]);
+    }
+
+    // 候选可能有误报，按调用方的做法校验原文和译文
+    auto search = [&](const std::string& query)
+    {
+        std::vector<uint32_t> candidates;
+        index.FindCandidates(query, candidates);
+        std::vector<uint32_t> matches;
+        for (uint32_t id : candidates)
+        {
+            if (HistoryIndex::ContainsIgnoreCase(views[id].source, query) || HistoryIndex::ContainsIgnoreCase(views[id].result, query))
+                matches.push_back(id);
+        }
+        return matches;
+    };
+
+    CHECK(search("对象") == std::vector<uint32_t>{ 0 });
+    CHECK(search("窗") == std::vector<uint32_t>{ 1 });
+    CHECK(search("WINDOW") == std::vector<uint32_t>{ 1 });
+    CHECK(search("http") == std::vector<uint32_t>{ 2 });
+    CHECK(search("e") == (std::vector<uint32_t>{ 2, 1, 0 }));
+    CHECK(search("不存在").empty());
+
+    index.Clear();
+    std::vector<uint32_t> candidates;
+    index.FindCandidates("对象", candidates);
+    CHECK(candidates.empty());
+}
@@ -0,0 +1,294 @@
+﻿#include "TestHarness.h"
+#include "HttpRecording.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+    // 按预设的分块应答的传输层，记录收到的请求数
+    class ScriptedTransport : public HttpTransport
+    {
+    public:
+        bool Send(const HttpRequest& request, const DataCallback& onData, HttpResult& result) override
+        {
+            ++calls;
+            result = HttpResult();
+            for (const std::string& chunk : chunks)
+            {
+                if (request.cancel != nullptr && *request.cancel)
+                {
+                    result.failure = HttpFailure::Cancelled;
+                    return false;
+                }
+                onData(chunk.data(), chunk.length());
+            }
+            result.statusCode = statusCode;
+            result.compressed = true;
+            result.wireBytesReceived = 42;
+            return true;
+        }
+
+        std::vector<std::string> chunks;
+        unsigned long statusCode = 200;
+        int calls = 0;
+    };
+
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    HttpRequest MakeRequest(std::string_view body)
+    {
+        HttpRequest request;
+        request.host = L"api.example.com";
+        request.path = L"/v1/chat/completions";
+        request.headers = L"Content-Type: application/json\r\nAuthorization: Bearer sk-secret\r\n";
+        request.body = body;
+        return request;
+    }
+
+    std::string Collect(HttpTransport& transport, const HttpRequest& request, HttpResult& result, std::vector<size_t>* sizes = nullptr)
+    {
+        std::string received;
+        transport.Send(request, [&](const char* data, size_t length)
+        {
+            received.append(data, length);
+            if (sizes != nullptr)
+                sizes->push_back(length);
+        }, result);
+        return received;
+    }
+}
+
+TEST_CASE(RequestKeyCoversRouteAndBodyOnly)
+{
+    HttpRequest a = MakeRequest("{\"text\":\"hello\"}");
+    HttpRequest b = MakeRequest("{\"text\":\"hello\"}");
+    b.headers = L"Authorization: Bearer other\r\n";
+    b.receiveTimeoutMs = 1;
+    CHECK_EQ(HttpRecording::RequestKey(a), HttpRecording::RequestKey(b));
+
+    b.body = "{\"text\":\"world\"}";
+    CHECK(HttpRecording::RequestKey(a) != HttpRecording::RequestKey(b));
+    b = MakeRequest(a.body);
+    b.port = 8443;
+    CHECK(HttpRecording::RequestKey(a) != HttpRecording::RequestKey(b));
+    b = MakeRequest(a.body);
+    b.path = L"/v1/other";
+    CHECK(HttpRecording::RequestKey(a) != HttpRecording::RequestKey(b));
+}
+
+TEST_CASE(RedactsSecretHeaders)
+{
+    std::string redacted = HttpRecording::RedactHeaders(
+        L"Content-Type: application/json\r\nauthorization: Bearer sk-1\r\nX-API-Key:abc\r\nCookie: a=b\r\n");
+    CHECK_EQ(redacted, std::string(
+        "Content-Type: application/json\r\nauthorization: <redacted>\r\nX-API-Key: <redacted>\r\nCookie: <redacted>\r\n"));
+    CHECK(redacted.find("sk-1") == std::string::npos);
+}
+
+TEST_CASE(EncodeDecodeRoundTrip)
+{
+    HttpExchange exchange;
+    exchange.key = 0x0123456789ABCDEFULL;
+    exchange.method = "POST";
+    exchange.host = "api.example.com";
+    exchange.port = 443;
+    exchange.path = "/v1/chat/completions";
+    exchange.headers = "Content-Type: application/json\r\n";
+    exchange.bodyLength = 1234;
+    exchange.failure = HttpFailure::Receive;
+    exchange.statusCode = 200;
+    exchange.compressed = true;
+    exchange.wireBytesReceived = 300;
+    exchange.chunks.push_back({ 150000, "data: {\"a\":1}\n\n" });
+    exchange.chunks.push_back({ 0, std::string("\0\xFF", 2) });
+    exchange.tailUs = 7;
+
+    std::string data;
+    HttpRecording::Encode(exchange, data);
+    HttpRecording::Encode(exchange, data);
+
+    size_t pos = 0;
+    HttpExchange decoded;
+    REQUIRE(HttpRecording::Decode(data, pos, decoded));
+    CHECK_EQ(decoded.key, exchange.key);
+    CHECK_EQ(decoded.host, exchange.host);
+    CHECK_EQ(decoded.path, exchange.path);
+    CHECK_EQ(decoded.bodyLength, exchange.bodyLength);
+    CHECK(decoded.failure == HttpFailure::Receive);
+    CHECK(decoded.compressed);
+    REQUIRE(decoded.chunks.size() == 2);
+    CHECK_EQ(decoded.chunks[0].delayUs, 150000u);
+    CHECK(decoded.chunks[1].data == exchange.chunks[1].data);
+    CHECK_EQ(decoded.tailUs, 7u);
+    REQUIRE(HttpRecording::Decode(data, pos, decoded));
+    CHECK_EQ(pos, data.length());
+}
+
+TEST_CASE(DecodeRejectsTruncatedRecords)
+{
+    HttpExchange exchange;
+    exchange.method = "POST";
+    exchange.chunks.push_back({ 10, "payload" });
+    std::string data;
+    HttpRecording::Encode(exchange, data);
+
+    for (size_t length = 0; length < data.length(); ++length)
+    {
+        size_t pos = 0;
+        HttpExchange decoded;
+        CHECK(!HttpRecording::Decode(data.substr(0, length), pos, decoded));
+        CHECK_EQ(pos, static_cast<size_t>(0));
+    }
+}
+
+TEST_CASE(RecordsAndReplaysExchanges)
+{
+    std::string path = TempPath("YunsioHttpRecordingTests.ytrr");
+    ScriptedTransport* inner = new ScriptedTransport();
+    inner->chunks = { "data: one\n\n", "data: two\n\n", "data: [DONE]\n\n" };
+    {
+        RecordingTransport recorder{ std::unique_ptr<HttpTransport>(inner) };
+        REQUIRE(recorder.Open(path));
+        HttpResult result;
+        CHECK_EQ(Collect(recorder, MakeRequest("first"), result), std::string("data: one\n\ndata: two\n\ndata: [DONE]\n\n"));
+        inner->chunks = { "second" };
+        inner->statusCode = 429;
+        Collect(recorder, MakeRequest("second"), result);
+
+        // 被取消的请求不录制
+        std::atomic<bool> cancel{ true };
+        HttpRequest cancelled = MakeRequest("cancelled");
+        cancelled.cancel = &cancel;
+        Collect(recorder, cancelled, result);
+        CHECK(result.failure == HttpFailure::Cancelled);
+        CHECK_EQ(inner->calls, 3);
+    }
+
+    ReplayTransport replay;
+    REQUIRE(replay.Load(path, 0));
+    CHECK_EQ(replay.GetExchangeCount(), static_cast<size_t>(2));
+
+    HttpResult result;
+    std::vector<size_t> sizes;
+    CHECK_EQ(Collect(replay, MakeRequest("first"), result, &sizes), std::string("data: one\n\ndata: two\n\ndata: [DONE]\n\n"));
+    CHECK(result.failure == HttpFailure::None);
+    CHECK_EQ(result.statusCode, 200ul);
+    CHECK(result.compressed);
+    CHECK_EQ(result.wireBytesReceived, static_cast<uint64_t>(42));
+    REQUIRE(sizes.size() == 3);
+    CHECK_EQ(sizes[0], static_cast<size_t>(11));
+
+    Collect(replay, MakeRequest("second"), result);
+    CHECK_EQ(result.statusCode, 429ul);
+
+    CHECK(Collect(replay, MakeRequest("cancelled"), result).empty());
+    CHECK(result.failure == HttpFailure::Connect);
+
+    // 录制文件里没有密钥
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    REQUIRE(file != nullptr);
+    std::string content;
+    char buffer[4096];
+    size_t length = 0;
+    while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        content.append(buffer, length);
+    std::fclose(file);
+    CHECK(content.find("sk-secret") == std::string::npos);
+
+    // 末尾不完整的记录忽略，之前的记录照常加载
+    std::filesystem::resize_file(path, content.length() - 3);
+    ReplayTransport truncated;
+    REQUIRE(truncated.Load(path, 0));
+    CHECK_EQ(truncated.GetExchangeCount(), static_cast<size_t>(1));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(ReplaysRepeatedRequestsRoundRobin)
+{
+    std::string path = TempPath("YunsioHttpRecordingRoundRobin.ytrr");
+    ScriptedTransport* inner = new ScriptedTransport();
+    {
+        RecordingTransport recorder{ std::unique_ptr<HttpTransport>(inner) };
+        REQUIRE(recorder.Open(path));
+        HttpResult result;
+        for (const char* answer : { "A", "B", "C" })
+        {
+            inner->chunks = { answer };
+            Collect(recorder, MakeRequest("same"), result);
+        }
+    }
+
+    ReplayTransport replay;
+    REQUIRE(replay.Load(path, 0));
+    HttpResult result;
+    std::string answers;
+    for (int i = 0; i < 4; ++i)
+        answers += Collect(replay, MakeRequest("same"), result);
+    CHECK_EQ(answers, std::string("ABCA"));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(ReplayHonorsRecordedTiming)
+{
+    std::string path = TempPath("YunsioHttpRecordingTiming.ytrr");
+    {
+        std::string data(HttpRecording::FILE_MAGIC, sizeof(HttpRecording::FILE_MAGIC));
+        data += static_cast<char>(HttpRecording::FILE_VERSION);
+        HttpExchange exchange;
+        exchange.key = HttpRecording::RequestKey(MakeRequest("timed"));
+        exchange.statusCode = 200;
+        exchange.chunks.push_back({ 20000, "a" });
+        exchange.chunks.push_back({ 20000, "b" });
+        exchange.tailUs = 10000;
+        HttpRecording::Encode(exchange, data);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        std::fwrite(data.data(), 1, data.length(), file);
+        std::fclose(file);
+    }
+
+    // 等待的截止时间累加计算：第一次等待睡过头时后一块的间隔会变短，只检查各块相对开始时刻的到达时间
+    ReplayTransport replay;
+    REQUIRE(replay.Load(path, 1.0));
+    HttpResult result;
+    std::string received;
+    std::vector<double> arrivals;
+    auto begin = std::chrono::steady_clock::now();
+    replay.Send(MakeRequest("timed"), [&](const char* data, size_t length)
+    {
+        received.append(data, length);
+        arrivals.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }, result);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    CHECK_EQ(received, std::string("ab"));
+    REQUIRE(arrivals.size() == 2);
+    CHECK(arrivals[0] >= 20.0);
+    CHECK(arrivals[1] >= 40.0);
+    CHECK(ms >= 50.0);
+    CHECK(result.latencyMs >= 50.0);
+    CHECK(result.responseMs >= 20.0);
+
+    ReplayTransport fast;
+    REQUIRE(fast.Load(path, 0));
+    Collect(fast, MakeRequest("timed"), result);
+    CHECK(result.latencyMs < 50.0);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(LoadRejectsForeignFiles)
+{
+    std::string path = TempPath("YunsioHttpRecordingForeign.ytrr");
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    std::fputs("not a recording", file);
+    std::fclose(file);
+
+    ReplayTransport replay;
+    CHECK(!replay.Load(path, 0));
+    CHECK(!replay.Load(TempPath("YunsioHttpRecordingMissing.ytrr"), 0));
+    std::filesystem::remove(path);
+}
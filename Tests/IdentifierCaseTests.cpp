@@ -0,0 +1,83 @@
+﻿#include "TestHarness.h"
+#include "IdentifierCase.h"
+#include "TranslationCache.h"
+
+namespace
+{
+    std::string Convert(const std::string& text, CaseStyle style)
+    {
+        std::string out;
+        IdentifierCase::Convert(text, style, out);
+        return out;
+    }
+}
+
+TEST_CASE(ConvertsPlainWordsToEveryStyle)
+{
+    CHECK_EQ(Convert("get object name", CaseStyle::Pascal), std::string("GetObjectName"));
+    CHECK_EQ(Convert("get object name", CaseStyle::Camel), std::string("getObjectName"));
+    CHECK_EQ(Convert("get object name", CaseStyle::Snake), std::string("get_object_name"));
+    CHECK_EQ(Convert("get object name", CaseStyle::ScreamingSnake), std::string("GET_OBJECT_NAME"));
+    CHECK_EQ(Convert("get object name", CaseStyle::Kebab), std::string("get-object-name"));
+    CHECK_EQ(Convert("get object name", CaseStyle::None), std::string("get object name"));
+}
+
+TEST_CASE(SplitsCamelHumpsAndAcronyms)
+{
+    CHECK_EQ(Convert("HTTPServer", CaseStyle::Snake), std::string("http_server"));
+    CHECK_EQ(Convert("getName", CaseStyle::Kebab), std::string("get-name"));
+    CHECK_EQ(Convert("HTTP request handler", CaseStyle::Pascal), std::string("HTTPRequestHandler"));
+    CHECK_EQ(Convert("HTTP request handler", CaseStyle::Camel), std::string("httpRequestHandler"));
+    CHECK_EQ(Convert("user ID", CaseStyle::Camel), std::string("userID"));
+}
+
+TEST_CASE(KeepsDigitsAttachedAndDropsApostrophes)
+{
+    CHECK_EQ(Convert("utf8 decoder", CaseStyle::Pascal), std::string("Utf8Decoder"));
+    CHECK_EQ(Convert("api v2", CaseStyle::Snake), std::string("api_v2"));
+    CHECK_EQ(Convert("user's profile", CaseStyle::Pascal), std::string("UsersProfile"));
+    CHECK_EQ(Convert("  load -- config, file!  ", CaseStyle::Kebab), std::string("load-config-file"));
+}
+
+TEST_CASE(LeavesNonAsciiWordsUnchanged)
+{
+    CHECK(!IdentifierCase::IsAsciiText("获取对象名称"));
+    CHECK(IdentifierCase::IsAsciiText("get name"));
+    CHECK_EQ(Convert("获取 name", CaseStyle::Pascal), std::string("获取Name"));
+    CHECK_EQ(Convert("", CaseStyle::Pascal), std::string());
+}
+
+TEST_CASE(ParsesStyleNames)
+{
+    CaseStyle style = CaseStyle::None;
+    CHECK(IdentifierCase::ParseStyle("screamingsnake", style));
+    CHECK(style == CaseStyle::ScreamingSnake);
+    CHECK(IdentifierCase::ParseStyle("None", style));
+    CHECK(style == CaseStyle::None);
+    CHECK(!IdentifierCase::ParseStyle("Title", style));
+}
+
+TEST_CASE(CacheIsKeyedByNamespaceAndEvictsLeastRecentlyUsed)
+{
+    TranslationCache::Clear();
+    TranslationCache::SetCapacity(2);
+    TranslationCache::Store("default", L"对象", L"object");
+    TranslationCache::Store("other", L"对象", L"thing");
+
+    std::wstring result;
+    REQUIRE(TranslationCache::Lookup("default", L"对象", result));
+    CHECK(result == L"object");
+    REQUIRE(TranslationCache::Lookup("other", L"对象", result));
+    CHECK(result == L"thing");
+
+    // default最近未使用，写入第三条时被淘汰
+    TranslationCache::Store("default", L"名称", L"name");
+    CHECK_EQ(TranslationCache::GetSize(), static_cast<size_t>(2));
+    CHECK(!TranslationCache::Lookup("default", L"对象", result));
+    CHECK(TranslationCache::Lookup("other", L"对象", result));
+
+    TranslationCache::SetCapacity(0);
+    TranslationCache::Store("default", L"新", L"new");
+    CHECK(!TranslationCache::Lookup("default", L"新", result));
+    TranslationCache::Clear();
+}
@@ -0,0 +1,230 @@
+﻿#include "TestHarness.h"
+#include "IpcProtocol.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::string BatchPayload(const std::string& profile, const std::vector<std::string>& texts)
+    {
+        std::string payload;
+        IpcProtocol::PutString(profile, payload);
+        IpcProtocol::PutU32(static_cast<uint32_t>(texts.size()), payload);
+        for (const std::string& text : texts)
+            IpcProtocol::PutString(text, payload);
+        return payload;
+    }
+}
+
+TEST_CASE(EncodesLittleEndianHeader)
+{
+    std::string out;
+    IpcProtocol::EncodeFrame(IpcFrameType::Translate, 0x01020304, "abc", out);
+    REQUIRE(out.length() == IpcProtocol::HEADER_SIZE + 3);
+    CHECK_EQ(out.substr(0, 4), std::string("\x03\x00\x00\x00", 4));
+    CHECK_EQ(static_cast<int>(out[4]), 0x01);
+    CHECK_EQ(static_cast<int>(out[5]), static_cast<int>(IpcProtocol::VERSION));
+    CHECK_EQ(out.substr(6, 2), std::string("\x00\x00", 2));
+    CHECK_EQ(out.substr(8, 4), std::string("\x04\x03\x02\x01", 4));
+    CHECK_EQ(out.substr(12), std::string("abc"));
+}
+
+TEST_CASE(RoundTripsBatchPayload)
+{
+    std::vector<std::string> texts = { "hello", std::string(), "用户名", std::string("a\0b", 3) };
+    std::string stream;
+    IpcProtocol::EncodeFrame(IpcFrameType::Batch, 7, BatchPayload("default", texts), stream);
+
+    IpcFrameDecoder decoder;
+    decoder.Feed(stream.data(), stream.length());
+    IpcFrame frame;
+    REQUIRE(decoder.Next(frame));
+    CHECK(frame.type == IpcFrameType::Batch);
+    CHECK_EQ(frame.requestId, 7u);
+
+    size_t offset = 0;
+    std::string profile;
+    uint32_t count = 0;
+    REQUIRE(IpcProtocol::ReadString(frame.payload, offset, profile));
+    REQUIRE(IpcProtocol::ReadU32(frame.payload, offset, count));
+    CHECK_EQ(profile, std::string("default"));
+    REQUIRE(count == texts.size());
+    for (const std::string& expected : texts)
+    {
+        std::string text;
+        REQUIRE(IpcProtocol::ReadString(frame.payload, offset, text));
+        CHECK(text == expected);
+    }
+    CHECK_EQ(offset, frame.payload.length());
+    CHECK(!decoder.Next(frame));
+    CHECK_EQ(decoder.GetBufferedSize(), static_cast<size_t>(0));
+}
+
+TEST_CASE(ReadersRejectTruncatedPayload)
+{
+    std::string payload;
+    IpcProtocol::PutString("translate me", payload);
+
+    size_t offset = 0;
+    std::string text;
+    CHECK(!IpcProtocol::ReadString(payload.substr(0, payload.length() - 1), offset, text));
+    CHECK_EQ(offset, static_cast<size_t>(0));
+
+    uint32_t value = 0;
+    offset = 2;
+    CHECK(!IpcProtocol::ReadU32(std::string("\x01\x02\x03\x04", 4), offset, value));
+    offset = 9;
+    CHECK(!IpcProtocol::ReadU32(std::string("\x01\x02\x03\x04", 4), offset, value));
+}
+
+TEST_CASE(DecodesResultFrame)
+{
+    std::string stream;
+    IpcProtocol::EncodeResult(3, 41, IpcStatus::Cached, "UserName", stream);
+    IpcFrameDecoder decoder;
+    decoder.Feed(stream.data(), stream.length());
+    IpcFrame frame;
+    REQUIRE(decoder.Next(frame));
+    CHECK(frame.type == IpcFrameType::Result);
+
+    size_t offset = 0;
+    uint32_t index = 0;
+    REQUIRE(IpcProtocol::ReadU32(frame.payload, offset, index));
+    CHECK_EQ(index, 41u);
+    REQUIRE(offset < frame.payload.length());
+    CHECK(static_cast<IpcStatus>(frame.payload[offset++]) == IpcStatus::Cached);
+    std::string text;
+    REQUIRE(IpcProtocol::ReadString(frame.payload, offset, text));
+    CHECK_EQ(text, std::string("UserName"));
+}
+
+TEST_CASE(DecodesPartialFrame)
+{
+    std::string content = "User";
+    std::string stream;
+    IpcProtocol::EncodePartial(5, 2, content.data() + 2, 2, stream);
+    IpcFrameDecoder decoder;
+    decoder.Feed(stream.data(), stream.length());
+    IpcFrame frame;
+    REQUIRE(decoder.Next(frame));
+    CHECK(frame.type == IpcFrameType::Partial);
+    CHECK_EQ(frame.requestId, 5u);
+
+    size_t offset = 0;
+    uint32_t position = 0;
+    std::string text;
+    REQUIRE(IpcProtocol::ReadU32(frame.payload, offset, position));
+    REQUIRE(IpcProtocol::ReadString(frame.payload, offset, text));
+    CHECK_EQ(position, 2u);
+    CHECK_EQ(text, std::string("er"));
+}
+
+TEST_CASE(StopsBeforeIncompleteUtf8Characters)
+{
+    std::string text = "a\xE7\x94\xA8\xF0\x9F\x98\x80";     // a、用、U+1F600
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(text), text.length());
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(text.substr(0, 7)), static_cast<size_t>(4));
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(text.substr(0, 5)), static_cast<size_t>(4));
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(text.substr(0, 3)), static_cast<size_t>(1));
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(text.substr(0, 2)), static_cast<size_t>(1));
+    CHECK_EQ(IpcProtocol::CompleteUtf8Length(std::string()), static_cast<size_t>(0));
+}
+
+TEST_CASE(ReassemblesFramesFromArbitraryChunks)
+{
+    std::mt19937 random(11);
+    std::string stream;
+    std::vector<std::string> sent;
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        std::string text(random() % 300, static_cast<char>('a' + i % 26));
+        IpcProtocol::EncodeResult(i, i, IpcStatus::Ok, text, stream);
+        sent.push_back(text);
+    }
+
+    IpcFrameDecoder decoder;
+    std::vector<IpcFrame> frames;
+    size_t position = 0;
+    while (position < stream.length())
+    {
+        size_t chunk = std::min<size_t>(1 + random() % 97, stream.length() - position);
+        decoder.Feed(stream.data() + position, chunk);
+        position += chunk;
+        IpcFrame frame;
+        while (decoder.Next(frame))
+            frames.push_back(frame);
+    }
+
+    CHECK(!decoder.HasError());
+    CHECK_EQ(decoder.GetBufferedSize(), static_cast<size_t>(0));
+    REQUIRE(frames.size() == sent.size());
+    for (uint32_t i = 0; i < frames.size(); ++i)
+    {
+        size_t offset = 5;
+        std::string text;
+        CHECK_EQ(frames[i].requestId, i);
+        CHECK(IpcProtocol::ReadString(frames[i].payload, offset, text) && text == sent[i]);
+    }
+}
+
+TEST_CASE(RejectsOversizedFrame)
+{
+    std::string header;
+    IpcProtocol::PutU32(IpcProtocol::MAX_PAYLOAD + 1, header);
+    header += static_cast<char>(IpcFrameType::Translate);
+    header += static_cast<char>(IpcProtocol::VERSION);
+    header.append(6, '\0');
+
+    IpcFrameDecoder decoder;
+    decoder.Feed(header.data(), header.length());
+    IpcFrame frame;
+    CHECK(!decoder.Next(frame));
+    CHECK(decoder.HasError());
+
+    // 出错后不再接受数据
+    std::string valid;
+    IpcProtocol::EncodeFrame(IpcFrameType::Cancel, 1, std::string(), valid);
+    decoder.Feed(valid.data(), valid.length());
+    CHECK(!decoder.Next(frame));
+}
+
+TEST_CASE(RejectsUnknownVersion)
+{
+    std::string stream;
+    IpcProtocol::EncodeFrame(IpcFrameType::Cancel, 1, std::string(), stream);
+    stream[5] = static_cast<char>(IpcProtocol::VERSION + 1);
+
+    IpcFrameDecoder decoder;
+    decoder.Feed(stream.data(), stream.length());
+    IpcFrame frame;
+    CHECK(!decoder.Next(frame));
+    CHECK(decoder.HasError());
+}
+
+TEST_CASE(BuffersOnlyIncompleteFrames)
+{
+    IpcFrameDecoder decoder;
+    std::string frameBytes;
+    IpcProtocol::EncodeResult(1, 0, IpcStatus::Ok, std::string(100, 'x'), frameBytes);
+
+    // 每次喂入一帧半，取出完整的帧后最多留下不到一帧
+    std::string stream;
+    for (int i = 0; i < 2000; ++i)
+        stream += frameBytes;
+    size_t half = frameBytes.length() / 2;
+    size_t position = 0;
+    size_t decoded = 0;
+    size_t maxBuffered = 0;
+    while (position < stream.length())
+    {
+        size_t chunk = std::min(frameBytes.length() + half, stream.length() - position);
+        decoder.Feed(stream.data() + position, chunk);
+        position += chunk;
+        IpcFrame frame;
+        while (decoder.Next(frame))
+            ++decoded;
+        maxBuffered = std::max(maxBuffered, decoder.GetBufferedSize());
+    }
+    CHECK_EQ(decoded, static_cast<size_t>(2000));
+    CHECK(maxBuffered < frameBytes.length());
+}
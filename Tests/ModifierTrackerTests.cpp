@@ -0,0 +1,120 @@
+﻿#include "TestHarness.h"
+#include "ModifierTracker.h"
+#include "TranslationProfile.h"
+
+namespace
+{
+    const uint32_t VK_SHIFT = 0x10;
+    const uint32_t VK_CONTROL = 0x11;
+    const uint32_t VK_LSHIFT = 0xA0;
+    const uint32_t VK_RSHIFT = 0xA1;
+    const uint32_t VK_LCONTROL = 0xA2;
+    const uint32_t VK_RCONTROL = 0xA3;
+    const uint32_t VK_LMENU = 0xA4;
+    const uint32_t VK_LWIN = 0x5B;
+    const uint32_t VK_SPACE = 0x20;
+
+    // 与GlobalHotkey相同：Ctrl不影响Ctrl+C，只等待Shift、Alt和Win
+    const uint32_t WAITED = HotkeyBinding::MOD_SHIFT_FLAG | HotkeyBinding::MOD_ALT_FLAG | HotkeyBinding::MOD_WIN_FLAG;
+
+    typedef ModifierTracker::State State;
+}
+
+TEST_CASE(MapsVirtualKeysToModifiers)
+{
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_SHIFT), HotkeyBinding::MOD_SHIFT_FLAG);
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_RSHIFT), HotkeyBinding::MOD_SHIFT_FLAG);
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_RCONTROL), HotkeyBinding::MOD_CONTROL_FLAG);
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_LMENU), HotkeyBinding::MOD_ALT_FLAG);
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_LWIN), HotkeyBinding::MOD_WIN_FLAG);
+    CHECK_EQ(ModifierTracker::ModifierOf(VK_SPACE), 0u);
+}
+
+TEST_CASE(ReleasesImmediatelyWhenNothingIsHeld)
+{
+    ModifierTracker tracker;
+    CHECK(tracker.GetState() == State::Idle);
+    tracker.Arm(0, 1000, WAITED);
+    CHECK(tracker.GetState() == State::Waiting);
+    CHECK(tracker.OnTick(0) == State::Released);
+}
+
+TEST_CASE(IgnoresModifiersThatAreNotWaitedFor)
+{
+    // Ctrl+Space：按着Ctrl也可以立即复制
+    ModifierTracker tracker;
+    tracker.Arm(0, 1000, WAITED);
+    CHECK(tracker.OnKey(VK_LCONTROL, true) == State::Waiting);
+    CHECK(tracker.OnKey(VK_SPACE, true) == State::Waiting);
+    CHECK_EQ(tracker.GetHeldModifiers(), 0u);
+    CHECK(tracker.OnTick(10) == State::Released);
+}
+
+TEST_CASE(WaitsForEveryPhysicalKey)
+{
+    ModifierTracker tracker;
+    tracker.Arm(0, 1000, WAITED);
+    tracker.OnKey(VK_LSHIFT, true);
+    tracker.OnKey(VK_RSHIFT, true);
+    tracker.OnKey(VK_LMENU, true);
+    CHECK(tracker.OnTick(0) == State::Waiting);
+    CHECK_EQ(tracker.GetHeldModifiers(), HotkeyBinding::MOD_SHIFT_FLAG | HotkeyBinding::MOD_ALT_FLAG);
+
+    CHECK(tracker.OnKey(VK_LSHIFT, false) == State::Waiting);
+    CHECK_EQ(tracker.GetHeldModifiers(), HotkeyBinding::MOD_SHIFT_FLAG | HotkeyBinding::MOD_ALT_FLAG);
+    CHECK(tracker.OnKey(VK_LMENU, false) == State::Waiting);
+    CHECK(tracker.OnKey(VK_RSHIFT, false) == State::Released);
+
+    // 释放后的事件不再改变状态
+    CHECK(tracker.OnKey(VK_LSHIFT, true) == State::Released);
+}
+
+TEST_CASE(GenericKeyUpReleasesBothSides)
+{
+    ModifierTracker tracker;
+    tracker.Arm(0, 1000, WAITED);
+    tracker.OnKey(VK_LSHIFT, true);
+    tracker.OnKey(VK_RSHIFT, true);
+    CHECK(tracker.OnKey(VK_SHIFT, false) == State::Released);
+
+    tracker.Arm(0, 1000, WAITED | HotkeyBinding::MOD_CONTROL_FLAG);
+    tracker.OnKey(VK_RCONTROL, true);
+    CHECK(tracker.OnKey(VK_CONTROL, false) == State::Released);
+}
+
+TEST_CASE(WaitsForKeysPressedAgain)
+{
+    ModifierTracker tracker;
+    tracker.Arm(0, 1000, WAITED);
+    tracker.OnKey(VK_LSHIFT, true);
+    tracker.OnKey(VK_LWIN, true);
+    CHECK(tracker.OnKey(VK_LSHIFT, false) == State::Waiting);
+    CHECK(tracker.OnKey(VK_LSHIFT, true) == State::Waiting);
+    CHECK(tracker.OnKey(VK_LWIN, false) == State::Waiting);
+    CHECK(tracker.OnKey(VK_LSHIFT, false) == State::Released);
+}
+
+TEST_CASE(TimesOutWhenKeyIsStuck)
+{
+    ModifierTracker tracker;
+    tracker.Arm(100, 1000, WAITED);
+    tracker.OnKey(VK_LSHIFT, true);
+    CHECK(tracker.OnTick(1099) == State::Waiting);
+    CHECK(tracker.OnTick(1100) == State::TimedOut);
+    CHECK(tracker.OnKey(VK_LSHIFT, false) == State::TimedOut);
+
+    tracker.Reset();
+    CHECK(tracker.GetState() == State::Idle);
+    CHECK_EQ(tracker.GetHeldModifiers(), 0u);
+    CHECK(tracker.OnTick(5000) == State::Idle);
+}
+
+TEST_CASE(ArmClearsPreviousKeys)
+{
+    ModifierTracker tracker;
+    tracker.Arm(0, 1000, WAITED);
+    tracker.OnKey(VK_LSHIFT, true);
+    tracker.Arm(0, 1000, WAITED);
+    CHECK_EQ(tracker.GetHeldModifiers(), 0u);
+    CHECK(tracker.OnTick(0) == State::Released);
+}
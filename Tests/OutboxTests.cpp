@@ -0,0 +1,194 @@
+﻿#include "TestHarness.h"
+#include "Outbox.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    using Clock = Outbox::Clock;
+
+    // 测试专用的队列文件，构造和析构时删除
+    class TempOutboxFile
+    {
+    public:
+        explicit TempOutboxFile(const char* name)
+            : m_path(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove(m_path);
+        }
+
+        ~TempOutboxFile()
+        {
+            std::filesystem::remove(m_path);
+        }
+
+        std::string Utf8() const { return m_path.u8string(); }
+
+        void Write(const std::string& content) const
+        {
+            std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+            file << content;
+        }
+
+        std::string Read() const
+        {
+            std::ifstream file(m_path, std::ios::binary);
+            return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    // 新加入的请求5秒后才到重放时间
+    Clock::time_point AfterInitialBackoff()
+    {
+        return Clock::now() + std::chrono::seconds(6);
+    }
+}
+
+TEST_CASE(EscapedFieldsRoundTripThroughFile)
+{
+    TempOutboxFile file("yunsio_outbox_escape.txt");
+    const std::string profile = "Tab\tProfile";
+    const std::string source = "line one\nline two\r\n\tC:\\path\\n end\\";
+
+    Outbox::Initialize(file.Utf8());
+    CHECK(Outbox::Enqueue(profile, source));
+    Outbox::Cleanup();
+
+    // 每条请求占一行，控制字符都已转义
+    std::string content = file.Read();
+    CHECK_EQ(content.find('\n'), content.length() - 1);
+    CHECK_EQ(content.find('\r'), std::string::npos);
+
+    // 加载的请求立即可以重放，失败次数与字段完整还原
+    Outbox::Initialize(file.Utf8());
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(1));
+    OutboxEntry entry;
+    REQUIRE(Outbox::TakeDue(Clock::now(), entry));
+    CHECK_EQ(entry.profile, profile);
+    CHECK_EQ(entry.source, source);
+    CHECK_EQ(entry.attempts, 0);
+    Outbox::Cleanup();
+}
+
+TEST_CASE(LoadSkipsMalformedLinesAndKeepsAttempts)
+{
+    TempOutboxFile file("yunsio_outbox_load.txt");
+    file.Write("3\tDefault\tfirst source\nno tabs here\n1\tDefault\t\n0\tCode\tsecond\tsource\n");
+
+    Outbox::Initialize(file.Utf8());
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(2));
+    OutboxEntry first;
+    OutboxEntry second;
+    REQUIRE(Outbox::TakeDue(Clock::now(), first));
+    REQUIRE(Outbox::TakeDue(Clock::now(), second));
+    CHECK_EQ(first.source, std::string("first source"));
+    CHECK_EQ(first.attempts, 3);
+    CHECK_EQ(second.profile, std::string("Code"));
+    CHECK_EQ(second.source, std::string("second\tsource"));
+    CHECK(first.id != second.id);
+
+    // 保存时丢弃无效的行，成功重放的请求从文件中移除
+    Outbox::Complete(first.id);
+    Outbox::Release(second.id);
+    CHECK_EQ(file.Read(), std::string("0\tCode\tsecond\\tsource\n"));
+    Outbox::Cleanup();
+}
+
+TEST_CASE(BackoffDoublesUpToTenMinutes)
+{
+    CHECK(Outbox::GetBackoff(1) == std::chrono::seconds(5));
+    CHECK(Outbox::GetBackoff(2) == std::chrono::seconds(10));
+    CHECK(Outbox::GetBackoff(3) == std::chrono::seconds(20));
+    CHECK(Outbox::GetBackoff(7) == std::chrono::seconds(320));
+    CHECK(Outbox::GetBackoff(8) == std::chrono::minutes(10));
+    CHECK(Outbox::GetBackoff(100) == std::chrono::minutes(10));
+}
+
+TEST_CASE(RetryFollowsBackoffAndDropsAfterMaxAttempts)
+{
+    TempOutboxFile file("yunsio_outbox_retry.txt");
+    Outbox::Initialize(file.Utf8());
+    REQUIRE(Outbox::Enqueue("Default", "retry me"));
+
+    // 新加入的请求等待首次退避时间
+    OutboxEntry entry;
+    CHECK(!Outbox::TakeDue(Clock::now(), entry));
+    Clock::time_point now = AfterInitialBackoff();
+    REQUIRE(Outbox::TakeDue(now, entry));
+    CHECK(!Outbox::HasDue(now));
+
+    for (int attempts = 1; attempts < Outbox::MAX_ATTEMPTS; ++attempts)
+    {
+        Outbox::Retry(entry.id, now);
+        CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(1));
+        CHECK(!Outbox::HasDue(now + Outbox::GetBackoff(attempts) - std::chrono::seconds(1)));
+        now += Outbox::GetBackoff(attempts);
+        REQUIRE(Outbox::TakeDue(now, entry));
+        CHECK_EQ(entry.attempts, attempts);
+    }
+    CHECK_EQ(file.Read(), "7\tDefault\tretry me\n");
+
+    // 失败次数达到上限时丢弃，文件随之清空
+    Outbox::Retry(entry.id, now);
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(0));
+    CHECK(file.Read().empty());
+    Outbox::Cleanup();
+}
+
+TEST_CASE(ReleaseDoesNotCountAsFailure)
+{
+    Outbox::Initialize(std::string());
+    REQUIRE(Outbox::Enqueue("Default", "interrupted"));
+    Clock::time_point now = AfterInitialBackoff();
+    OutboxEntry entry;
+    REQUIRE(Outbox::TakeDue(now, entry));
+    CHECK(!Outbox::TakeDue(now, entry));
+
+    Outbox::Release(entry.id);
+    CHECK(Outbox::HasDue(now));
+    REQUIRE(Outbox::TakeDue(now, entry));
+    CHECK_EQ(entry.attempts, 0);
+    Outbox::Cleanup();
+}
+
+TEST_CASE(EnqueueDeduplicatesByProfileAndSource)
+{
+    Outbox::Initialize(std::string());
+    CHECK(Outbox::Enqueue("Default", "same text"));
+    CHECK(!Outbox::Enqueue("Default", "same text"));
+    CHECK(Outbox::Enqueue("Identifier", "same text"));
+    CHECK(Outbox::Enqueue("Default", "other text"));
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(3));
+    Outbox::Cleanup();
+}
+
+TEST_CASE(EvictsOldestUntakenEntryWhenFull)
+{
+    Outbox::Initialize(std::string());
+    for (size_t i = 0; i < Outbox::MAX_ENTRIES; ++i)
+        REQUIRE(Outbox::Enqueue("Default", "source " + std::to_string(i)));
+
+    // 最早的请求正在重放，被丢弃的是第二早的
+    Clock::time_point now = AfterInitialBackoff();
+    OutboxEntry taken;
+    REQUIRE(Outbox::TakeDue(now, taken));
+    CHECK_EQ(taken.source, std::string("source 0"));
+    CHECK(Outbox::Enqueue("Default", "newest"));
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(Outbox::MAX_ENTRIES));
+    CHECK(!Outbox::Enqueue("Default", "source 0"));
+    CHECK(!Outbox::Enqueue("Default", "source 2"));
+    CHECK(Outbox::Enqueue("Default", "source 1"));
+    CHECK(!Outbox::Enqueue("Default", "source 3"));
+
+    // 全部在重放中时不丢弃，新请求加入失败
+    OutboxEntry entry;
+    while (Outbox::TakeDue(now, entry))
+        continue;
+    CHECK(!Outbox::Enqueue("Default", "no room"));
+    CHECK_EQ(Outbox::GetCount(), static_cast<size_t>(Outbox::MAX_ENTRIES));
+    Outbox::Cleanup();
+}
@@ -0,0 +1,290 @@
+﻿#include "TestHarness.h"
+#include "RateLimiter.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = RateLimiter::Clock;
+
+    // 测试专用的用量文件，构造和析构时删除
+    class TempQuotaFile
+    {
+    public:
+        explicit TempQuotaFile(const char* name)
+            : m_path(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove(m_path);
+        }
+
+        ~TempQuotaFile()
+        {
+            std::filesystem::remove(m_path);
+        }
+
+        std::string Utf8() const { return m_path.u8string(); }
+
+        void Write(const DailyUsage& usage) const
+        {
+            std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+            file << usage.date << ' ' << usage.requests << ' ' << usage.promptTokens << ' ' << usage.completionTokens << '\n';
+        }
+
+        DailyUsage Read() const
+        {
+            DailyUsage usage;
+            std::ifstream file(m_path, std::ios::binary);
+            file >> usage.date >> usage.requests >> usage.promptTokens >> usage.completionTokens;
+            return usage;
+        }
+
+    private:
+        std::filesystem::path m_path;
+    };
+}
+
+TEST_CASE(RequestBucketLimitsBurstAndRefills)
+{
+    RateLimiter::Initialize(std::string());
+    RateLimiter::SetLimits(60, 0);
+    Clock::time_point now = Clock::now();
+    Clock::time_point retryTime;
+
+    // 满桶可以连续发送一分钟的配额，之后按每秒一个补充
+    int granted = 0;
+    while (granted < 100 && RateLimiter::TryAcquire(now, retryTime))
+        granted++;
+    CHECK_EQ(granted, 60);
+    CHECK(retryTime > now);
+    CHECK(retryTime <= now + std::chrono::milliseconds(1100));
+    CHECK(RateLimiter::TryAcquire(now + std::chrono::milliseconds(1100), retryTime));
+    CHECK(!RateLimiter::TryAcquire(now + std::chrono::milliseconds(1100), retryTime));
+
+    // 0表示不限
+    RateLimiter::SetLimits(0, 0);
+    for (int i = 0; i < 1000; ++i)
+        REQUIRE(RateLimiter::TryAcquire(now, retryTime));
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(TokenUsageDrivesBucketNegative)
+{
+    RateLimiter::Initialize(std::string());
+    RateLimiter::SetLimits(0, 600);
+    Clock::time_point now = Clock::now();
+    Clock::time_point retryTime;
+
+    // token数在响应后才扣除，扣成负数后等待补充回零
+    CHECK(RateLimiter::TryAcquire(now, retryTime));
+    RateLimiter::RecordUsage(700, 200);
+    CHECK(!RateLimiter::TryAcquire(now, retryTime));
+    // 欠300个token，按每秒10个补充约需30秒
+    CHECK(retryTime >= now + std::chrono::seconds(29));
+    CHECK(retryTime <= now + std::chrono::seconds(31));
+    CHECK(RateLimiter::TryAcquire(now + std::chrono::seconds(31), retryTime));
+    RateLimiter::SetLimits(0, 0);
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(AcquireWaitsAndHonoursCancel)
+{
+    RateLimiter::Initialize(std::string());
+    RateLimiter::SetLimits(600, 0);
+    Clock::time_point now = Clock::now();
+    Clock::time_point retryTime;
+    while (RateLimiter::TryAcquire(now, retryTime)) {}
+
+    // 每秒补充10个请求令牌，等待约100毫秒后获取成功
+    auto begin = Clock::now();
+    CHECK(RateLimiter::Acquire(nullptr));
+    CHECK(Clock::now() - begin >= std::chrono::milliseconds(50));
+
+    while (RateLimiter::TryAcquire(Clock::now(), retryTime)) {}
+    std::atomic<bool> cancel{ true };
+    CHECK(!RateLimiter::Acquire(&cancel));
+    RateLimiter::SetLimits(0, 0);
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(DailyUsagePersistsAndResetsOnOtherDate)
+{
+    TempQuotaFile file("yunsio_quota_persist.txt");
+    RateLimiter::Initialize(file.Utf8());
+    std::string today = RateLimiter::GetDailyUsage().date;
+    CHECK_EQ(RateLimiter::GetDailyUsage().requests, static_cast<int64_t>(0));
+
+    Clock::time_point retryTime;
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(10, 5);
+    RateLimiter::Cleanup();
+    DailyUsage saved = file.Read();
+    CHECK_EQ(saved.date, today);
+    CHECK_EQ(saved.requests, static_cast<int64_t>(1));
+    CHECK_EQ(saved.promptTokens, static_cast<int64_t>(10));
+    CHECK_EQ(saved.completionTokens, static_cast<int64_t>(5));
+
+    RateLimiter::Initialize(file.Utf8());
+    CHECK_EQ(RateLimiter::GetDailyUsage().completionTokens, static_cast<int64_t>(5));
+    RateLimiter::Cleanup();
+
+    // 其他日期的用量不计入今天
+    DailyUsage old;
+    old.date = "2000-01-01";
+    old.requests = 99;
+    file.Write(old);
+    RateLimiter::Initialize(file.Utf8());
+    CHECK_EQ(RateLimiter::GetDailyUsage().requests, static_cast<int64_t>(0));
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(SaveMergesUsageWrittenByAnotherProcess)
+{
+    TempQuotaFile file("yunsio_quota_merge.txt");
+    RateLimiter::Initialize(file.Utf8());
+    std::string today = RateLimiter::GetDailyUsage().date;
+
+    Clock::time_point retryTime;
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(100, 50);
+    CHECK(RateLimiter::Flush());
+
+    // 另一个进程（如批处理实例）在此期间保存了自己的用量
+    DailyUsage other = file.Read();
+    other.requests += 7;
+    other.promptTokens += 700;
+    other.completionTokens += 70;
+    file.Write(other);
+
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(1, 2);
+    CHECK(RateLimiter::Flush());
+    DailyUsage merged = file.Read();
+    CHECK_EQ(merged.date, today);
+    CHECK_EQ(merged.requests, static_cast<int64_t>(9));
+    CHECK_EQ(merged.promptTokens, static_cast<int64_t>(801));
+    CHECK_EQ(merged.completionTokens, static_cast<int64_t>(122));
+    // 合并后本进程看到的是两个进程的总用量
+    CHECK_EQ(RateLimiter::GetDailyUsage().requests, static_cast<int64_t>(9));
+
+    // 没有新增用量时保存不改变文件
+    RateLimiter::Cleanup();
+    CHECK_EQ(file.Read().requests, static_cast<int64_t>(9));
+    CHECK(!std::filesystem::exists(std::filesystem::u8path(file.Utf8() + ".lock")));
+}
+
+TEST_CASE(RecordUsageLeavesTheFileToFlush)
+{
+    // 记录用量只更新内存，文件在Flush时才写入
+    TempQuotaFile file("yunsio_quota_deferred.txt");
+    RateLimiter::Initialize(file.Utf8());
+    Clock::time_point retryTime;
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(10, 5);
+    CHECK(!std::filesystem::exists(std::filesystem::u8path(file.Utf8())));
+    CHECK_EQ(RateLimiter::GetDailyUsage().promptTokens, static_cast<int64_t>(10));
+
+    CHECK(RateLimiter::Flush());
+    CHECK_EQ(file.Read().promptTokens, static_cast<int64_t>(10));
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(FlushDefersWhileAnotherProcessHoldsTheFileLock)
+{
+    TempQuotaFile file("yunsio_quota_locked.txt");
+    std::filesystem::path lockPath = std::filesystem::u8path(file.Utf8() + ".lock");
+    RateLimiter::Initialize(file.Utf8());
+    DailyUsage other;
+    other.date = RateLimiter::GetDailyUsage().date;
+    other.requests = 5;
+    file.Write(other);
+
+    Clock::time_point retryTime;
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(30, 20);
+
+    // 其他进程持有文件锁：保存等待期间获取配额和记录用量不被阻塞，超时后不覆盖文件
+    std::filesystem::create_directory(lockPath);
+    bool flushed = true;
+    std::thread flusher([&flushed] { flushed = RateLimiter::Flush(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto begin = Clock::now();
+    CHECK(RateLimiter::TryAcquire(Clock::now(), retryTime));
+    RateLimiter::RecordUsage(1, 1);
+    CHECK(Clock::now() - begin < std::chrono::milliseconds(200));
+    flusher.join();
+    CHECK(!flushed);
+    CHECK_EQ(file.Read().requests, static_cast<int64_t>(5));
+
+    // 锁释放后，放回的增量和等待期间新增的用量一起合并
+    std::filesystem::remove(lockPath);
+    CHECK(RateLimiter::Flush());
+    DailyUsage merged = file.Read();
+    CHECK_EQ(merged.requests, static_cast<int64_t>(7));
+    CHECK_EQ(merged.promptTokens, static_cast<int64_t>(31));
+    CHECK_EQ(RateLimiter::GetDailyUsage().requests, static_cast<int64_t>(7));
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(ConcurrentRecordingLosesNoUsage)
+{
+    // 多个线程同时记录用量，另一个线程反复保存，最终总数不丢失
+    TempQuotaFile file("yunsio_quota_concurrent.txt");
+    RateLimiter::Initialize(file.Utf8());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([]()
+        {
+            for (int i = 0; i < 50; ++i)
+                RateLimiter::RecordUsage(1, 1);
+        });
+    }
+    threads.emplace_back([]()
+    {
+        for (int i = 0; i < 20; ++i)
+            RateLimiter::Flush();
+    });
+    for (std::thread& thread : threads)
+        thread.join();
+    RateLimiter::Cleanup();
+    CHECK_EQ(file.Read().promptTokens, static_cast<int64_t>(200));
+}
+
+TEST_CASE(TimeoutRetryIsChargedAsAnotherRequest)
+{
+    // 与TranslationService相同：收紧的超时到期后的重试再获取一次请求令牌，两次发送都计入当日请求数
+    TempQuotaFile file("yunsio_quota_retry.txt");
+    RateLimiter::Initialize(file.Utf8());
+    RateLimiter::SetLimits(1, 0);
+    CHECK(RateLimiter::Acquire(nullptr));
+
+    // 每分钟只有一个请求时重试要等待令牌补充，等待中取消则不发送
+    Clock::time_point retryTime;
+    CHECK(!RateLimiter::TryAcquire(Clock::now(), retryTime));
+    CHECK(retryTime - Clock::now() > std::chrono::seconds(30));
+    std::atomic<bool> cancel{ true };
+    CHECK(!RateLimiter::Acquire(&cancel));
+    CHECK_EQ(RateLimiter::GetDailyUsage().requests, static_cast<int64_t>(1));
+
+    RateLimiter::SetLimits(0, 0);
+    CHECK(RateLimiter::Acquire(nullptr));
+    RateLimiter::RecordUsage(20, 10);
+    CHECK(RateLimiter::Flush());
+    CHECK_EQ(file.Read().requests, static_cast<int64_t>(2));
+    RateLimiter::Cleanup();
+}
+
+TEST_CASE(ThrottlePausesRequests)
+{
+    RateLimiter::Initialize(std::string());
+    RateLimiter::SetLimits(0, 0);
+    RateLimiter::OnThrottled();
+    Clock::time_point now = Clock::now();
+    Clock::time_point retryTime;
+    CHECK(!RateLimiter::TryAcquire(now, retryTime));
+    CHECK(retryTime > now + std::chrono::seconds(4));
+    CHECK(RateLimiter::TryAcquire(now + std::chrono::seconds(6), retryTime));
+    RateLimiter::Cleanup();
+}
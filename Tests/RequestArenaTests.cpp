@@ -0,0 +1,62 @@
+﻿#include "TestHarness.h"
+#include "RequestArena.h"
+#include <thread>
+
+TEST_CASE(ResetClearsContentsAndKeepsCapacity)
+{
+    RequestArena arena;
+    arena.utf8Text.assign(4000, 'a');
+    arena.body.assign(9000, 'b');
+    arena.result.assign(4000, L'c');
+    arena.parser.Feed("{\"choices\":[{\"message\":{\"content\":\"hello\"}}]}", 46);
+    REQUIRE(arena.parser.Finish());
+    const char* text = arena.utf8Text.data();
+    size_t capacity = arena.GetCapacityBytes();
+
+    arena.Reset();
+    CHECK(arena.utf8Text.empty());
+    CHECK(arena.body.empty());
+    CHECK(arena.result.empty());
+    CHECK(!arena.parser.Finish());
+    CHECK(arena.parser.GetContent().empty());
+    CHECK_EQ(arena.GetCapacityBytes(), capacity);
+
+    // 下一次同样大小的请求复用原来的内存
+    arena.utf8Text.assign(4000, 'd');
+    CHECK(arena.utf8Text.data() == text);
+}
+
+TEST_CASE(ResetReleasesBuffersOverTheRetainedCap)
+{
+    RequestArena arena;
+    arena.utf8Text.assign(100 * 1024, 'a');
+    arena.body.assign(120 * 1024, 'b');
+    arena.Reset();
+    size_t underCap = arena.GetCapacityBytes();
+    CHECK(underCap <= RequestArena::MAX_RETAINED_BYTES);
+    CHECK(arena.utf8Text.capacity() >= 100 * 1024);
+
+    // 超大请求之后释放全部可变缓冲区，只保留固定容量的响应环形缓冲区
+    arena.deltaOutput.assign(RequestArena::MAX_RETAINED_BYTES, 'c');
+    CHECK(arena.GetCapacityBytes() > RequestArena::MAX_RETAINED_BYTES);
+    arena.Reset();
+    CHECK(arena.GetCapacityBytes() <= RequestArena::MAX_RETAINED_BYTES);
+    CHECK(arena.utf8Text.capacity() < 1024);
+    CHECK(arena.body.capacity() < 1024);
+    CHECK(arena.deltaOutput.capacity() < 1024);
+    CHECK_EQ(arena.responseRing.GetCapacity(), static_cast<size_t>(ByteRing::DEFAULT_CAPACITY));
+
+    // 释放后照常使用
+    arena.utf8Text = "next request";
+    CHECK_EQ(arena.utf8Text, std::string("next request"));
+}
+
+TEST_CASE(EachThreadHasItsOwnArena)
+{
+    RequestArena* main = &RequestArena::ForCurrentThread();
+    CHECK(&RequestArena::ForCurrentThread() == main);
+
+    RequestArena* other = nullptr;
+    std::thread([&other] { other = &RequestArena::ForCurrentThread(); }).join();
+    CHECK(other != main);
+}
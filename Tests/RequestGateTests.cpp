@@ -0,0 +1,106 @@
+﻿#include "TestHarness.h"
+#include "RequestGate.h"
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace std::chrono_literals;
+}
+
+TEST_CASE(ClosedGateRejectsEntry)
+{
+    RequestGate gate;
+    CHECK(!gate.IsOpen());
+    CHECK(!gate.TryEnter());
+
+    gate.Open();
+    CHECK(gate.IsOpen());
+    {
+        RequestGate::Pass first = gate.TryEnter();
+        RequestGate::Pass second = gate.TryEnter();
+        CHECK(static_cast<bool>(first));
+        CHECK(static_cast<bool>(second));
+        CHECK_EQ(gate.GetInFlight(), 2u);
+
+        // 通行证移动后只离开一次
+        RequestGate::Pass moved = std::move(first);
+        CHECK(!first);
+        CHECK_EQ(gate.GetInFlight(), 2u);
+        second.Release();
+        second.Release();
+        CHECK_EQ(gate.GetInFlight(), 1u);
+    }
+    CHECK_EQ(gate.GetInFlight(), 0u);
+
+    CHECK(gate.CloseAndDrain());
+    CHECK(!gate.IsOpen());
+    CHECK(!gate.TryEnter());
+}
+
+TEST_CASE(CloseWaitsForInFlightCalls)
+{
+    RequestGate gate;
+    gate.Open();
+    RequestGate::Pass pass = gate.TryEnter();
+    REQUIRE(static_cast<bool>(pass));
+
+    // 持有通行证时关闭超时，闸门保持关闭，新的调用进不来
+    CHECK(!gate.CloseAndDrain(10ms));
+    CHECK(!gate.IsOpen());
+    CHECK(!gate.TryEnter());
+
+    std::thread leaver([&pass]()
+    {
+        std::this_thread::sleep_for(20ms);
+        pass.Release();
+    });
+    auto begin = std::chrono::steady_clock::now();
+    CHECK(gate.CloseAndDrain(2000ms));
+    CHECK(std::chrono::steady_clock::now() - begin >= 15ms);
+    leaver.join();
+
+    // 可以重新打开
+    gate.Open();
+    CHECK(static_cast<bool>(gate.TryEnter()));
+    CHECK(gate.CloseAndDrain());
+}
+
+TEST_CASE(StressEnterLeaveWhileClosing)
+{
+    // 多个调用方反复进出的同时关闭闸门：关闭返回后不再有调用在闸门内（配合 -DYUNSIO_SANITIZER=thread）
+    for (int round = 0; round < 20; ++round)
+    {
+        RequestGate gate;
+        gate.Open();
+        std::atomic<int> inside{ 0 };
+        std::atomic<bool> violated{ false };
+        std::atomic<bool> drained{ false };
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 4; ++t)
+        {
+            callers.emplace_back([&]()
+            {
+                for (;;)
+                {
+                    RequestGate::Pass pass = gate.TryEnter();
+                    if (!pass)
+                        break;
+                    inside++;
+                    if (drained)
+                        violated = true;
+                    std::this_thread::yield();
+                    inside--;
+                }
+            });
+        }
+        std::this_thread::sleep_for(1ms);
+        CHECK(gate.CloseAndDrain(2000ms));
+        drained = true;
+        CHECK_EQ(inside.load(), 0);
+        for (std::thread& caller : callers)
+            caller.join();
+        CHECK(!violated);
+        CHECK_EQ(gate.GetInFlight(), 0u);
+    }
+}
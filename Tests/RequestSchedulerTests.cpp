@@ -0,0 +1,346 @@
+﻿#include "TestHarness.h"
+#include "RequestScheduler.h"
+#include <algorithm>
+#include <string>
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    // 等待条件成立（最多2秒），避免测试在调度异常时挂起
+    template <typename Predicate>
+    bool WaitFor(Predicate predicate)
+    {
+        auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (!predicate())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    // 线程安全的执行记录
+    class Trace
+    {
+    public:
+        void Add(const std::string& entry)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.push_back(entry);
+        }
+
+        std::vector<std::string> Get() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_entries;
+        }
+
+        size_t Count(const std::string& entry) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return static_cast<size_t>(std::count(m_entries.begin(), m_entries.end(), entry));
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<std::string> m_entries;
+    };
+}
+
+TEST_CASE(RunsSubmittedJobs)
+{
+    RequestScheduler scheduler;
+    CHECK(!scheduler.Submit(RequestPriority::Interactive, [](const std::atomic<bool>&) { return true; }));
+    REQUIRE(scheduler.Start(RequestScheduler::Limits()));
+    CHECK(!scheduler.Start(RequestScheduler::Limits()));
+
+    std::atomic<int> done{ 0 };
+    for (int i = 0; i < 50; ++i)
+    {
+        RequestPriority priority = i % 2 ? RequestPriority::Background : RequestPriority::Interactive;
+        CHECK(scheduler.Submit(priority, [&done](const std::atomic<bool>&) { done++; return true; }));
+    }
+    CHECK(WaitFor([&]() { return done == 50; }));
+    CHECK(scheduler.Stop());
+    CHECK(!scheduler.Submit(RequestPriority::Interactive, [](const std::atomic<bool>&) { return true; }));
+}
+
+TEST_CASE(InteractiveJobsRunBeforeQueuedBackgroundJobs)
+{
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = 1;
+    limits.backgroundConcurrency = 1;
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(limits));
+
+    // 交互任务占住唯一的交互名额期间，后续交互任务和后台任务都在排队
+    std::atomic<bool> release{ false };
+    Trace trace;
+    scheduler.Submit(RequestPriority::Interactive, [&](const std::atomic<bool>&)
+    {
+        while (!release)
+            std::this_thread::sleep_for(1ms);
+        trace.Add("first");
+        return true;
+    });
+    CHECK(WaitFor([&]() { return scheduler.GetQueuedCount(RequestPriority::Interactive) == 0; }));
+    scheduler.Submit(RequestPriority::Background, [&](const std::atomic<bool>&) { trace.Add("background"); return true; });
+    scheduler.Submit(RequestPriority::Interactive, [&](const std::atomic<bool>&) { trace.Add("second"); return true; });
+    CHECK_EQ(scheduler.GetQueuedCount(RequestPriority::Background), static_cast<size_t>(1));
+
+    release = true;
+    CHECK(WaitFor([&]() { return trace.Get().size() == 3; }));
+    CHECK(trace.Get() == (std::vector<std::string>{ "first", "second", "background" }));
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(InteractiveArrivalPreemptsAndRequeuesBackground)
+{
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(RequestScheduler::Limits()));
+
+    Trace trace;
+    std::atomic<bool> started{ false };
+    scheduler.Submit(RequestPriority::Background, [&](const std::atomic<bool>& cancelled)
+    {
+        trace.Add("background.start");
+        started = true;
+        if (trace.Count("background.start") > 1)
+            return true;
+        // 第一次执行一直等到被抢占
+        while (!cancelled)
+            std::this_thread::sleep_for(1ms);
+        trace.Add("background.preempted");
+        return false;
+    });
+    CHECK(WaitFor([&]() { return started.load(); }));
+    scheduler.Submit(RequestPriority::Interactive, [&](const std::atomic<bool>&) { trace.Add("interactive"); return true; });
+
+    CHECK(WaitFor([&]() { return trace.Count("background.start") == 2; }));
+    std::vector<std::string> entries = trace.Get();
+    REQUIRE(entries.size() == 4);
+    // 交互任务与被抢占的后台任务并行收尾，但后台任务一定在让出后才重新开始
+    auto preempted = std::find(entries.begin(), entries.end(), "background.preempted");
+    CHECK(preempted != entries.end());
+    CHECK(std::find(preempted, entries.end(), "background.start") != entries.end());
+    CHECK_EQ(trace.Count("interactive"), static_cast<size_t>(1));
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(InteractiveJobsBypassBusyClientSlots)
+{
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = 1;
+    limits.clientConcurrency = 1;
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(limits));
+
+    // 客户端占满自己的名额并排起队，热键翻译仍立即执行
+    Trace trace;
+    std::atomic<bool> release{ false };
+    auto client = [&](const std::atomic<bool>&)
+    {
+        trace.Add("client");
+        while (!release)
+            std::this_thread::sleep_for(1ms);
+        return true;
+    };
+    for (int i = 0; i < 3; ++i)
+        scheduler.Submit(RequestPriority::Client, client);
+    scheduler.Submit(RequestPriority::Background, [&](const std::atomic<bool>&) { trace.Add("background"); return true; });
+    CHECK(WaitFor([&]() { return trace.Count("client") == 1; }));
+    scheduler.Submit(RequestPriority::Interactive, [&](const std::atomic<bool>&) { trace.Add("interactive"); return true; });
+
+    CHECK(WaitFor([&]() { return trace.Count("interactive") == 1; }));
+    CHECK_EQ(trace.Count("client"), static_cast<size_t>(1));
+    CHECK_EQ(scheduler.GetQueuedCount(RequestPriority::Client), static_cast<size_t>(2));
+
+    // 客户端请求全部完成后才轮到后台请求
+    release = true;
+    CHECK(WaitFor([&]() { return trace.Count("background") == 1; }));
+    CHECK(trace.Get() == (std::vector<std::string>{ "client", "interactive", "client", "client", "background" }));
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(RespectsConcurrencyLimits)
+{
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = 3;
+    limits.backgroundConcurrency = 2;
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(limits));
+
+    std::atomic<int> running{ 0 };
+    std::atomic<int> peak{ 0 };
+    std::atomic<int> done{ 0 };
+    auto job = [&](const std::atomic<bool>&)
+    {
+        int now = ++running;
+        int previous = peak.load();
+        while (now > previous && !peak.compare_exchange_weak(previous, now)) {}
+        std::this_thread::sleep_for(2ms);
+        running--;
+        done++;
+        return true;
+    };
+    for (int i = 0; i < 30; ++i)
+        scheduler.Submit(RequestPriority::Interactive, job);
+    CHECK(WaitFor([&]() { return done == 30; }));
+    CHECK(peak <= 3);
+
+    peak = 0;
+    for (int i = 0; i < 30; ++i)
+        scheduler.Submit(RequestPriority::Background, job);
+    CHECK(WaitFor([&]() { return done == 60; }));
+    CHECK(peak <= 2);
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(SetLimitsResizesRunningScheduler)
+{
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = 1;
+    limits.backgroundConcurrency = 1;
+    RequestScheduler scheduler;
+    scheduler.SetLimits(limits);    // 未启动时忽略
+    REQUIRE(scheduler.Start(limits));
+
+    std::atomic<int> running{ 0 };
+    std::atomic<int> peak{ 0 };
+    std::atomic<bool> release{ false };
+    std::atomic<int> done{ 0 };
+    auto job = [&](const std::atomic<bool>&)
+    {
+        int now = ++running;
+        int previous = peak.load();
+        while (now > previous && !peak.compare_exchange_weak(previous, now)) {}
+        while (!release)
+            std::this_thread::sleep_for(1ms);
+        running--;
+        done++;
+        return true;
+    };
+    for (int i = 0; i < 3; ++i)
+        scheduler.Submit(RequestPriority::Interactive, job);
+    CHECK(WaitFor([&]() { return running == 1; }));
+    std::this_thread::sleep_for(20ms);
+    CHECK_EQ(running.load(), 1);
+
+    // 提高上限后排队的任务立即启动
+    limits.interactiveConcurrency = 3;
+    scheduler.SetLimits(limits);
+    CHECK(WaitFor([&]() { return running == 3; }));
+    release = true;
+    CHECK(WaitFor([&]() { return done == 3; }));
+
+    // 降低上限后按新上限启动
+    release = false;
+    peak = 0;
+    limits.interactiveConcurrency = 1;
+    scheduler.SetLimits(limits);
+    for (int i = 0; i < 3; ++i)
+        scheduler.Submit(RequestPriority::Interactive, job);
+    CHECK(WaitFor([&]() { return running == 1; }));
+    std::this_thread::sleep_for(20ms);
+    release = true;
+    CHECK(WaitFor([&]() { return done == 6; }));
+    CHECK_EQ(peak.load(), 1);
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(StressSubmittersOnManyThreads)
+{
+    // 多个提交线程与抢占、重新排队并发进行（配合 -DYUNSIO_SANITIZER=thread 检查数据竞争）
+    RequestScheduler::Limits limits;
+    limits.interactiveConcurrency = 2;
+    limits.backgroundConcurrency = 2;
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(limits));
+
+    std::atomic<int> finished{ 0 };
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 4; ++t)
+    {
+        submitters.emplace_back([&, t]()
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                RequestPriority priority = (i + t) % 3 == 0 ? RequestPriority::Interactive : RequestPriority::Background;
+                scheduler.Submit(priority, [&](const std::atomic<bool>& cancelled)
+                {
+                    for (int spin = 0; spin < 50; ++spin)
+                    {
+                        if (cancelled)
+                            return false;
+                    }
+                    finished++;
+                    return true;
+                });
+            }
+        });
+    }
+    for (std::thread& submitter : submitters)
+        submitter.join();
+    CHECK(WaitFor([&]() { return finished == 800; }));
+    CHECK(scheduler.Stop());
+}
+
+TEST_CASE(StopDrainsThenCancels)
+{
+    RequestScheduler scheduler;
+    REQUIRE(scheduler.Start(RequestScheduler::Limits()));
+
+    // 会自然结束的任务在排空时限内完成，不会收到取消信号
+    std::atomic<bool> started{ false };
+    std::atomic<bool> sawCancel{ false };
+    scheduler.Submit(RequestPriority::Interactive, [&](const std::atomic<bool>& cancelled)
+    {
+        started = true;
+        std::this_thread::sleep_for(20ms);
+        sawCancel = cancelled.load();
+        return true;
+    });
+    std::atomic<bool> queuedRan{ false };
+    scheduler.Submit(RequestPriority::Background, [&](const std::atomic<bool>&) { queuedRan = true; return true; });
+    CHECK(WaitFor([&]() { return started.load(); }));
+    CHECK(scheduler.Stop(1000ms, 1000ms));
+    CHECK(!sawCancel);
+
+    // 只在取消后退出的任务：排空超时后收到取消信号
+    RequestScheduler second;
+    REQUIRE(second.Start(RequestScheduler::Limits()));
+    started = false;
+    second.Submit(RequestPriority::Background, [&](const std::atomic<bool>& cancelled)
+    {
+        started = true;
+        while (!cancelled)
+            std::this_thread::sleep_for(1ms);
+        return false;
+    });
+    CHECK(WaitFor([&]() { return started.load(); }));
+    auto begin = std::chrono::steady_clock::now();
+    CHECK(second.Stop(30ms, 1000ms));
+    CHECK(std::chrono::steady_clock::now() - begin >= 30ms);
+}
+
+TEST_CASE(StopReportsBlockedJobs)
+{
+    // 忽略取消信号的任务使停止失败；与进程退出路径相同，调度器故意泄漏，任务阻塞到进程结束
+    // （放行任务会让工作线程在静态对象析构期间继续上报统计）
+    auto* scheduler = new RequestScheduler();
+    REQUIRE(scheduler->Start(RequestScheduler::Limits()));
+    static std::atomic<bool> started{ false };
+    scheduler->Submit(RequestPriority::Interactive, [](const std::atomic<bool>&)
+    {
+        started = true;
+        for (;;)
+            std::this_thread::sleep_for(1s);
+        return true;
+    });
+    CHECK(WaitFor([&]() { return started.load(); }));
+    CHECK(!scheduler->Stop(10ms, 10ms));
+    CHECK(!scheduler->Stop());
+    CHECK(!scheduler->Submit(RequestPriority::Interactive, [](const std::atomic<bool>&) { return true; }));
+}
@@ -0,0 +1,104 @@
+﻿#include "TestHarness.h"
+#include "ResultPipeline.h"
+#include "AppConfig.h"
+#include "TranslationProfile.h"
+
+namespace
+{
+    std::string Run(uint32_t stages, std::string text, size_t maxLength = 0,
+        std::vector<ResultPipeline::Replacement> replacements = {})
+    {
+        ResultPipeline(stages, maxLength, std::move(replacements)).Apply(text);
+        return text;
+    }
+
+    const uint32_t IDENTIFIER = ResultPipeline::DEFAULT_TEXT_STAGES | ResultPipeline::IDENTIFIER_STAGES;
+}
+
+TEST_CASE(TextStagesStripWrappers)
+{
+    const uint32_t text = ResultPipeline::DEFAULT_TEXT_STAGES;
+    CHECK_EQ(Run(text, "  get object name \n"), std::string("get object name"));
+    CHECK_EQ(Run(text, "\xE3\x80\x80\xC2\xA0获取对象\xE3\x80\x80"), std::string("获取对象"));
+    CHECK_EQ(Run(text, "```text\nget object name\n```\n"), std::string("get object name"));
+    CHECK_EQ(Run(text, "```get object name```"), std::string("get object name"));
+    CHECK_EQ(Run(text, "\"`GetObject`\""), std::string("GetObject"));
+    CHECK_EQ(Run(text, "“获取对象”"), std::string("获取对象"));
+    CHECK_EQ(Run(text, "「设置」"), std::string("设置"));
+
+    // 内部还有同种引号时首尾不是一对
+    CHECK_EQ(Run(text, "\"a\" and \"b\""), std::string("\"a\" and \"b\""));
+    // 文本阶段不去除句点和解释
+    CHECK_EQ(Run(text, "It works. (see docs)"), std::string("It works. (see docs)"));
+}
+
+TEST_CASE(IdentifierStagesCleanAsciiResults)
+{
+    CHECK_EQ(Run(IDENTIFIER, "GetObject\nThis method returns the object."), std::string("GetObject"));
+    CHECK_EQ(Run(IDENTIFIER, "GetObject (gets the object)."), std::string("GetObject"));
+    CHECK_EQ(Run(IDENTIFIER, "GetObject（获取对象）"), std::string("GetObject"));
+    CHECK_EQ(Run(IDENTIFIER, "\"get object name.\""), std::string("get object name"));
+    CHECK_EQ(Run(IDENTIFIER, "user's file-path/name"), std::string("users file path name"));
+    CHECK_EQ(Run(IDENTIFIER, "loading..."), std::string("loading"));
+
+    // 中文译文（英译中）不受标识符阶段影响
+    CHECK_EQ(Run(IDENTIFIER, "获取对象。\n第二行"), std::string("获取对象。\n第二行"));
+}
+
+TEST_CASE(ReplacementsAndLengthLimit)
+{
+    std::vector<ResultPipeline::Replacement> replacements;
+    REQUIRE(ResultPipeline::ParseReplacements("Obj>Object;Info>Information", replacements));
+    CHECK_EQ(Run(0, "Obj Info Objective ObjInfo", 0, replacements), std::string("Object Information Objective ObjInfo"));
+
+    CHECK_EQ(Run(0, "获取对象名称", 4), std::string("获取对象"));
+    CHECK_EQ(Run(ResultPipeline::STAGE_TRIM, "get object name", 4), std::string("get"));
+    CHECK(!ResultPipeline::ParseReplacements("Obj", replacements));
+}
+
+TEST_CASE(ParsesStageLists)
+{
+    uint32_t stages = 0;
+    REQUIRE(ResultPipeline::ParseStages("trim, Quotes,PERIOD", stages));
+    CHECK_EQ(stages, ResultPipeline::STAGE_TRIM | ResultPipeline::STAGE_QUOTES | ResultPipeline::STAGE_PERIOD);
+    REQUIRE(ResultPipeline::ParseStages("None", stages));
+    CHECK_EQ(stages, 0u);
+    CHECK(!ResultPipeline::ParseStages("Trim,Bogus", stages));
+}
+
+TEST_CASE(DefaultStagesFollowProfileSettings)
+{
+    AppConfig config;
+    std::string error;
+    REQUIRE(ConfigParser::Parse(
+        "[Profile.Identifier]\n"
+        "Hotkey=Ctrl+Space\n"
+        "Case=Snake\n"
+        "CacheNamespace=shared\n"
+        "[Profile.Prose]\n"
+        "Hotkey=Ctrl+Alt+Space\n"
+        "Case=None\n"
+        "CacheNamespace=shared\n"
+        "[Profile.Custom]\n"
+        "Hotkey=Ctrl+Shift+Space\n"
+        "Case=Pascal\n"
+        "PostProcess=Trim\n",
+        config, error));
+
+    std::shared_ptr<const TranslationProfile> identifier = config.FindProfile("Identifier");
+    std::shared_ptr<const TranslationProfile> prose = config.FindProfile("Prose");
+    std::shared_ptr<const TranslationProfile> custom = config.FindProfile("Custom");
+    REQUIRE(identifier && prose && custom);
+    CHECK_EQ(identifier->resultPipeline.GetStages(), IDENTIFIER);
+    CHECK_EQ(prose->resultPipeline.GetStages(), ResultPipeline::DEFAULT_TEXT_STAGES);
+    CHECK_EQ(custom->resultPipeline.GetStages(), ResultPipeline::STAGE_TRIM);
+
+    // 两个配置档共享命名空间：缓存保存原始译文，各自在输出前处理，互不影响
+    const std::string cached = "\"The file was saved. It can be reopened.\"";
+    std::string forIdentifier = cached;
+    std::string forProse = cached;
+    identifier->resultPipeline.Apply(forIdentifier);
+    prose->resultPipeline.Apply(forProse);
+    CHECK_EQ(forIdentifier, std::string("The file was saved It can be reopened"));
+    CHECK_EQ(forProse, std::string("The file was saved. It can be reopened."));
+}
@@ -0,0 +1,113 @@
+﻿#include "TestHarness.h"
+#include "SentenceDelta.h"
+
+namespace
+{
+    std::vector<std::string> SplitText(const std::string& text)
+    {
+        std::vector<SentenceSpan> spans;
+        SentenceDelta::Split(text, spans);
+        std::vector<std::string> sentences;
+        for (const SentenceSpan& span : spans)
+            sentences.push_back(text.substr(span.begin, span.end - span.begin));
+        return sentences;
+    }
+}
+
+TEST_CASE(SplitsOnTerminatorsAndNewlines)
+{
+    std::vector<std::string> expected = { "First one.", "Second?!", "Third line", "Last" };
+    CHECK(SplitText("  First one. Second?!\nThird line\r\n\nLast  ") == expected);
+
+    expected = { "第一句。", "第二句！", "“第三句？”", "结尾" };
+    CHECK(SplitText("第一句。第二句！“第三句？”结尾") == expected);
+}
+
+TEST_CASE(KeepsClosersAndInlinePeriods)
+{
+    std::vector<std::string> expected = { "He said \"stop.\"", "Version 1.2 of config.ini (see docs.)", "Done." };
+    CHECK(SplitText("He said \"stop.\" Version 1.2 of config.ini (see docs.) Done.") == expected);
+}
+
+TEST_CASE(SpansCoverTrailingWhitespace)
+{
+    std::string text = "A. B.\n\nC.";
+    std::vector<SentenceSpan> spans;
+    SentenceDelta::Split(text, spans);
+    REQUIRE(spans.size() == 3);
+    CHECK_EQ(spans[0].next, spans[1].begin);
+    CHECK_EQ(text.substr(spans[1].end, spans[1].next - spans[1].end), std::string("\n\n"));
+    CHECK_EQ(spans[2].next, text.length());
+}
+
+TEST_CASE(ReusesUnchangedSentences)
+{
+    SentenceDelta delta;
+    REQUIRE(delta.Build("Open the file. Edit the text. Save it.", "Open the file. Change the text. Save it.",
+        "打开文件。修改文本。保存。"));
+    CHECK_EQ(delta.GetSentenceCount(), static_cast<size_t>(3));
+    CHECK_EQ(delta.GetChangedCount(), static_cast<size_t>(1));
+    CHECK_EQ(delta.GetReusedBytes(), std::string("Open the file.Save it.").length());
+
+    std::string batch;
+    delta.BuildBatch(batch);
+    CHECK_EQ(batch, std::string("1|Edit the text.\n"));
+
+    std::string out;
+    REQUIRE(delta.Assemble("1|编辑文本。\n", out));
+    CHECK_EQ(out, std::string("打开文件。编辑文本。保存。"));
+}
+
+TEST_CASE(HandlesInsertedAndDeletedSentences)
+{
+    SentenceDelta delta;
+    REQUIRE(delta.Build("Alpha is here. New sentence. Gamma is here.", "Alpha is here. Beta is here. Gamma is here.",
+        "Alpha在这。Beta在这。Gamma在这。"));
+    CHECK_EQ(delta.GetChangedCount(), static_cast<size_t>(1));
+
+    std::string out;
+    REQUIRE(delta.Assemble("1|新句子。", out));
+    CHECK_EQ(out, std::string("Alpha在这。新句子。Gamma在这。"));
+
+    // 只删除句子时不需要请求
+    REQUIRE(delta.Build("Alpha is here. Gamma is here.", "Alpha is here. Beta is here. Gamma is here.",
+        "Alpha在这。Beta在这。Gamma在这。"));
+    CHECK_EQ(delta.GetChangedCount(), static_cast<size_t>(0));
+    std::string batch;
+    delta.BuildBatch(batch);
+    CHECK(batch.empty());
+    REQUIRE(delta.Assemble(std::string(), out));
+    CHECK_EQ(out, std::string("Alpha在这。Gamma在这。"));
+}
+
+TEST_CASE(KeepsNewSourceLineBreaksAndInsertsEnglishSpaces)
+{
+    SentenceDelta delta;
+    REQUIRE(delta.Build("第一句。新的一句。\n第三句。", "第一句。第二句。\n第三句。", "First. Second.\nThird."));
+    std::string out;
+    REQUIRE(delta.Assemble("1|A new one.", out));
+    CHECK_EQ(out, std::string("First. A new one.\nThird."));
+}
+
+TEST_CASE(RejectsMisalignedHistory)
+{
+    SentenceDelta delta;
+    // 译文句数不同
+    CHECK(!delta.Build("One. Two.", "One. Two.", "一二。"));
+    // 换行位置不同
+    CHECK(!delta.Build("One.\nTwo.", "One.\nTwo.", "一。二。\n"));
+    // 没有可以沿用的句子
+    CHECK(!delta.Build("Three. Four.", "One. Two.", "一。二。"));
+    CHECK(!delta.Build(std::string(), "One.", "一。"));
+}
+
+TEST_CASE(AssembleFailsOnMissingTranslations)
+{
+    SentenceDelta delta;
+    REQUIRE(delta.Build("A b. C d. E f.", "A b. X y. Z w.", "甲。乙。丙。"));
+    CHECK_EQ(delta.GetChangedCount(), static_cast<size_t>(2));
+    std::string out;
+    CHECK(!delta.Assemble("1|丁。", out));
+    CHECK(delta.Assemble("1|丁。\n2|戊。", out));
+    CHECK_EQ(out, std::string("甲。丁。戊。"));
+}
@@ -0,0 +1,187 @@
+﻿#include "TestHarness.h"
+#include "ResponseStream.h"
+#include <random>
+
+namespace
+{
+    // 收集指定路径下的字符串值和全部数值
+    class CollectingHandler : public JsonHandler
+    {
+    public:
+        std::string content;
+        std::vector<std::string> numbers;
+
+        bool OnStringBegin(const JsonPath& path) override
+        {
+            return path.GetDepth() == 1 && path.IsKey(0, "text");
+        }
+
+        void OnStringFragment(std::string_view fragment) override { content.append(fragment); }
+
+        void OnNumber(const JsonPath& path, std::string_view number) override
+        {
+            (void)path;
+            numbers.emplace_back(number);
+        }
+    };
+
+    // 按随机边界分块送入解析器
+    void FeedInChunks(ChatResponseParser& parser, const std::string& body, std::mt19937& random)
+    {
+        size_t pos = 0;
+        while (pos < body.length())
+        {
+            size_t length = std::min<size_t>(body.length() - pos, 1 + random() % 7);
+            parser.Feed(body.data() + pos, length);
+            pos += length;
+        }
+    }
+
+    const char JSON_RESPONSE[] =
+        "{\"id\":\"x\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\","
+        "\"content\":\"get \\\"object\\\" name \\u4e2d\\ud83d\\ude00\\n\"}}],"
+        "\"usage\":{\"prompt_tokens\":120,\"completion_tokens\":7,\"total_tokens\":127,"
+        "\"prompt_tokens_details\":{\"cached_tokens\":96}}}";
+
+    const char EXPECTED_CONTENT[] = "get \"object\" name \xE4\xB8\xAD\xF0\x9F\x98\x80\n";
+}
+
+TEST_CASE(ParsesJsonResponseAtEveryChunkBoundary)
+{
+    std::string body = JSON_RESPONSE;
+    ChatResponseParser parser;
+    for (size_t split = 0; split <= body.length(); ++split)
+    {
+        parser.Reset();
+        parser.Feed(body.data(), split);
+        parser.Feed(body.data() + split, body.length() - split);
+        REQUIRE(parser.Finish());
+        CHECK_EQ(parser.GetContent(), std::string(EXPECTED_CONTENT));
+        CHECK_EQ(parser.GetUsage().promptTokens, 120);
+        CHECK_EQ(parser.GetUsage().completionTokens, 7);
+        CHECK_EQ(parser.GetUsage().cachedTokens, 96);
+    }
+}
+
+TEST_CASE(JoinsSseDeltas)
+{
+    std::string body =
+        ": keep-alive\n\n"
+        "data: {\"choices\":[{\"delta\":{\"role\":\"assistant\",\"content\":\"get \"}}]}\n\n"
+        "data:{\"choices\":[{\"delta\":{\"content\":\"object\"}}]}\r\n\r\n"
+        "data: {\"choices\":[{\"delta\":{\"content\":\" name\"}}],\"usage\":{\"prompt_tokens\":5,\"completion_tokens\":3}}\n\n"
+        "data: [DONE]\n\n";
+    std::mt19937 random(1);
+    ChatResponseParser parser;
+    for (int round = 0; round < 200; ++round)
+    {
+        parser.Reset();
+        FeedInChunks(parser, body, random);
+        REQUIRE(parser.Finish());
+        CHECK_EQ(parser.GetContent(), std::string("get object name"));
+        CHECK(parser.GetUsage().reported);
+        CHECK_EQ(parser.GetUsage().completionTokens, 3);
+    }
+}
+
+TEST_CASE(CapturesApiErrors)
+{
+    std::string body = "{\"error\":{\"message\":\"Invalid API-key provided.\",\"type\":\"invalid_request_error\"}}";
+    ChatResponseParser parser;
+    parser.Feed(body.data(), body.length());
+    CHECK(!parser.Finish());
+    CHECK_EQ(parser.GetErrorMessage(), std::string("Invalid API-key provided."));
+}
+
+TEST_CASE(TokenizerReportsPathsAndNumbers)
+{
+    CollectingHandler handler;
+    StreamingJsonParser parser(handler);
+    std::string body = "{\"a\":[1,-2.5e3,{\"b\":null}],\"text\":\"x\\/y\\t\",\"c\":true}";
+    REQUIRE(parser.Feed(body.data(), body.length()));
+    CHECK(parser.IsComplete());
+    CHECK_EQ(handler.content, std::string("x/y\t"));
+    CHECK(handler.numbers == (std::vector<std::string>{ "1", "-2.5e3" }));
+}
+
+TEST_CASE(TokenizerRejectsMalformedInput)
+{
+    const char* const inputs[] =
+    {
+        "{\"a\" 1}", "[1,]", "{\"a\":tru}", "[\"\\x\"]", "[\"\\u12G4\"]", "{]", "[1 2]", "}",
+    };
+    for (const char* input : inputs)
+    {
+        CollectingHandler handler;
+        StreamingJsonParser parser(handler);
+        bool ok = parser.Feed(input, std::string(input).length());
+        CHECK(!ok || !parser.IsComplete());
+        CHECK(parser.HasError() || !parser.IsComplete());
+    }
+
+    // 超过最大嵌套深度
+    CollectingHandler handler;
+    StreamingJsonParser parser(handler);
+    std::string deep(StreamingJsonParser::MAX_DEPTH + 1, '[');
+    CHECK(!parser.Feed(deep.data(), deep.length()));
+    CHECK(parser.HasError());
+}
+
+TEST_CASE(SurvivesRandomGarbage)
+{
+    // 模糊测试：随机字节和随机截断的合法响应都不能崩溃或越界（配合ASan运行）
+    std::mt19937 random(7);
+    ChatResponseParser parser;
+    std::string body = JSON_RESPONSE;
+    for (int round = 0; round < 2000; ++round)
+    {
+        std::string input(random() % 256, '\0');
+        for (char& c : input)
+            c = static_cast<char>(random() % 4 == 0 ? "{}[]\":,\\u"[random() % 10] : random());
+        if (round % 2 == 0)
+        {
+            // 合法响应中随机改写几个字节
+            input = body;
+            for (int i = 0; i < 3; ++i)
+                input[random() % input.length()] = static_cast<char>(random());
+        }
+        parser.Reset();
+        FeedInChunks(parser, input, random);
+        parser.Finish();
+    }
+    CHECK(true);
+}
+
+TEST_CASE(RingInterleavesReadsAndWrites)
+{
+    // 随机的写入和读取长度，读出的字节序列必须与写入一致
+    std::mt19937 random(3);
+    ByteRing ring(37);
+    uint8_t nextWrite = 0;
+    uint8_t nextRead = 0;
+    size_t total = 0;
+    for (int round = 0; round < 20000; ++round)
+    {
+        size_t writable = 0;
+        char* dest = ring.GetWriteSpan(writable);
+        size_t toWrite = writable == 0 ? 0 : random() % (writable + 1);
+        for (size_t i = 0; i < toWrite; ++i)
+            dest[i] = static_cast<char>(nextWrite++);
+        ring.CommitWrite(toWrite);
+        REQUIRE(ring.GetSize() <= ring.GetCapacity());
+
+        size_t readable = 0;
+        const char* src = ring.GetReadSpan(readable);
+        size_t toRead = readable == 0 ? 0 : random() % (readable + 1);
+        for (size_t i = 0; i < toRead; ++i)
+            REQUIRE(static_cast<uint8_t>(src[i]) == nextRead++);
+        ring.ConsumeRead(toRead);
+        total += toRead;
+    }
+    CHECK(total > 100000);
+
+    ring.Reset();
+    size_t writable = 0;
+    ring.GetWriteSpan(writable);
+    CHECK_EQ(writable, ring.GetCapacity());
+}
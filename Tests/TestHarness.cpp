@@ -0,0 +1,76 @@
+﻿#include "TestHarness.h"
+#include <cstdio>
+
+namespace
+{
+    int s_failures = 0;
+}
+
+/**
+ * @brief 获取测试列表（函数内静态变量，保证先于各测试文件的注册完成初始化）
+ * @return 测试列表
+ */
+std::vector<TestRegistry::TestEntry>& TestRegistry::Entries()
+{
+    static std::vector<TestEntry> entries;
+    return entries;
+}
+
+/**
+ * @brief 注册一个测试
+ * @param name 测试名称
+ * @param function 测试函数
+ * @return 总是返回true
+ */
+bool TestRegistry::Register(const char* name, TestFunction function)
+{
+    Entries().push_back({ name, function });
+    return true;
+}
+
+/**
+ * @brief 记录一次检查失败
+ * @param file 源文件
+ * @param line 行号
+ * @param message 失败描述
+ */
+void TestRegistry::Fail(const char* file, int line, const std::string& message)
+{
+    s_failures++;
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+}
+
+/**
+ * @brief 运行全部测试，或名称包含filter的测试
+ * @param filter 名称过滤
+ * @return 失败的检查数
+ */
+int TestRegistry::RunAll(const std::string& filter)
+{
+    int passed = 0;
+    int failed = 0;
+    for (const TestEntry& entry : Entries())
+    {
+        if (!filter.empty() && std::string(entry.name).find(filter) == std::string::npos)
+            continue;
+
+        int before = s_failures;
+        entry.function();
+        if (s_failures == before)
+        {
+            passed++;
+        }
+        else
+        {
+            failed++;
+            std::fprintf(stderr, "FAILED %s\n", entry.name);
+        }
+    }
+    std::printf("%d passed, %d failed\n", passed, failed);
+    return s_failures;
+}
+
+int main(int argc, char** argv)
+{
+    return TestRegistry::RunAll(argc > 1 ? argv[1] : "") == 0 ? 0 : 1;
+}
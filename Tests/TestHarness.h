@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+/**
+ * @class TestRegistry
+ * @brief 最小的单元测试注册表（只覆盖不依赖Windows API的模块）
+ *
+ * 每个测试文件用TEST_CASE定义若干测试，与TestHarness.cpp链接成一个可执行文件，
+ * 由CTest逐个运行。检查失败时记录文件、行号和表达式并继续执行，全部测试结束后以失败数为退出码
+ */
+class TestRegistry
+{
+public:
+    typedef void (*TestFunction)();
+
+    /**
+     * @brief 注册一个测试（由TEST_CASE在静态初始化时调用）
+     * @param name 测试名称
+     * @param function 测试函数
+     * @return 总是返回true
+     */
+    static bool Register(const char* name, TestFunction function);
+
+    /**
+     * @brief 记录一次检查失败
+     * @param file 源文件
+     * @param line 行号
+     * @param message 失败描述
+     */
+    static void Fail(const char* file, int line, const std::string& message);
+
+    /**
+     * @brief 运行全部测试，或名称包含filter的测试
+     * @param filter 名称过滤（为空时运行全部）
+     * @return 失败的检查数
+     */
+    static int RunAll(const std::string& filter);
+
+private:
+    struct TestEntry
+    {
+        const char* name;
+        TestFunction function;
+    };
+
+    static std::vector<TestEntry>& Entries();
+};
+
+namespace TestDetail
+{
+    // 把检查中的值格式化为字符串（字符串加引号便于看出首尾空白）
+    template <typename T>
+    std::string Describe(const T& value)
+    {
+        std::ostringstream stream;
+        stream << value;
+        return stream.str();
+    }
+
+    inline std::string Describe(const std::string& value) { return "\"" + value + "\""; }
+    inline std::string Describe(const char* value) { return value ? "\"" + std::string(value) + "\"" : "null"; }
+    inline std::string Describe(bool value) { return value ? "true" : "false"; }
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+// 定义一个测试：TEST_CASE(Name) { ... }
+#define TEST_CASE(name) \
+    static void name(); \
+    static const bool TEST_CONCAT(s_registered, name) = TestRegistry::Register(#name, name); \
+    static void name()
+
+// 检查表达式为真
+#define CHECK(expression) \
+    do { if (!(expression)) TestRegistry::Fail(__FILE__, __LINE__, "CHECK(" #expression ")"); } while (0)
+
+// 检查两个值相等，失败时输出两边的值（按值复制，类内初始化的静态常量无需另行定义）
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto testActual = (actual); \
+        const auto testExpected = (expected); \
+        if (!(testActual == testExpected)) \
+            TestRegistry::Fail(__FILE__, __LINE__, "CHECK_EQ(" #actual ", " #expected "): " + \
+                TestDetail::Describe(testActual) + " != " + TestDetail::Describe(testExpected)); \
+    } while (0)
+
+// 前置条件不满足时结束当前测试（后续检查没有意义）
+#define REQUIRE(expression) \
+    do { if (!(expression)) { TestRegistry::Fail(__FILE__, __LINE__, "REQUIRE(" #expression ")"); return; } } while (0)
@@ -0,0 +1,165 @@
+﻿#include "TestHarness.h"
+#include "TextInjector.h"
+#include <algorithm>
+
+namespace
+{
+    // 模拟目标程序：记录收到的事件和批次，可在第N批拒绝全部或部分事件
+    class RecordingSink : public InputSink
+    {
+    public:
+        size_t Send(const KeyEvent* events, size_t count) override
+        {
+            size_t batch = batches.size();
+            batches.push_back(count);
+            size_t accepted = batch == rejectBatch ? std::min(count, acceptOnReject) : count;
+            received.insert(received.end(), events, events + accepted);
+            return accepted;
+        }
+
+        void Pause(uint32_t milliseconds) override
+        {
+            pauses.push_back(milliseconds);
+        }
+
+        std::wstring Text() const
+        {
+            std::wstring text;
+            for (const KeyEvent& event : received)
+            {
+                if (!event.keyUp)
+                    text += static_cast<wchar_t>(event.unit);
+            }
+            return text;
+        }
+
+        size_t rejectBatch = static_cast<size_t>(-1);
+        size_t acceptOnReject = 0;
+        std::vector<KeyEvent> received;
+        std::vector<size_t> batches;
+        std::vector<uint32_t> pauses;
+    };
+
+    bool IsHighSurrogate(uint16_t unit) { return unit >= 0xD800 && unit <= 0xDBFF; }
+}
+
+TEST_CASE(ChoosesTypingOnlyForShortSingleLineText)
+{
+    InjectionPolicy policy;
+    CHECK(TextInjector::ChooseMethod(L"UserName", policy, true) == InjectionMethod::Type);
+    CHECK(TextInjector::ChooseMethod(L"UserName", policy, false) == InjectionMethod::Clipboard);
+    CHECK(TextInjector::ChooseMethod(L"", policy, true) == InjectionMethod::Clipboard);
+    CHECK(TextInjector::ChooseMethod(L"line one\nline two", policy, true) == InjectionMethod::Clipboard);
+    CHECK(TextInjector::ChooseMethod(L"a\tb", policy, true) == InjectionMethod::Clipboard);
+    CHECK(TextInjector::ChooseMethod(std::wstring(policy.maxTypedUnits, L'x'), policy, true) == InjectionMethod::Type);
+    CHECK(TextInjector::ChooseMethod(std::wstring(policy.maxTypedUnits + 1, L'x'), policy, true) == InjectionMethod::Clipboard);
+
+    policy.maxTypedUnits = 0;
+    CHECK(TextInjector::ChooseMethod(L"x", policy, true) == InjectionMethod::Clipboard);
+}
+
+TEST_CASE(BuildsDownUpPairs)
+{
+    std::vector<KeyEvent> events;
+    TextInjector::BuildEvents(L"ab", events);
+    REQUIRE(events.size() == 4);
+    CHECK_EQ(events[0].unit, static_cast<uint16_t>('a'));
+    CHECK(!events[0].keyUp);
+    CHECK(events[1].keyUp);
+    CHECK_EQ(events[2].unit, static_cast<uint16_t>('b'));
+}
+
+TEST_CASE(TypesInBatchesWithPauses)
+{
+    InjectionPolicy policy;
+    policy.batchUnits = 4;
+    policy.batchPauseMs = 3;
+    std::vector<KeyEvent> events;
+    TextInjector::BuildEvents(L"abcdefghij", events);
+
+    RecordingSink sink;
+    CHECK(TextInjector::Type(events, sink, policy) == InjectionOutcome::Typed);
+    CHECK(sink.Text() == L"abcdefghij");
+    REQUIRE(sink.batches.size() == 3);
+    CHECK_EQ(sink.batches[0], static_cast<size_t>(8));
+    CHECK_EQ(sink.batches[2], static_cast<size_t>(4));
+    REQUIRE(sink.pauses.size() == 2);
+    CHECK_EQ(sink.pauses[0], 3u);
+}
+
+TEST_CASE(NeverSplitsSurrogatePairs)
+{
+    // 每个表情符号是一对代理项，与ASCII交错后批次边界会落在各个位置
+    std::wstring text;
+    for (int i = 0; i < 40; ++i)
+    {
+        text += L'x';
+        text += static_cast<wchar_t>(0xD83D);
+        text += static_cast<wchar_t>(0xDE00);
+    }
+
+    for (size_t batchUnits = 1; batchUnits <= 7; ++batchUnits)
+    {
+        InjectionPolicy policy;
+        policy.batchUnits = batchUnits;
+        std::vector<KeyEvent> events;
+        TextInjector::BuildEvents(text, events);
+        RecordingSink sink;
+        CHECK(TextInjector::Type(events, sink, policy) == InjectionOutcome::Typed);
+        CHECK(sink.Text() == text);
+
+        size_t position = 0;
+        for (size_t count : sink.batches)
+        {
+            position += count;
+            if (position < events.size())
+                CHECK(!IsHighSurrogate(events[position - 1].unit));
+        }
+    }
+}
+
+TEST_CASE(ReportsRejectedBeforeAnyInput)
+{
+    InjectionPolicy policy;
+    policy.batchUnits = 2;
+    std::vector<KeyEvent> events;
+    TextInjector::BuildEvents(L"abcd", events);
+
+    RecordingSink sink;
+    sink.rejectBatch = 0;
+    CHECK(TextInjector::Type(events, sink, policy) == InjectionOutcome::Rejected);
+    CHECK(sink.received.empty());
+}
+
+TEST_CASE(ReportsPartialAfterSomeInput)
+{
+    InjectionPolicy policy;
+    policy.batchUnits = 2;
+    std::vector<KeyEvent> events;
+    TextInjector::BuildEvents(L"abcdef", events);
+
+    // 第二批被拒绝：已输入的字符不能再粘贴一遍
+    RecordingSink sink;
+    sink.rejectBatch = 1;
+    CHECK(TextInjector::Type(events, sink, policy) == InjectionOutcome::Partial);
+    CHECK(sink.Text() == L"ab");
+    CHECK_EQ(sink.batches.size(), static_cast<size_t>(2));
+
+    // 第一批只接受了一部分也算部分输入
+    RecordingSink first;
+    first.rejectBatch = 0;
+    first.acceptOnReject = 2;
+    CHECK(TextInjector::Type(events, first, policy) == InjectionOutcome::Partial);
+    CHECK(first.Text() == L"a");
+}
+
+TEST_CASE(MatchesClassListCaseInsensitively)
+{
+    std::wstring list = L"TscShellContainerClass; VMwareUnityHostWndClass ;;";
+    CHECK(TextInjector::MatchesClassList(L"TscShellContainerClass", list));
+    CHECK(TextInjector::MatchesClassList(L"vmwareunityhostwndclass", list));
+    CHECK(!TextInjector::MatchesClassList(L"Notepad", list));
+    CHECK(!TextInjector::MatchesClassList(L"TscShell", list));
+    CHECK(!TextInjector::MatchesClassList(L"", list));
+    CHECK(!TextInjector::MatchesClassList(L"Notepad", L""));
+}
@@ -0,0 +1,155 @@
+﻿#include "TestHarness.h"
+#include "TranslationMemory.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::vector<uint32_t> Chars(const std::string& text)
+    {
+        std::vector<uint32_t> chars;
+        MemoryIndex::Normalize(text, chars);
+        return chars;
+    }
+
+    // 不限距离的完整编辑距离，作为带状实现的参考
+    size_t FullEditDistance(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+    {
+        std::vector<size_t> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j)
+            row[j] = j;
+        for (size_t i = 1; i <= a.size(); ++i)
+        {
+            size_t diagonal = row[0];
+            row[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j)
+            {
+                size_t above = row[j];
+                row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + (a[i - 1] == b[j - 1] ? 0 : 1));
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    }
+}
+
+TEST_CASE(NormalizeDropsCaseWhitespaceAndPunctuation)
+{
+    CHECK(Chars("Hello, World!") == Chars("hello world"));
+    CHECK(Chars("用户名。") == Chars("用户名"));
+    CHECK(Chars("“引号”，全角！") == Chars("引号全角"));
+    CHECK_EQ(Chars("a\xC2\xA0" "b").size(), static_cast<size_t>(2));
+    CHECK(Chars("ab") != Chars("AC"));
+
+    // 非法的UTF-8按单字节处理，不越界
+    CHECK_EQ(Chars("\xE4\xB8").size(), static_cast<size_t>(2));
+}
+
+TEST_CASE(BoundedEditDistanceMatchesFullDistance)
+{
+    std::mt19937 random(5);
+    for (int round = 0; round < 2000; ++round)
+    {
+        std::vector<uint32_t> a(random() % 30);
+        std::vector<uint32_t> b(random() % 30);
+        for (uint32_t& c : a)
+            c = 'a' + random() % 3;
+        for (uint32_t& c : b)
+            c = 'a' + random() % 3;
+        size_t limit = random() % 12;
+        size_t full = FullEditDistance(a, b);
+        size_t bounded = MemoryIndex::BoundedEditDistance(a, b, limit);
+        if (full <= limit)
+            CHECK_EQ(bounded, full);
+        else
+            CHECK_EQ(bounded, limit + 1);
+    }
+}
+
+TEST_CASE(FindsNearDuplicates)
+{
+    MemoryIndex index(1000);
+    CHECK(index.Add("ns", "Failed to open the configuration file.", "无法打开配置文件。"));
+    CHECK(index.Add("ns", "The network connection was lost.", "网络连接已断开。"));
+
+    MemoryMatch match;
+    REQUIRE(index.Lookup("ns", "failed to open the configuration file", 1.0, match));
+    CHECK_EQ(match.similarity, 1.0);
+    CHECK_EQ(match.result, std::string("无法打开配置文件。"));
+    CHECK_EQ(match.source, std::string("Failed to open the configuration file."));
+
+    REQUIRE(index.Lookup("ns", "Failed to open the configuraton file.", 0.9, match));
+    CHECK(match.similarity < 1.0 && match.similarity >= 0.9);
+    CHECK_EQ(match.result, std::string("无法打开配置文件。"));
+
+    CHECK(!index.Lookup("ns", "Failed to open the configuraton file.", 1.0, match));
+    CHECK(!index.Lookup("ns", "Completely unrelated sentence here.", 0.5, match));
+}
+
+TEST_CASE(NamespacesDoNotMatchEachOther)
+{
+    MemoryIndex index(1000);
+    index.Add("a", "Save the current document", "保存当前文档");
+    MemoryMatch match;
+    CHECK(!index.Lookup("b", "Save the current document", 0.5, match));
+    CHECK(index.Lookup("a", "Save the current document", 0.5, match));
+}
+
+TEST_CASE(RejectsShortAndLongSources)
+{
+    MemoryIndex index(1000);
+    CHECK(!index.Add("ns", "a b!", "甲乙"));
+    CHECK(!index.Add("ns", std::string(MemoryIndex::MAX_CHARS + 1, 'x'), "长"));
+    CHECK(!index.Add("ns", "long enough source", std::string()));
+    CHECK_EQ(index.GetSize(), static_cast<size_t>(0));
+}
+
+TEST_CASE(ReplacesNormalizedDuplicates)
+{
+    MemoryIndex index(1000);
+    index.Add("ns", "Open the file", "打开文件");
+    index.Add("ns", "open the FILE.", "打开该文件");
+    CHECK_EQ(index.GetSize(), static_cast<size_t>(1));
+
+    MemoryMatch match;
+    REQUIRE(index.Lookup("ns", "Open the file", 1.0, match));
+    CHECK_EQ(match.result, std::string("打开该文件"));
+}
+
+TEST_CASE(DropsOldestHalfAtCapacity)
+{
+    const size_t capacity = 100;
+    MemoryIndex index(capacity);
+    for (size_t i = 0; i < capacity; ++i)
+        index.Add("ns", "sentence number " + std::to_string(i * 7919), "第" + std::to_string(i) + "句");
+    CHECK_EQ(index.GetSize(), capacity);
+
+    // 再加入一条时丢弃较早的一半
+    index.Add("ns", "one more sentence", "又一句");
+    CHECK_EQ(index.GetSize(), capacity / 2 + 1);
+
+    MemoryMatch match;
+    CHECK(!index.Lookup("ns", "sentence number 0", 1.0, match));
+    REQUIRE(index.Lookup("ns", "sentence number " + std::to_string((capacity - 1) * 7919), 1.0, match));
+    CHECK_EQ(match.result, "第" + std::to_string(capacity - 1) + "句");
+    CHECK(index.Lookup("ns", "one more sentence", 1.0, match));
+}
+
+TEST_CASE(GlobalMemoryCanBeDisabled)
+{
+    TranslationMemory::SetCapacity(100);
+    TranslationMemory::Add("ns", "Connection timed out", "连接超时");
+    CHECK_EQ(TranslationMemory::GetSize(), static_cast<size_t>(1));
+
+    MemoryMatch match;
+    CHECK(TranslationMemory::Lookup("ns", "connection timed out.", 1.0, match));
+    CHECK(!TranslationMemory::Lookup("ns", "connection timed out.", 0.0, match));
+
+    TranslationMemory::Clear();
+    CHECK_EQ(TranslationMemory::GetSize(), static_cast<size_t>(0));
+
+    TranslationMemory::SetCapacity(0);
+    TranslationMemory::Add("ns", "Connection timed out", "连接超时");
+    CHECK_EQ(TranslationMemory::GetSize(), static_cast<size_t>(0));
+    CHECK(!TranslationMemory::Lookup("ns", "Connection timed out", 1.0, match));
+}